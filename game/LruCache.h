@@ -0,0 +1,321 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <utility>
+
+struct LruCacheStats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+};
+
+/**
+ * Least-recently-used cache that stores all entries in preallocated, contiguous arrays.
+ *
+ * Keys are found through an open-addressing hash table with linear probing, which stores the
+ * hash of each entry next to its index so that most probes never touch the entries themselves.
+ * The recency list is threaded through the entries as indices rather than pointers. Nothing is
+ * allocated after construction, apart from what copying keys and values allocates.
+ *
+ * The cache holds at most maxCount entries, whose weights (1 per entry by default) add up to at
+ * most maxWeight. Hashes can be computed once by the caller and passed to the *Hashed functions,
+ * which must be given the same hash that Hash would compute for the key.
+ *
+ * Not thread-safe.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename Equal = std::equal_to<Key>>
+class LruCache {
+ public:
+  explicit LruCache(size_t maxCount, size_t maxWeight = std::numeric_limits<size_t>::max())
+      : _maxCount(maxCount),
+        _maxWeight(maxWeight),
+        _entries(std::make_unique<Entry[]>(maxCount)),
+        _tableMask(TableSizeFor(maxCount) - 1),
+        _table(std::make_unique<Slot[]>(_tableMask + 1)) {
+    clear();
+  }
+
+  /**
+   * Copies the value of a cached entry and marks it as most recently used.
+   * @return False if the key is not in the cache.
+   */
+  bool tryGet(const Key &key, Value &value) {
+    return tryGetHashed(key, Hash()(key), value);
+  }
+
+  bool tryGetHashed(const Key &key, size_t hash, Value &value) {
+    auto entry = findHashed(key, hash);
+    if (!entry) {
+      return false;
+    }
+    value = *entry;
+    return true;
+  }
+
+  /**
+   * Returns the value of a cached entry and marks it as most recently used, or null.
+   * The pointer is invalidated by the next insert or remove.
+   */
+  Value *find(const Key &key) {
+    return findHashed(key, Hash()(key));
+  }
+
+  Value *findHashed(const Key &key, size_t hash) {
+    auto index = lookup(key, Mix(hash));
+    if (index == None) {
+      _stats.misses++;
+      return nullptr;
+    }
+    _stats.hits++;
+    moveToFront(index);
+    return &*_entries[index].value;
+  }
+
+  /**
+   * Adds an entry, or replaces the value of an existing one, and marks it as most recently used.
+   * Least recently used entries are evicted until the limits are met again, but the entry that
+   * was just inserted is kept even if its weight alone exceeds maxWeight.
+   * @return The inserted value, or null if the cache has no capacity. The pointer is invalidated
+   * by the next insert or remove.
+   */
+  Value *insert(const Key &key, Value value, size_t weight = 1) {
+    return insertHashed(key, Hash()(key), std::move(value), weight);
+  }
+
+  Value *insertHashed(const Key &key, size_t hash, Value value, size_t weight = 1) {
+    if (_maxCount == 0) {
+      return nullptr;
+    }
+
+    auto mixedHash = Mix(hash);
+    auto index = lookup(key, mixedHash);
+    if (index != None) {
+      auto &entry = _entries[index];
+      entry.value.emplace(std::move(value));
+      _weight = _weight - entry.weight + weight;
+      entry.weight = weight;
+      moveToFront(index);
+    } else {
+      if (_count == _maxCount) {
+        evict();
+      }
+      index = _freeList;
+      auto &entry = _entries[index];
+      _freeList = entry.next;
+      entry.key.emplace(key);
+      entry.value.emplace(std::move(value));
+      entry.hash = mixedHash;
+      entry.weight = weight;
+      linkFront(index);
+      insertSlot(mixedHash, index);
+      _count++;
+      _weight += weight;
+    }
+
+    while (_weight > _maxWeight && _tail != index) {
+      evict();
+    }
+    return &*_entries[index].value;
+  }
+
+  /**
+   * @return False if the key was not in the cache.
+   */
+  bool remove(const Key &key) {
+    return removeHashed(key, Hash()(key));
+  }
+
+  bool removeHashed(const Key &key, size_t hash) {
+    auto index = lookup(key, Mix(hash));
+    if (index == None) {
+      return false;
+    }
+    removeEntry(index);
+    return true;
+  }
+
+  /**
+   * Removes all entries. The statistics are kept.
+   */
+  void clear() {
+    for (size_t i = 0; i < _maxCount; i++) {
+      _entries[i].key.reset();
+      _entries[i].value.reset();
+      _entries[i].next = i + 1 < _maxCount ? (uint32_t)(i + 1) : None;
+    }
+    for (size_t i = 0; i <= _tableMask; i++) {
+      _table[i].index = None;
+    }
+    _freeList = _maxCount > 0 ? 0 : None;
+    _head = None;
+    _tail = None;
+    _count = 0;
+    _weight = 0;
+  }
+
+  [[nodiscard]] size_t size() const {
+    return _count;
+  }
+
+  [[nodiscard]] size_t weight() const {
+    return _weight;
+  }
+
+  [[nodiscard]] size_t maxCount() const {
+    return _maxCount;
+  }
+
+  [[nodiscard]] size_t maxWeight() const {
+    return _maxWeight;
+  }
+
+  [[nodiscard]] const LruCacheStats &stats() const {
+    return _stats;
+  }
+
+  void resetStats() {
+    _stats = {};
+  }
+
+ private:
+  static constexpr uint32_t None = std::numeric_limits<uint32_t>::max();
+
+  struct Entry {
+    std::optional<Key> key;
+    std::optional<Value> value;
+    size_t weight = 0;
+    uint32_t hash = 0;
+    uint32_t prev = None;
+    uint32_t next = None;
+  };
+
+  struct Slot {
+    uint32_t hash;
+    uint32_t index;  // None if the slot is empty
+  };
+
+  // Keeps the table at most half full, so that probe sequences stay short
+  static size_t TableSizeFor(size_t maxCount) {
+    size_t size = 8;
+    while (size < maxCount * 2) {
+      size *= 2;
+    }
+    return size;
+  }
+
+  // std::hash is the identity function for integers in some standard libraries, which would
+  // cluster sequential keys in the table
+  static uint32_t Mix(size_t hash) {
+    auto mixed = (uint64_t)hash * 0x9E3779B97F4A7C15ull;
+    return (uint32_t)(mixed >> 32);
+  }
+
+  uint32_t lookup(const Key &key, uint32_t hash) const {
+    for (auto pos = hash & _tableMask;; pos = (pos + 1) & _tableMask) {
+      auto &slot = _table[pos];
+      if (slot.index == None) {
+        return None;
+      }
+      if (slot.hash == hash && Equal()(*_entries[slot.index].key, key)) {
+        return slot.index;
+      }
+    }
+  }
+
+  void insertSlot(uint32_t hash, uint32_t index) {
+    auto pos = hash & _tableMask;
+    while (_table[pos].index != None) {
+      pos = (pos + 1) & _tableMask;
+    }
+    _table[pos] = {hash, index};
+  }
+
+  // Deletes by shifting the following entries of the probe sequence back, so that the table never
+  // fills up with tombstones
+  void removeSlot(uint32_t hash, uint32_t index) {
+    auto pos = hash & _tableMask;
+    while (_table[pos].index != index) {
+      pos = (pos + 1) & _tableMask;
+    }
+
+    auto next = (pos + 1) & _tableMask;
+    while (_table[next].index != None) {
+      auto home = _table[next].hash & _tableMask;
+      // Move the slot into the gap unless its home position lies cyclically in (pos, next]
+      if (((next - home) & _tableMask) >= ((next - pos) & _tableMask)) {
+        _table[pos] = _table[next];
+        pos = next;
+      }
+      next = (next + 1) & _tableMask;
+    }
+    _table[pos].index = None;
+  }
+
+  void linkFront(uint32_t index) {
+    auto &entry = _entries[index];
+    entry.prev = None;
+    entry.next = _head;
+    if (_head != None) {
+      _entries[_head].prev = index;
+    } else {
+      _tail = index;
+    }
+    _head = index;
+  }
+
+  void unlink(uint32_t index) {
+    auto &entry = _entries[index];
+    if (entry.prev != None) {
+      _entries[entry.prev].next = entry.next;
+    } else {
+      _head = entry.next;
+    }
+    if (entry.next != None) {
+      _entries[entry.next].prev = entry.prev;
+    } else {
+      _tail = entry.prev;
+    }
+  }
+
+  void moveToFront(uint32_t index) {
+    if (_head != index) {
+      unlink(index);
+      linkFront(index);
+    }
+  }
+
+  void evict() {
+    _stats.evictions++;
+    removeEntry(_tail);
+  }
+
+  void removeEntry(uint32_t index) {
+    auto &entry = _entries[index];
+    removeSlot(entry.hash, index);
+    unlink(index);
+    entry.key.reset();
+    entry.value.reset();
+    entry.next = _freeList;
+    _freeList = index;
+    _count--;
+    _weight -= entry.weight;
+  }
+
+  const size_t _maxCount;
+  const size_t _maxWeight;
+  std::unique_ptr<Entry[]> _entries;
+  const size_t _tableMask;
+  std::unique_ptr<Slot[]> _table;
+  uint32_t _freeList = None;
+  uint32_t _head = None;  // Most recently used
+  uint32_t _tail = None;  // Least recently used
+  size_t _count = 0;
+  size_t _weight = 0;
+  LruCacheStats _stats{};
+};
@@ -0,0 +1,185 @@
+
+#include <algorithm>
+
+#include "MesParser.h"
+#include "interop/Transcoding.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MES_PARSER_SSE
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define MES_PARSER_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static constexpr size_t NotFound = SIZE_MAX;
+
+#if defined(MES_PARSER_SSE)
+static int CountTrailingZeros(uint32_t value) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, value);
+  return (int)index;
+#else
+  return __builtin_ctz(value);
+#endif
+}
+#elif defined(MES_PARSER_NEON)
+static int CountTrailingZeros(uint64_t value) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward64(&index, value);
+  return (int)index;
+#else
+  return __builtin_ctzll(value);
+#endif
+}
+#endif
+
+/**
+ * Returns the position of the first occurrence of either a or b at or after pos, scanning 16
+ * bytes at a time.
+ */
+static size_t FindEither(const uint8_t *data, size_t pos, size_t length, uint8_t a, uint8_t b) {
+#if defined(MES_PARSER_SSE)
+  auto va = _mm_set1_epi8((char)a);
+  auto vb = _mm_set1_epi8((char)b);
+  for (; pos + 16 <= length; pos += 16) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+    auto mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)));
+    if (mask != 0) {
+      return pos + CountTrailingZeros((uint32_t)mask);
+    }
+  }
+#elif defined(MES_PARSER_NEON)
+  auto va = vdupq_n_u8(a);
+  auto vb = vdupq_n_u8(b);
+  for (; pos + 16 <= length; pos += 16) {
+    auto v = vld1q_u8(data + pos);
+    auto matches = vorrq_u8(vceqq_u8(v, va), vceqq_u8(v, vb));
+    // Narrow each byte of the comparison result to a nibble to get a 64-bit mask
+    auto mask = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+    if (mask != 0) {
+      return pos + CountTrailingZeros(mask) / 4;
+    }
+  }
+#endif
+  for (; pos < length; pos++) {
+    if (data[pos] == a || data[pos] == b) {
+      return pos;
+    }
+  }
+  return NotFound;
+}
+
+static int LineAt(const uint8_t *data, size_t pos) {
+  return 1 + (int)std::count(data, data + pos, '\n');
+}
+
+static bool IsSpace(uint8_t ch) {
+  return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+static bool ParseId(const uint8_t *start, const uint8_t *end, int32_t &id) {
+  while (start < end && IsSpace(*start)) {
+    start++;
+  }
+  while (end > start && IsSpace(end[-1])) {
+    end--;
+  }
+  auto negative = start < end && *start == '-';
+  if (negative) {
+    start++;
+  }
+  if (start == end) {
+    return false;
+  }
+
+  int64_t value = 0;
+  for (; start < end; start++) {
+    if (*start < '0' || *start > '9') {
+      return false;
+    }
+    value = value * 10 + (*start - '0');
+    if (value > INT32_MAX) {
+      return false;
+    }
+  }
+  id = (int32_t)(negative ? -value : value);
+  return true;
+}
+
+bool ParseMesFile(const uint8_t *data, size_t length, MesFile &result, std::string &error) {
+  result.entries.clear();
+  // Windows-1252 decodes to exactly one UTF-16 code unit per byte
+  result.text.resize(length);
+  size_t textLength = 0;
+
+  size_t pos = 0;
+  while (true) {
+    pos = FindEither(data, pos, length, '{', '/');
+    if (pos == NotFound) {
+      break;
+    }
+    if (data[pos] == '/') {
+      if (pos + 1 < length && data[pos + 1] == '/') {
+        pos = FindEither(data, pos, length, '\n', '\n');
+        if (pos == NotFound) {
+          break;
+        }
+      }
+      pos++;
+      continue;
+    }
+
+    auto idStart = pos + 1;
+    auto idEnd = FindEither(data, idStart, length, '}', '}');
+    if (idEnd == NotFound) {
+      error = "Unterminated message ID in line " + std::to_string(LineAt(data, pos));
+      return false;
+    }
+    int32_t id;
+    if (!ParseId(data + idStart, data + idEnd, id)) {
+      error = "Invalid message ID in line " + std::to_string(LineAt(data, pos));
+      return false;
+    }
+
+    auto textStart = FindEither(data, idEnd + 1, length, '{', '{');
+    if (textStart == NotFound) {
+      error = "Missing text for message " + std::to_string(id);
+      return false;
+    }
+    textStart++;
+    auto textEnd = FindEither(data, textStart, length, '}', '}');
+    if (textEnd == NotFound) {
+      error = "Unterminated text of message " + std::to_string(id);
+      return false;
+    }
+
+    auto decoded = Transcode(TextEncoding::Windows1252, TextEncoding::Utf16, data + textStart,
+                             textEnd - textStart, result.text.data() + textLength);
+    result.entries.push_back({id, (int32_t)textLength, (int32_t)decoded});
+    textLength += decoded;
+    pos = textEnd + 1;
+  }
+  result.text.resize(textLength);
+
+  // Sort by ID and keep only the last occurrence of duplicate IDs
+  std::stable_sort(result.entries.begin(), result.entries.end(),
+                   [](const MesEntry &a, const MesEntry &b) { return a.id < b.id; });
+  auto out = result.entries.begin();
+  for (auto it = result.entries.begin(); it != result.entries.end(); ++it) {
+    if (out != result.entries.begin() && out[-1].id == it->id) {
+      out[-1] = *it;
+    } else {
+      *out++ = *it;
+    }
+  }
+  result.entries.erase(out, result.entries.end());
+  return true;
+}
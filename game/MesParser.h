@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * A message (.mes) file entry. The text is stored in MesFile::text at [offset, offset + length).
+ */
+struct MesEntry {
+  int32_t id;
+  int32_t offset;
+  int32_t length;
+};
+
+/**
+ * The parsed contents of a message file: all texts decoded to UTF-16 in one contiguous buffer,
+ * and an index sorted by ID. If an ID occurs more than once, the last occurrence wins.
+ */
+struct MesFile {
+  std::u16string text;
+  std::vector<MesEntry> entries;
+};
+
+/**
+ * Parses the legacy message file format, where each entry consists of two brace groups:
+ * {id}{text}. The text may span multiple lines and is decoded as Windows-1252. Anything outside
+ * of the brace groups is ignored, as are // comments.
+ *
+ * @param error Receives a description of the problem (with line number) if parsing fails.
+ */
+bool ParseMesFile(const uint8_t *data, size_t length, MesFile &result, std::string &error);
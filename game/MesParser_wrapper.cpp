@@ -0,0 +1,47 @@
+#include <memory>
+#include <new>
+
+#include "MesParser.h"
+#include "interop/string_interop.h"
+#include "utils.h"
+
+/**
+ * Parses a message file. On success, the text and index can be read from the returned handle
+ * until it is freed with MesFile_Free. On failure, returns null and sets error.
+ */
+NATIVE_API MesFile *MesFile_Parse(const uint8_t *data, int length, char16_t **error) noexcept {
+  *error = nullptr;
+  if (length < 0) {
+    *error = copyString(L"Negative message file length");
+    return nullptr;
+  }
+
+  // The text buffer is as large as the file, and allocation failures must not escape through
+  // the noexcept ABI boundary
+  try {
+    auto result = std::make_unique<MesFile>();
+    std::string errorMessage;
+    if (!ParseMesFile(data, length, *result, errorMessage)) {
+      *error = copyString(localToWide(errorMessage));
+      return nullptr;
+    }
+    return result.release();
+  } catch (const std::bad_alloc &) {
+    *error = copyString(L"Out of memory while parsing the message file");
+    return nullptr;
+  }
+}
+
+NATIVE_API void MesFile_GetText(MesFile *file, const char16_t **text, int *textLength) {
+  *text = file->text.data();
+  *textLength = (int)file->text.length();
+}
+
+NATIVE_API void MesFile_GetEntries(MesFile *file, const MesEntry **entries, int *entryCount) {
+  *entries = file->entries.data();
+  *entryCount = (int)file->entries.size();
+}
+
+NATIVE_API void MesFile_Free(MesFile *file) {
+  delete file;
+}
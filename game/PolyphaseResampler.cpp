@@ -0,0 +1,156 @@
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "PolyphaseResampler.h"
+
+// Fraction of the lower Nyquist frequency that is kept, leaves room for the transition band
+static constexpr double Rolloff = 0.94;
+static constexpr double KaiserBeta = 8.6;
+static constexpr double Pi = 3.14159265358979323846;
+
+// Zeroth order modified Bessel function of the first kind (for the Kaiser window)
+static double BesselI0(double x) {
+  double sum = 1;
+  double term = 1;
+  for (int k = 1; k < 50; k++) {
+    term *= (x / (2 * k)) * (x / (2 * k));
+    sum += term;
+    if (term < sum * 1e-12) {
+      break;
+    }
+  }
+  return sum;
+}
+
+bool PolyphaseResampler::IsSupported(int inputRate, int outputRate) {
+  if (inputRate <= 0 || outputRate <= 0) {
+    return false;
+  }
+  auto divisor = std::gcd(inputRate, outputRate);
+  return (uint32_t)(outputRate / divisor) <= MaxPhases;
+}
+
+PolyphaseResampler::PolyphaseResampler(int channels, int inputRate, int outputRate,
+                                       int tapsPerPhase)
+    : _channels(channels), _inputRate(inputRate), _taps(tapsPerPhase) {
+  auto divisor = std::gcd(inputRate, outputRate);
+  _phases = (uint32_t)(outputRate / divisor);
+  _step = (uint32_t)(inputRate / divisor);
+
+  // When downsampling, the cutoff has to move down to the output Nyquist frequency
+  auto cutoff = Rolloff * std::min(1.0, (double)outputRate / inputRate);
+  auto halfTaps = _taps / 2;
+  auto windowNorm = BesselI0(KaiserBeta);
+
+  // Tap t of phase p weighs input sample (base - halfTaps + 1 + t) for an output
+  // located at base + p / phases.
+  _coefficients.resize((size_t)_phases * _taps);
+  for (uint32_t p = 0; p < _phases; p++) {
+    auto coefficients = &_coefficients[(size_t)p * _taps];
+    double sum = 0;
+    for (int t = 0; t < _taps; t++) {
+      auto x = (double)p / _phases + (halfTaps - 1 - t);
+      auto u = x / halfTaps;
+      double window = 0;
+      if (std::abs(u) < 1) {
+        window = BesselI0(KaiserBeta * std::sqrt(1 - u * u)) / windowNorm;
+      }
+      auto arg = Pi * cutoff * x;
+      auto sinc = arg == 0 ? 1.0 : std::sin(arg) / arg;
+      coefficients[t] = (float)(cutoff * sinc * window);
+      sum += coefficients[t];
+    }
+    // Normalize each phase to unity gain so that DC passes through unchanged
+    for (int t = 0; t < _taps; t++) {
+      coefficients[t] = (float)(coefficients[t] / sum);
+    }
+  }
+
+  _history.resize(_channels);
+  _output.resize(_channels);
+  reset();
+}
+
+void PolyphaseResampler::reset() {
+  // Pretend the stream was preceded by silence
+  auto halfTaps = (size_t)_taps / 2;
+  for (auto &history : _history) {
+    history.assign(halfTaps - 1, 0.0f);
+  }
+  _base = halfTaps - 1;
+  _phase = 0;
+}
+
+size_t PolyphaseResampler::process(const float *const *planes, size_t count) {
+  auto halfTaps = (size_t)_taps / 2;
+
+  for (int ch = 0; ch < _channels; ch++) {
+    _history[ch].insert(_history[ch].end(), planes[ch], planes[ch] + count);
+  }
+
+  auto available = _history[0].size();
+  auto maxOutput = (available * _phases) / _step + 1;
+  for (auto &output : _output) {
+    output.resize(maxOutput);
+  }
+
+  size_t produced = 0;
+  auto base = _base;
+  auto phase = _phase;
+  while (base + halfTaps < available) {
+    auto coefficients = &_coefficients[(size_t)phase * _taps];
+    for (int ch = 0; ch < _channels; ch++) {
+      auto input = &_history[ch][base + 1 - halfTaps];
+      // Multiple accumulators so the compiler can keep several multiply-adds in flight
+      float acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+      int t = 0;
+      for (; t + 4 <= _taps; t += 4) {
+        acc0 += input[t] * coefficients[t];
+        acc1 += input[t + 1] * coefficients[t + 1];
+        acc2 += input[t + 2] * coefficients[t + 2];
+        acc3 += input[t + 3] * coefficients[t + 3];
+      }
+      for (; t < _taps; t++) {
+        acc0 += input[t] * coefficients[t];
+      }
+      _output[ch][produced] = (acc0 + acc1) + (acc2 + acc3);
+    }
+    produced++;
+
+    phase += _step;
+    base += phase / _phases;
+    phase %= _phases;
+  }
+
+  // Drop history that no future output sample will reference
+  auto consumed = base - (halfTaps - 1);
+  for (auto &history : _history) {
+    history.erase(history.begin(), history.begin() + consumed);
+  }
+  _base = base - consumed;
+  _phase = phase;
+
+  return produced;
+}
+
+size_t PolyphaseResampler::outputCount(size_t count) const {
+  // process() produces a sample for every step while _base + halfTaps < available, and every
+  // sample moves the position forward by _step / _phases input samples
+  auto halfTaps = (size_t)_taps / 2;
+  auto available = _history[0].size() + count;
+  if (available <= _base + halfTaps) {
+    return 0;
+  }
+  auto limit = (uint64_t)(available - _base - halfTaps) * _phases - _phase;
+  return (size_t)((limit + _step - 1) / _step);
+}
+
+size_t PolyphaseResampler::maxInputCount(size_t maxOutput) const {
+  // Inverse of outputCount
+  auto halfTaps = (size_t)_taps / 2;
+  auto available = ((uint64_t)maxOutput * _step + _phase) / _phases + _base + halfTaps;
+  auto history = _history[0].size();
+  return available > history ? (size_t)(available - history) : 0;
+}
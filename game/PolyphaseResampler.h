@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Converts planar audio between two fixed sample rates using a Kaiser-windowed sinc filter
+ * split into one set of taps per phase of the rational ratio outputRate/inputRate.
+ *
+ * The resampler is stateful and keeps the tail of the previous input block as history, so
+ * consecutive blocks of a stream are resampled seamlessly. It is not thread-safe.
+ */
+class PolyphaseResampler {
+ public:
+  /**
+   * Upper limit for the number of phases (the reduced output rate) to bound the size of the
+   * coefficient table.
+   */
+  static constexpr uint32_t MaxPhases = 2048;
+
+  static constexpr int DefaultTapsPerPhase = 32;
+
+  /**
+   * Use IsSupported to check the ratio before creating a resampler.
+   */
+  PolyphaseResampler(int channels, int inputRate, int outputRate,
+                     int tapsPerPhase = DefaultTapsPerPhase);
+
+  static bool IsSupported(int inputRate, int outputRate);
+
+  /**
+   * Resamples count samples per channel. The result is available through output() until the
+   * next call.
+   * @return The number of output samples produced per channel.
+   */
+  size_t process(const float *const *planes, size_t count);
+
+  /**
+   * Exact number of samples per channel that the next call to process produces for count
+   * input samples.
+   */
+  [[nodiscard]] size_t outputCount(size_t count) const;
+
+  /**
+   * Largest number of input samples per channel for which the next call to process produces
+   * at most maxOutput samples.
+   */
+  [[nodiscard]] size_t maxInputCount(size_t maxOutput) const;
+
+  [[nodiscard]] const float *output(int channel) const {
+    return _output[channel].data();
+  }
+
+  [[nodiscard]] int inputRate() const {
+    return _inputRate;
+  }
+
+  /**
+   * Forgets all buffered history, i.e. when the stream is interrupted.
+   */
+  void reset();
+
+ private:
+  const int _channels;
+  const int _inputRate;
+  const int _taps;
+  // Reduced ratio: for every _step input samples, _phases output samples are produced
+  uint32_t _phases;
+  uint32_t _step;
+  std::vector<float> _coefficients;  // _phases x _taps
+
+  std::vector<std::vector<float>> _history;
+  std::vector<std::vector<float>> _output;
+  // Position of the next output sample: _history[ch][_base] + _phase / _phases
+  size_t _base = 0;
+  uint32_t _phase = 0;
+};
@@ -0,0 +1,229 @@
+
+#include "SampleConversion.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SAMPLE_CONVERSION_SSE
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define SAMPLE_CONVERSION_NEON
+#include <arm_neon.h>
+#endif
+
+static void DeinterleaveScalar(const float *interleaved, int channels, float *const *planes,
+                               size_t start, size_t count) {
+  for (auto i = start; i < count; i++) {
+    for (int ch = 0; ch < channels; ch++) {
+      planes[ch][i] = interleaved[i * channels + ch];
+    }
+  }
+}
+
+#if defined(SAMPLE_CONVERSION_SSE)
+
+/**
+ * Deinterleaves blocks of 4 frames and returns the number of frames that have been processed.
+ */
+static size_t Deinterleave2(const float *in, float *left, float *right, size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    auto a = _mm_loadu_ps(in + i * 2);
+    auto b = _mm_loadu_ps(in + i * 2 + 4);
+    _mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+  return i;
+}
+
+static size_t Deinterleave4(const float *in, float *const *planes, size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    auto r0 = _mm_loadu_ps(in + i * 4);
+    auto r1 = _mm_loadu_ps(in + i * 4 + 4);
+    auto r2 = _mm_loadu_ps(in + i * 4 + 8);
+    auto r3 = _mm_loadu_ps(in + i * 4 + 12);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(planes[0] + i, r0);
+    _mm_storeu_ps(planes[1] + i, r1);
+    _mm_storeu_ps(planes[2] + i, r2);
+    _mm_storeu_ps(planes[3] + i, r3);
+  }
+  return i;
+}
+
+static size_t Deinterleave6(const float *in, float *const *planes, size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    auto frame = in + i * 6;
+    // Each group of three registers holds two frames. Regroup them into channel pairs
+    // (c0 c1 | c2 c3 | c4 c5) of both frames, then split the pairs of two groups.
+    __m128 pairs[2][3];
+    for (int g = 0; g < 2; g++) {
+      auto a = _mm_loadu_ps(frame + g * 12);
+      auto b = _mm_loadu_ps(frame + g * 12 + 4);
+      auto c = _mm_loadu_ps(frame + g * 12 + 8);
+      pairs[g][0] = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 2, 1, 0));
+      pairs[g][1] = _mm_shuffle_ps(a, c, _MM_SHUFFLE(1, 0, 3, 2));
+      pairs[g][2] = _mm_shuffle_ps(b, c, _MM_SHUFFLE(3, 2, 1, 0));
+    }
+    for (int p = 0; p < 3; p++) {
+      _mm_storeu_ps(planes[p * 2] + i,
+                    _mm_shuffle_ps(pairs[0][p], pairs[1][p], _MM_SHUFFLE(2, 0, 2, 0)));
+      _mm_storeu_ps(planes[p * 2 + 1] + i,
+                    _mm_shuffle_ps(pairs[0][p], pairs[1][p], _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+  }
+  return i;
+}
+
+static size_t Deinterleave8(const float *in, float *const *planes, size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    auto frame = in + i * 8;
+    auto l0 = _mm_loadu_ps(frame);
+    auto h0 = _mm_loadu_ps(frame + 4);
+    auto l1 = _mm_loadu_ps(frame + 8);
+    auto h1 = _mm_loadu_ps(frame + 12);
+    auto l2 = _mm_loadu_ps(frame + 16);
+    auto h2 = _mm_loadu_ps(frame + 20);
+    auto l3 = _mm_loadu_ps(frame + 24);
+    auto h3 = _mm_loadu_ps(frame + 28);
+    _MM_TRANSPOSE4_PS(l0, l1, l2, l3);
+    _MM_TRANSPOSE4_PS(h0, h1, h2, h3);
+    _mm_storeu_ps(planes[0] + i, l0);
+    _mm_storeu_ps(planes[1] + i, l1);
+    _mm_storeu_ps(planes[2] + i, l2);
+    _mm_storeu_ps(planes[3] + i, l3);
+    _mm_storeu_ps(planes[4] + i, h0);
+    _mm_storeu_ps(planes[5] + i, h1);
+    _mm_storeu_ps(planes[6] + i, h2);
+    _mm_storeu_ps(planes[7] + i, h3);
+  }
+  return i;
+}
+
+#elif defined(SAMPLE_CONVERSION_NEON)
+
+static size_t Deinterleave2(const float *in, float *left, float *right, size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    auto v = vld2q_f32(in + i * 2);
+    vst1q_f32(left + i, v.val[0]);
+    vst1q_f32(right + i, v.val[1]);
+  }
+  return i;
+}
+
+static size_t Deinterleave4(const float *in, float *const *planes, size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    auto v = vld4q_f32(in + i * 4);
+    vst1q_f32(planes[0] + i, v.val[0]);
+    vst1q_f32(planes[1] + i, v.val[1]);
+    vst1q_f32(planes[2] + i, v.val[2]);
+    vst1q_f32(planes[3] + i, v.val[3]);
+  }
+  return i;
+}
+
+// vld3q on 6-channel data yields channels c and c+3 of two frames (alternating), which are
+// then split into their own channels by unzipping two such loads.
+static size_t Deinterleave6(const float *in, float *const *planes, size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    auto a = vld3q_f32(in + i * 6);
+    auto b = vld3q_f32(in + i * 6 + 12);
+    for (int c = 0; c < 3; c++) {
+      auto split = vuzpq_f32(a.val[c], b.val[c]);
+      vst1q_f32(planes[c] + i, split.val[0]);
+      vst1q_f32(planes[c + 3] + i, split.val[1]);
+    }
+  }
+  return i;
+}
+
+static size_t Deinterleave8(const float *in, float *const *planes, size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    auto a = vld4q_f32(in + i * 8);
+    auto b = vld4q_f32(in + i * 8 + 16);
+    for (int c = 0; c < 4; c++) {
+      auto split = vuzpq_f32(a.val[c], b.val[c]);
+      vst1q_f32(planes[c] + i, split.val[0]);
+      vst1q_f32(planes[c + 4] + i, split.val[1]);
+    }
+  }
+  return i;
+}
+
+#endif
+
+void DeinterleaveSamples(const float *interleaved, int channels, float *const *planes,
+                         size_t count) {
+  size_t processed = 0;
+#if defined(SAMPLE_CONVERSION_SSE) || defined(SAMPLE_CONVERSION_NEON)
+  switch (channels) {
+    case 2:
+      processed = Deinterleave2(interleaved, planes[0], planes[1], count);
+      break;
+    case 4:
+      processed = Deinterleave4(interleaved, planes, count);
+      break;
+    case 6:
+      processed = Deinterleave6(interleaved, planes, count);
+      break;
+    case 8:
+      processed = Deinterleave8(interleaved, planes, count);
+      break;
+    default:
+      break;
+  }
+#endif
+  // Handles the remainder and channel counts without a dedicated kernel
+  DeinterleaveScalar(interleaved, channels, planes, processed, count);
+}
+
+static constexpr float S16Scale = 1.0f / 32768.0f;
+static constexpr float S32Scale = 1.0f / 2147483648.0f;
+
+void ConvertS16ToFloat(const int16_t *samples, float *out, size_t count) {
+  size_t i = 0;
+#if defined(SAMPLE_CONVERSION_SSE)
+  auto scale = _mm_set1_ps(S16Scale);
+  for (; i + 8 <= count; i += 8) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i));
+    // Sign-extend by placing each sample in the upper half of a 32-bit lane and shifting down
+    auto lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    auto hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+    _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+  }
+#elif defined(SAMPLE_CONVERSION_NEON)
+  for (; i + 8 <= count; i += 8) {
+    auto v = vld1q_s16(samples + i);
+    vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), S16Scale));
+    vst1q_f32(out + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), S16Scale));
+  }
+#endif
+  for (; i < count; i++) {
+    out[i] = samples[i] * S16Scale;
+  }
+}
+
+void ConvertS32ToFloat(const int32_t *samples, float *out, size_t count) {
+  size_t i = 0;
+#if defined(SAMPLE_CONVERSION_SSE)
+  auto scale = _mm_set1_ps(S32Scale);
+  for (; i + 4 <= count; i += 4) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i));
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+  }
+#elif defined(SAMPLE_CONVERSION_NEON)
+  for (; i + 4 <= count; i += 4) {
+    // Treat the samples as fixed point numbers with 31 fractional bits
+    vst1q_f32(out + i, vcvtq_n_f32_s32(vld1q_s32(samples + i), 31));
+  }
+#endif
+  for (; i < count; i++) {
+    out[i] = (float)samples[i] * S32Scale;
+  }
+}
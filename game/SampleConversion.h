@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Maximum number of interleaved channels supported by the conversion functions (7.1).
+ */
+constexpr int MaxInterleavedChannels = 8;
+
+/**
+ * Splits count frames of interleaved samples (channels values per frame) into one plane per
+ * channel. Uses SSE or NEON kernels for 2, 4, 6 and 8 channels where available.
+ */
+void DeinterleaveSamples(const float *interleaved, int channels, float *const *planes,
+                         size_t count);
+
+/**
+ * Formats accepted by SoLoudDynamicSource. Integer samples use their full range.
+ */
+enum class SampleFormat : int { Float32 = 0, Int16, Int32 };
+
+/**
+ * Converts signed 16-bit samples to floats in [-1, 1).
+ */
+void ConvertS16ToFloat(const int16_t *samples, float *out, size_t count);
+
+/**
+ * Converts signed 32-bit samples to floats in [-1, 1].
+ */
+void ConvertS32ToFloat(const int32_t *samples, float *out, size_t count);
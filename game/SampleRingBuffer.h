@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * A preallocated, lock-free single-producer/single-consumer ring buffer for planar audio samples.
+ *
+ * Each channel has its own plane of samples, but all planes share a single pair of read/write
+ * positions so that the consumer always sees the same number of samples on every channel.
+ * The positions are free-running counters and are only masked when indexing into the planes,
+ * which requires the capacity to be a power of two.
+ *
+ * Only one thread may call the producer methods (write*) and only one thread may call the
+ * consumer methods (read*) at any given time. Any thread may drop the oldest samples, which
+ * moves the read position right away, so the producer never has to wait for the consumer to
+ * reclaim dropped space. The consumer commits its reads with a compare-and-swap on the read
+ * position: if samples were dropped while it was copying them, they may have been overwritten,
+ * so it discards the copy and reads again from the new position.
+ *
+ * The usable capacity can be smaller than the (power of two) size of the planes.
+ */
+class SampleRingBuffer {
+ public:
+  SampleRingBuffer(int channels, size_t capacity)
+      : _channels(channels),
+        _capacity(capacity),
+        _planeSize(RoundUpToPowerOfTwo(capacity)),
+        _mask(_planeSize - 1) {
+    _samples = std::make_unique<float[]>(_planeSize * channels);
+  }
+
+  [[nodiscard]] int channels() const {
+    return _channels;
+  }
+
+  [[nodiscard]] size_t capacity() const {
+    return _capacity;
+  }
+
+  /**
+   * Number of samples (per channel) that are currently queued. Can be called from any thread,
+   * but the result is only a snapshot if called from neither producer nor consumer.
+   */
+  [[nodiscard]] size_t size() const {
+    auto readPos = _readPos.load(std::memory_order_acquire);
+    auto writePos = _writePos.load(std::memory_order_acquire);
+    return writePos - std::min(readPos, writePos);
+  }
+
+  /**
+   * Number of samples (per channel) that can be written without overwriting queued samples.
+   */
+  [[nodiscard]] size_t writeAvailable() const {
+    return _capacity - size();
+  }
+
+  /**
+   * Producer: Writes up to count samples per channel. The given callback is called once or twice
+   * (if the write wraps around the end of the buffer) with the arguments
+   * (size_t ringOffset, size_t sourceOffset, size_t length) and must fill
+   * plane(channel) + ringOffset for length samples on every channel, starting at sourceOffset
+   * of its own source data. The samples become visible to the consumer after the callback returns.
+   * @return The number of samples per channel that were written.
+   */
+  template <typename Fn>
+  size_t write(size_t count, Fn &&fill) {
+    auto writePos = _writePos.load(std::memory_order_relaxed);
+    auto readPos = _readPos.load(std::memory_order_acquire);
+    count = std::min(count, _capacity - (writePos - readPos));
+    if (count == 0) {
+      return 0;
+    }
+
+    auto offset = writePos & _mask;
+    auto firstLength = std::min(count, _planeSize - offset);
+    fill(offset, size_t{0}, firstLength);
+    if (firstLength < count) {
+      fill(size_t{0}, firstLength, count - firstLength);
+    }
+
+    _writePos.store(writePos + count, std::memory_order_release);
+    return count;
+  }
+
+  /**
+   * Producer: Copies up to count samples from each of the given planes.
+   */
+  size_t writePlanar(const float *const *planes, size_t count) {
+    return write(count, [&](size_t ringOffset, size_t sourceOffset, size_t length) {
+      for (int ch = 0; ch < _channels; ch++) {
+        std::copy_n(planes[ch] + sourceOffset, length, plane(ch) + ringOffset);
+      }
+    });
+  }
+
+  /**
+   * Consumer: Copies up to count samples per channel into the given output planes,
+   * each of which must have room for count samples.
+   * @return The number of samples per channel that were read.
+   */
+  size_t readPlanar(float *const *planes, size_t count) {
+    auto readPos = _readPos.load(std::memory_order_acquire);
+    for (;;) {
+      auto writePos = _writePos.load(std::memory_order_acquire);
+      auto readCount = std::min(count, writePos - readPos);
+      if (readCount == 0) {
+        return 0;
+      }
+
+      auto offset = readPos & _mask;
+      auto firstLength = std::min(readCount, _planeSize - offset);
+      for (int ch = 0; ch < _channels; ch++) {
+        std::copy_n(plane(ch) + offset, firstLength, planes[ch]);
+        std::copy_n(plane(ch), readCount - firstLength, planes[ch] + firstLength);
+      }
+
+      // The copy must be complete before the read position is checked for drops
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (_readPos.compare_exchange_strong(readPos, readPos + readCount,
+                                           std::memory_order_acq_rel,
+                                           std::memory_order_acquire)) {
+        return readCount;
+      }
+      // Samples were dropped during the copy and the producer may have reused their space.
+      // readPos now holds the new read position.
+    }
+  }
+
+  /**
+   * Drops up to count of the oldest queued samples. Can be called from any thread. The space
+   * they occupied can be written immediately.
+   * @return The number of samples per channel that were dropped.
+   */
+  size_t discard(size_t count) {
+    auto readPos = _readPos.load(std::memory_order_acquire);
+    for (;;) {
+      auto writePos = _writePos.load(std::memory_order_acquire);
+      auto dropped = std::min(count, writePos - std::min(readPos, writePos));
+      if (dropped == 0) {
+        return 0;
+      }
+      // The consumer or another thread may have moved the read position in the meantime
+      if (_readPos.compare_exchange_weak(readPos, readPos + dropped, std::memory_order_acq_rel,
+                                         std::memory_order_acquire)) {
+        return dropped;
+      }
+    }
+  }
+
+  /**
+   * Drops all queued samples in constant time. Can be called from any thread, and the whole
+   * capacity can be written immediately afterwards.
+   */
+  void clear() {
+    discard(SIZE_MAX);
+  }
+
+  [[nodiscard]] float *plane(int channel) {
+    return _samples.get() + channel * _planeSize;
+  }
+
+ private:
+  static size_t RoundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  const int _channels;
+  const size_t _capacity;
+  const size_t _planeSize;
+  const size_t _mask;
+  std::unique_ptr<float[]> _samples;
+
+  // Keep producer and consumer positions on separate cache lines to avoid false sharing
+  alignas(64) std::atomic<size_t> _writePos{0};
+  alignas(64) std::atomic<size_t> _readPos{0};
+};
@@ -1,18 +1,11 @@
 
 #include <algorithm>
+#include <chrono>
+#include <thread>
 
+#include "SampleConversion.h"
 #include "SoLoudDynamicSource.h"
 
-static int consumeSamples(std::vector<float> &queue, float *samplesOut,
-                          unsigned int requestedCount) {
-  auto copySamples = std::min<size_t>(requestedCount, queue.size());
-  std::copy(queue.begin(), queue.begin() + copySamples, samplesOut);
-
-  std::copy(queue.begin() + copySamples, queue.end(), queue.begin());
-  queue.resize(queue.size() - copySamples);
-  return copySamples;
-}
-
 class SoLoudDynamicSourceInstance : public SoLoud::AudioSourceInstance {
  public:
   explicit SoLoudDynamicSourceInstance(SoLoudDynamicSource *source) : source(source) {}
@@ -28,47 +21,263 @@ class SoLoudDynamicSourceInstance : public SoLoud::AudioSourceInstance {
       return 0;
     }
 
-    std::lock_guard<std::mutex> lg(source->_mutex);
-    auto copyCount = consumeSamples(source->leftSampleQueue, aBuffer, aSamplesToRead);
-    if (source->mChannels == 2) {
-      consumeSamples(source->rightSampleQueue, aBuffer + aBufferSize, aSamplesToRead);
+    // SoLoud expects the channels one after the other, each aBufferSize samples apart
+    float *planes[SoLoud::MAX_CHANNELS];
+    for (unsigned int ch = 0; ch < mChannels; ch++) {
+      planes[ch] = aBuffer + ch * aBufferSize;
     }
-    return copyCount;
+    auto copyCount = source->_queue.readPlanar(planes, aSamplesToRead);
+    source->recordConsumed(aSamplesToRead, copyCount);
+    return (unsigned int)copyCount;
   }
 
   bool hasEnded() override { return !source || source->_atEnd; }
 
-  SoLoud::result seek(SoLoud::time aSeconds, float *mScratch, unsigned int mScratchSize) override {
-    return SoLoud::NOT_IMPLEMENTED;
+  // Queued samples belong to the old position, so seeking drops them and moves the clock
+  SoLoud::result seek(SoLoud::time aSeconds, [[maybe_unused]] float *mScratch,
+                      [[maybe_unused]] unsigned int mScratchSize) override {
+    if (!source) {
+      return SoLoud::INVALID_PARAMETER;
+    }
+    source->resetPosition(aSeconds);
+    mStreamPosition = aSeconds;
+    return SoLoud::SO_NO_ERROR;
   }
 
   SoLoudDynamicSource *source;
 };
 
-static void appendPlanarSamples(std::vector<float> &queue, float *samples, int count) {
-  auto curSize = queue.size();
-  queue.resize(curSize + count);
-  std::copy(samples, samples + count, queue.begin() + curSize);
-}
-
-SoLoudDynamicSource::SoLoudDynamicSource(int channelCount, int sampleRate) {
+SoLoudDynamicSource::SoLoudDynamicSource(int channelCount, int sampleRate, int capacityMs,
+                                         OverflowPolicy overflowPolicy)
+    : _queue(channelCount, std::max<size_t>(1, (size_t)sampleRate * capacityMs / 1000)),
+      _overflowPolicy(overflowPolicy) {
   mFlags = SINGLE_INSTANCE | INAUDIBLE_TICK;
   mChannels = channelCount;
   mBaseSamplerate = (float)sampleRate;
 }
 
-void SoLoudDynamicSource::pushSamples(float **planes, int sampleCount, bool interleaved) {
+template <typename Fn>
+bool SoLoudDynamicSource::writeSamples(size_t count, Fn &&fill) {
+  auto generation = _flushGeneration.load(std::memory_order_acquire);
+  size_t written = 0;
+  while (written < count) {
+    written += _queue.write(count - written, [&](size_t ringOffset, size_t sourceOffset,
+                                                 size_t length) {
+      fill(ringOffset, written + sourceOffset, length);
+    });
+    // Only the decoder thread writes the high-water mark
+    auto queued = (uint32_t)_queue.size();
+    if (queued > _highWaterMark.load(std::memory_order_relaxed)) {
+      _highWaterMark.store(queued, std::memory_order_relaxed);
+    }
+    if (written == count) {
+      break;
+    }
+    if (_overflowPolicy == OverflowPolicy::DropOldest) {
+      // Dropping makes room right away, even while the audio thread is not playing the source
+      auto dropped = _queue.discard(count - written);
+      _droppedSamples.fetch_add(dropped, std::memory_order_relaxed);
+      continue;
+    }
+    // Wait for the audio thread to make room, unless the queue is flushed or the source is freed
+    // in the meantime: the rest of the samples belong to the old position then, and must not go
+    // into the room made by the flush. Rejected pushes were checked against the exact number of
+    // queued samples up front and never get here.
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    if (_closed || _flushGeneration.load(std::memory_order_acquire) != generation) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SoLoudDynamicSource::writePlanar(const float *const *planes, size_t count) {
+  return writeSamples(count, [&](size_t ringOffset, size_t sourceOffset, size_t length) {
+    for (unsigned int ch = 0; ch < mChannels; ch++) {
+      std::copy_n(planes[ch] + sourceOffset, length, _queue.plane(ch) + ringOffset);
+    }
+  });
+}
+
+// Number of frames converted at once, small enough for the scratch buffers to stay in cache
+static constexpr size_t ConversionChunkSize = 1024;
+
+void SoLoudDynamicSource::convertChunk(SampleFormat format, const void *const *planes,
+                                       bool interleaved, size_t offset, size_t count) {
+  auto channels = (int)mChannels;
+  float *dest[MaxInterleavedChannels];
+  for (int ch = 0; ch < channels; ch++) {
+    dest[ch] = &_planarScratch[ch * ConversionChunkSize];
+  }
+
   if (interleaved) {
-    std::abort();
+    auto interleavedCount = count * channels;
+    auto interleavedOffset = offset * channels;
+    const float *samples;
+    switch (format) {
+      case SampleFormat::Int16:
+        ConvertS16ToFloat(static_cast<const int16_t *>(planes[0]) + interleavedOffset,
+                          _interleavedScratch.data(), interleavedCount);
+        samples = _interleavedScratch.data();
+        break;
+      case SampleFormat::Int32:
+        ConvertS32ToFloat(static_cast<const int32_t *>(planes[0]) + interleavedOffset,
+                          _interleavedScratch.data(), interleavedCount);
+        samples = _interleavedScratch.data();
+        break;
+      default:
+        samples = static_cast<const float *>(planes[0]) + interleavedOffset;
+        break;
+    }
+    DeinterleaveSamples(samples, channels, dest, count);
+    return;
   }
 
-  std::lock_guard<std::mutex> lg(_mutex);
-  appendPlanarSamples(leftSampleQueue, planes[0], sampleCount);
-  if (mChannels == 2) {
-    appendPlanarSamples(rightSampleQueue, planes[1], sampleCount);
+  for (int ch = 0; ch < channels; ch++) {
+    switch (format) {
+      case SampleFormat::Int16:
+        ConvertS16ToFloat(static_cast<const int16_t *>(planes[ch]) + offset, dest[ch], count);
+        break;
+      case SampleFormat::Int32:
+        ConvertS32ToFloat(static_cast<const int32_t *>(planes[ch]) + offset, dest[ch], count);
+        break;
+      default:
+        std::copy_n(static_cast<const float *>(planes[ch]) + offset, count, dest[ch]);
+        break;
+    }
   }
 }
 
+size_t SoLoudDynamicSource::writableSamples() const {
+  auto writable = _queue.writeAvailable();
+  return _resampler ? _resampler->maxInputCount(writable) : writable;
+}
+
+bool SoLoudDynamicSource::pushSamples(SampleFormat format, const void *const *planes,
+                                      int sampleCount, bool interleaved) {
+  // Lets the destructor wait for a push that is blocked on another thread
+  _activePushes++;
+  auto result = !_closed && queueSamples(format, planes, sampleCount, interleaved);
+  _activePushes--;
+  return result;
+}
+
+bool SoLoudDynamicSource::queueSamples(SampleFormat format, const void *const *planes,
+                                       int sampleCount, bool interleaved) {
+  auto channels = (int)mChannels;
+
+  if (_overflowPolicy == OverflowPolicy::Reject) {
+    // Only this thread adds samples, so anything that fits now still fits when it's written
+    auto queuedCount = _resampler ? _resampler->outputCount(sampleCount) : (size_t)sampleCount;
+    if (queuedCount > _queue.writeAvailable()) {
+      return false;
+    }
+  }
+
+  // Float input that needs no resampling can be written to the queue directly
+  if (format == SampleFormat::Float32 && !_resampler) {
+    if (interleaved) {
+      auto samples = static_cast<const float *>(planes[0]);
+      return writeSamples(sampleCount, [&](size_t ringOffset, size_t sourceOffset, size_t length) {
+        float *dest[MaxInterleavedChannels];
+        for (int ch = 0; ch < channels; ch++) {
+          dest[ch] = _queue.plane(ch) + ringOffset;
+        }
+        DeinterleaveSamples(samples + sourceOffset * channels, channels, dest, length);
+      });
+    }
+    return writePlanar(reinterpret_cast<const float *const *>(planes), sampleCount);
+  }
+
+  if (_planarScratch.empty()) {
+    _planarScratch.resize(ConversionChunkSize * channels);
+    _interleavedScratch.resize(ConversionChunkSize * channels);
+  }
+
+  const float *chunkPlanes[MaxInterleavedChannels];
+  for (size_t offset = 0; offset < (size_t)sampleCount; offset += ConversionChunkSize) {
+    auto count = std::min(ConversionChunkSize, sampleCount - offset);
+    convertChunk(format, planes, interleaved, offset, count);
+    for (int ch = 0; ch < channels; ch++) {
+      chunkPlanes[ch] = &_planarScratch[ch * ConversionChunkSize];
+    }
+
+    if (_resampler) {
+      count = _resampler->process(chunkPlanes, count);
+      for (int ch = 0; ch < channels; ch++) {
+        chunkPlanes[ch] = _resampler->output(ch);
+      }
+    }
+    if (!writePlanar(chunkPlanes, count)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SoLoudDynamicSource::setInputSampleRate(int sampleRate) {
+  auto outputRate = (int)mBaseSamplerate;
+  if (sampleRate == outputRate) {
+    _resampler.reset();
+    return true;
+  }
+  if (_resampler && _resampler->inputRate() == sampleRate) {
+    return true;
+  }
+  if (!PolyphaseResampler::IsSupported(sampleRate, outputRate)) {
+    return false;
+  }
+  _resampler = std::make_unique<PolyphaseResampler>((int)mChannels, sampleRate, outputRate);
+  return true;
+}
+
+void SoLoudDynamicSource::recordConsumed(size_t requested, size_t consumed) {
+  // A seek may reset the clock concurrently, so this has to be an atomic add
+  _samplesConsumed.fetch_add(consumed, std::memory_order_acq_rel);
+
+  // Running dry before the first sample arrived (or after a flush) or after the stream
+  // ended is expected
+  if (consumed > 0) {
+    _awaitingData.store(false, std::memory_order_relaxed);
+  } else if (_awaitingData.load(std::memory_order_relaxed)) {
+    return;
+  }
+  if (consumed < requested && !_atEnd) {
+    auto underruns = _underrunCount.load(std::memory_order_relaxed);
+    _underrunTimes[underruns % UnderrunHistorySize].store(clockNanos(), std::memory_order_relaxed);
+    _underrunCount.store(underruns + 1, std::memory_order_release);
+  }
+}
+
+int64_t SoLoudDynamicSource::clockNanos() {
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+void SoLoudDynamicSource::getStats(SoLoudDynamicSourceStats *stats) const {
+  stats->samplesConsumed = samplesConsumed();
+  stats->queuedSamples = (uint32_t)_queue.size();
+  stats->highWaterMark = _highWaterMark.load(std::memory_order_relaxed);
+  stats->underrunCount = _underrunCount.load(std::memory_order_acquire);
+  stats->lastUnderrunTime = 0;
+  if (stats->underrunCount > 0) {
+    auto index = (stats->underrunCount - 1) % UnderrunHistorySize;
+    stats->lastUnderrunTime = _underrunTimes[index].load(std::memory_order_relaxed);
+  }
+  stats->droppedSamples = _droppedSamples.load(std::memory_order_relaxed);
+}
+
+int SoLoudDynamicSource::getUnderrunTimes(int64_t *times, int count) const {
+  auto underruns = _underrunCount.load(std::memory_order_acquire);
+  auto available = (int)std::min<uint32_t>(underruns, UnderrunHistorySize);
+  count = std::min(count, available);
+  for (int i = 0; i < count; i++) {
+    auto index = (underruns - 1 - i) % UnderrunHistorySize;
+    times[i] = _underrunTimes[index].load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
 SoLoud::AudioSourceInstance *SoLoudDynamicSource::createInstance() {
   std::lock_guard<std::mutex> lg(_mutex);
   if (_instance) {
@@ -80,6 +289,13 @@ SoLoud::AudioSourceInstance *SoLoudDynamicSource::createInstance() {
 }
 
 SoLoudDynamicSource::~SoLoudDynamicSource() {
+  // A push blocked on another thread gives up once it sees this, and has to return before the
+  // queue goes away
+  _closed = true;
+  while (_activePushes > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
   std::lock_guard<std::mutex> lg(_mutex);
   if (_instance) {
     _instance->source = nullptr;
@@ -87,3 +303,29 @@ SoLoudDynamicSource::~SoLoudDynamicSource() {
 }
 
 void SoLoudDynamicSource::ended() { _atEnd = true; }
+
+void SoLoudDynamicSource::flush() {
+  // Frees the whole capacity right away, even if the audio thread never reads again
+  _queue.clear();
+  _flushGeneration++;
+  _awaitingData = true;
+  if (_resampler) {
+    _resampler->reset();
+  }
+}
+
+void SoLoudDynamicSource::seek(double seconds) {
+  if (_resampler) {
+    _resampler->reset();
+  }
+  resetPosition(seconds);
+}
+
+void SoLoudDynamicSource::resetPosition(double seconds) {
+  _queue.clear();
+  _flushGeneration++;
+  _awaitingData = true;
+  _samplesConsumed.store((uint64_t)(std::max(0.0, seconds) * mBaseSamplerate),
+                         std::memory_order_release);
+  _atEnd = false;
+}
@@ -1,32 +1,195 @@
-
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <vector>
 
 #include <soloud/soloud.h>
 
+#include "PolyphaseResampler.h"
+#include "SampleConversion.h"
+#include "SampleRingBuffer.h"
+
+class SoLoudDynamicSourceInstance;
+
+/**
+ * Snapshot of the playback position and buffer level of a dynamic source.
+ * Times are in nanoseconds of SoLoudDynamicSource::clockNanos().
+ */
+struct SoLoudDynamicSourceStats {
+  // Samples per channel handed to SoLoud since playback started
+  uint64_t samplesConsumed;
+  // Samples per channel currently queued
+  uint32_t queuedSamples;
+  // Largest number of queued samples per channel observed after a push
+  uint32_t highWaterMark;
+  // Number of times the audio thread requested more samples than were queued
+  uint32_t underrunCount;
+  int64_t lastUnderrunTime;
+  // Samples per channel dropped by the DropOldest overflow policy
+  uint64_t droppedSamples;
+};
+
+/**
+ * What pushSamples does when the queue has reached its capacity.
+ */
+enum class OverflowPolicy : int {
+  // Wait on the pushing thread until the audio thread has consumed enough samples. The push gives
+  // up and returns false if the source is flushed, seeked or freed while it waits.
+  Block = 0,
+  // Discard the oldest queued samples to make room, without ever waiting
+  DropOldest,
+  // Reject the entire push if it doesn't fit
+  Reject
+};
+
 class SoLoudDynamicSource : public SoLoud::AudioSource {
   friend class SoLoudDynamicSourceInstance;
 
  public:
-  SoLoudDynamicSource(int channelCount, int sampleRate);
+  /**
+   * Default amount of audio that can be queued before the overflow policy applies.
+   */
+  static constexpr int DefaultCapacityMs = 10000;
+
+  /**
+   * @param channelCount Between 1 and MaxInterleavedChannels (7.1).
+   * @param capacityMs Maximum amount of queued audio. This bounds both memory usage and latency.
+   */
+  SoLoudDynamicSource(int channelCount, int sampleRate, int capacityMs = DefaultCapacityMs,
+                      OverflowPolicy overflowPolicy = OverflowPolicy::Block);
+  /**
+   * May run while a push is blocked on another thread: the push is cancelled, and the destructor
+   * waits for it to return.
+   */
   ~SoLoudDynamicSource() override;
 
-  void pushSamples(float* planes[], int sampleCount, bool interleaved);
+  /**
+   * Queues sampleCount samples per channel. If interleaved is true, planes[0] points to
+   * sampleCount frames of interleaved samples, otherwise planes holds one plane per channel.
+   */
+  bool pushSamples(float* planes[], int sampleCount, bool interleaved) {
+    return pushSamples(SampleFormat::Float32, reinterpret_cast<const void* const*>(planes),
+                       sampleCount, interleaved);
+  }
+
+  /**
+   * Same as above, but converts samples of the given format to float on the calling thread
+   * (and resamples them if an input sample rate has been set).
+   * @return false if the samples were rejected because of OverflowPolicy::Reject, or if a push
+   * blocked by OverflowPolicy::Block was cancelled before all samples were queued.
+   */
+  bool pushSamples(SampleFormat format, const void* const* planes, int sampleCount,
+                   bool interleaved);
+
+  /**
+   * Sets the sample rate of pushed samples. If it differs from the rate this source was
+   * created with, samples are resampled with a polyphase filter before they're queued.
+   * Must be called from the thread that pushes samples.
+   * @return false if the ratio between the rates is not supported.
+   */
+  bool setInputSampleRate(int sampleRate);
+
+  void setOverflowPolicy(OverflowPolicy policy) {
+    _overflowPolicy = policy;
+  }
+
+  /**
+   * Number of samples per channel (at the input sample rate) that can currently be pushed
+   * without triggering the overflow policy. Must be called from the thread that pushes samples.
+   */
+  [[nodiscard]] size_t writableSamples() const;
 
   void ended();
 
+  /**
+   * Drops all queued samples in constant time, i.e. when a cutscene is skipped. The playback
+   * clock keeps running from its current value. Must be called from the pushing thread,
+   * since it also resets the state of the resampler.
+   */
+  void flush();
+
+  /**
+   * Flushes the queue and moves the playback clock (samplesConsumed) to the given position.
+   * Samples pushed afterwards are assumed to start at that position.
+   */
+  void seek(double seconds);
+
   SoLoud::AudioSourceInstance* createInstance() override;
 
+  /**
+   * The following can be called from any thread and never block.
+   */
+  [[nodiscard]] uint64_t samplesConsumed() const {
+    return _samplesConsumed.load(std::memory_order_acquire);
+  }
+
+  void getStats(SoLoudDynamicSourceStats* stats) const;
+
+  /**
+   * Copies the times of the most recent underruns (newest first) into times.
+   * At most UnderrunHistorySize underrun times are retained.
+   * @return The number of times that were copied.
+   */
+  int getUnderrunTimes(int64_t* times, int count) const;
+
+  static constexpr int UnderrunHistorySize = 16;
+
+  /**
+   * Monotonic clock used for telemetry timestamps.
+   */
+  static int64_t clockNanos();
+
  private:
+  bool queueSamples(SampleFormat format, const void* const* planes, int sampleCount,
+                    bool interleaved);
+
+  // Returns false if a blocked write was cancelled
+  template <typename Fn>
+  bool writeSamples(size_t count, Fn&& fill);
+
+  bool writePlanar(const float* const* planes, size_t count);
+
+  // Called on the audio thread after samples have been read from the queue
+  void recordConsumed(size_t requested, size_t consumed);
+
+  // Drops queued samples and moves the clock, but leaves the resampler alone.
+  // Safe to call from any thread.
+  void resetPosition(double seconds);
+
+  // Converts a chunk of input into planar floats in _planarScratch
+  void convertChunk(SampleFormat format, const void* const* planes, bool interleaved,
+                    size_t offset, size_t count);
+
+  // Only guards the instance pointer, never taken on the audio thread
   std::mutex _mutex;
 
   SoLoudDynamicSourceInstance* _instance = nullptr;
 
-  // Split queues per channel, inefficient but dumb and simple
-  std::vector<float> leftSampleQueue;
-  std::vector<float> rightSampleQueue;
+  // Written by the decoder thread, read by the audio thread
+  SampleRingBuffer _queue;
+
+  std::atomic<bool> _atEnd{false};
+  // Set until the first samples have been played after creation or a flush
+  std::atomic<bool> _awaitingData{true};
+
+  // Cancel blocked pushes: incremented by every flush or seek, and set once the source is freed
+  std::atomic<uint32_t> _flushGeneration{0};
+  std::atomic<bool> _closed{false};
+  std::atomic<int> _activePushes{0};
+
+  // Telemetry, written by either the audio thread or the decoder thread
+  std::atomic<uint64_t> _samplesConsumed{0};
+  std::atomic<uint32_t> _highWaterMark{0};
+  std::atomic<uint32_t> _underrunCount{0};
+  std::atomic<int64_t> _underrunTimes[UnderrunHistorySize]{};
+  std::atomic<uint64_t> _droppedSamples{0};
+
+  std::atomic<OverflowPolicy> _overflowPolicy;
 
-  bool _atEnd = false;
+  // State only used by the decoder thread for format and rate conversion
+  std::unique_ptr<PolyphaseResampler> _resampler;
+  std::vector<float> _interleavedScratch;
+  std::vector<float> _planarScratch;
 };
@@ -1,16 +1,85 @@
 
+#include "SampleConversion.h"
 #include "SoLoudDynamicSource.h"
 #include "utils.h"
 
 NATIVE_API SoLoudDynamicSource *SoLoudDynamicSource_Create(int channelCount, int sampleRate) {
+  if (channelCount < 1 || channelCount > MaxInterleavedChannels) {
+    return nullptr;
+  }
   return new SoLoudDynamicSource(channelCount, sampleRate);
 }
 
-NATIVE_API void SoLoudDynamicSource_PushSamples(SoLoudDynamicSource *source,
-                                                float *planes[],
-                                                int sampleCount,
-                                                int interleaved) {
-  source->pushSamples(planes, sampleCount, interleaved != 0);
+NATIVE_API SoLoudDynamicSource *SoLoudDynamicSource_CreateWithCapacity(
+    int channelCount, int sampleRate, int capacityMs, OverflowPolicy overflowPolicy) {
+  if (channelCount < 1 || channelCount > MaxInterleavedChannels || capacityMs <= 0) {
+    return nullptr;
+  }
+  return new SoLoudDynamicSource(channelCount, sampleRate, capacityMs, overflowPolicy);
+}
+
+NATIVE_API ApiBool SoLoudDynamicSource_PushSamples(SoLoudDynamicSource *source,
+                                                   float *planes[],
+                                                   int sampleCount,
+                                                   int interleaved) {
+  return source->pushSamples(planes, sampleCount, interleaved != 0);
+}
+
+NATIVE_API ApiBool SoLoudDynamicSource_PushSamplesS16(SoLoudDynamicSource *source,
+                                                      const int16_t *planes[],
+                                                      int sampleCount,
+                                                      int interleaved) {
+  return source->pushSamples(SampleFormat::Int16, reinterpret_cast<const void *const *>(planes),
+                             sampleCount, interleaved != 0);
+}
+
+NATIVE_API ApiBool SoLoudDynamicSource_PushSamplesS32(SoLoudDynamicSource *source,
+                                                      const int32_t *planes[],
+                                                      int sampleCount,
+                                                      int interleaved) {
+  return source->pushSamples(SampleFormat::Int32, reinterpret_cast<const void *const *>(planes),
+                             sampleCount, interleaved != 0);
+}
+
+NATIVE_API ApiBool SoLoudDynamicSource_SetInputSampleRate(SoLoudDynamicSource *source,
+                                                         int sampleRate) {
+  return source->setInputSampleRate(sampleRate);
+}
+
+NATIVE_API void SoLoudDynamicSource_Flush(SoLoudDynamicSource *source) {
+  source->flush();
+}
+
+NATIVE_API void SoLoudDynamicSource_Seek(SoLoudDynamicSource *source, double seconds) {
+  source->seek(seconds);
+}
+
+NATIVE_API void SoLoudDynamicSource_SetOverflowPolicy(SoLoudDynamicSource *source,
+                                                      OverflowPolicy policy) {
+  source->setOverflowPolicy(policy);
+}
+
+NATIVE_API uint32_t SoLoudDynamicSource_GetWritableSamples(SoLoudDynamicSource *source) {
+  return (uint32_t)source->writableSamples();
+}
+
+NATIVE_API uint64_t SoLoudDynamicSource_GetSamplesConsumed(SoLoudDynamicSource *source) {
+  return source->samplesConsumed();
+}
+
+NATIVE_API void SoLoudDynamicSource_GetStats(SoLoudDynamicSource *source,
+                                             SoLoudDynamicSourceStats *stats) {
+  source->getStats(stats);
+}
+
+NATIVE_API int SoLoudDynamicSource_GetUnderrunTimes(SoLoudDynamicSource *source,
+                                                    int64_t *times,
+                                                    int count) {
+  return source->getUnderrunTimes(times, count);
+}
+
+NATIVE_API int64_t SoLoudDynamicSource_GetClock() {
+  return SoLoudDynamicSource::clockNanos();
 }
 
 NATIVE_API void SoLoudDynamicSource_Free(SoLoudDynamicSource *source) {
@@ -0,0 +1,154 @@
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "BufferPool.h"
+
+namespace {
+
+constexpr int SizeClassCount = 15;
+static_assert(BufferPool::MinClassSize << (SizeClassCount - 1) == BufferPool::MaxClassSize);
+
+int SizeClassFor(size_t size) {
+  if (size > BufferPool::MaxClassSize) {
+    return -1;
+  }
+  int sizeClass = 0;
+  while ((BufferPool::MinClassSize << sizeClass) < size) {
+    sizeClass++;
+  }
+  return sizeClass;
+}
+
+size_t CapacityFor(int sizeClass, size_t size) {
+  if (sizeClass < 0) {
+    // Round oversized buffers up to the alignment, so that SIMD loops can overrun the size
+    return (size + BufferPool::Alignment - 1) & ~(BufferPool::Alignment - 1);
+  }
+  return BufferPool::MinClassSize << sizeClass;
+}
+
+uint8_t *AllocateData(size_t capacity) {
+  return static_cast<uint8_t *>(
+      ::operator new(capacity, std::align_val_t(BufferPool::Alignment)));
+}
+
+void FreeData(uint8_t *data) {
+  ::operator delete(data, std::align_val_t(BufferPool::Alignment));
+}
+
+class Pools {
+ public:
+  // Moving storage between buffers in resize() does not count as acquiring or releasing a buffer
+  PooledBuffer *acquire(size_t size, bool counted = true) {
+    auto sizeClass = SizeClassFor(size);
+    auto capacity = CapacityFor(sizeClass, size);
+
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+      _stats.acquired += counted ? 1 : 0;
+      _stats.bytesInUse += capacity;
+      _stats.peakBytesInUse = std::max(_stats.peakBytesInUse, _stats.bytesInUse);
+      if (sizeClass >= 0 && !_free[sizeClass].empty()) {
+        auto buffer = _free[sizeClass].back();
+        _free[sizeClass].pop_back();
+        _stats.reused += counted ? 1 : 0;
+        _stats.bytesPooled -= capacity;
+        buffer->size = size;
+        return buffer;
+      }
+    }
+
+    // Allocate outside the lock, large allocations can take a while
+    return new PooledBuffer{AllocateData(capacity), size, capacity, sizeClass};
+  }
+
+  void resize(PooledBuffer *buffer, size_t size) {
+    if (size <= buffer->capacity) {
+      buffer->size = size;
+      return;
+    }
+
+    // Move the contents into a larger buffer, and give the old storage to the pool
+    auto larger = acquire(size, false);
+    memcpy(larger->data, buffer->data, buffer->size);
+    std::swap(*buffer, *larger);
+    release(larger, false);
+  }
+
+  void release(PooledBuffer *buffer, bool counted = true) {
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+      _stats.released += counted ? 1 : 0;
+      _stats.bytesInUse -= buffer->capacity;
+      auto sizeClass = buffer->sizeClass;
+      if (sizeClass >= 0 && _free[sizeClass].size() < BufferPool::MaxPooledPerClass &&
+          _stats.bytesPooled + buffer->capacity <= BufferPool::MaxPooledBytes) {
+        _free[sizeClass].push_back(buffer);
+        _stats.bytesPooled += buffer->capacity;
+        return;
+      }
+    }
+
+    FreeData(buffer->data);
+    delete buffer;
+  }
+
+  BufferPoolStats stats() {
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _stats;
+  }
+
+  void trim() {
+    std::vector<PooledBuffer *> buffers;
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+      for (auto &pool : _free) {
+        buffers.insert(buffers.end(), pool.begin(), pool.end());
+        pool.clear();
+      }
+      _stats.bytesPooled = 0;
+    }
+
+    for (auto buffer : buffers) {
+      FreeData(buffer->data);
+      delete buffer;
+    }
+  }
+
+ private:
+  std::mutex _mutex;
+  std::vector<PooledBuffer *> _free[SizeClassCount];
+  BufferPoolStats _stats{};
+};
+
+// Intentionally never destroyed, see Logger.cpp
+Pools &GetPools() {
+  static auto pools = new Pools;
+  return *pools;
+}
+
+}  // namespace
+
+PooledBuffer *BufferPool::Acquire(size_t size) {
+  return GetPools().acquire(size);
+}
+
+void BufferPool::Resize(PooledBuffer *buffer, size_t size) {
+  GetPools().resize(buffer, size);
+}
+
+void BufferPool::Release(PooledBuffer *buffer) {
+  GetPools().release(buffer);
+}
+
+BufferPoolStats BufferPool::GetStats() {
+  return GetPools().stats();
+}
+
+void BufferPool::Trim() {
+  GetPools().trim();
+}
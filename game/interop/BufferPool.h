@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * A block of native memory handed out by BufferPool. The data is aligned to
+ * BufferPool::Alignment bytes.
+ */
+struct PooledBuffer {
+  uint8_t *data;
+  size_t size;      // Number of bytes in use
+  size_t capacity;  // Number of bytes allocated
+  int sizeClass;    // -1 if the buffer is too large to be pooled
+};
+
+struct BufferPoolStats {
+  uint64_t acquired;        // Number of buffers handed out
+  uint64_t reused;          // Number of buffers handed out that came from a pool
+  uint64_t released;        // Number of buffers given back
+  uint64_t bytesInUse;      // Capacity of the buffers that are currently handed out
+  uint64_t peakBytesInUse;  // Highest value of bytesInUse so far
+  uint64_t bytesPooled;     // Capacity of the buffers that are waiting in the pools
+};
+
+/**
+ * Process-wide pools of output buffers for decoders, so that streaming data does not allocate and
+ * free memory for every chunk. Capacities are rounded up to powers of two between MinClassSize
+ * and MaxClassSize, and released buffers are kept for the next request of the same size class.
+ * Larger buffers are allocated and freed directly.
+ *
+ * All functions are thread-safe, but a single buffer must not be used by multiple threads at once.
+ */
+class BufferPool {
+ public:
+  static constexpr size_t Alignment = 64;
+  static constexpr size_t MinClassSize = 4 * 1024;
+  static constexpr size_t MaxClassSize = 64 * 1024 * 1024;
+
+  /**
+   * Released buffers beyond these limits are freed instead of being pooled.
+   */
+  static constexpr size_t MaxPooledPerClass = 8;
+  static constexpr size_t MaxPooledBytes = 128 * 1024 * 1024;
+
+  /**
+   * Returns a buffer whose size is the requested size. The contents are undefined.
+   */
+  static PooledBuffer *Acquire(size_t size);
+
+  /**
+   * Changes the size of a buffer, keeping its contents up to the smaller of the old and new size.
+   * The data pointer changes if the capacity of the buffer is exceeded.
+   */
+  static void Resize(PooledBuffer *buffer, size_t size);
+
+  /**
+   * Gives a buffer back to the pool. The buffer must not be used afterwards.
+   */
+  static void Release(PooledBuffer *buffer);
+
+  static BufferPoolStats GetStats();
+
+  /**
+   * Frees all buffers that are waiting in the pools.
+   */
+  static void Trim();
+};
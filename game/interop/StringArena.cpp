@@ -0,0 +1,50 @@
+
+#include <algorithm>
+#include <cstring>
+
+#include "StringArena.h"
+#include "string_interop.h"
+
+char16_t *StringArena::copy(std::wstring_view str) {
+  auto length = utf16Length(str);
+  auto result =
+      static_cast<char16_t *>(allocate((length + 1) * sizeof(char16_t), alignof(char16_t)));
+  toUtf16(str, result);
+  result[length] = 0;
+  return result;
+}
+
+char *StringArena::copy(std::string_view str) {
+  auto result = static_cast<char *>(allocate(str.length() + 1, 1));
+  memcpy(result, str.data(), str.length());
+  result[str.length()] = 0;
+  return result;
+}
+
+void *StringArena::allocate(size_t size, size_t alignment) {
+  while (_current < _chunks.size()) {
+    auto &chunk = _chunks[_current];
+    auto offset = (_offset + alignment - 1) & ~(alignment - 1);
+    if (offset + size <= chunk.size) {
+      _offset = offset + size;
+      return chunk.data.get() + offset;
+    }
+    _current++;
+    _offset = 0;
+  }
+
+  // Oversized allocations get a chunk of their own
+  auto chunkSize = std::max(_chunkSize, size);
+  _chunks.push_back({std::make_unique<std::byte[]>(chunkSize), chunkSize});
+  _current = _chunks.size() - 1;
+  _offset = size;
+  return _chunks.back().data.get();
+}
+
+size_t StringArena::bytesUsed() const {
+  size_t result = _offset;
+  for (size_t i = 0; i < _current && i < _chunks.size(); i++) {
+    result += _chunks[i].size;
+  }
+  return result;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/**
+ * Bump allocator for strings that are returned to managed code. Instead of allocating each
+ * string separately with the interop allocator (which managed code then has to free again),
+ * strings are copied into large chunks that are released all at once by reset(), i.e. once
+ * per frame or at the end of a scope.
+ *
+ * Managed code must copy the strings before the arena is reset. An arena is not thread-safe.
+ */
+class StringArena {
+ public:
+  static constexpr size_t DefaultChunkSize = 64 * 1024;
+
+  explicit StringArena(size_t chunkSize = DefaultChunkSize) : _chunkSize(chunkSize) {}
+
+  /**
+   * Copies a string as null-terminated UTF-16.
+   */
+  char16_t *copy(std::wstring_view str);
+
+  /**
+   * Copies a null-terminated narrow string.
+   */
+  char *copy(std::string_view str);
+
+  void *allocate(size_t size, size_t alignment);
+
+  /**
+   * Invalidates all strings that have been copied so far. Keeps the allocated chunks for reuse.
+   */
+  void reset() {
+    _current = 0;
+    _offset = 0;
+  }
+
+  /**
+   * Number of bytes used since the last reset, including space left unused at the end of chunks.
+   */
+  [[nodiscard]] size_t bytesUsed() const;
+
+ private:
+  struct Chunk {
+    std::unique_ptr<std::byte[]> data;
+    size_t size;
+  };
+
+  const size_t _chunkSize;
+  std::vector<Chunk> _chunks;
+  size_t _current = 0;  // Index of the chunk that is being filled
+  size_t _offset = 0;   // Offset into the current chunk
+};
@@ -0,0 +1,19 @@
+
+#include "../utils.h"
+#include "StringArena.h"
+
+NATIVE_API StringArena *StringArena_Create() {
+  return new StringArena();
+}
+
+NATIVE_API void StringArena_Reset(StringArena *arena) {
+  arena->reset();
+}
+
+NATIVE_API size_t StringArena_GetBytesUsed(StringArena *arena) {
+  return arena->bytesUsed();
+}
+
+NATIVE_API void StringArena_Free(StringArena *arena) {
+  delete arena;
+}
@@ -0,0 +1,318 @@
+
+#include <cstdint>
+#include <cstring>
+
+#include "Transcoding.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRANSCODING_SSE
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define TRANSCODING_NEON
+#include <arm_neon.h>
+#endif
+
+static constexpr uint32_t ReplacementCharacter = 0xFFFD;
+
+// Code points of Windows-1252 bytes 0x80-0x9F. Unassigned bytes map to the C1 control
+// characters, like MultiByteToWideChar does.
+static constexpr char16_t Windows1252High[32] = {
+    0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0160,
+    0x2039, 0x0152, 0x008D, 0x017D, 0x008F, 0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022,
+    0x2013, 0x2014, 0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178};
+
+/*
+ * ASCII fast paths. Each copies the longest ASCII prefix of the input to the output and returns
+ * its length.
+ */
+
+static size_t CopyAscii(const uint8_t *in, size_t length, uint8_t *out) {
+  size_t i = 0;
+#if defined(TRANSCODING_SSE)
+  for (; i + 16 <= length; i += 16) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    if (_mm_movemask_epi8(v) != 0) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), v);
+  }
+#elif defined(TRANSCODING_NEON)
+  for (; i + 16 <= length; i += 16) {
+    auto v = vld1q_u8(in + i);
+    if (vmaxvq_u8(v) >= 0x80) {
+      break;
+    }
+    vst1q_u8(out + i, v);
+  }
+#endif
+  for (; i < length && in[i] < 0x80; i++) {
+    out[i] = in[i];
+  }
+  return i;
+}
+
+static size_t CopyAscii(const uint8_t *in, size_t length, char16_t *out) {
+  size_t i = 0;
+#if defined(TRANSCODING_SSE)
+  auto zero = _mm_setzero_si128();
+  for (; i + 16 <= length; i += 16) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    if (_mm_movemask_epi8(v) != 0) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_unpacklo_epi8(v, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 8), _mm_unpackhi_epi8(v, zero));
+  }
+#elif defined(TRANSCODING_NEON)
+  for (; i + 16 <= length; i += 16) {
+    auto v = vld1q_u8(in + i);
+    if (vmaxvq_u8(v) >= 0x80) {
+      break;
+    }
+    vst1q_u16(reinterpret_cast<uint16_t *>(out + i), vmovl_u8(vget_low_u8(v)));
+    vst1q_u16(reinterpret_cast<uint16_t *>(out + i + 8), vmovl_u8(vget_high_u8(v)));
+  }
+#endif
+  for (; i < length && in[i] < 0x80; i++) {
+    out[i] = in[i];
+  }
+  return i;
+}
+
+static size_t CopyAscii(const char16_t *in, size_t length, uint8_t *out) {
+  size_t i = 0;
+#if defined(TRANSCODING_SSE)
+  auto nonAscii = _mm_set1_epi16((short)0xFF80);
+  for (; i + 16 <= length; i += 16) {
+    auto lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    auto hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i + 8));
+    auto highBits = _mm_and_si128(_mm_or_si128(lo, hi), nonAscii);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(highBits, _mm_setzero_si128())) != 0xFFFF) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(lo, hi));
+  }
+#elif defined(TRANSCODING_NEON)
+  for (; i + 16 <= length; i += 16) {
+    auto lo = vld1q_u16(reinterpret_cast<const uint16_t *>(in + i));
+    auto hi = vld1q_u16(reinterpret_cast<const uint16_t *>(in + i + 8));
+    if (vmaxvq_u16(vorrq_u16(lo, hi)) >= 0x80) {
+      break;
+    }
+    vst1q_u8(out + i, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+  }
+#endif
+  for (; i < length && in[i] < 0x80; i++) {
+    out[i] = (uint8_t)in[i];
+  }
+  return i;
+}
+
+static size_t CopyAscii(const char16_t *in, size_t length, char16_t *out) {
+  size_t i = 0;
+  for (; i < length && in[i] < 0x80; i++) {
+    out[i] = in[i];
+  }
+  return i;
+}
+
+/*
+ * Decoders read one code point starting at in[pos] and advance pos past it.
+ */
+
+static uint32_t DecodeUtf8(const uint8_t *in, size_t length, size_t &pos) {
+  auto lead = in[pos++];
+  if (lead < 0x80) {
+    return lead;
+  }
+
+  int continuationBytes;
+  uint32_t codePoint;
+  uint32_t minimum;
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    continuationBytes = 1;
+    codePoint = lead & 0x1F;
+    minimum = 0x80;
+  } else if (lead >= 0xE0 && lead <= 0xEF) {
+    continuationBytes = 2;
+    codePoint = lead & 0x0F;
+    minimum = 0x800;
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    continuationBytes = 3;
+    codePoint = lead & 0x07;
+    minimum = 0x10000;
+  } else {
+    return ReplacementCharacter;
+  }
+
+  for (int i = 0; i < continuationBytes; i++) {
+    if (pos >= length || (in[pos] & 0xC0) != 0x80) {
+      // Resume decoding at the offending byte
+      return ReplacementCharacter;
+    }
+    codePoint = (codePoint << 6) | (in[pos++] & 0x3F);
+  }
+
+  auto surrogate = codePoint >= 0xD800 && codePoint < 0xE000;
+  if (codePoint < minimum || codePoint > 0x10FFFF || surrogate) {
+    return ReplacementCharacter;
+  }
+  return codePoint;
+}
+
+static uint32_t DecodeUtf16(const char16_t *in, size_t length, size_t &pos) {
+  uint32_t unit = in[pos++];
+  if (unit < 0xD800 || unit >= 0xE000) {
+    return unit;
+  }
+  if (unit < 0xDC00 && pos < length && in[pos] >= 0xDC00 && in[pos] < 0xE000) {
+    return 0x10000 + ((unit - 0xD800) << 10) + (in[pos++] - 0xDC00);
+  }
+  return ReplacementCharacter;
+}
+
+static uint32_t DecodeWindows1252(const uint8_t *in, size_t /* length */, size_t &pos) {
+  auto ch = in[pos++];
+  if (ch >= 0x80 && ch < 0xA0) {
+    return Windows1252High[ch - 0x80];
+  }
+  return ch;
+}
+
+/*
+ * Encoders write one code point and return the number of code units written.
+ */
+
+static size_t EncodeUtf8(uint32_t codePoint, uint8_t *out) {
+  if (codePoint < 0x80) {
+    out[0] = (uint8_t)codePoint;
+    return 1;
+  } else if (codePoint < 0x800) {
+    out[0] = (uint8_t)(0xC0 | (codePoint >> 6));
+    out[1] = (uint8_t)(0x80 | (codePoint & 0x3F));
+    return 2;
+  } else if (codePoint < 0x10000) {
+    out[0] = (uint8_t)(0xE0 | (codePoint >> 12));
+    out[1] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+    out[2] = (uint8_t)(0x80 | (codePoint & 0x3F));
+    return 3;
+  }
+  out[0] = (uint8_t)(0xF0 | (codePoint >> 18));
+  out[1] = (uint8_t)(0x80 | ((codePoint >> 12) & 0x3F));
+  out[2] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+  out[3] = (uint8_t)(0x80 | (codePoint & 0x3F));
+  return 4;
+}
+
+static size_t EncodeUtf16(uint32_t codePoint, char16_t *out) {
+  if (codePoint < 0x10000) {
+    out[0] = (char16_t)codePoint;
+    return 1;
+  }
+  codePoint -= 0x10000;
+  out[0] = (char16_t)(0xD800 + (codePoint >> 10));
+  out[1] = (char16_t)(0xDC00 + (codePoint & 0x3FF));
+  return 2;
+}
+
+static size_t EncodeWindows1252(uint32_t codePoint, uint8_t *out) {
+  if (codePoint < 0x80 || (codePoint >= 0xA0 && codePoint <= 0xFF)) {
+    out[0] = (uint8_t)codePoint;
+    return 1;
+  }
+  for (int i = 0; i < 32; i++) {
+    if (Windows1252High[i] == codePoint) {
+      out[0] = (uint8_t)(0x80 + i);
+      return 1;
+    }
+  }
+  out[0] = '?';
+  return 1;
+}
+
+template <typename In, typename Out, uint32_t (*Decode)(const In *, size_t, size_t &),
+          size_t (*Encode)(uint32_t, Out *)>
+static size_t TranscodeImpl(const void *input, size_t length, void *output) {
+  auto in = static_cast<const In *>(input);
+  auto out = static_cast<Out *>(output);
+  size_t pos = 0;
+  size_t written = 0;
+  while (pos < length) {
+    auto ascii = CopyAscii(in + pos, length - pos, out + written);
+    pos += ascii;
+    written += ascii;
+    if (pos < length) {
+      written += Encode(Decode(in, length, pos), out + written);
+    }
+  }
+  return written;
+}
+
+size_t MaxTranscodedLength(TextEncoding /* from */, TextEncoding to, size_t length) {
+  // A single UTF-16 code unit or Windows-1252 byte may need up to three UTF-8 bytes, and a
+  // single invalid UTF-8 byte becomes a three-byte replacement character. Every other
+  // combination produces at most one code unit per input code unit.
+  if (to == TextEncoding::Utf8) {
+    return length * 3;
+  }
+  return length;
+}
+
+size_t Transcode(TextEncoding from, TextEncoding to, const void *input, size_t length,
+                 void *output) {
+  switch (from) {
+    case TextEncoding::Utf8:
+      switch (to) {
+        case TextEncoding::Utf8:
+          return TranscodeImpl<uint8_t, uint8_t, DecodeUtf8, EncodeUtf8>(input, length, output);
+        case TextEncoding::Utf16:
+          return TranscodeImpl<uint8_t, char16_t, DecodeUtf8, EncodeUtf16>(input, length, output);
+        case TextEncoding::Windows1252:
+          return TranscodeImpl<uint8_t, uint8_t, DecodeUtf8, EncodeWindows1252>(input, length,
+                                                                                output);
+      }
+      break;
+    case TextEncoding::Utf16:
+      switch (to) {
+        case TextEncoding::Utf8:
+          return TranscodeImpl<char16_t, uint8_t, DecodeUtf16, EncodeUtf8>(input, length, output);
+        case TextEncoding::Utf16:
+          return TranscodeImpl<char16_t, char16_t, DecodeUtf16, EncodeUtf16>(input, length,
+                                                                             output);
+        case TextEncoding::Windows1252:
+          return TranscodeImpl<char16_t, uint8_t, DecodeUtf16, EncodeWindows1252>(input, length,
+                                                                                  output);
+      }
+      break;
+    case TextEncoding::Windows1252:
+      switch (to) {
+        case TextEncoding::Utf8:
+          return TranscodeImpl<uint8_t, uint8_t, DecodeWindows1252, EncodeUtf8>(input, length,
+                                                                                output);
+        case TextEncoding::Utf16:
+          return TranscodeImpl<uint8_t, char16_t, DecodeWindows1252, EncodeUtf16>(input, length,
+                                                                                  output);
+        case TextEncoding::Windows1252:
+          memcpy(output, input, length);
+          return length;
+      }
+      break;
+  }
+  return 0;
+}
+
+std::wstring Windows1252ToWide(std::string_view text) {
+  std::wstring result(text.length(), L'\0');
+  if constexpr (sizeof(wchar_t) == sizeof(char16_t)) {
+    Transcode(TextEncoding::Windows1252, TextEncoding::Utf16, text.data(), text.length(),
+              result.data());
+  } else {
+    // Windows-1252 only contains characters from the BMP, so UTF-32 is just wider
+    for (size_t i = 0; i < text.length(); i++) {
+      size_t pos = i;
+      result[i] = (wchar_t)DecodeWindows1252(reinterpret_cast<const uint8_t *>(text.data()),
+                                             text.length(), pos);
+    }
+  }
+  return result;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * Encodings supported by the transcoding functions. Lengths are always given in code units of
+ * the respective encoding (bytes for UTF-8 and Windows-1252, char16_t for UTF-16).
+ */
+enum class TextEncoding : int { Utf8 = 0, Utf16 = 1, Windows1252 = 2 };
+
+/**
+ * Upper bound for the number of code units that transcoding length code units can produce.
+ */
+size_t MaxTranscodedLength(TextEncoding from, TextEncoding to, size_t length);
+
+/**
+ * Converts text between encodings. Runs of ASCII are converted 16 characters at a time using
+ * SSE2 or NEON where available.
+ *
+ * Invalid input (malformed UTF-8, unpaired surrogates) is replaced with U+FFFD, and characters
+ * that Windows-1252 can not represent are replaced with '?'.
+ *
+ * @param output Must have room for MaxTranscodedLength(from, to, length) code units.
+ * @return The number of code units written to output.
+ */
+size_t Transcode(TextEncoding from, TextEncoding to, const void *input, size_t length,
+                 void *output);
+
+/**
+ * Decodes the legacy 8-bit text used by the game's data files.
+ */
+std::wstring Windows1252ToWide(std::string_view text);
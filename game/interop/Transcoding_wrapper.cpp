@@ -0,0 +1,79 @@
+
+#include <climits>
+#include <cstdint>
+
+#include "../utils.h"
+#include "Transcoding.h"
+
+// The maximum output length grows linearly with the input length, and can exceed the range of
+// int for UTF-8 output, so it is computed in 64 bits
+static uint64_t MaxLength64(TextEncoding from, TextEncoding to, int length) {
+  return (uint64_t)length * MaxTranscodedLength(from, to, 1);
+}
+
+/**
+ * @return The capacity needed to convert length code units, or -1 if length is negative or
+ * the capacity would not fit into an int.
+ */
+NATIVE_API int Transcode_GetMaxLength(TextEncoding from, TextEncoding to, int length) {
+  if (length < 0) {
+    return -1;
+  }
+  auto maxLength = MaxLength64(from, to, length);
+  return maxLength > INT_MAX ? -1 : (int)maxLength;
+}
+
+/**
+ * Converts a single string.
+ * @return The number of code units written, or -1 if length is negative or the output may be
+ * too small, which is the case if its capacity is below Transcode_GetMaxLength.
+ */
+NATIVE_API int Transcode_Convert(TextEncoding from, TextEncoding to, const void *input,
+                                 int length, void *output, int outputCapacity) {
+  if (length < 0 || (int64_t)outputCapacity < (int64_t)MaxLength64(from, to, length)) {
+    return -1;
+  }
+  return (int)Transcode(from, to, input, length, output);
+}
+
+/**
+ * Converts a table of count strings in one call. String i spans the code units
+ * [inputOffsets[i], inputOffsets[i + 1]) of input, so inputOffsets has count + 1 entries.
+ * The converted strings are written back-to-back to output, and their offsets are written to
+ * outputOffsets in the same way.
+ * @return The total number of code units written, or -1 if the offsets are negative or not in
+ * ascending order, or if the output may be too small.
+ */
+NATIVE_API int Transcode_ConvertBatch(TextEncoding from, TextEncoding to, const void *input,
+                                      const int *inputOffsets, int count, void *output,
+                                      int outputCapacity, int *outputOffsets) {
+  auto inputUnitSize = from == TextEncoding::Utf16 ? sizeof(char16_t) : 1;
+  auto outputUnitSize = to == TextEncoding::Utf16 ? sizeof(char16_t) : 1;
+  auto in = static_cast<const uint8_t *>(input);
+  auto out = static_cast<uint8_t *>(output);
+
+  if (count < 0 || inputOffsets[0] < 0) {
+    return -1;
+  }
+  for (int i = 0; i < count; i++) {
+    if (inputOffsets[i + 1] < inputOffsets[i]) {
+      return -1;
+    }
+  }
+
+  auto totalLength = inputOffsets[count] - inputOffsets[0];
+  if ((int64_t)outputCapacity < (int64_t)MaxLength64(from, to, totalLength)) {
+    return -1;
+  }
+
+  size_t written = 0;
+  outputOffsets[0] = 0;
+  for (int i = 0; i < count; i++) {
+    auto start = inputOffsets[i];
+    auto length = inputOffsets[i + 1] - start;
+    written += Transcode(from, to, in + start * inputUnitSize, length,
+                         out + written * outputUnitSize);
+    outputOffsets[i + 1] = (int)written;
+  }
+  return (int)written;
+}
@@ -1,22 +1,72 @@
 
 #include "string_interop.h"
-#include <combaseapi.h>
-#include <codecvt>
+#include <cstdint>
+#include <cstring>
 #include <string>
 
 /*
- * As per .NET docs, on Windows, we can directly return strings from P/Invoke as long as they
- * have been allocated with CoTaskMemAlloc.
+ * As per .NET docs, we can directly return strings from P/Invoke as long as they have been
+ * allocated with CoTaskMemAlloc (which .NET maps to malloc on other platforms).
  */
 
-// This is obviously not true for Linux at the moment, and needs to be redone
-static_assert(sizeof(wchar_t) == sizeof(char16_t));
+size_t utf16Length(std::wstring_view str) {
+  if constexpr (sizeof(wchar_t) == sizeof(char16_t)) {
+    return str.length();
+  } else {
+    size_t length = 0;
+    for (auto ch : str) {
+      length += (uint32_t)ch > 0xFFFF ? 2 : 1;
+    }
+    return length;
+  }
+}
+
+void toUtf16(std::wstring_view str, char16_t *out) {
+  if constexpr (sizeof(wchar_t) == sizeof(char16_t)) {
+    memcpy(out, str.data(), sizeof(char16_t) * str.length());
+  } else {
+    for (auto ch : str) {
+      auto codePoint = (uint32_t)ch;
+      if (codePoint > 0xFFFF) {
+        codePoint -= 0x10000;
+        *out++ = (char16_t)(0xD800 + (codePoint >> 10));
+        *out++ = (char16_t)(0xDC00 + (codePoint & 0x3FF));
+      } else {
+        *out++ = (char16_t)codePoint;
+      }
+    }
+  }
+}
+
+size_t fromUtf16(std::u16string_view str, wchar_t *out) {
+  if constexpr (sizeof(wchar_t) == sizeof(char16_t)) {
+    memcpy(out, str.data(), sizeof(char16_t) * str.length());
+    return str.length();
+  } else {
+    size_t length = 0;
+    for (size_t i = 0; i < str.length(); i++) {
+      uint32_t codePoint = str[i];
+      if (codePoint >= 0xD800 && codePoint < 0xDC00 && i + 1 < str.length() &&
+          str[i + 1] >= 0xDC00 && str[i + 1] < 0xE000) {
+        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (str[++i] - 0xDC00);
+      }
+      out[length++] = (wchar_t)codePoint;
+    }
+    return length;
+  }
+}
+
+std::wstring fromUtf16(std::u16string_view str) {
+  std::wstring result(str.length(), L'\0');
+  result.resize(fromUtf16(str, result.data()));
+  return result;
+}
 
 char16_t *copyString(const std::wstring_view &str) {
-  auto len = str.length();
-  auto result = reinterpret_cast<char16_t *>(CoTaskMemAlloc(len * 2 + 2));
+  auto len = utf16Length(str);
+  auto result = reinterpret_cast<char16_t *>(allocInteropMemory(sizeof(char16_t) * (len + 1)));
 
-  memcpy(result, str.data(), sizeof(char16_t) * len);
+  toUtf16(str, result);
   result[len] = 0;
 
   return result;
@@ -24,7 +74,7 @@ char16_t *copyString(const std::wstring_view &str) {
 
 char *copyString(const std::string_view &str) {
   auto len = str.length();
-  auto result = reinterpret_cast<char *>(CoTaskMemAlloc(len + 1));
+  auto result = reinterpret_cast<char *>(allocInteropMemory(len + 1));
 
   memcpy(result, str.data(), len);
   result[len] = 0;
@@ -33,39 +83,9 @@ char *copyString(const std::string_view &str) {
 }
 
 char *copyString(const char *str) {
-  auto len = strlen(str);
-  auto result = reinterpret_cast<char *>(CoTaskMemAlloc(len + 1));
-
-  memcpy(result, str, len);
-  result[len] = 0;
-
-  return result;
+  return copyString(std::string_view(str));
 }
 
 char16_t *copyString(const wchar_t *str) {
-  auto len = wcslen(str);
-  auto result = reinterpret_cast<char16_t *>(CoTaskMemAlloc(sizeof(wchar_t) * (len + 1)));
-
-  memcpy(result, str, sizeof(wchar_t) * len);
-  result[len] = 0;
-
-  return result;
-}
-
-std::wstring localToWide(std::string_view view) {
-  std::wstring result;
-
-  auto wideLength = MultiByteToWideChar(CP_ACP, 0, view.data(), view.length(), nullptr, 0);
-  if (wideLength == 0) {
-    return result;
-  }
-
-  result.resize(wideLength);
-
-  if (!MultiByteToWideChar(CP_ACP, 0, view.data(), view.length(), &result[0], result.length())) {
-    result.resize(0);
-    return result;
-  }
-
-  return result;
+  return copyString(std::wstring_view(str));
 }
@@ -1,14 +1,47 @@
-
 #pragma once
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 
+/*
+ * Strings returned from these functions are allocated with the allocator that .NET uses to free
+ * strings returned from P/Invoke calls (CoTaskMemAlloc on Windows, malloc elsewhere).
+ */
 [[maybe_unused]] char16_t *copyString(const std::wstring_view &);
 [[maybe_unused]] char *copyString(const std::string_view &);
 [[maybe_unused]] char *copyString(const char *);
 [[maybe_unused]] char16_t *copyString(const wchar_t *);
 
 /**
- * Converts from whatever the platform uses as it's default encoding to a wide string.
+ * Allocates memory that managed code can free with Marshal.FreeCoTaskMem. Implemented per platform.
+ */
+void *allocInteropMemory(size_t size);
+
+/**
+ * Number of UTF-16 code units needed for a wide string (wchar_t is UTF-32 outside of Windows).
+ */
+size_t utf16Length(std::wstring_view str);
+
+/**
+ * Writes utf16Length(str) code units to out, without a null terminator.
+ */
+void toUtf16(std::wstring_view str, char16_t *out);
+
+/**
+ * Converts UTF-16 text from managed code to a wide string.
+ */
+std::wstring fromUtf16(std::u16string_view str);
+
+/**
+ * Writes str as wide characters to out, which needs room for str.length() characters.
+ * @return The number of characters written.
+ */
+size_t fromUtf16(std::u16string_view str, wchar_t *out);
+
+/**
+ * Converts from whatever the platform uses as its default encoding (the ANSI code page on
+ * Windows, UTF-8 elsewhere) to a wide string. Use Windows1252ToWide for the game's text data.
+ * Implemented per platform.
  */
 [[maybe_unused]] std::wstring localToWide(std::string_view view);
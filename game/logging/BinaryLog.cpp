@@ -0,0 +1,341 @@
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BinaryLog.h"
+#include "BinaryLogFormat.h"
+#include "BoundedMpscQueue.h"
+
+using namespace BinaryLogFormat;
+
+namespace {
+
+// How often the capture thread writes queued records to the file
+constexpr auto WriteInterval = std::chrono::milliseconds(20);
+
+struct Descriptor {
+  LogLevel level;
+  std::wstring_view format;
+  const char *file;
+  int line;
+};
+
+struct BinaryRecord {
+  uint32_t descriptorId;
+  uint64_t timestamp;
+  uint16_t payloadSize;
+  uint8_t payload[BinaryLog::MaxPayloadSize];
+};
+
+/**
+ * Appends values to a fixed-size buffer and refuses values that do not fit.
+ */
+class PayloadWriter {
+ public:
+  PayloadWriter(uint8_t *data, size_t capacity) : _data(data), _capacity(capacity) {}
+
+  template <typename T>
+  bool put(T value) {
+    if (_size + sizeof(T) > _capacity) {
+      return false;
+    }
+    memcpy(_data + _size, &value, sizeof(T));
+    _size += sizeof(T);
+    return true;
+  }
+
+  [[nodiscard]] uint8_t *position() {
+    return _data + _size;
+  }
+
+  [[nodiscard]] size_t remaining() const {
+    return _capacity - _size;
+  }
+
+  [[nodiscard]] size_t size() const {
+    return _size;
+  }
+
+ private:
+  uint8_t *_data;
+  size_t _size = 0;
+  size_t _capacity;
+};
+
+/**
+ * Emits text as UTF-16 code units, stopping before maxUnits would be exceeded.
+ * wchar_t is UTF-16 on Windows, and UTF-32 elsewhere.
+ * @return The number of code units emitted.
+ */
+template <typename Fn>
+size_t EncodeUtf16(std::wstring_view text, size_t maxUnits, Fn &&emit) {
+  size_t units = 0;
+  for (auto ch : text) {
+    auto codePoint = (uint32_t)ch;
+    if (sizeof(wchar_t) > 2 && codePoint > 0xFFFF) {
+      if (units + 2 > maxUnits) {
+        break;
+      }
+      codePoint -= 0x10000;
+      emit((char16_t)(0xD800 + (codePoint >> 10)));
+      emit((char16_t)(0xDC00 + (codePoint & 0x3FF)));
+      units += 2;
+    } else {
+      if (units + 1 > maxUnits) {
+        break;
+      }
+      emit((char16_t)codePoint);
+      units++;
+    }
+  }
+  return units;
+}
+
+bool EncodeArg(PayloadWriter &writer, const LogArg &arg) {
+  switch (arg.type()) {
+    case LogArg::Type::WideString: {
+      if (!writer.put(ArgType::WideString) || !writer.put(uint16_t{0})) {
+        return false;
+      }
+      // Patch the length once the number of code units that fit is known
+      auto lengthPtr = writer.position() - sizeof(uint16_t);
+      auto units = EncodeUtf16(arg.wideString(), writer.remaining() / sizeof(char16_t),
+                               [&](char16_t unit) { writer.put(unit); });
+      auto unitCount = (uint16_t)units;
+      memcpy(lengthPtr, &unitCount, sizeof(unitCount));
+      return true;
+    }
+    case LogArg::Type::NarrowString: {
+      if (!writer.put(ArgType::NarrowString) || !writer.put(uint16_t{0})) {
+        return false;
+      }
+      auto lengthPtr = writer.position() - sizeof(uint16_t);
+      auto length = (uint16_t)std::min(arg.narrowString().length(), writer.remaining());
+      for (size_t i = 0; i < length; i++) {
+        writer.put(arg.narrowString()[i]);
+      }
+      memcpy(lengthPtr, &length, sizeof(length));
+      return true;
+    }
+    case LogArg::Type::Bool:
+      return writer.put(ArgType::Bool) && writer.put((uint8_t)(arg.signedValue() != 0));
+    case LogArg::Type::Signed:
+      return writer.put(ArgType::Signed) && writer.put(arg.signedValue());
+    case LogArg::Type::Unsigned:
+      return writer.put(ArgType::Unsigned) && writer.put(arg.unsignedValue());
+    case LogArg::Type::Float:
+      return writer.put(ArgType::Float) && writer.put(arg.floatValue());
+    case LogArg::Type::Pointer:
+      return writer.put(ArgType::Pointer) &&
+             writer.put((uint64_t)(uintptr_t)arg.pointerValue());
+  }
+  return false;
+}
+
+class BinaryCapture {
+ public:
+  uint32_t registerFormat(LogLevel level, std::wstring_view format, const char *file, int line) {
+    std::lock_guard<std::mutex> guard(_descriptorMutex);
+    _descriptors.push_back({level, format, file, line});
+    return (uint32_t)(_descriptors.size() - 1);
+  }
+
+  void write(uint32_t descriptorId, const LogArg *args, size_t argCount) {
+    auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+    auto pushed = _queue.tryPush([&](BinaryRecord &record) {
+      record.descriptorId = descriptorId;
+      record.timestamp = (uint64_t)timestamp;
+      PayloadWriter writer(record.payload, sizeof(record.payload));
+      for (size_t i = 0; i < argCount; i++) {
+        if (!EncodeArg(writer, args[i])) {
+          break;
+        }
+      }
+      record.payloadSize = (uint16_t)writer.size();
+    });
+    if (!pushed) {
+      _dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  bool start(std::wstring_view path) {
+    stop();
+
+    std::lock_guard<std::mutex> guard(_fileMutex);
+    _file.open(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+    if (!_file) {
+      return false;
+    }
+    _file.write(Magic, sizeof(Magic));
+    _file.write(reinterpret_cast<const char *>(&Version), sizeof(Version));
+    _descriptorsWritten = 0;
+
+    std::lock_guard<std::mutex> threadGuard(_threadMutex);
+    _stop = false;
+    _writer = std::thread([this] { run(); });
+    return true;
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> guard(_threadMutex);
+      if (_writer.joinable()) {
+        {
+          std::lock_guard<std::mutex> wakeGuard(_wakeMutex);
+          _stop = true;
+        }
+        _wakeup.notify_one();
+        _writer.join();
+      }
+    }
+
+    std::lock_guard<std::mutex> guard(_fileMutex);
+    if (_file.is_open()) {
+      flushLocked();
+      _file.close();
+    }
+  }
+
+  void flush() {
+    std::lock_guard<std::mutex> guard(_fileMutex);
+    if (_file.is_open()) {
+      flushLocked();
+    }
+  }
+
+ private:
+  void run() {
+    std::unique_lock<std::mutex> lock(_wakeMutex);
+    while (!_stop) {
+      _wakeup.wait_for(lock, WriteInterval, [this] { return _stop; });
+      lock.unlock();
+      flush();
+      lock.lock();
+    }
+  }
+
+  // Requires _fileMutex
+  void flushLocked() {
+    // Collect the records first: every record's descriptor has been registered before the
+    // record was queued, so writing the descriptors afterwards covers all of them
+    _buffer.clear();
+    _queue.drain([this](const BinaryRecord &record) {
+      _buffer.push_back((uint8_t)ChunkType::Record);
+      append(record.descriptorId);
+      append(record.timestamp);
+      append(record.payloadSize);
+      _buffer.insert(_buffer.end(), record.payload, record.payload + record.payloadSize);
+    });
+    auto dropped = (uint64_t)_dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+      _buffer.push_back((uint8_t)ChunkType::Dropped);
+      append(dropped);
+    }
+
+    writeNewDescriptors();
+    _file.write(reinterpret_cast<const char *>(_buffer.data()), (std::streamsize)_buffer.size());
+    _file.flush();
+  }
+
+  // Requires _fileMutex
+  void writeNewDescriptors() {
+    std::lock_guard<std::mutex> guard(_descriptorMutex);
+    std::vector<uint8_t> chunk;
+    for (; _descriptorsWritten < _descriptors.size(); _descriptorsWritten++) {
+      auto &descriptor = _descriptors[_descriptorsWritten];
+      chunk.clear();
+      chunk.push_back((uint8_t)ChunkType::Descriptor);
+      appendTo(chunk, (uint32_t)_descriptorsWritten);
+      chunk.push_back((uint8_t)descriptor.level);
+      appendTo(chunk, (uint32_t)descriptor.line);
+
+      auto fileLength = (uint16_t)std::min<size_t>(strlen(descriptor.file), UINT16_MAX);
+      appendTo(chunk, fileLength);
+      chunk.insert(chunk.end(), descriptor.file, descriptor.file + fileLength);
+
+      auto lengthPos = chunk.size();
+      appendTo(chunk, uint16_t{0});
+      auto units = EncodeUtf16(descriptor.format, UINT16_MAX,
+                               [&](char16_t unit) { appendTo(chunk, unit); });
+      auto unitCount = (uint16_t)units;
+      memcpy(&chunk[lengthPos], &unitCount, sizeof(unitCount));
+
+      _file.write(reinterpret_cast<const char *>(chunk.data()), (std::streamsize)chunk.size());
+    }
+  }
+
+  template <typename T>
+  static void appendTo(std::vector<uint8_t> &buffer, T value) {
+    auto bytes = reinterpret_cast<const uint8_t *>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+  }
+
+  template <typename T>
+  void append(T value) {
+    appendTo(_buffer, value);
+  }
+
+  BoundedMpscQueue<BinaryRecord, BinaryLog::QueueCapacity> _queue;
+  std::atomic<size_t> _dropped{0};
+
+  std::mutex _descriptorMutex;
+  std::vector<Descriptor> _descriptors;
+
+  // Guards the file and serializes consumers of the queue
+  std::mutex _fileMutex;
+  std::ofstream _file;
+  size_t _descriptorsWritten = 0;
+  std::vector<uint8_t> _buffer;
+
+  std::mutex _threadMutex;
+  std::thread _writer;
+
+  std::mutex _wakeMutex;
+  std::condition_variable _wakeup;
+  bool _stop = false;
+};
+
+// Intentionally never destroyed, see Logger.cpp
+BinaryCapture &Capture() {
+  static auto capture = new BinaryCapture;
+  return *capture;
+}
+
+}  // namespace
+
+uint32_t BinaryLog::RegisterFormat(LogLevel level, std::wstring_view format, const char *file,
+                                   int line) {
+  return Capture().registerFormat(level, format, file, line);
+}
+
+void BinaryLog::WriteRecord(uint32_t descriptorId, const LogArg *args, size_t argCount) {
+  Capture().write(descriptorId, args, argCount);
+}
+
+bool BinaryLog::StartCapture(std::wstring_view path) {
+  _capturing.store(false, std::memory_order_relaxed);
+  if (!Capture().start(path)) {
+    return false;
+  }
+  _capturing.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+void BinaryLog::StopCapture() {
+  _capturing.store(false, std::memory_order_relaxed);
+  Capture().stop();
+}
+
+void BinaryLog::Flush() {
+  Capture().flush();
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+
+#include "Logger.h"
+
+/**
+ * Logs a message through the binary log if a capture is running, or as text through Logger
+ * otherwise. The format string is registered once per call site, after which each call only
+ * copies the descriptor ID, a timestamp and the raw arguments into a lock-free queue. Formatting
+ * is left to the log decoder tool. Uses the same "{}" placeholders as Logger.
+ */
+#define BINARY_LOG(level, format, ...)                                                     \
+  do {                                                                                     \
+    if (Logger::IsEnabled(level)) {                                                        \
+      static const uint32_t binaryLogDescriptor_ =                                         \
+          BinaryLog::RegisterFormat(level, format, __FILE__, __LINE__);                    \
+      BinaryLog::Write(binaryLogDescriptor_, level, format, ##__VA_ARGS__);                \
+    }                                                                                      \
+  } while (0)
+
+class BinaryLog {
+ public:
+  /**
+   * Number of records that can be queued before further records are dropped.
+   */
+  static constexpr size_t QueueCapacity = 4096;
+
+  /**
+   * Maximum size of the encoded arguments of a single record.
+   */
+  static constexpr size_t MaxPayloadSize = 232;
+
+  /**
+   * Registers a call site and returns its descriptor ID. The format must outlive the process
+   * (i.e. be a string literal).
+   */
+  static uint32_t RegisterFormat(LogLevel level, std::wstring_view format, const char *file,
+                                 int line);
+
+  static bool IsCapturing() {
+    return _capturing.load(std::memory_order_relaxed);
+  }
+
+  template <typename... Args>
+  static void Write(uint32_t descriptorId, LogLevel level, std::wstring_view format,
+                    const Args &...args) {
+    if (IsCapturing()) {
+      const LogArg logArgs[] = {args..., LogArg(false)};
+      WriteRecord(descriptorId, logArgs, sizeof...(Args));
+    } else {
+      Logger::Log(level, format, args...);
+    }
+  }
+
+  /**
+   * Starts writing binary log records to the given file, replacing a running capture.
+   * @return False if the file could not be created.
+   */
+  static bool StartCapture(std::wstring_view path);
+
+  /**
+   * Writes all pending records and closes the capture file.
+   */
+  static void StopCapture();
+
+  /**
+   * Writes all pending records to the capture file on the calling thread.
+   */
+  static void Flush();
+
+ private:
+  static void WriteRecord(uint32_t descriptorId, const LogArg *args, size_t argCount);
+
+  static inline std::atomic<bool> _capturing{false};
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Layout of binary log capture files, shared by the native library and the log decoder.
+ *
+ * A file starts with Magic and Version, followed by a sequence of chunks that each start with a
+ * ChunkType byte. All integers are little-endian and strings are length-prefixed (uint16_t),
+ * without a terminator.
+ *
+ * Descriptor: uint32_t id, uint8_t level, uint32_t line, string file (UTF-8),
+ *             string format (UTF-16 code units).
+ * Record:     uint32_t descriptor id, uint64_t timestamp (nanoseconds since the Unix epoch),
+ *             uint16_t payload size, payload.
+ * Dropped:    uint64_t number of records that were lost because the queue was full.
+ *
+ * A descriptor is always written before the first record that references it. The payload of a
+ * record is a sequence of arguments, each being an ArgType byte followed by its value. Strings
+ * that did not fit into a record are truncated.
+ */
+namespace BinaryLogFormat {
+
+constexpr char Magic[8] = {'O', 'T', 'B', 'L', 'O', 'G', '\r', '\n'};
+constexpr uint32_t Version = 1;
+
+enum class ChunkType : uint8_t { Descriptor = 1, Record = 2, Dropped = 3 };
+
+enum class ArgType : uint8_t {
+  WideString = 1,    // uint16_t length, UTF-16 code units
+  NarrowString = 2,  // uint16_t length, bytes in the encoding of the logging process
+  Bool = 3,          // uint8_t
+  Signed = 4,        // int64_t
+  Unsigned = 5,      // uint64_t
+  Float = 6,         // double
+  Pointer = 7        // uint64_t
+};
+
+}  // namespace BinaryLogFormat
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Bounded multi-producer/single-consumer queue with preallocated slots.
+ *
+ * Producers claim a slot with a CAS on the enqueue position and publish it through the slot's
+ * sequence number, so pushing never blocks and fails if the queue is full. Callers have to
+ * serialize consumers themselves.
+ */
+template <typename T, size_t Capacity>
+class BoundedMpscQueue {
+  static_assert((Capacity & (Capacity - 1)) == 0, "Queue capacity must be a power of two");
+
+ public:
+  BoundedMpscQueue() : _slots(std::make_unique<Slot[]>(Capacity)) {
+    for (size_t i = 0; i < Capacity; i++) {
+      _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Claims a slot and calls fill(T &) to fill it in place.
+   * @return False without calling fill if the queue is full.
+   */
+  template <typename Fn>
+  bool tryPush(Fn &&fill) {
+    auto pos = _enqueuePos.load(std::memory_order_relaxed);
+    Slot *slot;
+    while (true) {
+      slot = &_slots[pos & (Capacity - 1)];
+      auto sequence = slot->sequence.load(std::memory_order_acquire);
+      auto diff = (intptr_t)sequence - (intptr_t)pos;
+      if (diff == 0) {
+        if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = _enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+
+    fill(slot->value);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Consumer: Passes every published element to fn(T &), stopping at the first slot that has
+   * been claimed but not yet published.
+   * @return The number of elements that were consumed.
+   */
+  template <typename Fn>
+  size_t drain(Fn &&fn) {
+    size_t count = 0;
+    auto pos = _dequeuePos.load(std::memory_order_relaxed);
+    while (true) {
+      auto &slot = _slots[pos & (Capacity - 1)];
+      if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+        break;
+      }
+      fn(slot.value);
+      slot.sequence.store(pos + Capacity, std::memory_order_release);
+      pos++;
+      count++;
+    }
+    _dequeuePos.store(pos, std::memory_order_relaxed);
+    return count;
+  }
+
+  [[nodiscard]] size_t enqueuePos() const {
+    return _enqueuePos.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] size_t dequeuePos() const {
+    return _dequeuePos.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Slot {
+    // Equals the enqueue position this slot is free for, or that position + 1 once it is filled
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  std::unique_ptr<Slot[]> _slots;
+  alignas(64) std::atomic<size_t> _enqueuePos{0};
+  alignas(64) std::atomic<size_t> _dequeuePos{0};
+};
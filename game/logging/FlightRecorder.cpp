@@ -0,0 +1,272 @@
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include "FlightRecorder.h"
+
+namespace {
+
+enum class EventKind : uint8_t { Log, Marker, StaticMarker };
+
+struct FlightEvent {
+  uint64_t timestamp;  // Nanoseconds since the Unix epoch
+  const char *staticName;
+  EventKind kind;
+  LogLevel level;
+  uint16_t length;
+  wchar_t text[FlightRecorder::MaxEventText];
+};
+
+struct ThreadRing {
+  // Only written by the owning thread. Events [writeCount - EventsPerThread, writeCount) are valid.
+  std::atomic<uint64_t> writeCount{0};
+  std::atomic<bool> inUse{true};
+  uint64_t threadId = 0;
+  ThreadRing *next = nullptr;
+  FlightEvent events[FlightRecorder::EventsPerThread];
+};
+
+// Once this many rings exist, the rings of exited threads are reused instead of keeping their
+// events around
+constexpr int MaxRetainedRings = 64;
+
+// Rings are never freed, so a dump can walk this list at any time
+std::atomic<ThreadRing *> rings{nullptr};
+std::atomic<int> ringCount{0};
+
+ThreadRing *AcquireRing() {
+  auto threadId = (uint64_t)std::hash<std::thread::id>()(std::this_thread::get_id());
+
+  if (ringCount.load(std::memory_order_relaxed) >= MaxRetainedRings) {
+    for (auto ring = rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+      auto inUse = false;
+      if (ring->inUse.compare_exchange_strong(inUse, true, std::memory_order_acquire)) {
+        ring->threadId = threadId;
+        ring->writeCount.store(0, std::memory_order_release);
+        return ring;
+      }
+    }
+  }
+
+  ringCount.fetch_add(1, std::memory_order_relaxed);
+  auto ring = new ThreadRing;
+  ring->threadId = threadId;
+  auto head = rings.load(std::memory_order_relaxed);
+  do {
+    ring->next = head;
+  } while (!rings.compare_exchange_weak(head, ring, std::memory_order_release,
+                                        std::memory_order_relaxed));
+  return ring;
+}
+
+// Hands the ring back when the owning thread exits
+struct ThreadRingOwner {
+  ThreadRing *ring = AcquireRing();
+
+  ~ThreadRingOwner() {
+    ring->inUse.store(false, std::memory_order_release);
+  }
+};
+
+FlightEvent &BeginEvent(ThreadRing *&ring, uint64_t &index) {
+  thread_local ThreadRingOwner owner;
+  ring = owner.ring;
+  index = ring->writeCount.load(std::memory_order_relaxed);
+  auto &event = ring->events[index % FlightRecorder::EventsPerThread];
+  event.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::system_clock::now().time_since_epoch())
+                        .count();
+  return event;
+}
+
+void CommitEvent(ThreadRing *ring, uint64_t index) {
+  ring->writeCount.store(index + 1, std::memory_order_release);
+}
+
+void RecordText(EventKind kind, LogLevel level, std::wstring_view text) {
+  ThreadRing *ring;
+  uint64_t index;
+  auto &event = BeginEvent(ring, index);
+  event.kind = kind;
+  event.level = level;
+  event.staticName = nullptr;
+  event.length = (uint16_t)std::min(text.length(), FlightRecorder::MaxEventText);
+  std::copy_n(text.data(), event.length, event.text);
+  CommitEvent(ring, index);
+}
+
+/**
+ * Buffers dump output on the stack, since the dump must not allocate.
+ */
+class DumpBuffer {
+ public:
+  DumpBuffer(FlightRecorder::DumpWriter writer, void *context)
+      : _writer(writer), _context(context) {}
+
+  ~DumpBuffer() {
+    flush();
+  }
+
+  void put(char ch) {
+    if (_length == sizeof(_buffer)) {
+      flush();
+    }
+    _buffer[_length++] = ch;
+  }
+
+  void put(const char *text) {
+    for (; *text; text++) {
+      put(*text);
+    }
+  }
+
+  void putNumber(uint64_t value, int minDigits = 1) {
+    char digits[20];
+    int count = 0;
+    do {
+      digits[count++] = (char)('0' + value % 10);
+      value /= 10;
+    } while (value > 0);
+    for (; count < minDigits; count++) {
+      digits[count] = '0';
+    }
+    while (count > 0) {
+      put(digits[--count]);
+    }
+  }
+
+  void putHex(uint64_t value) {
+    for (int shift = 60; shift >= 0; shift -= 4) {
+      put("0123456789abcdef"[(value >> shift) & 0xF]);
+    }
+  }
+
+  // wchar_t is UTF-16 on Windows, and UTF-32 elsewhere
+  void putWide(const wchar_t *text, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+      auto codePoint = (uint32_t)text[i];
+      if (codePoint >= 0xD800 && codePoint < 0xDC00 && i + 1 < length &&
+          (uint32_t)text[i + 1] >= 0xDC00 && (uint32_t)text[i + 1] < 0xE000) {
+        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + ((uint32_t)text[i + 1] - 0xDC00);
+        i++;
+      } else if ((codePoint >= 0xD800 && codePoint < 0xE000) || codePoint > 0x10FFFF) {
+        codePoint = 0xFFFD;
+      }
+
+      if (codePoint < 0x80) {
+        // Keep every event on a single line
+        put(codePoint == '\n' || codePoint == '\r' ? ' ' : (char)codePoint);
+      } else if (codePoint < 0x800) {
+        put((char)(0xC0 | (codePoint >> 6)));
+        put((char)(0x80 | (codePoint & 0x3F)));
+      } else if (codePoint < 0x10000) {
+        put((char)(0xE0 | (codePoint >> 12)));
+        put((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+        put((char)(0x80 | (codePoint & 0x3F)));
+      } else {
+        put((char)(0xF0 | (codePoint >> 18)));
+        put((char)(0x80 | ((codePoint >> 12) & 0x3F)));
+        put((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+        put((char)(0x80 | (codePoint & 0x3F)));
+      }
+    }
+  }
+
+  void flush() {
+    if (_length > 0) {
+      _writer(_context, _buffer, _length);
+      _length = 0;
+    }
+  }
+
+ private:
+  FlightRecorder::DumpWriter _writer;
+  void *_context;
+  char _buffer[1024];
+  size_t _length = 0;
+};
+
+const char *LevelName(LogLevel level) {
+  switch (level) {
+    case LogLevel::Error:
+      return "ERROR";
+    case LogLevel::Warn:
+      return "WARN ";
+    case LogLevel::Info:
+      return "INFO ";
+    case LogLevel::Debug:
+      return "DEBUG";
+  }
+  return "?    ";
+}
+
+void DumpEvent(DumpBuffer &out, const FlightEvent &event) {
+  // Seconds since the Unix epoch, formatting a date would not be safe in a crash handler
+  out.putNumber(event.timestamp / 1000000000);
+  out.put('.');
+  out.putNumber((event.timestamp / 1000) % 1000000, 6);
+  out.put(' ');
+  switch (event.kind) {
+    case EventKind::Log:
+      out.put(LevelName(event.level));
+      out.put(' ');
+      out.putWide(event.text, std::min<size_t>(event.length, FlightRecorder::MaxEventText));
+      break;
+    case EventKind::Marker:
+      out.put("MARK  ");
+      out.putWide(event.text, std::min<size_t>(event.length, FlightRecorder::MaxEventText));
+      break;
+    case EventKind::StaticMarker:
+      out.put("MARK  ");
+      out.put(event.staticName ? event.staticName : "");
+      break;
+  }
+  out.put('\n');
+}
+
+}  // namespace
+
+void FlightRecorder::RecordLog(LogLevel level, std::wstring_view message) {
+  RecordText(EventKind::Log, level, message);
+}
+
+void FlightRecorder::Mark(const char *name) {
+  ThreadRing *ring;
+  uint64_t index;
+  auto &event = BeginEvent(ring, index);
+  event.kind = EventKind::StaticMarker;
+  event.staticName = name;
+  event.length = 0;
+  CommitEvent(ring, index);
+}
+
+void FlightRecorder::Mark(std::wstring_view name) {
+  RecordText(EventKind::Marker, LogLevel::Debug, name);
+}
+
+void FlightRecorder::Dump(DumpWriter writer, void *context) {
+  DumpBuffer out(writer, context);
+  out.put("OpenTemple native flight recorder\n");
+
+  for (auto ring = rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+    auto count = ring->writeCount.load(std::memory_order_acquire);
+    if (count == 0) {
+      continue;
+    }
+
+    out.put("\nThread ");
+    out.putHex(ring->threadId);
+    if (!ring->inUse.load(std::memory_order_relaxed)) {
+      out.put(" (exited)");
+    }
+    out.put('\n');
+
+    auto first = count > EventsPerThread ? count - EventsPerThread : 0;
+    for (auto i = first; i < count; i++) {
+      DumpEvent(out, ring->events[i % EventsPerThread]);
+    }
+  }
+}
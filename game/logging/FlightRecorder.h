@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "Logger.h"
+
+/**
+ * Keeps the most recent log messages and trace markers of every thread in a fixed-size ring
+ * buffer, so that they can be written to a file after a crash.
+ *
+ * Recording only touches memory owned by the calling thread and never locks. A thread's buffer is
+ * allocated the first time it records an event. Buffers of exited threads are kept, until too
+ * many buffers exist and they are handed to new threads instead.
+ *
+ * Dumping does not allocate or lock either, so it can be done from a crash handler, but events
+ * that are being written during the dump may come out garbled.
+ */
+class FlightRecorder {
+ public:
+  static constexpr size_t EventsPerThread = 256;
+
+  /**
+   * Longer messages are truncated to this number of characters.
+   */
+  static constexpr size_t MaxEventText = 52;
+
+  /**
+   * Called by Logger for every message of an enabled level, regardless of the sink.
+   */
+  static void RecordLog(LogLevel level, std::wstring_view message);
+
+  /**
+   * Records a trace marker. Only the pointer is stored, so the name must be a string literal.
+   */
+  static void Mark(const char *name);
+
+  /**
+   * Records a trace marker with a name that is copied (and truncated).
+   */
+  static void Mark(std::wstring_view name);
+
+  using DumpWriter = void (*)(void *context, const char *data, size_t length);
+
+  /**
+   * Writes the recorded events of all threads as UTF-8 text, one line per event and grouped by
+   * thread, oldest first. Safe to call from a crash handler.
+   */
+  static void Dump(DumpWriter writer, void *context);
+
+  /**
+   * Writes the recorded events to the given file. Implemented per platform.
+   * @return False if the file could not be created.
+   */
+  static bool DumpToFile(std::wstring_view path);
+
+  /**
+   * Dumps the recorded events to the given file when the process crashes. Previously installed
+   * handlers (i.e. the .NET runtime) see the crash first, and nothing is written if they handle
+   * it. Only the first crash is written. Implemented per platform.
+   */
+  static bool InstallCrashHandler(std::wstring_view path);
+};
@@ -0,0 +1,22 @@
+
+#include <algorithm>
+
+#include "../interop/string_interop.h"
+#include "../utils.h"
+#include "FlightRecorder.h"
+
+NATIVE_API void FlightRecorder_Mark(const char16_t *name, int nameLength) {
+  // The name is truncated anyway, so convert it on the stack
+  wchar_t buffer[FlightRecorder::MaxEventText];
+  auto length = std::min<size_t>(std::max(nameLength, 0), FlightRecorder::MaxEventText);
+  length = fromUtf16(std::u16string_view(name, length), buffer);
+  FlightRecorder::Mark(std::wstring_view(buffer, length));
+}
+
+NATIVE_API ApiBool FlightRecorder_DumpToFile(const char16_t *path) {
+  return FlightRecorder::DumpToFile(fromUtf16(path));
+}
+
+NATIVE_API ApiBool FlightRecorder_InstallCrashHandler(const char16_t *path) {
+  return FlightRecorder::InstallCrashHandler(fromUtf16(path));
+}
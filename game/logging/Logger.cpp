@@ -1,22 +1,265 @@
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cwchar>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "../interop/string_interop.h"
+#include "BinaryLog.h"
+#include "BoundedMpscQueue.h"
+#include "FlightRecorder.h"
 #include "Logger.h"
 
-std::mutex Logger::_mutex;
-std::function<void(LogLevel, std::wstring_view)> Logger::_sink;
+namespace {
+
+using LogSink = std::function<void(LogLevel, std::wstring_view)>;
+
+// Upper bound for how long a message can sit in the queue if the wakeup was missed
+constexpr auto DrainInterval = std::chrono::milliseconds(50);
+
+struct LogMessage {
+  LogLevel level;
+  size_t length;
+  wchar_t text[Logger::MaxMessageLength];
+};
+
+// Set while the current thread is calling the sink, so that a sink which logs, flushes or
+// removes itself does not wait for its own delivery to finish
+thread_local bool t_delivering = false;
+
+class LogPipeline {
+ public:
+  void log(LogLevel level, std::wstring_view message) {
+    if (!_hasSink.load(std::memory_order_relaxed)) {
+      return;
+    }
+    auto pushed = _queue.tryPush([=](LogMessage &slot) {
+      slot.level = level;
+      slot.length = std::min(message.length(), Logger::MaxMessageLength);
+      std::copy_n(message.data(), slot.length, slot.text);
+    });
+    if (!pushed) {
+      _dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    // Only pay for the wakeup if the delivery thread is actually waiting for messages
+    if (_drainerWaiting.load(std::memory_order_relaxed)) {
+      _wakeup.notify_one();
+    }
+  }
+
+  void setSink(LogSink sink) {
+    {
+      std::lock_guard<std::mutex> guard(_sinkMutex);
+      _sink = std::make_shared<LogSink>(std::move(sink));
+    }
+    _hasSink.store(true, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> guard(_threadMutex);
+    if (!_drainer.joinable()) {
+      _stop = false;
+      _drainer = std::thread([this] { run(); });
+    }
+  }
+
+  void clearSink() {
+    _hasSink.store(false, std::memory_order_relaxed);
+    stopDrainer();
 
-void Logger::Log(LogLevel level, std::wstring_view message) {
-  std::lock_guard<std::mutex> guard(_mutex);
-  if (_sink) {
-    _sink(level, message);
+    // When called from the sink, the delivery in progress sends the remaining messages
+    deliver(true);
+    std::lock_guard<std::mutex> guard(_sinkMutex);
+    _sink = nullptr;
   }
+
+  void flush() {
+    if (t_delivering) {
+      return;
+    }
+    auto target = _queue.enqueuePos();
+    // Messages logged before the call may sit behind a slot that another thread is still writing
+    for (int attempt = 0; attempt < 1000 && _queue.dequeuePos() < target; attempt++) {
+      if (deliver(true) == 0) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+ private:
+  void run() {
+    std::unique_lock<std::mutex> lock(_wakeMutex);
+    while (!_stop) {
+      _drainerWaiting.store(true, std::memory_order_relaxed);
+      _wakeup.wait_for(lock, DrainInterval, [this] {
+        return _stop || _queue.enqueuePos() != _queue.dequeuePos();
+      });
+      _drainerWaiting.store(false, std::memory_order_relaxed);
+
+      lock.unlock();
+      // Never wait here: the thread that is delivering may be joining this one
+      deliver(false);
+      lock.lock();
+    }
+  }
+
+  void stopDrainer() {
+    std::lock_guard<std::mutex> guard(_threadMutex);
+    if (!_drainer.joinable()) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> wakeGuard(_wakeMutex);
+      _stop = true;
+    }
+    _wakeup.notify_one();
+    if (_drainer.get_id() == std::this_thread::get_id()) {
+      // The sink itself removed the sink
+      _drainer.detach();
+    } else {
+      _drainer.join();
+    }
+  }
+
+  /**
+   * Passes queued messages to the sink. Only the sink pointer is copied under _sinkMutex, and
+   * the sink is called without holding it, so the sink may replace or remove itself.
+   * _deliveryMutex keeps the messages in order and the sink on one thread at a time.
+   * If wait is false and another thread is delivering, nothing is done.
+   */
+  size_t deliver(bool wait) {
+    if (t_delivering) {
+      return 0;
+    }
+    std::unique_lock<std::mutex> deliveryLock(_deliveryMutex, std::defer_lock);
+    if (wait) {
+      deliveryLock.lock();
+    } else if (!deliveryLock.try_lock()) {
+      return 0;
+    }
+
+    std::shared_ptr<LogSink> sink;
+    {
+      std::lock_guard<std::mutex> guard(_sinkMutex);
+      sink = _sink;
+    }
+
+    t_delivering = true;
+    auto count = _queue.drain([&](const LogMessage &message) {
+      if (sink) {
+        (*sink)(message.level, std::wstring_view(message.text, message.length));
+      }
+    });
+
+    auto dropped = _dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0 && sink) {
+      (*sink)(LogLevel::Warn,
+              std::to_wstring(dropped) +
+                  L" native log messages were dropped because the log queue was full.");
+    }
+    t_delivering = false;
+    return count;
+  }
+
+  BoundedMpscQueue<LogMessage, Logger::QueueCapacity> _queue;
+  std::atomic<bool> _hasSink{false};
+  std::atomic<size_t> _dropped{0};
+
+  // Serializes consumers of the queue and calls to the sink
+  std::mutex _deliveryMutex;
+
+  std::mutex _sinkMutex;
+  std::shared_ptr<LogSink> _sink;
+
+  std::mutex _threadMutex;
+  std::thread _drainer;
+
+  std::mutex _wakeMutex;
+  std::condition_variable _wakeup;
+  std::atomic<bool> _drainerWaiting{false};
+  bool _stop = false;
+};
+
+// Intentionally never destroyed, so that logging during static destruction remains safe and a
+// delivery thread that is still running at exit does not terminate the process.
+LogPipeline &Pipeline() {
+  static auto pipeline = new LogPipeline;
+  return *pipeline;
+}
+
+}  // namespace
+
+void Logger::Enqueue(LogLevel level, std::wstring_view message) {
+  FlightRecorder::RecordLog(level, message);
+  Pipeline().log(level, message);
+}
+
+void LogArg::appendTo(std::wstring &out) const {
+  switch (_type) {
+    case Type::WideString:
+      out.append(_wide);
+      break;
+    case Type::NarrowString:
+      out.append(localToWide(_narrow));
+      break;
+    case Type::Bool:
+      out.append(_signed ? L"true" : L"false");
+      break;
+    case Type::Signed:
+      out.append(std::to_wstring(_signed));
+      break;
+    case Type::Unsigned:
+      out.append(std::to_wstring(_unsigned));
+      break;
+    case Type::Float: {
+      wchar_t buffer[32];
+      swprintf(buffer, std::size(buffer), L"%g", _float);
+      out.append(buffer);
+      break;
+    }
+    case Type::Pointer: {
+      wchar_t buffer[32];
+      swprintf(buffer, std::size(buffer), L"0x%llx", (unsigned long long)(uintptr_t)_pointer);
+      out.append(buffer);
+      break;
+    }
+  }
+}
+
+std::wstring Logger::Format(std::wstring_view format, const LogArg *args, size_t argCount) {
+  std::wstring result;
+  result.reserve(format.size() + argCount * 16);
+
+  size_t argIndex = 0;
+  size_t pos = 0;
+  while (argIndex < argCount) {
+    auto placeholder = format.find(L"{}", pos);
+    if (placeholder == std::wstring_view::npos) {
+      break;
+    }
+    result.append(format.substr(pos, placeholder - pos));
+    args[argIndex++].appendTo(result);
+    pos = placeholder + 2;
+  }
+  result.append(format.substr(pos));
+  return result;
 }
 
 void Logger::SetSink(std::function<void(LogLevel, std::wstring_view)> sink) {
-  std::lock_guard<std::mutex> guard(_mutex);
-  _sink = std::move(sink);
+  Pipeline().setSink(std::move(sink));
 }
 
 void Logger::ClearSink() {
-  std::lock_guard<std::mutex> guard(_mutex);
-  _sink = nullptr;
+  Pipeline().clearSink();
+}
+
+void Logger::Flush() {
+  Pipeline().flush();
+  BinaryLog::Flush();
 }
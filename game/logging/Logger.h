@@ -1,14 +1,146 @@
-
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
-#include <mutex>
+#include <string>
 #include <string_view>
+#include <type_traits>
 
 enum class LogLevel : int { Error, Warn, Info, Debug };
 
+/**
+ * A single argument for the formatting overloads of Logger. Only references the value, which
+ * is converted to text after the log level has been checked.
+ */
+class LogArg {
+ public:
+  enum class Type { WideString, NarrowString, Bool, Signed, Unsigned, Float, Pointer };
+
+  template <typename T>
+  LogArg(const T &value) {  // NOLINT(google-explicit-constructor)
+    if constexpr (std::is_convertible_v<const T &, std::wstring_view>) {
+      _type = Type::WideString;
+      _wide = value;
+    } else if constexpr (std::is_convertible_v<const T &, std::string_view>) {
+      _type = Type::NarrowString;
+      _narrow = value;
+    } else if constexpr (std::is_same_v<T, bool>) {
+      _type = Type::Bool;
+      _signed = value;
+    } else if constexpr (std::is_enum_v<T>) {
+      _type = Type::Signed;
+      _signed = (int64_t)value;
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+      _type = Type::Signed;
+      _signed = value;
+    } else if constexpr (std::is_integral_v<T>) {
+      _type = Type::Unsigned;
+      _unsigned = value;
+    } else if constexpr (std::is_floating_point_v<T>) {
+      _type = Type::Float;
+      _float = value;
+    } else {
+      static_assert(std::is_pointer_v<T>, "Unsupported log argument type");
+      _type = Type::Pointer;
+      _pointer = value;
+    }
+  }
+
+  /**
+   * Appends the textual representation of the argument.
+   */
+  void appendTo(std::wstring &out) const;
+
+  [[nodiscard]] Type type() const {
+    return _type;
+  }
+  // Only valid for the matching type (Bool uses signedValue)
+  [[nodiscard]] std::wstring_view wideString() const {
+    return _wide;
+  }
+  [[nodiscard]] std::string_view narrowString() const {
+    return _narrow;
+  }
+  [[nodiscard]] int64_t signedValue() const {
+    return _signed;
+  }
+  [[nodiscard]] uint64_t unsignedValue() const {
+    return _unsigned;
+  }
+  [[nodiscard]] double floatValue() const {
+    return _float;
+  }
+  [[nodiscard]] const void *pointerValue() const {
+    return _pointer;
+  }
+
+ private:
+  Type _type;
+  union {
+    std::wstring_view _wide;
+    std::string_view _narrow;
+    int64_t _signed;
+    uint64_t _unsigned;
+    double _float;
+    const void *_pointer;
+  };
+};
+
+/**
+ * Forwards native log messages to a sink (usually the managed logger).
+ *
+ * Logging never blocks the calling thread: messages are copied into a preallocated lock-free
+ * queue and delivered to the sink in batches by a background thread. If the queue is full, the
+ * message is dropped and the sink is told how many messages were lost.
+ */
 class Logger {
  public:
+  /**
+   * Number of messages that can be queued before further messages are dropped.
+   */
+  static constexpr size_t QueueCapacity = 512;
+
+  /**
+   * Longer messages are truncated to this number of characters.
+   */
+  static constexpr size_t MaxMessageLength = 1024;
+
+  static constexpr uint32_t AllLevels = 0xF;
+
+  static constexpr uint32_t LevelBit(LogLevel level) {
+    return 1u << (int)level;
+  }
+
+  /**
+   * Check this before building an expensive message by hand. The formatting overloads below
+   * already do this.
+   */
+  static bool IsEnabled(LogLevel level) {
+    return (_enabledLevels.load(std::memory_order_relaxed) & LevelBit(level)) != 0;
+  }
+
+  /**
+   * Sets the levels that are logged as a combination of LevelBit values. All levels are
+   * enabled by default.
+   */
+  static void SetEnabledLevels(uint32_t mask) {
+    _enabledLevels.store(mask & AllLevels, std::memory_order_relaxed);
+  }
+
+  static uint32_t EnabledLevels() {
+    return _enabledLevels.load(std::memory_order_relaxed);
+  }
+
+  static void SetLevelEnabled(LogLevel level, bool enabled) {
+    if (enabled) {
+      _enabledLevels.fetch_or(LevelBit(level), std::memory_order_relaxed);
+    } else {
+      _enabledLevels.fetch_and(~LevelBit(level), std::memory_order_relaxed);
+    }
+  }
+
   static void Error(std::wstring_view message) {
     Log(LogLevel::Error, message);
   }
@@ -21,12 +153,64 @@ class Logger {
   static void Debug(std::wstring_view message) {
     Log(LogLevel::Debug, message);
   }
-  static void Log(LogLevel level, std::wstring_view message);
+  static void Log(LogLevel level, std::wstring_view message) {
+    if (IsEnabled(level)) {
+      Enqueue(level, message);
+    }
+  }
 
+  /**
+   * Logs a message in which every "{}" is replaced by the next argument. The arguments are only
+   * converted to text if the level is enabled, so disabled calls cost a load and a branch.
+   * Surplus placeholders are kept as-is and surplus arguments are ignored.
+   */
+  template <typename... Args>
+  static void Error(std::wstring_view format, const Args &...args) {
+    Log(LogLevel::Error, format, args...);
+  }
+  template <typename... Args>
+  static void Warn(std::wstring_view format, const Args &...args) {
+    Log(LogLevel::Warn, format, args...);
+  }
+  template <typename... Args>
+  static void Info(std::wstring_view format, const Args &...args) {
+    Log(LogLevel::Info, format, args...);
+  }
+  template <typename... Args>
+  static void Debug(std::wstring_view format, const Args &...args) {
+    Log(LogLevel::Debug, format, args...);
+  }
+  template <typename... Args>
+  static void Log(LogLevel level, std::wstring_view format, const Args &...args) {
+    if (IsEnabled(level)) {
+      const LogArg logArgs[] = {args...};
+      Enqueue(level, Format(format, logArgs, sizeof...(Args)));
+    }
+  }
+
+  static std::wstring Format(std::wstring_view format, const LogArg *args, size_t argCount);
+
+  /**
+   * Sets the sink and starts the thread that delivers messages to it.
+   * The sink is only ever called from one thread at a time, but not from the thread that logged.
+   * It may log, flush and replace or remove the sink itself.
+   */
   static void SetSink(std::function<void(LogLevel, std::wstring_view)>);
+
+  /**
+   * Delivers all pending messages, stops the delivery thread and removes the sink.
+   */
   static void ClearSink();
 
+  /**
+   * Delivers all messages logged before the call to the sink on the calling thread and writes
+   * pending binary log records to the capture file.
+   * Meant for shutdown and crash handling, where the delivery thread may never get to run again.
+   */
+  static void Flush();
+
  private:
-  static std::mutex _mutex;
-  static std::function<void(LogLevel, std::wstring_view)> _sink;
+  static void Enqueue(LogLevel level, std::wstring_view message);
+
+  static inline std::atomic<uint32_t> _enabledLevels{AllLevels};
 };
@@ -1,17 +1,48 @@
 
 #include "../interop/string_interop.h"
 #include "../utils.h"
+#include "BinaryLog.h"
 #include "Logger.h"
 
 using LogCallback = void(LogLevel, const char16_t *, unsigned int);
 
 NATIVE_API void Logger_SetSink(LogCallback *callback) {
-  static_assert(sizeof(wchar_t) == sizeof(char16_t), ".NET uses UTF-16");
   Logger::SetSink([=](LogLevel level, std::wstring_view message) {
-    callback(level, reinterpret_cast<const char16_t *>(message.data()), message.length());
+    // .NET uses UTF-16, which wchar_t is only on Windows
+    if constexpr (sizeof(wchar_t) == sizeof(char16_t)) {
+      callback(level, reinterpret_cast<const char16_t *>(message.data()), message.length());
+    } else {
+      std::u16string utf16(utf16Length(message), u'\0');
+      toUtf16(message, utf16.data());
+      callback(level, utf16.data(), utf16.length());
+    }
   });
 }
 
 NATIVE_API void Logger_ClearSink() {
   Logger::ClearSink();
 }
+
+NATIVE_API void Logger_Flush() {
+  Logger::Flush();
+}
+
+NATIVE_API void Logger_SetEnabledLevels(uint32_t mask) {
+  Logger::SetEnabledLevels(mask);
+}
+
+NATIVE_API uint32_t Logger_GetEnabledLevels() {
+  return Logger::EnabledLevels();
+}
+
+NATIVE_API void Logger_SetLevelEnabled(LogLevel level, ApiBool enabled) {
+  Logger::SetLevelEnabled(level, enabled);
+}
+
+NATIVE_API ApiBool Logger_StartBinaryCapture(const char16_t *path) {
+  return BinaryLog::StartCapture(fromUtf16(path));
+}
+
+NATIVE_API void Logger_StopBinaryCapture() {
+  BinaryLog::StopCapture();
+}
@@ -0,0 +1,149 @@
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+
+#include "../logging/FlightRecorder.h"
+
+static const int CrashSignals[] = {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT};
+static constexpr int CrashSignalCount = sizeof(CrashSignals) / sizeof(CrashSignals[0]);
+
+// Only touched outside of the signal handler while installing it
+static char crashDumpPath[4096];
+static struct sigaction previousActions[CrashSignalCount];
+static bool handlerInstalled = false;
+static std::atomic_flag crashDumped = ATOMIC_FLAG_INIT;
+
+// Lets the handler run after a stack overflow on the thread that installed it. Other threads use
+// the alternate stack the runtime gave them, if any.
+static constexpr size_t AlternateStackSize = 64 * 1024;
+
+static void WriteToFd(void *context, const char *data, size_t length) {
+  auto fd = *static_cast<int *>(context);
+  while (length > 0) {
+    auto written = write(fd, data, length);
+    if (written <= 0) {
+      return;
+    }
+    data += written;
+    length -= (size_t)written;
+  }
+}
+
+static bool DumpToPath(const char *path) {
+  auto fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  FlightRecorder::Dump(WriteToFd, &fd);
+  close(fd);
+  return true;
+}
+
+static void DumpCrashOnce() {
+  // A crash in the dump itself, or an abort() while dying, must not truncate the first dump
+  if (!crashDumped.test_and_set()) {
+    DumpToPath(crashDumpPath);
+  }
+}
+
+static bool IsDefaultAction(int signal) {
+  struct sigaction current {};
+  return sigaction(signal, nullptr, &current) == 0 && !(current.sa_flags & SA_SIGINFO) &&
+         current.sa_handler == SIG_DFL;
+}
+
+static void CrashHandler(int signal, siginfo_t *info, void *ucontext) {
+  // The runtime gets to look at the signal first: it turns faults in managed code into
+  // exceptions (i.e. NullReferenceException) and returns, in which case nothing has crashed
+  for (int i = 0; i < CrashSignalCount; i++) {
+    if (CrashSignals[i] != signal) {
+      continue;
+    }
+    auto &previous = previousActions[i];
+    if (previous.sa_flags & SA_SIGINFO) {
+      previous.sa_sigaction(signal, info, ucontext);
+    } else if (previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN) {
+      previous.sa_handler(signal);
+    } else if (previous.sa_handler == SIG_IGN) {
+      return;
+    } else {
+      // Nobody else wants the signal, so the process dies the default way
+      DumpCrashOnce();
+      sigaction(signal, &previous, nullptr);
+      raise(signal);
+      return;
+    }
+
+    // A runtime that could not handle the signal restores the default action, so that the
+    // faulting instruction kills the process once the handler returns
+    if (IsDefaultAction(signal)) {
+      DumpCrashOnce();
+    }
+    return;
+  }
+}
+
+// wchar_t is UTF-32 on POSIX platforms
+static std::string ToUtf8(std::wstring_view text) {
+  std::string result;
+  for (auto ch : text) {
+    auto codePoint = (uint32_t)ch;
+    if (codePoint < 0x80) {
+      result.push_back((char)codePoint);
+    } else if (codePoint < 0x800) {
+      result.push_back((char)(0xC0 | (codePoint >> 6)));
+      result.push_back((char)(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+      result.push_back((char)(0xE0 | (codePoint >> 12)));
+      result.push_back((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+      result.push_back((char)(0x80 | (codePoint & 0x3F)));
+    } else {
+      result.push_back((char)(0xF0 | (codePoint >> 18)));
+      result.push_back((char)(0x80 | ((codePoint >> 12) & 0x3F)));
+      result.push_back((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+      result.push_back((char)(0x80 | (codePoint & 0x3F)));
+    }
+  }
+  return result;
+}
+
+bool FlightRecorder::DumpToFile(std::wstring_view path) {
+  return DumpToPath(ToUtf8(path).c_str());
+}
+
+bool FlightRecorder::InstallCrashHandler(std::wstring_view path) {
+  auto utf8Path = ToUtf8(path);
+  if (utf8Path.size() >= sizeof(crashDumpPath)) {
+    return false;
+  }
+  memcpy(crashDumpPath, utf8Path.c_str(), utf8Path.size() + 1);
+
+  if (handlerInstalled) {
+    return true;
+  }
+
+  stack_t currentStack{};
+  if (sigaltstack(nullptr, &currentStack) == 0 && (currentStack.ss_flags & SS_DISABLE)) {
+    // Intentionally never freed, the handler may need it until the process exits
+    stack_t alternateStack{};
+    alternateStack.ss_sp = malloc(AlternateStackSize);
+    alternateStack.ss_size = AlternateStackSize;
+    if (alternateStack.ss_sp && sigaltstack(&alternateStack, nullptr) != 0) {
+      free(alternateStack.ss_sp);
+    }
+  }
+
+  struct sigaction action {};
+  action.sa_sigaction = CrashHandler;
+  action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+  sigemptyset(&action.sa_mask);
+  for (int i = 0; i < CrashSignalCount; i++) {
+    sigaction(CrashSignals[i], &action, &previousActions[i]);
+  }
+  handlerInstalled = true;
+  return true;
+}
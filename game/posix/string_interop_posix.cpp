@@ -0,0 +1,19 @@
+#include <cstdlib>
+#include <string>
+
+#include "../interop/Transcoding.h"
+#include "../interop/string_interop.h"
+
+// .NET frees memory returned from P/Invoke calls with free() on non-Windows platforms
+void *allocInteropMemory(size_t size) {
+  return malloc(size);
+}
+
+// Narrow strings from the C library, FreeType and exception messages are UTF-8 here
+std::wstring localToWide(std::string_view view) {
+  std::u16string utf16(MaxTranscodedLength(TextEncoding::Utf8, TextEncoding::Utf16, view.length()),
+                       u'\0');
+  utf16.resize(Transcode(TextEncoding::Utf8, TextEncoding::Utf16, view.data(), view.length(),
+                         utf16.data()));
+  return fromUtf16(utf16);
+}
@@ -1,4 +1,6 @@
 
+#include <cmath>
+
 #include "DrawingEngine.h"
 #include "../../logging/Logger.h"
 #include "HangingIndentObject.h"
@@ -18,8 +20,10 @@ DrawingEngine::DrawingEngine(const winrt::com_ptr<ID3D11Device>& d3dDevice, bool
     Logger::Info(L"Creating Direct2D Factory (debug=false).");
   }
 
+  // Multi-threaded, since layouts holding rasterized bitmaps may be changed and freed on other
+  // threads than the render thread
   winrt::check_hresult(
-      D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, factoryOptions, _factory.put()));
+      D2D1CreateFactory(D2D1_FACTORY_TYPE_MULTI_THREADED, factoryOptions, _factory.put()));
 
   auto dxgiDevice = d3dDevice.as<IDXGIDevice>();
 
@@ -55,7 +59,7 @@ winrt::com_ptr<IDWriteTextFormat2> DrawingEngine::GetTextFormat(const TextFormat
   }
 
   winrt::com_ptr<IDWriteTextFormat> format;
-  winrt::check_hresult(_textFactory->CreateTextFormat(key.FontFamilyName.c_str(),
+  winrt::check_hresult(_textFactory->CreateTextFormat(_fontNames.name(key.FontFamily).c_str(),
                                                       _fontCollection.get(),
                                                       ConvertFontWeight(key.FontWeight),
                                                       ConvertFontStyle(key.FontStyle),
@@ -116,8 +120,14 @@ winrt::com_ptr<ID2D1SolidColorBrush> DrawingEngine::GetBrush(uint32_t color) {
 }
 
 void DrawingEngine::ReloadFontFamilies() {
-  // When font families change, text formats must also be re-evaluated
+  // When font families change, text formats and layouts must also be re-evaluated
   _textFormatCache.clear();
+  _textLayoutCache.clear();
+  _textRenderer->ClearOutlineCache();
+  if (_bitmapTextRenderer) {
+    _bitmapTextRenderer->ClearOutlineCache();
+  }
+  _fontGeneration++;
 
   // DirectWrite caches font collections internally.
   // If we reload, we need to generate a new key
@@ -164,6 +174,99 @@ TextLayout* DrawingEngine::CreateTextLayout(const ParagraphStyle& paragraphStyle
                                             uint32_t textLength,
                                             float maxWidth,
                                             float maxHeight) {
+  return new TextLayout(
+      *this,
+      CreateTextLayoutData(paragraphStyle, textStyle, text, textLength, maxWidth, maxHeight));
+}
+
+TextLayout* DrawingEngine::CreateCachedTextLayout(const ParagraphStyle& paragraphStyle,
+                                                  const TextStyle& textStyle,
+                                                  const wchar_t* text,
+                                                  uint32_t textLength,
+                                                  float maxWidth,
+                                                  float maxHeight,
+                                                  const TextStyleRun* runs,
+                                                  uint32_t runCount) {
+  if (!_textLayoutCache.enabled()) {
+    auto data = CreateTextLayoutData(paragraphStyle, textStyle, text, textLength, maxWidth,
+                                     maxHeight);
+    for (uint32_t i = 0; i < runCount; i++) {
+      data->SetStyle(runs[i].Start, runs[i].Length, runs[i].Properties, runs[i].Style);
+    }
+    return new TextLayout(*this, std::move(data));
+  }
+
+  TextLayoutRequest request{paragraphStyle, textStyle, {text, textLength}, maxWidth, maxHeight,
+                            runs, runCount};
+  auto hash = TextLayoutCache::Hash(request);
+  if (auto data = _textLayoutCache.find(hash, request)) {
+    return new TextLayout(*this, std::move(data), true);
+  }
+
+  // The recipe outlives the caller's strings, so the font faces are replaced with interned names
+  auto recipe = std::make_shared<TextLayoutRecipe>(
+      TextLayoutRecipe{paragraphStyle, textStyle, {text, textLength}, maxWidth, maxHeight,
+                       {runs, runs + runCount}});
+  recipe->textStyle.FontFace = _fontNames.name(_fontNames.intern(textStyle.FontFace)).c_str();
+  for (auto& run : recipe->runs) {
+    if (run.Style.FontFace) {
+      run.Style.FontFace = _fontNames.name(_fontNames.intern(run.Style.FontFace)).c_str();
+    }
+  }
+
+  auto data = CreateTextLayoutData(*recipe);
+  data->recipe = std::move(recipe);
+  // Formats the layout while it is still private to this thread, since other threads may measure
+  // it as soon as it is in the cache
+  data->GetMetrics();
+  _textLayoutCache.insert(hash, data);
+  return new TextLayout(*this, std::move(data), true);
+}
+
+TextLayout* DrawingEngine::CreateTextLayoutFromMarkup(const ParagraphStyle& paragraphStyle,
+                                                      const TextStyle& textStyle,
+                                                      std::wstring_view markup,
+                                                      float maxWidth,
+                                                      float maxHeight,
+                                                      const MarkupStyle* palette,
+                                                      uint32_t paletteSize) {
+  // Reused by all calls on the same thread
+  thread_local std::wstring markupText;
+  thread_local std::vector<TextStyleSpan> markupSpans;
+  thread_local std::vector<TextStyle> markupStyles;
+
+  ParseMarkup(markup, palette, paletteSize, markupText, markupSpans);
+
+  markupStyles.clear();
+  for (uint32_t i = 0; i < paletteSize; i++) {
+    markupStyles.push_back(palette[i].Style);
+  }
+
+  auto data = CreateTextLayoutData(paragraphStyle, textStyle, markupText.c_str(),
+                                   (uint32_t)markupText.length(), maxWidth, maxHeight);
+  data->SetStyles(markupSpans.data(), (uint32_t)markupSpans.size(), markupStyles.data(),
+                  paletteSize);
+  return new TextLayout(*this, std::move(data));
+}
+
+std::shared_ptr<TextLayoutData> DrawingEngine::CreateTextLayoutData(
+    const TextLayoutRecipe& recipe) {
+  auto data = CreateTextLayoutData(recipe.paragraphStyle, recipe.textStyle, recipe.text.c_str(),
+                                   (uint32_t)recipe.text.length(), recipe.maxWidth,
+                                   recipe.maxHeight);
+  for (auto& run : recipe.runs) {
+    data->SetStyle(run.Start, run.Length, run.Properties, run.Style);
+  }
+  return data;
+}
+
+std::shared_ptr<TextLayoutData> DrawingEngine::CreateTextLayoutData(
+    const ParagraphStyle& paragraphStyle,
+    const TextStyle& textStyle,
+    const wchar_t* text,
+    uint32_t textLength,
+    float maxWidth,
+    float maxHeight) {
   auto rootFormat = GetTextFormat(paragraphStyle, textStyle);
 
   // A somewhat annoying hack to insert a negative-width inline object at the start to simulate
@@ -191,9 +294,8 @@ TextLayout* DrawingEngine::CreateTextLayout(const ParagraphStyle& paragraphStyle
     textLayout->SetInlineObject(hangingIndent.get(), {0, 1});
   }
 
-  auto defaultStyle = CreateTextRendererStyle(textStyle);
-  auto result = new TextLayout(*this, textLayout, paragraphStyle.HangingIndent,
-                               paragraphStyle.Indent, std::move(*defaultStyle));
+  auto result = std::make_shared<TextLayoutData>(textLayout, paragraphStyle.HangingIndent,
+                                                 paragraphStyle.Indent, textStyle);
 
   // Some default text styles needs to be applied to the whole range of the text layout
   // since it is not part of the DWrite text format.
@@ -209,26 +311,108 @@ TextLayout* DrawingEngine::CreateTextLayout(const ParagraphStyle& paragraphStyle
   return result;
 }
 
-winrt::com_ptr<TextRendererStyle> DrawingEngine::CreateTextRendererStyle(const TextStyle& style) {
-  // Convert the colors into strong-references to D2D1 brushes.
-  auto color = GetBrush(style.Color).as<ID2D1Brush>();
-  winrt::com_ptr<ID2D1Brush> dropShadowColor;
-  if (!IsTransparent(style.DropShadowColor)) {
-    dropShadowColor = GetBrush(style.DropShadowColor).as<ID2D1Brush>();
+void DrawingEngine::RenderTextLayout(float x, float y, TextLayout& textLayout, float opacity) {
+  if (textLayout.IsBitmapCaching() && RenderTextLayoutBitmap(x, y, textLayout, opacity)) {
+    return;
+  }
+  textLayout.Render(*_textRenderer, x, y, opacity);
+}
+
+// Larger layouts are always drawn directly, so that a few large texts can not use up video memory
+constexpr float MaxTextLayoutBitmapSize = 2048;
+
+bool DrawingEngine::RenderTextLayoutBitmap(float x, float y, TextLayout& textLayout,
+                                           float opacity) {
+  // Scaled or rotated text would be blurry when drawn from a bitmap
+  D2D1_MATRIX_3X2_F transform;
+  _context->GetTransform(&transform);
+  if (transform._11 != 1 || transform._12 != 0 || transform._21 != 0 || transform._22 != 1) {
+    return false;
   }
-  winrt::com_ptr<ID2D1Brush> outlineColor;
-  if (!IsTransparent(style.OutlineColor)) {
-    outlineColor = GetBrush(style.OutlineColor).as<ID2D1Brush>();
+
+  float dpiX, dpiY;
+  _context->GetDpi(&dpiX, &dpiY);
+  auto& bitmap = textLayout.GetBitmap();
+  if (!bitmap.bitmap || bitmap.dpiX != dpiX || bitmap.dpiY != dpiY ||
+      bitmap.fontGeneration != _fontGeneration) {
+    if (!RasterizeTextLayout(textLayout, dpiX, dpiY)) {
+      return false;
+    }
   }
 
-  winrt::com_ptr<TextRendererStyle> renderStyle;
-  renderStyle.attach(
-      new TextRendererStyle(color, dropShadowColor, outlineColor, style.OutlineWidth));
-  return renderStyle;
+  // Snap the bitmap to device pixels, so that it is copied without being resampled. This moves
+  // the text by less than a pixel compared to drawing it directly.
+  auto scaleX = dpiX / 96.0f;
+  auto scaleY = dpiY / 96.0f;
+  auto deviceLeft = std::round((x + transform._31 + bitmap.bounds.left) * scaleX);
+  auto deviceTop = std::round((y + transform._32 + bitmap.bounds.top) * scaleY);
+  auto left = deviceLeft / scaleX - transform._31;
+  auto top = deviceTop / scaleY - transform._32;
+  auto destination = D2D1::RectF(left,
+                                 top,
+                                 left + bitmap.bounds.right - bitmap.bounds.left,
+                                 top + bitmap.bounds.bottom - bitmap.bounds.top);
+  _context->DrawBitmap(bitmap.bitmap.get(), destination, opacity,
+                       D2D1_INTERPOLATION_MODE_NEAREST_NEIGHBOR, nullptr);
+  return true;
 }
 
-void DrawingEngine::RenderTextLayout(float x, float y, TextLayout& textLayout, float opacity) {
-  textLayout.Render(*_textRenderer, x, y, opacity);
+bool DrawingEngine::RasterizeTextLayout(TextLayout& textLayout, float dpiX, float dpiY) {
+  auto& bitmap = textLayout.GetBitmap();
+  bitmap = {};
+
+  // Align the bounds to device pixels
+  auto scaleX = dpiX / 96.0f;
+  auto scaleY = dpiY / 96.0f;
+  auto bounds = textLayout.GetDrawBounds();
+  auto left = std::floor(bounds.left * scaleX);
+  auto top = std::floor(bounds.top * scaleY);
+  auto width = std::ceil(bounds.right * scaleX) - left;
+  auto height = std::ceil(bounds.bottom * scaleY) - top;
+  if (!(width > 0 && height > 0) || width > MaxTextLayoutBitmapSize ||
+      height > MaxTextLayoutBitmapSize) {
+    return false;
+  }
+
+  if (!_bitmapContext) {
+    winrt::com_ptr<ID2D1Device> device;
+    _context->GetDevice(device.put());
+    winrt::check_hresult(
+        device->CreateDeviceContext(D2D1_DEVICE_CONTEXT_OPTIONS_NONE, _bitmapContext.put()));
+    _bitmapContext->SetTextAntialiasMode(D2D1_TEXT_ANTIALIAS_MODE_GRAYSCALE);
+    _bitmapTextRenderer = std::make_unique<TextRenderer>(_textFactory, _bitmapContext);
+  }
+
+  D2D1_BITMAP_PROPERTIES1 bitmapProperties{};
+  bitmapProperties.pixelFormat =
+      D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED);
+  bitmapProperties.dpiX = dpiX;
+  bitmapProperties.dpiY = dpiY;
+  bitmapProperties.bitmapOptions = D2D1_BITMAP_OPTIONS_TARGET;
+  winrt::com_ptr<ID2D1Bitmap1> target;
+  winrt::check_hresult(_bitmapContext->CreateBitmap(D2D1::SizeU((uint32_t)width, (uint32_t)height),
+                                                    nullptr, 0, bitmapProperties, target.put()));
+
+  // Opacity is applied when the bitmap is drawn
+  _bitmapContext->SetTarget(target.get());
+  _bitmapContext->SetDpi(dpiX, dpiY);
+  _bitmapContext->BeginDraw();
+  _bitmapContext->Clear(D2D1::ColorF(0, 0.0f));
+  _bitmapContext->SetTransform(D2D1::Matrix3x2F::Translation(-left / scaleX, -top / scaleY));
+  textLayout.Render(*_bitmapTextRenderer, 0, 0, 1.0f);
+  auto result = _bitmapContext->EndDraw();
+  _bitmapContext->SetTarget(nullptr);
+  winrt::check_hresult(result);
+
+  bitmap.bitmap = std::move(target);
+  bitmap.bounds = D2D1::RectF(left / scaleX,
+                              top / scaleY,
+                              (left + width) / scaleX,
+                              (top + height) / scaleY);
+  bitmap.dpiX = dpiX;
+  bitmap.dpiY = dpiY;
+  bitmap.fontGeneration = _fontGeneration;
+  return true;
 }
 
 void DrawingEngine::RenderBackgroundAndBorder(float x, float y, float width, float height,
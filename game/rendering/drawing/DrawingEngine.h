@@ -6,16 +6,37 @@
 #include <d3d11.h>
 #include <dwrite_3.h>
 #include <unordered_map>
-#include "LRUCache11.h"
+
+#include "../../LruCache.h"
+#include "../../text/MarkupParser.h"
 
 #include "FontFile.h"
+#include "FontNameTable.h"
 #include "Style.h"
+#include "TextFormatCache.h"
 #include "TextFormatKey.h"
 #include "TextLayout.h"
+#include "TextLayoutCache.h"
 #include "TextRenderer.h"
 
 class MemoryFontLoader;
 
+/**
+ * Lays out and draws UI text with DirectWrite and Direct2D.
+ *
+ * Layouts may be built and measured on worker threads, while a single render thread draws:
+ * - Any thread may create layouts (CreateTextLayout, CreateCachedTextLayout and
+ *   CreateTextLayoutFromMarkup), and then style, resize, measure and hit-test them. A TextLayout
+ *   must only be used by one thread at a time, and is usually handed to the render thread once it
+ *   has been built. Layouts from the layout cache are shared between threads, but copied before
+ *   they are changed. Drawing, measuring and hit-testing a shared layout is serialized by a lock
+ *   in its TextLayoutData.
+ * - Everything else, including drawing layouts, belongs to the render thread. Fonts must only be
+ *   added or reloaded while no other thread creates layouts.
+ *
+ * Only DirectWrite is used to build layouts. Colors are turned into Direct2D brushes when the text
+ * is drawn.
+ */
 class DrawingEngine {
  public:
   explicit DrawingEngine(const winrt::com_ptr<ID3D11Device> &d3dDevice, bool debugDevice);
@@ -37,6 +58,45 @@ class DrawingEngine {
                                float maxWidth,
                                float maxHeight);
 
+  /**
+   * Like CreateTextLayout followed by SetStyle for each of the given runs, but the layout is
+   * taken from the layout cache if one was created with the same parameters before. Cached layouts
+   * are shared, and copied when they are changed.
+   */
+  TextLayout *CreateCachedTextLayout(const ParagraphStyle &paragraphStyle,
+                                     const TextStyle &textStyle,
+                                     const wchar_t *text,
+                                     uint32_t textLength,
+                                     float maxWidth,
+                                     float maxHeight,
+                                     const TextStyleRun *runs,
+                                     uint32_t runCount);
+
+  /**
+   * Strips the style markup from the text (see ParseMarkup) and creates a layout with the palette
+   * styles applied to the marked up ranges.
+   */
+  TextLayout *CreateTextLayoutFromMarkup(const ParagraphStyle &paragraphStyle,
+                                         const TextStyle &textStyle,
+                                         std::wstring_view markup,
+                                         float maxWidth,
+                                         float maxHeight,
+                                         const MarkupStyle *palette,
+                                         uint32_t paletteSize);
+
+  /**
+   * Builds a new, unshared layout from the parameters of a cached layout.
+   */
+  std::shared_ptr<TextLayoutData> CreateTextLayoutData(const TextLayoutRecipe &recipe);
+
+  void ConfigureTextLayoutCache(size_t maxEntries, size_t maxBytes) {
+    _textLayoutCache.configure(maxEntries, maxBytes);
+  }
+
+  [[nodiscard]] TextLayoutCacheStats GetTextLayoutCacheStats() const {
+    return _textLayoutCache.stats();
+  }
+
   const std::vector<FontFile> &GetFontFiles() const {
     return _fontFiles;
   }
@@ -50,10 +110,16 @@ class DrawingEngine {
   int GetFontFamiliesCount() const;
   std::wstring GetFontFamilyName(int familyIndex) const;
 
+  /**
+   * Only for the render thread.
+   */
   winrt::com_ptr<ID2D1SolidColorBrush> GetBrush(uint32_t color);
 
-  winrt::com_ptr<TextRendererStyle> CreateTextRendererStyle(const TextStyle &style);
-
+  /**
+   * Draws the layout. Layouts with bitmap caching enabled are drawn from their bitmap, which is
+   * rasterized again when the layout, the canvas scale or the fonts have changed since. They are
+   * drawn directly if the current transform scales or rotates, or if they are too large.
+   */
   void RenderTextLayout(float x, float y, TextLayout &textLayout, float opacity);
 
   void RenderBackgroundAndBorder(float x, float y, float width, float height,
@@ -72,14 +138,36 @@ class DrawingEngine {
  private:
   winrt::com_ptr<IDWriteTextFormat2> GetTextFormat(const ParagraphStyle &paragraphStyle,
                                                    const TextStyle &textStyle) {
-    return GetTextFormat(TextFormatKey(paragraphStyle, textStyle));
+    return GetTextFormat(TextFormatKey(_fontNames, paragraphStyle, textStyle));
   }
   winrt::com_ptr<IDWriteTextFormat2> GetTextFormat(const TextFormatKey &key);
 
+  std::shared_ptr<TextLayoutData> CreateTextLayoutData(const ParagraphStyle &paragraphStyle,
+                                                       const TextStyle &textStyle,
+                                                       const wchar_t *text,
+                                                       uint32_t textLength,
+                                                       float maxWidth,
+                                                       float maxHeight);
+
+  /**
+   * @return False if the layout has to be drawn directly instead.
+   */
+  bool RenderTextLayoutBitmap(float x, float y, TextLayout &textLayout, float opacity);
+
+  bool RasterizeTextLayout(TextLayout &textLayout, float dpiX, float dpiY);
+
   winrt::com_ptr<ID2D1DeviceContext> _context;
 
   std::unique_ptr<TextRenderer> _textRenderer;
 
+  // Separate device context for rasterizing text layouts into bitmaps while the main context is
+  // drawing. Created on first use.
+  winrt::com_ptr<ID2D1DeviceContext> _bitmapContext;
+  std::unique_ptr<TextRenderer> _bitmapTextRenderer;
+
+  // Incremented when fonts are reloaded, which invalidates all rasterized text layouts
+  uint32_t _fontGeneration = 1;
+
   winrt::com_ptr<IDWriteFactory1> _textFactory;
 
   winrt::com_ptr<IDWriteFontCollection> _fontCollection;
@@ -88,12 +176,17 @@ class DrawingEngine {
 
   std::vector<FontFile> _fontFiles;
 
+  FontNameTable _fontNames;
+
   // TextFormat cache
-  lru11::Cache<TextFormatKey, winrt::com_ptr<IDWriteTextFormat2>> _textFormatCache;
+  TextFormatCache _textFormatCache;
 
   std::wstring _locale;
 
-  lru11::Cache<uint32_t, winrt::com_ptr<ID2D1SolidColorBrush>> _colorBrushCache;
+  // Only used by the render thread
+  LruCache<uint32_t, winrt::com_ptr<ID2D1SolidColorBrush>> _colorBrushCache;
+
+  TextLayoutCache _textLayoutCache;
 
   winrt::com_ptr<ID2D1Factory1> _factory;
 
@@ -1,5 +1,8 @@
 
 #include <d3d.h>
+#include <exception>
+#include <new>
+#include "../../interop/StringArena.h"
 #include "../../interop/string_interop.h"
 #include "../../logging/Logger.h"
 #include "../../utils.h"
@@ -67,6 +70,19 @@ NATIVE_API ApiBool DrawingEngine_SetRenderTarget(DrawingEngine *engine,
   }
 }
 
+/**
+ * Memory render targets are only supported by the software engine used on other platforms.
+ */
+NATIVE_API ApiBool DrawingEngine_SetMemoryRenderTarget(DrawingEngine *engine,
+                                                       uint8_t *pixels,
+                                                       int width,
+                                                       int height,
+                                                       int stride,
+                                                       char16_t **error) noexcept {
+  *error = copyString(L"Memory render targets are not supported on this platform.");
+  return false;
+}
+
 NATIVE_API void DrawingEngine_SetTransform(DrawingEngine *engine,
                                            D2D1_MATRIX_3X2_F *matrix) noexcept {
   engine->SetTransform(*matrix);
@@ -120,6 +136,35 @@ NATIVE_API char16_t *DrawingEngine_GetFontFamilyName(DrawingEngine *engine, int
   return copyString(engine->GetFontFamilyName(index));
 }
 
+/**
+ * Like DrawingEngine_GetFontFamilyName, but the name is only valid until the arena is reset.
+ * Returns null and sets error if DirectWrite fails or the arena could not grow.
+ */
+NATIVE_API const char16_t *DrawingEngine_GetFontFamilyNameInArena(DrawingEngine *engine,
+                                                                  int index,
+                                                                  StringArena *arena,
+                                                                  int *length,
+                                                                  char16_t **error) noexcept {
+  *error = nullptr;
+  *length = 0;
+
+  // Neither DirectWrite errors nor allocation failures may escape through the noexcept ABI
+  // boundary. winrt::hresult_error does not derive from std::exception.
+  try {
+    auto name = engine->GetFontFamilyName(index);
+    auto result = arena->copy(name);
+    *length = (int)name.length();
+    return result;
+  } catch (const winrt::hresult_error &e) {
+    *error = copyString(e.message().c_str());
+  } catch (const std::bad_alloc &) {
+    *error = copyString(L"Out of memory while copying the font family name");
+  } catch (...) {
+    *error = copyString(L"Unknown Error");
+  }
+  return nullptr;
+}
+
 NATIVE_API ApiBool DrawingEngine_CreateTextLayout(DrawingEngine *engine,
                                                   const ParagraphStyle &paragraphStyle,
                                                   const TextStyle &textStyle,
@@ -147,6 +192,99 @@ NATIVE_API ApiBool DrawingEngine_CreateTextLayout(DrawingEngine *engine,
   }
 }
 
+/**
+ * Like DrawingEngine_CreateTextLayout followed by TextLayout_SetStyle for every run, but returns
+ * a shared layout from the layout cache if the same layout has been created before.
+ */
+NATIVE_API ApiBool DrawingEngine_CreateCachedTextLayout(DrawingEngine *engine,
+                                                        const ParagraphStyle &paragraphStyle,
+                                                        const TextStyle &textStyle,
+                                                        const wchar_t *text,
+                                                        uint32_t textLength,
+                                                        float maxWidth,
+                                                        float maxHeight,
+                                                        const TextStyleRun *runs,
+                                                        uint32_t runCount,
+                                                        TextLayout **textLayout,
+                                                        char16_t **error) noexcept {
+  *error = nullptr;
+  *textLayout = nullptr;
+
+  if (!textStyle.FontFace) {
+    *error = copyString(L"FontFace must be set.");
+    return false;
+  }
+  for (uint32_t i = 0; i < runCount; i++) {
+    auto &run = runs[i];
+    if ((run.Properties & TextStyleProperty::FontFace) == TextStyleProperty::FontFace &&
+        !run.Style.FontFace) {
+      *error = copyString(L"FontFace must be set for runs that change the font face.");
+      return false;
+    }
+  }
+
+  try {
+    *textLayout = engine->CreateCachedTextLayout(paragraphStyle, textStyle, text, textLength,
+                                                 maxWidth, maxHeight, runs, runCount);
+    return true;
+  } catch (const winrt::hresult_error &e) {
+    *error = copyString(e.message().c_str());
+    return false;
+  }
+}
+
+/**
+ * Creates a layout from text with inline style markup, applying the styles of the palette to the
+ * marked up ranges (see ParseMarkup).
+ */
+NATIVE_API ApiBool DrawingEngine_CreateTextLayoutFromMarkup(DrawingEngine *engine,
+                                                            const ParagraphStyle &paragraphStyle,
+                                                            const TextStyle &textStyle,
+                                                            const wchar_t *markup,
+                                                            uint32_t markupLength,
+                                                            float maxWidth,
+                                                            float maxHeight,
+                                                            const MarkupStyle *palette,
+                                                            uint32_t paletteSize,
+                                                            TextLayout **textLayout,
+                                                            char16_t **error) noexcept {
+  *error = nullptr;
+  *textLayout = nullptr;
+
+  if (!textStyle.FontFace) {
+    *error = copyString(L"FontFace must be set.");
+    return false;
+  }
+  for (uint32_t i = 0; i < paletteSize; i++) {
+    if ((palette[i].Properties & TextStyleProperty::FontFace) == TextStyleProperty::FontFace &&
+        !palette[i].Style.FontFace) {
+      *error = copyString(L"FontFace must be set for palette entries that change the font face.");
+      return false;
+    }
+  }
+
+  try {
+    *textLayout = engine->CreateTextLayoutFromMarkup(paragraphStyle, textStyle,
+                                                     {markup, markupLength}, maxWidth, maxHeight,
+                                                     palette, paletteSize);
+    return true;
+  } catch (const winrt::hresult_error &e) {
+    *error = copyString(e.message().c_str());
+    return false;
+  }
+}
+
+NATIVE_API void DrawingEngine_ConfigureTextLayoutCache(DrawingEngine *engine,
+                                                       uint32_t maxEntries,
+                                                       uint64_t maxBytes) noexcept {
+  engine->ConfigureTextLayoutCache(maxEntries, (size_t)maxBytes);
+}
+
+NATIVE_API void DrawingEngine_GetTextLayoutCacheStats(DrawingEngine *engine,
+                                                      TextLayoutCacheStats *stats) noexcept {
+  *stats = engine->GetTextLayoutCacheStats();
+}
+
 NATIVE_API void DrawingEngine_GetStructSizes(int *paragraphStylesSize,
                                              int *textStylesSize) noexcept {
   *paragraphStylesSize = sizeof(ParagraphStyle);
@@ -0,0 +1,24 @@
+
+#include "FontNameTable.h"
+
+FontNameId FontNameTable::intern(StyleStringView name) {
+  {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    auto it = _ids.find(name);
+    if (it != _ids.end()) {
+      return it->second;
+    }
+  }
+
+  // Another thread may have added the name in the meantime
+  std::unique_lock<std::shared_mutex> lock(_mutex);
+  auto it = _ids.find(name);
+  if (it != _ids.end()) {
+    return it->second;
+  }
+
+  auto id = (FontNameId)_names.size();
+  auto &stored = _names.emplace_back(name);
+  _ids.emplace(stored, id);
+  return id;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "Style.h"
+
+using FontNameId = uint32_t;
+
+/**
+ * Interns font family names, so that text format keys can refer to a font by a small ID instead of
+ * holding a copy of its name. Names are compared case-sensitively.
+ *
+ * Thread-safe. Looking up a known name only takes a shared lock.
+ */
+class FontNameTable {
+ public:
+  /**
+   * Returns the ID of the given name, and assigns a new one the first time a name is seen.
+   * Only allocates when a new name is added.
+   */
+  FontNameId intern(StyleStringView name);
+
+  /**
+   * The returned name is null-terminated and remains valid as long as the table exists.
+   */
+  [[nodiscard]] const StyleString &name(FontNameId id) const {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _names[id];
+  }
+
+  [[nodiscard]] size_t size() const {
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _names.size();
+  }
+
+ private:
+  mutable std::shared_mutex _mutex;
+  // Elements of a deque are never moved, so the map can refer to the strings directly
+  std::deque<StyleString> _names;
+  std::unordered_map<StyleStringView, FontNameId> _ids;
+};
@@ -0,0 +1,94 @@
+
+#include <algorithm>
+
+#include "GlyphOutlineCache.h"
+#include "StyleHash.h"
+
+// Direct2D does not report the memory used by a path geometry, so it is estimated per glyph
+constexpr size_t EstimatedBytesPerGlyph = 512;
+
+static uint64_t HashGlyphRun(const DWRITE_GLYPH_RUN &glyphRun) {
+  using namespace StyleHash;
+  auto hash = Combine(Seed, (uint64_t)(uintptr_t)glyphRun.fontFace);
+  hash = Combine(hash, Float(glyphRun.fontEmSize));
+  hash = Combine(hash, glyphRun.isSideways);
+  hash = Combine(hash, glyphRun.bidiLevel % 2);
+  hash = Combine(hash, glyphRun.glyphCount);
+  for (uint32_t i = 0; i < glyphRun.glyphCount; i++) {
+    hash = Combine(hash, glyphRun.glyphIndices[i]);
+    if (glyphRun.glyphAdvances) {
+      hash = Combine(hash, Float(glyphRun.glyphAdvances[i]));
+    }
+    if (glyphRun.glyphOffsets) {
+      hash = Combine(hash, Float(glyphRun.glyphOffsets[i].advanceOffset));
+      hash = Combine(hash, Float(glyphRun.glyphOffsets[i].ascenderOffset));
+    }
+  }
+  return hash;
+}
+
+bool GlyphOutlineCache::Outline::Matches(const DWRITE_GLYPH_RUN &glyphRun) const {
+  auto count = glyphRun.glyphCount;
+  if (fontFace.get() != glyphRun.fontFace || fontEmSize != glyphRun.fontEmSize ||
+      isSideways != (glyphRun.isSideways != 0) || isRightToLeft != (glyphRun.bidiLevel % 2 != 0) ||
+      glyphIndices.size() != count ||
+      glyphAdvances.size() != (glyphRun.glyphAdvances ? count : 0) ||
+      glyphOffsets.size() != (glyphRun.glyphOffsets ? count : 0)) {
+    return false;
+  }
+  if (!std::equal(glyphIndices.begin(), glyphIndices.end(), glyphRun.glyphIndices) ||
+      (glyphRun.glyphAdvances &&
+       !std::equal(glyphAdvances.begin(), glyphAdvances.end(), glyphRun.glyphAdvances))) {
+    return false;
+  }
+  if (glyphRun.glyphOffsets) {
+    for (uint32_t i = 0; i < count; i++) {
+      if (glyphOffsets[i].advanceOffset != glyphRun.glyphOffsets[i].advanceOffset ||
+          glyphOffsets[i].ascenderOffset != glyphRun.glyphOffsets[i].ascenderOffset) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+ID2D1PathGeometry *GlyphOutlineCache::Get(ID2D1Factory &factory,
+                                          const DWRITE_GLYPH_RUN &glyphRun) {
+  auto hash = HashGlyphRun(glyphRun);
+  // An entry for a different glyph run with the same hash is replaced below
+  if (auto outline = _cache.find(hash); outline && outline->Matches(glyphRun)) {
+    return outline->geometry.get();
+  }
+
+  auto count = glyphRun.glyphCount;
+  Outline outline;
+  outline.fontFace.copy_from(glyphRun.fontFace);
+  outline.fontEmSize = glyphRun.fontEmSize;
+  outline.isSideways = glyphRun.isSideways != 0;
+  outline.isRightToLeft = glyphRun.bidiLevel % 2 != 0;
+  outline.glyphIndices.assign(glyphRun.glyphIndices, glyphRun.glyphIndices + count);
+  if (glyphRun.glyphAdvances) {
+    outline.glyphAdvances.assign(glyphRun.glyphAdvances, glyphRun.glyphAdvances + count);
+  }
+  if (glyphRun.glyphOffsets) {
+    outline.glyphOffsets.assign(glyphRun.glyphOffsets, glyphRun.glyphOffsets + count);
+  }
+
+  winrt::check_hresult(factory.CreatePathGeometry(outline.geometry.put()));
+  winrt::com_ptr<ID2D1GeometrySink> sink;
+  winrt::check_hresult(outline.geometry->Open(sink.put()));
+  winrt::check_hresult(glyphRun.fontFace->GetGlyphRunOutline(glyphRun.fontEmSize,
+                                                             glyphRun.glyphIndices,
+                                                             glyphRun.glyphAdvances,
+                                                             glyphRun.glyphOffsets,
+                                                             count,
+                                                             glyphRun.isSideways,
+                                                             outline.isRightToLeft,
+                                                             sink.get()));
+  winrt::check_hresult(sink->Close());
+
+  auto bytes = sizeof(Outline) +
+               count * (sizeof(uint16_t) + sizeof(float) + sizeof(DWRITE_GLYPH_OFFSET) +
+                        EstimatedBytesPerGlyph);
+  return _cache.insert(hash, std::move(outline), bytes)->geometry.get();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <d2d1_1.h>
+#include <dwrite.h>
+#include <winrt/base.h>
+
+#include <vector>
+
+#include "../../LruCache.h"
+
+/**
+ * Caches the outline geometry of glyph runs that are drawn with an outline, so that outlined text
+ * that does not change is not converted to a path geometry again on every frame. Geometries are
+ * built at the origin and have to be translated to the glyph run's position when drawing them.
+ *
+ * Entries are found by a hash of the font face, size and glyphs, and the glyphs are compared in
+ * full before an entry is returned. The cache is limited by the number of entries and by an
+ * estimate of their memory use.
+ */
+class GlyphOutlineCache {
+ public:
+  static constexpr size_t MaxEntries = 2048;
+  static constexpr size_t MaxBytes = 4 * 1024 * 1024;
+
+  GlyphOutlineCache() : _cache(MaxEntries, MaxBytes) {}
+
+  /**
+   * Returns the outline of the glyph run, which remains valid until the next call.
+   */
+  ID2D1PathGeometry *Get(ID2D1Factory &factory, const DWRITE_GLYPH_RUN &glyphRun);
+
+  void Clear() {
+    _cache.clear();
+  }
+
+  [[nodiscard]] const LruCacheStats &Stats() const {
+    return _cache.stats();
+  }
+
+ private:
+  struct Outline {
+    // Keeps the font face alive, so that its address can not be reused by another font face
+    winrt::com_ptr<IDWriteFontFace> fontFace;
+    float fontEmSize;
+    bool isSideways;
+    bool isRightToLeft;
+    std::vector<uint16_t> glyphIndices;
+    std::vector<float> glyphAdvances;
+    std::vector<DWRITE_GLYPH_OFFSET> glyphOffsets;
+    winrt::com_ptr<ID2D1PathGeometry> geometry;
+
+    [[nodiscard]] bool Matches(const DWRITE_GLYPH_RUN &glyphRun) const;
+  };
+
+  LruCache<uint64_t, Outline> _cache;
+};
@@ -1,8 +1,10 @@
 
 #pragma once
 
-#include <winrt/base.h>
 #include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
 
 enum class TextAlign : int { Left = 0, Center, Right, Justified };
 
@@ -87,29 +89,38 @@ struct ParagraphStyle {
   bool HangingIndent;
   float Indent;
   float TabStopWidth;
-  TextAlign TextAlignment;
-  ParagraphAlign ParagraphAlignment;
-  WordWrap WordWrap;
-  TrimMode TrimMode;
-  TrimmingSign TrimmingSign;
-  LineSpacingMode LineSpacingMode; // Default, Uniform, Proportional
+  ::TextAlign TextAlignment;
+  ::ParagraphAlign ParagraphAlignment;
+  ::WordWrap WordWrap;
+  ::TrimMode TrimMode;
+  ::TrimmingSign TrimmingSign;
+  ::LineSpacingMode LineSpacingMode; // Default, Uniform, Proportional
   // If mode is proportional, this is a factor
   // If mode is default this is ignored
   // If mode is uniform, this is an absolute pixel value
   float LineHeight;
 };
 
+// Managed code passes strings as UTF-16, which matches wchar_t only on Windows
+#ifdef _WIN32
+using StyleChar = wchar_t;
+#else
+using StyleChar = char16_t;
+#endif
+using StyleString = std::basic_string<StyleChar>;
+using StyleStringView = std::basic_string_view<StyleChar>;
+
 struct TextStyle {
-  const wchar_t *FontFace;
+  const StyleChar *FontFace;
   float FontSize;
   // ARGB (high->low)
   uint32_t Color;
   bool Underline;
   bool LineThrough;
   bool Kerning;
-  FontStretch FontStretch;
-  FontStyle FontStyle;
-  FontWeight FontWeight;
+  ::FontStretch FontStretch;
+  ::FontStyle FontStyle;
+  ::FontWeight FontWeight;
   uint32_t DropShadowColor;
   uint32_t OutlineColor;
   float OutlineWidth;
@@ -142,6 +153,27 @@ inline constexpr TextStyleProperty operator&(TextStyleProperty a, TextStylePrope
   return static_cast<TextStyleProperty>(static_cast<int>(a) & static_cast<int>(b));
 }
 
+/**
+ * Applies the given properties of a text style to a range of text in a layout.
+ */
+struct TextStyleRun {
+  uint32_t Start;
+  uint32_t Length;
+  TextStyleProperty Properties;
+  TextStyle Style;
+};
+
+/**
+ * Like TextStyleRun, but refers to a style in a separate table, so that spans with the same style
+ * can share it.
+ */
+struct TextStyleSpan {
+  uint32_t Start;
+  uint32_t Length;
+  TextStyleProperty Properties;
+  uint32_t StyleIndex;
+};
+
 inline bool IsTransparent(uint32_t color) {
   return (color & 0xFF000000) == 0;
 }
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+#include "Style.h"
+
+/**
+ * Hashing and comparison of styles for the caches of the drawing engine.
+ */
+namespace StyleHash {
+
+// Every value is folded in with a multiplication, so that unlike XOR-ing hashes, equal values in
+// different fields do not cancel out and swapping two fields changes the hash
+inline uint64_t Combine(uint64_t hash, uint64_t value) {
+  hash = (hash ^ value) * 0xff51afd7ed558ccdull;
+  return hash ^ (hash >> 32);
+}
+
+inline uint64_t Float(float value) {
+  // 0.0 and -0.0 compare equal, so they have to hash to the same value
+  if (value == 0) {
+    return 0;
+  }
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+inline uint64_t String(StyleStringView text) {
+  return std::hash<StyleStringView>()(text);
+}
+
+constexpr uint64_t Seed = 0x9e3779b97f4a7c15ull;
+
+inline uint64_t Of(const ParagraphStyle &style) {
+  auto hash = Seed;
+  hash = Combine(hash, style.HangingIndent);
+  hash = Combine(hash, Float(style.Indent));
+  hash = Combine(hash, Float(style.TabStopWidth));
+  hash = Combine(hash, (uint64_t)style.TextAlignment);
+  hash = Combine(hash, (uint64_t)style.ParagraphAlignment);
+  hash = Combine(hash, (uint64_t)style.WordWrap);
+  hash = Combine(hash, (uint64_t)style.TrimMode);
+  hash = Combine(hash, (uint64_t)style.TrimmingSign);
+  hash = Combine(hash, (uint64_t)style.LineSpacingMode);
+  hash = Combine(hash, Float(style.LineHeight));
+  return hash;
+}
+
+inline uint64_t Of(const TextStyle &style) {
+  auto hash = Seed;
+  hash = Combine(hash, style.FontFace ? String(style.FontFace) : 0);
+  hash = Combine(hash, Float(style.FontSize));
+  hash = Combine(hash, style.Color);
+  hash = Combine(hash, style.Underline);
+  hash = Combine(hash, style.LineThrough);
+  hash = Combine(hash, style.Kerning);
+  hash = Combine(hash, (uint64_t)style.FontStretch);
+  hash = Combine(hash, (uint64_t)style.FontStyle);
+  hash = Combine(hash, (uint64_t)style.FontWeight);
+  hash = Combine(hash, style.DropShadowColor);
+  hash = Combine(hash, style.OutlineColor);
+  hash = Combine(hash, Float(style.OutlineWidth));
+  return hash;
+}
+
+inline uint64_t Of(const TextStyleRun &run) {
+  auto hash = Seed;
+  hash = Combine(hash, run.Start);
+  hash = Combine(hash, run.Length);
+  hash = Combine(hash, (uint64_t)run.Properties);
+  return Combine(hash, Of(run.Style));
+}
+
+inline bool Equal(const ParagraphStyle &a, const ParagraphStyle &b) {
+  return a.HangingIndent == b.HangingIndent &&            //
+         a.Indent == b.Indent &&                          //
+         a.TabStopWidth == b.TabStopWidth &&              //
+         a.TextAlignment == b.TextAlignment &&            //
+         a.ParagraphAlignment == b.ParagraphAlignment &&  //
+         a.WordWrap == b.WordWrap &&                      //
+         a.TrimMode == b.TrimMode &&                      //
+         a.TrimmingSign == b.TrimmingSign &&              //
+         a.LineSpacingMode == b.LineSpacingMode &&        //
+         a.LineHeight == b.LineHeight;
+}
+
+inline bool Equal(const TextStyle &a, const TextStyle &b) {
+  // Font faces are compared by their name, not by their address
+  auto sameFontFace = a.FontFace == b.FontFace ||
+                      (a.FontFace && b.FontFace &&
+                       StyleStringView(a.FontFace) == StyleStringView(b.FontFace));
+  return sameFontFace &&                            //
+         a.FontSize == b.FontSize &&                //
+         a.Color == b.Color &&                      //
+         a.Underline == b.Underline &&              //
+         a.LineThrough == b.LineThrough &&          //
+         a.Kerning == b.Kerning &&                  //
+         a.FontStretch == b.FontStretch &&          //
+         a.FontStyle == b.FontStyle &&              //
+         a.FontWeight == b.FontWeight &&            //
+         a.DropShadowColor == b.DropShadowColor &&  //
+         a.OutlineColor == b.OutlineColor &&        //
+         a.OutlineWidth == b.OutlineWidth;
+}
+
+inline bool Equal(const TextStyleRun &a, const TextStyleRun &b) {
+  return a.Start == b.Start && a.Length == b.Length && a.Properties == b.Properties &&
+         Equal(a.Style, b.Style);
+}
+
+}  // namespace StyleHash
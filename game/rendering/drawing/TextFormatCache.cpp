@@ -0,0 +1,29 @@
+#include "TextFormatCache.h"
+
+TextFormatCache::TextFormatCache(size_t maxEntries) {
+  auto entriesPerShard = (maxEntries + ShardCount - 1) / ShardCount;
+  for (auto &shard : _shards) {
+    shard = std::make_unique<Shard>(entriesPerShard);
+  }
+}
+
+bool TextFormatCache::tryGet(const TextFormatKey &key,
+                             winrt::com_ptr<IDWriteTextFormat2> &format) {
+  auto &shard = shardFor(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  return shard.cache.tryGet(key, format);
+}
+
+void TextFormatCache::insert(const TextFormatKey &key,
+                             const winrt::com_ptr<IDWriteTextFormat2> &format) {
+  auto &shard = shardFor(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  shard.cache.insert(key, format);
+}
+
+void TextFormatCache::clear() {
+  for (auto &shard : _shards) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    shard->cache.clear();
+  }
+}
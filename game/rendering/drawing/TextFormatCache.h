@@ -0,0 +1,46 @@
+#pragma once
+
+#include <dwrite_3.h>
+#include <winrt/base.h>
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+#include "../../LruCache.h"
+#include "TextFormatKey.h"
+
+/**
+ * Retains the DirectWrite text formats that layouts are created from.
+ *
+ * Thread-safe. Formats are spread over shards by the hash of their key, each with its own lock,
+ * so that threads creating layouts at the same time rarely wait for each other. Formats are
+ * created outside of the lock, and are not changed once they are in the cache.
+ */
+class TextFormatCache {
+ public:
+  static constexpr size_t ShardCount = 8;
+
+  explicit TextFormatCache(size_t maxEntries);
+
+  bool tryGet(const TextFormatKey &key, winrt::com_ptr<IDWriteTextFormat2> &format);
+
+  void insert(const TextFormatKey &key, const winrt::com_ptr<IDWriteTextFormat2> &format);
+
+  void clear();
+
+ private:
+  struct Shard {
+    explicit Shard(size_t maxEntries) : cache(maxEntries) {}
+
+    std::mutex mutex;
+    LruCache<TextFormatKey, winrt::com_ptr<IDWriteTextFormat2>> cache;
+  };
+
+  Shard &shardFor(const TextFormatKey &key) {
+    return *_shards[key.Hash % ShardCount];
+  }
+
+  std::array<std::unique_ptr<Shard>, ShardCount> _shards;
+};
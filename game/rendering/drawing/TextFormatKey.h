@@ -1,17 +1,23 @@
-
 #pragma once
 
-#include <algorithm>
-#include <string>
+#include <cstdint>
+#include <functional>
 
+#include "FontNameTable.h"
 #include "Style.h"
+#include "StyleHash.h"
 
 /**
  * Uniquely identifies a DirectWrite textformat for caching purposes.
+ *
+ * The font family is referred to by its interned ID, and the hash is computed once on
+ * construction, so creating and looking up a key does not allocate (unless the font name has
+ * never been seen before).
  */
 struct TextFormatKey {
-  TextFormatKey(const ParagraphStyle &paragraphStyle, const TextStyle &textStyle)
-      : FontFamilyName(textStyle.FontFace),
+  TextFormatKey(FontNameTable &fontNames, const ParagraphStyle &paragraphStyle,
+                const TextStyle &textStyle)
+      : FontFamily(fontNames.intern(textStyle.FontFace)),
         FontWeight(textStyle.FontWeight),
         FontStyle(textStyle.FontStyle),
         FontStretch(textStyle.FontStretch),
@@ -23,59 +29,67 @@ struct TextFormatKey {
         TrimMode(paragraphStyle.TrimMode),
         TrimmingSign(paragraphStyle.TrimmingSign),
         LineSpacingMode(paragraphStyle.LineSpacingMode),
-        LineHeight(paragraphStyle.LineHeight) {}
+        LineHeight(paragraphStyle.LineHeight),
+        Hash(ComputeHash()) {}
 
-  const std::wstring FontFamilyName;
-  const FontWeight FontWeight;
-  const FontStyle FontStyle;
-  const FontStretch FontStretch;
+  const FontNameId FontFamily;
+  const ::FontWeight FontWeight;
+  const ::FontStyle FontStyle;
+  const ::FontStretch FontStretch;
   const float FontSize;
   const float TabStopWidth;
-  const TextAlign TextAlignment;
-  const ParagraphAlign ParagraphAlignment;
-  const WordWrap WordWrap;
-  const TrimMode TrimMode;
-  const TrimmingSign TrimmingSign;
-  const LineSpacingMode LineSpacingMode;
+  const ::TextAlign TextAlignment;
+  const ::ParagraphAlign ParagraphAlignment;
+  const ::WordWrap WordWrap;
+  const ::TrimMode TrimMode;
+  const ::TrimmingSign TrimmingSign;
+  const ::LineSpacingMode LineSpacingMode;
   const float LineHeight;
+  const uint64_t Hash;
+
+  bool operator==(const TextFormatKey &other) const noexcept {
+    return Hash == other.Hash &&                              //
+           FontFamily == other.FontFamily &&                  //
+           FontWeight == other.FontWeight &&                  //
+           FontStyle == other.FontStyle &&                    //
+           FontStretch == other.FontStretch &&                //
+           FontSize == other.FontSize &&                      //
+           TabStopWidth == other.TabStopWidth &&              //
+           TextAlignment == other.TextAlignment &&            //
+           ParagraphAlignment == other.ParagraphAlignment &&  //
+           WordWrap == other.WordWrap &&                      //
+           TrimMode == other.TrimMode &&                      //
+           TrimmingSign == other.TrimmingSign &&              //
+           LineSpacingMode == other.LineSpacingMode &&        //
+           LineHeight == other.LineHeight;
+  }
+
+ private:
+  [[nodiscard]] uint64_t ComputeHash() const {
+    using namespace StyleHash;
+    auto hash = Seed;
+    hash = Combine(hash, FontFamily);
+    hash = Combine(hash, (uint64_t)FontWeight);
+    hash = Combine(hash, (uint64_t)FontStyle);
+    hash = Combine(hash, (uint64_t)FontStretch);
+    hash = Combine(hash, Float(FontSize));
+    hash = Combine(hash, Float(TabStopWidth));
+    hash = Combine(hash, (uint64_t)TextAlignment);
+    hash = Combine(hash, (uint64_t)ParagraphAlignment);
+    hash = Combine(hash, (uint64_t)WordWrap);
+    hash = Combine(hash, (uint64_t)TrimMode);
+    hash = Combine(hash, (uint64_t)TrimmingSign);
+    hash = Combine(hash, (uint64_t)LineSpacingMode);
+    hash = Combine(hash, Float(LineHeight));
+    return hash;
+  }
 };
 
 namespace std {
 template <>
 struct hash<TextFormatKey> {
   size_t operator()(const TextFormatKey &key) const noexcept {
-    return std::hash<wstring>()(key.FontFamilyName) ^       //
-           std::hash<int>()((int)key.FontWeight) ^          //
-           std::hash<int>()((int)key.FontStyle) ^           //
-           std::hash<int>()((int)key.FontStretch) ^         //
-           std::hash<float>()(key.FontSize) ^               //
-           std::hash<float>()(key.TabStopWidth) ^           //
-           std::hash<int>()((int)key.TextAlignment) ^       //
-           std::hash<int>()((int)key.ParagraphAlignment) ^  //
-           std::hash<int>()((int)key.WordWrap) ^            //
-           std::hash<int>()((int)key.TrimMode) ^            //
-           std::hash<int>()((int)key.TrimmingSign) ^        //
-           std::hash<int>()((int)key.LineSpacingMode) ^     //
-           std::hash<float>()(key.LineHeight);
-  }
-};
-
-template <>
-struct equal_to<TextFormatKey> {
-  bool operator()(const TextFormatKey &left, const TextFormatKey &right) const noexcept {
-    return left.FontFamilyName == right.FontFamilyName &&          //
-           left.FontWeight == right.FontWeight &&                  //
-           left.FontStyle == right.FontStyle &&                    //
-           left.FontStretch == right.FontStretch &&                //
-           left.FontSize == right.FontSize &&                      //
-           left.TabStopWidth == right.TabStopWidth &&              //
-           left.TextAlignment == right.TextAlignment &&            //
-           left.ParagraphAlignment == right.ParagraphAlignment &&  //
-           left.WordWrap == right.WordWrap &&                      //
-           left.TrimMode == right.TrimMode &&                      //
-           left.TrimmingSign == right.TrimmingSign &&                      //
-           left.LineSpacingMode == right.LineSpacingMode &&        //
-           left.LineHeight == right.LineHeight;
+    return (size_t)key.Hash;
   }
 };
 }  // namespace std
@@ -1,4 +1,6 @@
 
+#include <algorithm>
+
 #include "TextLayout.h"
 #include "DrawingEngine.h"
 #include "StyleConversion.h"
@@ -6,8 +8,21 @@
 #include "TextRendererStyle.h"
 
 void TextLayout::Render(TextRenderer &renderer, float x, float y, float opacity) {
-  TextRendererDrawingContext context(_defaultStyle, opacity);
-  _layout->Draw(&context, &renderer, x + _indent, y);
+  std::lock_guard<std::mutex> lock(_data->mutex);
+  TextRendererDrawingContext context(_data->defaultStyle, opacity);
+  _data->layout->Draw(&context, &renderer, x + _data->indent, y);
+}
+
+TextLayoutData &TextLayout::MakeUnique() {
+  // Any change invalidates the rasterized layout
+  _bitmap = {};
+  // Shared layouts are never changed, so their recipe can be read without holding the lock. The
+  // copy has no recipe, since it no longer matches the cache entry once it is changed.
+  if (_shared) {
+    _data = _engine.CreateTextLayoutData(*_data->recipe);
+    _shared = false;
+  }
+  return *_data;
 }
 
 constexpr auto RenderingPropertiesMask =
@@ -17,77 +32,172 @@ void TextLayout::SetStyle(uint32_t start,
                           uint32_t length,
                           TextStyleProperty properties,
                           const TextStyle &style) {
-  if (_hangingIndent) {
+  MakeUnique().SetStyle(start, length, properties, style);
+}
+
+void TextLayout::SetStyles(const TextStyleSpan *spans,
+                           uint32_t spanCount,
+                           const TextStyle *styles,
+                           uint32_t styleCount) {
+  MakeUnique().SetStyles(spans, spanCount, styles, styleCount);
+}
+
+void TextLayoutData::SetStyle(uint32_t start,
+                              uint32_t length,
+                              TextStyleProperty properties,
+                              const TextStyle &style) {
+  winrt::com_ptr<TextRendererStyle> renderStyle;
+  if ((properties & RenderingPropertiesMask) != static_cast<TextStyleProperty>(0)) {
+    renderStyle.attach(new TextRendererStyle(style));
+  }
+  SetStyle(start, length, properties, style, renderStyle.get());
+}
+
+void TextLayoutData::SetStyles(const TextStyleSpan *spans,
+                               uint32_t spanCount,
+                               const TextStyle *styles,
+                               uint32_t styleCount) {
+  // Renderer styles are created on first use, and then shared by all spans using the same style
+  std::vector<winrt::com_ptr<TextRendererStyle>> renderStyles(styleCount);
+  for (uint32_t i = 0; i < spanCount; i++) {
+    auto &span = spans[i];
+    auto &style = styles[span.StyleIndex];
+    auto &renderStyle = renderStyles[span.StyleIndex];
+    if (!renderStyle &&
+        (span.Properties & RenderingPropertiesMask) != static_cast<TextStyleProperty>(0)) {
+      renderStyle.attach(new TextRendererStyle(style));
+    }
+    SetStyle(span.Start, span.Length, span.Properties, style, renderStyle.get());
+  }
+}
+
+void TextLayoutData::SetStyle(uint32_t start,
+                              uint32_t length,
+                              TextStyleProperty properties,
+                              const TextStyle &style,
+                              TextRendererStyle *renderStyle) {
+  if (hangingIndent) {
     start++;
   }
 
   DWRITE_TEXT_RANGE range{start, length};
 
   if ((properties & TextStyleProperty::FontFace) == TextStyleProperty::FontFace) {
-    winrt::check_hresult(_layout->SetFontFamilyName(style.FontFace, range));
+    winrt::check_hresult(layout->SetFontFamilyName(style.FontFace, range));
   }
 
   if ((properties & TextStyleProperty::FontSize) == TextStyleProperty::FontSize) {
-    winrt::check_hresult(_layout->SetFontSize(style.FontSize, range));
+    winrt::check_hresult(layout->SetFontSize(style.FontSize, range));
   }
 
   if ((properties & TextStyleProperty::Underline) == TextStyleProperty::Underline) {
-    winrt::check_hresult(_layout->SetUnderline(style.Underline, range));
+    winrt::check_hresult(layout->SetUnderline(style.Underline, range));
   }
 
   if ((properties & TextStyleProperty::LineThrough) == TextStyleProperty::LineThrough) {
-    winrt::check_hresult(_layout->SetStrikethrough(style.LineThrough, range));
+    winrt::check_hresult(layout->SetStrikethrough(style.LineThrough, range));
   }
 
   if ((properties & TextStyleProperty::FontStretch) == TextStyleProperty::FontStretch) {
-    winrt::check_hresult(_layout->SetFontStretch(ConvertFontStretch(style.FontStretch), range));
+    winrt::check_hresult(layout->SetFontStretch(ConvertFontStretch(style.FontStretch), range));
   }
 
   if ((properties & TextStyleProperty::FontStyle) == TextStyleProperty::FontStyle) {
-    winrt::check_hresult(_layout->SetFontStyle(ConvertFontStyle(style.FontStyle), range));
+    winrt::check_hresult(layout->SetFontStyle(ConvertFontStyle(style.FontStyle), range));
   }
 
   if ((properties & TextStyleProperty::FontWeight) == TextStyleProperty::FontWeight) {
-    winrt::check_hresult(_layout->SetFontWeight(ConvertFontWeight(style.FontWeight), range));
+    winrt::check_hresult(layout->SetFontWeight(ConvertFontWeight(style.FontWeight), range));
   }
 
   if ((properties & TextStyleProperty::Kerning) == TextStyleProperty::Kerning) {
     // More easily applying kerning is a newer feature
-    if (_layout1) {
-      winrt::check_hresult(_layout1->SetPairKerning(style.Kerning, range));
+    if (layout1) {
+      winrt::check_hresult(layout1->SetPairKerning(style.Kerning, range));
     }
   }
 
-  if ((properties & RenderingPropertiesMask) != static_cast<TextStyleProperty>(0)) {
-    auto renderStyle = _engine.CreateTextRendererStyle(style);
-
-    winrt::check_hresult(_layout->SetDrawingEffect(renderStyle.get(), range));
+  if (renderStyle) {
+    winrt::check_hresult(layout->SetDrawingEffect(renderStyle, range));
+    if (renderStyle->HasOutline()) {
+      maxOutlineWidth = std::max<float>(maxOutlineWidth, renderStyle->GetOutlineWidth());
+    }
   }
+
+  metricsDirty = true;
 }
 
 void TextLayout::SetMaxWidth(float maxWidth) {
-  winrt::check_hresult(_layout->SetMaxWidth(maxWidth));
-  _metricsDirty = true;
+  auto &data = MakeUnique();
+  winrt::check_hresult(data.layout->SetMaxWidth(maxWidth));
+  data.metricsDirty = true;
 }
 
 void TextLayout::SetMaxHeight(float maxHeight) {
-  winrt::check_hresult(_layout->SetMaxHeight(maxHeight));
-  _metricsDirty = true;
+  auto &data = MakeUnique();
+  winrt::check_hresult(data.layout->SetMaxHeight(maxHeight));
+  data.metricsDirty = true;
 }
 
-const DWRITE_TEXT_METRICS &TextLayout::GetMetrics() {
-  if (_metricsDirty) {
-    winrt::check_hresult(_layout->GetMetrics(&_metrics));
-    _metricsDirty = false;
+void TextLayout::SetBitmapCaching(bool enabled) {
+  _bitmapCaching = enabled;
+  if (!enabled) {
+    _bitmap = {};
+  }
+}
+
+// Overhangs are measured from the edges of the layout box, whose size can be practically
+// unlimited. They are only used for boxes small enough for the sum to be precise.
+constexpr float MaxPreciseLayoutExtent = 65536.0f;
+
+// Covers the drop shadow offset and antialiasing, as well as glyphs that extend past the text
+// metrics when the overhangs can not be used
+constexpr float DrawBoundsPadding = 4.0f;
+
+D2D1_RECT_F TextLayout::GetDrawBounds() {
+  std::lock_guard<std::mutex> lock(_data->mutex);
+  auto &metrics = _data->GetMetrics();
+  DWRITE_OVERHANG_METRICS overhangs{};
+  winrt::check_hresult(_data->layout->GetOverhangMetrics(&overhangs));
+
+  auto left = std::min<float>(metrics.left, -overhangs.left);
+  auto top = std::min<float>(metrics.top, -overhangs.top);
+  auto right = metrics.left + metrics.widthIncludingTrailingWhitespace;
+  if (metrics.layoutWidth < MaxPreciseLayoutExtent) {
+    right = std::max<float>(right, metrics.layoutWidth + overhangs.right);
+  }
+  auto bottom = metrics.top + metrics.height;
+  if (metrics.layoutHeight < MaxPreciseLayoutExtent) {
+    bottom = std::max<float>(bottom, metrics.layoutHeight + overhangs.bottom);
+  }
+
+  auto padding = DrawBoundsPadding + _data->maxOutlineWidth / 2;
+  return D2D1::RectF(left + _data->indent - padding,
+                     top - padding,
+                     right + _data->indent + padding,
+                     bottom + padding);
+}
+
+const DWRITE_TEXT_METRICS &TextLayoutData::GetMetrics() {
+  if (metricsDirty) {
+    winrt::check_hresult(layout->GetMetrics(&metrics));
+    metricsDirty = false;
   }
 
-  return _metrics;
+  return metrics;
+}
+
+const DWRITE_TEXT_METRICS &TextLayout::GetMetrics() {
+  // Shared layouts are measured before they are shared, so the returned metrics do not change
+  std::lock_guard<std::mutex> lock(_data->mutex);
+  return _data->GetMetrics();
 }
 
 bool TextLayout::GetLineMetrics(DWRITE_LINE_METRICS *lineMetrics,
                                 uint32_t count,
                                 uint32_t *actualCount) {
-  auto hr = _layout->GetLineMetrics(lineMetrics, count, actualCount);
+  std::lock_guard<std::mutex> lock(_data->mutex);
+  auto hr = _data->layout->GetLineMetrics(lineMetrics, count, actualCount);
   if (hr == E_NOT_SUFFICIENT_BUFFER) {
     return false;
   }
@@ -96,12 +206,15 @@ bool TextLayout::GetLineMetrics(DWRITE_LINE_METRICS *lineMetrics,
 }
 
 bool TextLayout::HitTestPoint(float x, float y, int *position, int *length, bool *trailingHit) {
-  x -= _indent;
+  x -= _data->indent;
 
   BOOL trailingHitBool = 0;
   BOOL inside = 0;
   DWRITE_HIT_TEST_METRICS metrics{};
-  winrt::check_hresult(_layout->HitTestPoint(x, y, &trailingHitBool, &inside, &metrics));
+  {
+    std::lock_guard<std::mutex> lock(_data->mutex);
+    winrt::check_hresult(_data->layout->HitTestPoint(x, y, &trailingHitBool, &inside, &metrics));
+  }
 
   *trailingHit = trailingHitBool;
   *position = (int)metrics.textPosition;
@@ -109,7 +222,7 @@ bool TextLayout::HitTestPoint(float x, float y, int *position, int *length, bool
 
   // If we have a hanging indent, the first character is a fake inline object
   // We need to adjust the position accordingly
-  if (_hangingIndent) {
+  if (_data->hangingIndent) {
     if ((*position)-- == 0) {
       // If we did hit the hanging indent itself, mark it as an outside hit and
       // adjust the trailing hit since it's always "before" the first character
@@ -125,14 +238,17 @@ bool TextLayout::HitTestPoint(float x, float y, int *position, int *length, bool
 void TextLayout::HitTestTextPosition(uint32_t textPosition, bool afterPosition, DWRITE_HIT_TEST_METRICS *metrics) {
   float x = 0;
   float y = 0;
-  winrt::check_hresult(_layout->HitTestTextPosition(textPosition, afterPosition, &x, &y, metrics));
-  metrics->left += _indent;
+  std::lock_guard<std::mutex> lock(_data->mutex);
+  winrt::check_hresult(
+      _data->layout->HitTestTextPosition(textPosition, afterPosition, &x, &y, metrics));
+  metrics->left += _data->indent;
 }
 
 bool TextLayout::HitTestTextRange(uint32_t start, uint32_t length, DWRITE_HIT_TEST_METRICS *metrics,
                                   uint32_t metricsCount, uint32_t *actualMetricsCount) {
-  auto result =
-      _layout->HitTestTextRange(start, length, 0, 0, metrics, metricsCount, actualMetricsCount);
+  std::lock_guard<std::mutex> lock(_data->mutex);
+  auto result = _data->layout->HitTestTextRange(start, length, 0, 0, metrics, metricsCount,
+                                                actualMetricsCount);
   if (result == E_NOT_SUFFICIENT_BUFFER) {
     return false;
   }
@@ -140,7 +256,7 @@ bool TextLayout::HitTestTextRange(uint32_t start, uint32_t length, DWRITE_HIT_TE
   // Correct the left edge by adding our indent
   auto count = min(*actualMetricsCount, metricsCount);
   for (auto i = 0u; i < count; i++) {
-    metrics[i].left += _indent;
+    metrics[i].left += _data->indent;
   }
   return true;
 }
@@ -1,9 +1,13 @@
 
 #pragma once
 
+#include <d2d1_1.h>
 #include <dwrite_2.h>
 #include <winrt/base.h>
 
+#include <memory>
+#include <mutex>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -13,20 +17,104 @@
 class TextRenderer;
 class DrawingEngine;
 
+/**
+ * Everything needed to build a text layout again, which is kept for layouts in the layout cache.
+ * The font faces of the styles point to names interned by the drawing engine.
+ */
+struct TextLayoutRecipe {
+  ParagraphStyle paragraphStyle;
+  TextStyle textStyle;
+  std::wstring text;
+  float maxWidth;
+  float maxHeight;
+  std::vector<TextStyleRun> runs;
+};
+
+/**
+ * The DirectWrite layout behind a TextLayout. Layouts from the layout cache are shared by all
+ * TextLayout instances that were created with the same parameters, possibly on different threads.
+ * They are measured before they are shared, and are never changed afterwards.
+ */
+struct TextLayoutData {
+  TextLayoutData(const winrt::com_ptr<IDWriteTextLayout> &layout,
+                 const bool hangingIndent,
+                 const float indent,
+                 const TextStyle &defaultStyle)
+      : layout(layout),
+        layout1(layout.try_as<IDWriteTextLayout1>()),
+        layout2(layout.try_as<IDWriteTextLayout2>()),
+        hangingIndent(hangingIndent),
+        indent(indent),
+        defaultStyle(defaultStyle) {
+    if (this->defaultStyle.HasOutline()) {
+      maxOutlineWidth = this->defaultStyle.GetOutlineWidth();
+    }
+  }
+
+  const winrt::com_ptr<IDWriteTextLayout> layout;
+  const winrt::com_ptr<IDWriteTextLayout1> layout1;
+  const winrt::com_ptr<IDWriteTextLayout2> layout2;
+  const bool hangingIndent;
+  const float indent;
+  TextRendererStyle defaultStyle;
+  bool metricsDirty = true;
+  DWRITE_TEXT_METRICS metrics{};
+  // Widest outline of any style applied to the layout, which extends the drawn area
+  float maxOutlineWidth = 0;
+
+  // Only set for layouts from the layout cache
+  std::shared_ptr<const TextLayoutRecipe> recipe;
+
+  // DirectWrite layouts are not thread-safe, not even for queries. Held while the layout is drawn,
+  // measured or hit-tested, since a shared layout may be drawn by the render thread while a
+  // worker thread measures it.
+  std::mutex mutex;
+
+  void SetStyle(uint32_t start,
+                uint32_t length,
+                TextStyleProperty properties,
+                const TextStyle &style);
+
+  void SetStyles(const TextStyleSpan *spans,
+                 uint32_t spanCount,
+                 const TextStyle *styles,
+                 uint32_t styleCount);
+
+  /**
+   * Formats the layout if it has changed since it was last measured. The caller must hold the
+   * mutex if the layout may be shared.
+   */
+  const DWRITE_TEXT_METRICS &GetMetrics();
+
+ private:
+  void SetStyle(uint32_t start,
+                uint32_t length,
+                TextStyleProperty properties,
+                const TextStyle &style,
+                TextRendererStyle *renderStyle);
+};
+
+/**
+ * A text layout rasterized into a bitmap, with everything needed to tell whether it is still
+ * up-to-date.
+ */
+struct TextLayoutBitmap {
+  winrt::com_ptr<ID2D1Bitmap1> bitmap;
+  // Area covered by the bitmap in DIPs, relative to the position the layout is drawn at
+  D2D1_RECT_F bounds{};
+  float dpiX = 0;
+  float dpiY = 0;
+  uint32_t fontGeneration = 0;
+};
+
 class TextLayout {
  public:
-  TextLayout(DrawingEngine &engine,
-             const winrt::com_ptr<IDWriteTextLayout> &layout,
-             const bool hangingIndent,
-             const float indent,
-             TextRendererStyle defaultStyle)
-      : _engine(engine),
-        _layout(layout),
-        _layout1(layout.try_as<IDWriteTextLayout1>()),
-        _layout2(layout.try_as<IDWriteTextLayout2>()),
-        _hangingIndent(hangingIndent),
-        _indent(indent),
-        _defaultStyle(std::move(defaultStyle)) {}
+  /**
+   * @param shared Whether the data is shared with the layout cache, and thereby possibly with
+   * other threads.
+   */
+  TextLayout(DrawingEngine &engine, std::shared_ptr<TextLayoutData> data, bool shared = false)
+      : _engine(engine), _data(std::move(data)), _shared(shared) {}
 
   void Render(TextRenderer &renderer, float x, float y, float opacity);
 
@@ -35,6 +123,15 @@ class TextLayout {
                 TextStyleProperty properties,
                 const TextStyle &style);
 
+  /**
+   * Applies styles to multiple ranges of text at once. Each span refers to an entry of the style
+   * table by its index, which must be less than styleCount.
+   */
+  void SetStyles(const TextStyleSpan *spans,
+                 uint32_t spanCount,
+                 const TextStyle *styles,
+                 uint32_t styleCount);
+
   const DWRITE_TEXT_METRICS &GetMetrics();
 
   /**
@@ -47,6 +144,26 @@ class TextLayout {
 
   void SetMaxHeight(float maxHeight);
 
+  /**
+   * Enables drawing the layout from a bitmap, which is rasterized the first time the layout is
+   * drawn and again after it has been changed. See DrawingEngine::RenderTextLayout.
+   */
+  void SetBitmapCaching(bool enabled);
+
+  [[nodiscard]] bool IsBitmapCaching() const {
+    return _bitmapCaching;
+  }
+
+  TextLayoutBitmap &GetBitmap() {
+    return _bitmap;
+  }
+
+  /**
+   * Returns the area that drawing the layout at the origin may touch, including drop shadows and
+   * outlines, in DIPs.
+   */
+  D2D1_RECT_F GetDrawBounds();
+
   bool HitTestPoint(float x, float y, int *position, int *length, bool *trailingHit);
 
   /**
@@ -64,13 +181,16 @@ class TextLayout {
                         uint32_t *actualMetricsCount);
 
  private:
+  /**
+   * Layouts shared with the layout cache are copied before they are modified, so that the change
+   * is not visible through other TextLayout instances. Whether the data is shared is tracked
+   * explicitly rather than through the reference count, which other threads change concurrently.
+   */
+  TextLayoutData &MakeUnique();
+
   DrawingEngine &_engine;
-  const bool _hangingIndent;
-  const float _indent;
-  bool _metricsDirty = true;
-  TextRendererStyle _defaultStyle;
-  winrt::com_ptr<IDWriteTextLayout> _layout;
-  winrt::com_ptr<IDWriteTextLayout1> _layout1;
-  winrt::com_ptr<IDWriteTextLayout2> _layout2;
-  DWRITE_TEXT_METRICS _metrics{};
+  std::shared_ptr<TextLayoutData> _data;
+  bool _shared;
+  bool _bitmapCaching = false;
+  TextLayoutBitmap _bitmap;
 };
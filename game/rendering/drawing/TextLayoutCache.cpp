@@ -0,0 +1,73 @@
+
+#include "TextLayoutCache.h"
+#include "StyleHash.h"
+#include "TextLayout.h"
+
+// DirectWrite does not report the memory used by a layout, so it is estimated from the text length
+// (glyph indices, advances, offsets and cluster maps for every character)
+constexpr size_t EstimatedBytesPerCharacter = 48;
+constexpr size_t EstimatedBytesPerLayout = 1024;
+
+static size_t EstimateBytes(const TextLayoutRecipe &recipe) {
+  return EstimatedBytesPerLayout + sizeof(TextLayoutData) + sizeof(TextLayoutRecipe) +
+         recipe.text.length() * (sizeof(wchar_t) + EstimatedBytesPerCharacter) +
+         recipe.runs.size() * sizeof(TextStyleRun);
+}
+
+uint64_t TextLayoutCache::Hash(const TextLayoutRequest &request) {
+  using namespace StyleHash;
+  auto hash = Combine(Seed, String(request.text));
+  hash = Combine(hash, Of(request.paragraphStyle));
+  hash = Combine(hash, Of(request.textStyle));
+  hash = Combine(hash, Float(request.maxWidth));
+  hash = Combine(hash, Float(request.maxHeight));
+  hash = Combine(hash, request.runCount);
+  for (uint32_t i = 0; i < request.runCount; i++) {
+    hash = Combine(hash, Of(request.runs[i]));
+  }
+  return hash;
+}
+
+static bool Matches(const TextLayoutRecipe &recipe, const TextLayoutRequest &request) {
+  if (recipe.text != request.text || recipe.maxWidth != request.maxWidth ||
+      recipe.maxHeight != request.maxHeight || recipe.runs.size() != request.runCount ||
+      !StyleHash::Equal(recipe.paragraphStyle, request.paragraphStyle) ||
+      !StyleHash::Equal(recipe.textStyle, request.textStyle)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < request.runCount; i++) {
+    if (!StyleHash::Equal(recipe.runs[i], request.runs[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::shared_ptr<TextLayoutData> TextLayoutCache::find(uint64_t hash,
+                                                      const TextLayoutRequest &request) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto entry = _cache->find(hash);
+  // A different layout with the same hash is treated as a miss, and replaced on insert
+  if (entry && Matches(*(*entry)->recipe, request)) {
+    return *entry;
+  }
+  return nullptr;
+}
+
+void TextLayoutCache::insert(uint64_t hash, std::shared_ptr<TextLayoutData> data) {
+  auto bytes = EstimateBytes(*data->recipe);
+  std::lock_guard<std::mutex> lock(_mutex);
+  _cache->insert(hash, std::move(data), bytes);
+}
+
+void TextLayoutCache::configure(size_t maxEntries, size_t maxBytes) {
+  auto cache = std::make_unique<Cache>(maxEntries, maxBytes);
+  std::lock_guard<std::mutex> lock(_mutex);
+  _cache = std::move(cache);
+}
+
+TextLayoutCacheStats TextLayoutCache::stats() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto &stats = _cache->stats();
+  return {stats.hits, stats.misses, stats.evictions, (uint32_t)_cache->size(), _cache->weight()};
+}
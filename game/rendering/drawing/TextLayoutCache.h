@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+#include "../../LruCache.h"
+#include "Style.h"
+
+struct TextLayoutData;
+
+struct TextLayoutCacheStats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  uint32_t entries;
+  uint64_t bytes;
+};
+
+/**
+ * The parameters of a text layout that is requested from the layout cache.
+ */
+struct TextLayoutRequest {
+  const ParagraphStyle &paragraphStyle;
+  const TextStyle &textStyle;
+  std::wstring_view text;
+  float maxWidth;
+  float maxHeight;
+  const TextStyleRun *runs;
+  uint32_t runCount;
+};
+
+/**
+ * Retains text layouts, so that labels whose text, styles and size do not change are only laid out
+ * once. Entries are found by a hash of all parameters, and the parameters are compared in full
+ * before an entry is returned. The cache is limited by the number of entries and by an estimate of
+ * the memory used by the layouts.
+ *
+ * Thread-safe. Layouts are created outside of the lock, so two threads requesting the same missing
+ * layout both create it, and the second insert replaces the first.
+ */
+class TextLayoutCache {
+ public:
+  static constexpr size_t DefaultMaxEntries = 1024;
+  static constexpr size_t DefaultMaxBytes = 8 * 1024 * 1024;
+
+  TextLayoutCache() : _cache(std::make_unique<Cache>(DefaultMaxEntries, DefaultMaxBytes)) {}
+
+  static uint64_t Hash(const TextLayoutRequest &request);
+
+  std::shared_ptr<TextLayoutData> find(uint64_t hash, const TextLayoutRequest &request);
+
+  void insert(uint64_t hash, std::shared_ptr<TextLayoutData> data);
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _cache->clear();
+  }
+
+  /**
+   * Changes the limits of the cache, which drops all cached layouts and resets the statistics.
+   * A maxEntries of 0 disables the cache.
+   */
+  void configure(size_t maxEntries, size_t maxBytes);
+
+  [[nodiscard]] bool enabled() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _cache->maxCount() > 0;
+  }
+
+  [[nodiscard]] TextLayoutCacheStats stats() const;
+
+ private:
+  using Cache = LruCache<uint64_t, std::shared_ptr<TextLayoutData>>;
+
+  mutable std::mutex _mutex;
+  // Recreated when the limits change
+  std::unique_ptr<Cache> _cache;
+};
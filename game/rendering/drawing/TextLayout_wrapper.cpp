@@ -1,5 +1,6 @@
 
 #include "../../interop/string_interop.h"
+#include "../../logging/BinaryLog.h"
 #include "../../logging/Logger.h"
 #include "../../utils.h"
 #include "TextLayout.h"
@@ -21,6 +22,39 @@ NATIVE_API ApiBool TextLayout_SetStyle(TextLayout *layout,
   }
 }
 
+/**
+ * Applies multiple styles in one call. Spans refer to entries of the style table by index, and
+ * the rendering style of each entry is only created once.
+ */
+NATIVE_API ApiBool TextLayout_SetStyles(TextLayout *layout,
+                                        const TextStyleSpan *spans,
+                                        uint32_t spanCount,
+                                        const TextStyle *styles,
+                                        uint32_t styleCount,
+                                        char16_t **error) noexcept {
+  *error = nullptr;
+
+  for (uint32_t i = 0; i < spanCount; i++) {
+    if (spans[i].StyleIndex >= styleCount) {
+      *error = copyString(L"Style index of span " + std::to_wstring(i) + L" is out of range.");
+      return false;
+    }
+    if ((spans[i].Properties & TextStyleProperty::FontFace) == TextStyleProperty::FontFace &&
+        !styles[spans[i].StyleIndex].FontFace) {
+      *error = copyString(L"FontFace must be set for spans that change the font face.");
+      return false;
+    }
+  }
+
+  try {
+    layout->SetStyles(spans, spanCount, styles, styleCount);
+    return true;
+  } catch (const winrt::hresult_error &e) {
+    *error = copyString(e.message().c_str());
+    return false;
+  }
+}
+
 NATIVE_API void TextLayout_Free(TextLayout *layout) noexcept {
   delete layout;
 }
@@ -117,7 +151,8 @@ NATIVE_API ApiBool TextLayout_HitTestPoint(
     *trailingHit = trailingHitBool;
     return hit;
   } catch (winrt::hresult_error &e) {
-    Logger::Error(std::wstring(L"TextLayout_HitTestPoint failed: ") + e.message());
+    // Hit testing runs for every mouse move, so keep this cheap when it fails repeatedly
+    BINARY_LOG(LogLevel::Error, L"TextLayout_HitTestPoint failed: {}", e.message());
     return false;
   }
 }
@@ -153,7 +188,7 @@ NATIVE_API void TextLayout_HitTestTextPosition(TextLayout *layout,
     ConvertHitTestRects(&metrics, rect, 1);
   } catch (winrt::hresult_error &e) {
     *rect = {};
-    Logger::Error(std::wstring(L"TextLayout_HitTestTextPosition failed: ") + e.message());
+    BINARY_LOG(LogLevel::Error, L"TextLayout_HitTestTextPosition failed: {}", e.message());
   }
 }
 
@@ -210,3 +245,7 @@ NATIVE_API ApiBool TextLayout_SetMaxHeight(TextLayout *layout, float maxHeight)
     return false;
   }
 }
+
+NATIVE_API void TextLayout_SetBitmapCaching(TextLayout *layout, ApiBool enabled) noexcept {
+  layout->SetBitmapCaching(enabled);
+}
@@ -2,24 +2,11 @@
 #include <d2d1_2.h>
 #include <dwrite_2.h>
 #include <winrt/base.h>
-#include <functional>
 
 #include "StyleConversion.h"
 #include "TextRenderer.h"
 #include "TextRendererStyle.h"
 
-static inline void WithOpacity(ID2D1Brush *brush, float opacity,
-                               const std::function<void(ID2D1Brush *)> &callback) {
-  if (opacity < 1) {
-    float orgOpacity = brush->GetOpacity();
-    brush->SetOpacity(opacity);
-    callback(brush);
-    brush->SetOpacity(orgOpacity);
-  } else {
-    callback(brush);
-  }
-}
-
 static inline TextRendererDrawingContext &GetDrawingContext(void *clientDrawingContext) {
   return *reinterpret_cast<TextRendererDrawingContext *>(clientDrawingContext);
 }
@@ -34,6 +21,17 @@ TextRenderer::TextRenderer(const winrt::com_ptr<IDWriteFactory> &dWriteFactory,
                            const winrt::com_ptr<ID2D1DeviceContext> &deviceContext)
     : _dWriteFactory2(dWriteFactory.as<IDWriteFactory2>()), _context(deviceContext) {
   _context->GetFactory(_factory.put());
+  winrt::check_hresult(_context->CreateSolidColorBrush(D2D1::ColorF(0, 0.0f), _brush.put()));
+}
+
+ID2D1Brush *TextRenderer::GetBrush(const D2D1_COLOR_F &color, float opacity) {
+  _brush->SetColor(color);
+  _brush->SetOpacity(opacity);
+  return _brush.get();
+}
+
+ID2D1Brush *TextRenderer::GetBrush(uint32_t color, float opacity) {
+  return GetBrush(ConvertColor(color), opacity);
 }
 
 HRESULT TextRenderer::IsPixelSnappingDisabled(void *clientDrawingContext,
@@ -67,12 +65,10 @@ HRESULT TextRenderer::DrawGlyphRun(void *clientDrawingContext,
 
   // If the style dictates a drop shadow, draw it first by simply drawing the glyph run
   // offset by 1,1
-  auto &shadowBrush = style.GetDropShadowColor();
-  if (shadowBrush) {
+  if (style.HasDropShadow()) {
     auto origin = D2D1::Point2(baselineOriginX + 1, baselineOriginY + 1);
-    WithOpacity(shadowBrush.get(), opacity, [&](auto brush) {
-      _context->DrawGlyphRun(origin, glyphRun, brush, measuringMode);
-    });
+    _context->DrawGlyphRun(origin, glyphRun, GetBrush(style.GetDropShadowColor(), opacity),
+                           measuringMode);
   }
 
   // Attempt to draw colored glyph layers first,
@@ -82,11 +78,8 @@ HRESULT TextRenderer::DrawGlyphRun(void *clientDrawingContext,
     if (style.HasOutline()) {
       DrawOutline(style, baselineOriginX, baselineOriginY, glyphRun, opacity);
     } else {
-      auto brush = style.GetColor().get();
-      WithOpacity(brush, opacity, [&](auto brush) {
-        _context->DrawGlyphRun(D2D1::Point2(baselineOriginX, baselineOriginY), glyphRun, brush,
-                                    measuringMode);
-      });
+      _context->DrawGlyphRun(D2D1::Point2(baselineOriginX, baselineOriginY), glyphRun,
+                             GetBrush(style.GetColor(), opacity), measuringMode);
     }
   }
 
@@ -123,8 +116,6 @@ bool TextRenderer::DrawColoredLayers(float baselineOriginX,
   winrt::check_hresult(result);
 
   // DirectWrite will tell us if the glyph run has no layers to save us time
-  winrt::com_ptr<ID2D1SolidColorBrush> solidBrush;
-
   // If it has layers, draw each layer with the correct color
   for (;;) {
     BOOL haveRun;
@@ -137,24 +128,16 @@ bool TextRenderer::DrawColoredLayers(float baselineOriginX,
 
     ID2D1Brush *layerBrush;
     if (colorRun->paletteIndex == 0xFFFF) {
-      layerBrush = style.GetColor().get();
+      layerBrush = GetBrush(style.GetColor(), opacity);
     } else {
-      if (solidBrush == nullptr) {
-        winrt::check_hresult(
-            _context->CreateSolidColorBrush(&colorRun->runColor, nullptr, solidBrush.put()));
-      } else {
-        solidBrush->SetColor(colorRun->runColor);
-      }
-      layerBrush = solidBrush.get();
+      layerBrush = GetBrush(colorRun->runColor, opacity);
     }
 
-    WithOpacity(layerBrush, opacity, [&](auto brush) {
-      _context->DrawGlyphRun(
-          D2D1::Point2(colorRun->baselineOriginX, colorRun->baselineOriginY),
-          &colorRun->glyphRun,
-          brush,
-          measuringMode);
-    });
+    _context->DrawGlyphRun(
+        D2D1::Point2(colorRun->baselineOriginX, colorRun->baselineOriginY),
+        &colorRun->glyphRun,
+        layerBrush,
+        measuringMode);
   }
 
   return true;
@@ -163,8 +146,7 @@ bool TextRenderer::DrawColoredLayers(float baselineOriginX,
 void TextRenderer::FillRectangle(const D2D_RECT_F &rect,
                                  const TextRendererStyle &style,
                                  float opacity) {
-  WithOpacity(style.GetColor().get(), opacity,
-              [&](auto brush) { _context->FillRectangle(&rect, brush); });
+  _context->FillRectangle(&rect, GetBrush(style.GetColor(), opacity));
 }
 
 HRESULT TextRenderer::DrawUnderline(void *clientDrawingContext, FLOAT baselineOriginX,
@@ -234,56 +216,21 @@ ULONG TextRenderer::Release() {
   return 0;
 }
 
-/**
- * Convenience function to create a path geometry using a geometry sink.
- */
-inline winrt::com_ptr<ID2D1PathGeometry> CreatePathGeometry(
-    ID2D1Factory &factory, const std::function<void(ID2D1GeometrySink *)> &consumer) {
-  winrt::com_ptr<ID2D1PathGeometry> pathGeometry;
-  winrt::check_hresult(factory.CreatePathGeometry(pathGeometry.put()));
-
-  winrt::com_ptr<ID2D1GeometrySink> sink;
-  winrt::check_hresult(pathGeometry->Open(sink.put()));
-  consumer(sink.get());
-  winrt::check_hresult(sink->Close());
-
-  return std::move(pathGeometry);
-}
-
 void TextRenderer::DrawOutline(const TextRendererStyle &style,
                                float x,
                                float y,
                                const DWRITE_GLYPH_RUN *glyphRun,
                                float opacity) {
-  auto pathGeometry = CreatePathGeometry(*_factory, [&](auto sink) {
-    auto fontFace = glyphRun->fontFace;
-    winrt::check_hresult(fontFace->GetGlyphRunOutline(glyphRun->fontEmSize,
-                                                      glyphRun->glyphIndices,
-                                                      glyphRun->glyphAdvances,
-                                                      glyphRun->glyphOffsets,
-                                                      glyphRun->glyphCount,
-                                                      glyphRun->isSideways,
-                                                      glyphRun->bidiLevel % 2 != 0,
-                                                      sink));
-  });
-
-  // Initialize a matrix to translate the origin of the glyph run.
-  auto matrix = new D2D1::Matrix3x2F(1.0f, 0.0f, 0.0f, 1.0f, x, y);
-  winrt::com_ptr<ID2D1TransformedGeometry> transformedGeometry;
-  winrt::check_hresult(
-      _factory->CreateTransformedGeometry(pathGeometry.get(), matrix, transformedGeometry.put()));
-
-  auto outlineWidth = style.GetOutlineWidth();
-  auto &outlineBrush = style.GetOutlineColor();
-  auto &fillBrush = style.GetColor();
-
-  if (fillBrush) {
-    WithOpacity(fillBrush.get(), opacity,
-                [&](auto brush) { _context->FillGeometry(transformedGeometry.get(), brush); });
-  }
-  if (outlineBrush) {
-    WithOpacity(outlineBrush.get(), opacity, [&](auto brush) {
-      _context->DrawGeometry(transformedGeometry.get(), brush, outlineWidth);
-    });
-  }
+  // The cached outline is at the origin, so it is moved to the glyph run by the transform
+  auto geometry = _outlineCache.Get(*_factory, *glyphRun);
+  D2D1_MATRIX_3X2_F transform;
+  _context->GetTransform(&transform);
+  _context->SetTransform(D2D1::Matrix3x2F::Translation(x, y) *
+                         static_cast<const D2D1::Matrix3x2F &>(transform));
+
+  _context->FillGeometry(geometry, GetBrush(style.GetColor(), opacity));
+  _context->DrawGeometry(geometry, GetBrush(style.GetOutlineColor(), opacity),
+                         style.GetOutlineWidth());
+
+  _context->SetTransform(transform);
 }
@@ -3,8 +3,9 @@
 
 #include <d2d1_1.h>
 #include <dwrite_3.h>
+#include <winrt/base.h>
 
-#include "LRUCache11.h"
+#include "GlyphOutlineCache.h"
 #include "Style.h"
 
 struct TextRendererStyle;
@@ -47,10 +48,23 @@ class TextRenderer : public IDWriteTextRenderer {
   ULONG STDMETHODCALLTYPE AddRef() override;
   ULONG STDMETHODCALLTYPE Release() override;
 
+  /**
+   * Discards the cached outlines, which keep the font faces they were built from alive.
+   */
+  void ClearOutlineCache() {
+    _outlineCache.Clear();
+  }
+
  private:
   winrt::com_ptr<IDWriteFactory2> _dWriteFactory2;
   winrt::com_ptr<ID2D1Factory> _factory;
   winrt::com_ptr<ID2D1DeviceContext> _context;
+  // Recolored for every draw call, since styles only hold packed colors
+  winrt::com_ptr<ID2D1SolidColorBrush> _brush;
+  GlyphOutlineCache _outlineCache;
+
+  ID2D1Brush *GetBrush(const D2D1_COLOR_F &color, float opacity);
+  ID2D1Brush *GetBrush(uint32_t color, float opacity);
 
   void FillRectangle(const D2D_RECT_F &rect, const TextRendererStyle &style, float opacity);
 
@@ -13,11 +13,11 @@ HRESULT TextRendererStyle::QueryInterface(const IID &riid, void **ppvObject) noe
 }
 
 ULONG TextRendererStyle::AddRef() noexcept {
-  return InterlockedIncrement(&_refCount);
+  return ++_refCount;
 }
 
 ULONG TextRendererStyle::Release() noexcept {
-  ULONG refCount = InterlockedDecrement(&_refCount);
+  ULONG refCount = --_refCount;
   if (!refCount) {
     delete this;
   }
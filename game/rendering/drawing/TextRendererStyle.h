@@ -3,35 +3,46 @@
 
 #include <Unknwn.h>
 #include <winrt/base.h>
-#include <d2d1.h>
+
+#include <atomic>
+
 #include "Style.h"
 
+/**
+ * The rendering properties of a range of text, attached to text layouts as drawing effects.
+ * Colors are kept as packed values and only turned into brushes by TextRenderer when the text is
+ * drawn, so that styles can be created on any thread.
+ */
 class __declspec(uuid("{4e27f114-78ee-410c-8a9b-4f641654214c}")) TextRendererStyle
     : public IUnknown {
  public:
-  TextRendererStyle(const winrt::com_ptr<ID2D1Brush> &color,
-                    const winrt::com_ptr<ID2D1Brush> &dropShadowColor,
-                    const winrt::com_ptr<ID2D1Brush> &outlineColor,
-                    const float outlineWidth)
-      : _color(color),
-        _dropShadowColor(dropShadowColor),
-        _outlineColor(outlineColor),
-        _outlineWidth(outlineWidth) {}
-
-  [[nodiscard]] const winrt::com_ptr<ID2D1Brush> &GetColor() const {
+  explicit TextRendererStyle(const TextStyle &style)
+      : _color(style.Color),
+        _dropShadowColor(style.DropShadowColor),
+        _outlineColor(style.OutlineColor),
+        _outlineWidth(style.OutlineWidth) {}
+
+  // Reference counted, so it can neither be copied nor moved
+  TextRendererStyle(const TextRendererStyle &) = delete;
+  TextRendererStyle &operator=(const TextRendererStyle &) = delete;
+
+  [[nodiscard]] uint32_t GetColor() const {
     return _color;
   }
-  [[nodiscard]] const winrt::com_ptr<ID2D1Brush> &GetDropShadowColor() const {
+  [[nodiscard]] uint32_t GetDropShadowColor() const {
     return _dropShadowColor;
   }
-  [[nodiscard]] const winrt::com_ptr<ID2D1Brush> &GetOutlineColor() const {
+  [[nodiscard]] uint32_t GetOutlineColor() const {
     return _outlineColor;
   }
   [[nodiscard]] float GetOutlineWidth() const {
     return _outlineWidth;
   }
+  [[nodiscard]] bool HasDropShadow() const {
+    return !IsTransparent(_dropShadowColor);
+  }
   [[nodiscard]] bool HasOutline() const {
-    return _outlineColor && _outlineWidth > 0;
+    return !IsTransparent(_outlineColor) && _outlineWidth > 0;
   }
 
   HRESULT STDMETHODCALLTYPE QueryInterface(const IID &riid, void **ppvObject) noexcept override;
@@ -39,9 +50,10 @@ class __declspec(uuid("{4e27f114-78ee-410c-8a9b-4f641654214c}")) TextRendererSty
   ULONG STDMETHODCALLTYPE Release() noexcept override;
 
  private:
-  uint32_t _refCount = 1;
-  const winrt::com_ptr<ID2D1Brush> _color;
-  const winrt::com_ptr<ID2D1Brush> _dropShadowColor;
-  const winrt::com_ptr<ID2D1Brush> _outlineColor;
+  // Styles of cached layouts are referenced from layouts used on several threads
+  std::atomic<uint32_t> _refCount{1};
+  const uint32_t _color;
+  const uint32_t _dropShadowColor;
+  const uint32_t _outlineColor;
   const float _outlineWidth;
 };
@@ -0,0 +1,203 @@
+
+#include <algorithm>
+#include <cmath>
+
+#include "SoftwareCanvas.h"
+
+PixelRect PixelRect::Intersect(const PixelRect &other) const {
+  return {std::max(left, other.left), std::max(top, other.top), std::min(right, other.right),
+          std::min(bottom, other.bottom)};
+}
+
+// Exact division by 255 with rounding, for values up to 255 * 255
+static inline uint32_t Div255(uint32_t value) {
+  value += 128;
+  return (value + (value >> 8)) >> 8;
+}
+
+// Blends the RGB of a color with the given alpha (0-255) over a premultiplied BGRA pixel
+static inline void BlendPixel(uint8_t *pixel, uint32_t color, uint32_t alpha) {
+  auto inverse = 255 - alpha;
+  pixel[0] = (uint8_t)Div255((color & 0xFF) * alpha + pixel[0] * inverse);
+  pixel[1] = (uint8_t)Div255(((color >> 8) & 0xFF) * alpha + pixel[1] * inverse);
+  pixel[2] = (uint8_t)Div255(((color >> 16) & 0xFF) * alpha + pixel[2] * inverse);
+  pixel[3] = (uint8_t)(alpha + Div255(pixel[3] * inverse));
+}
+
+static inline uint32_t ColorAlpha(uint32_t color, float opacity) {
+  return (uint32_t)std::lround((float)(color >> 24) * std::clamp(opacity, 0.0f, 1.0f));
+}
+
+// Fraction of the pixel span [pixel, pixel + 1) that lies within [from, to)
+static inline float SpanCoverage(int pixel, float from, float to) {
+  return std::clamp(std::min((float)pixel + 1, to) - std::max((float)pixel, from), 0.0f, 1.0f);
+}
+
+static inline float RectCoverage(int x, int y, float left, float top, float right, float bottom) {
+  return SpanCoverage(x, left, right) * SpanCoverage(y, top, bottom);
+}
+
+// Approximates the coverage of a pixel by a rounded rectangle from the distance of the pixel's
+// center to the shape's edge
+static inline float RoundedRectCoverage(int x, int y, float left, float top, float right,
+                                        float bottom, float radius) {
+  radius = std::clamp(radius, 0.0f, std::min(right - left, bottom - top) / 2);
+  auto centerX = (left + right) / 2;
+  auto centerY = (top + bottom) / 2;
+  auto dx = std::abs((float)x + 0.5f - centerX) - ((right - left) / 2 - radius);
+  auto dy = std::abs((float)y + 0.5f - centerY) - ((bottom - top) / 2 - radius);
+  // Only pixels near the corners need the square root. std::hypot is much slower and guards
+  // against overflows that can not happen with pixel coordinates.
+  auto outsideX = std::max(dx, 0.0f);
+  auto outsideY = std::max(dy, 0.0f);
+  auto outside = outsideX == 0 || outsideY == 0
+                     ? outsideX + outsideY
+                     : std::sqrt(outsideX * outsideX + outsideY * outsideY);
+  auto inside = std::min(std::max(dx, dy), 0.0f);
+  auto distance = outside + inside - radius;
+  return std::clamp(0.5f - distance, 0.0f, 1.0f);
+}
+
+// A rectangle of pixels that are entirely within the (rounded) rectangle, with a distance of at
+// least a pixel from its antialiased edge. It leaves out the sides next to the corners.
+static inline PixelRect RoundedRectInterior(float left, float top, float right, float bottom,
+                                            float radius) {
+  auto inset = std::clamp(radius, 0.0f, std::min(right - left, bottom - top) / 2) + 1;
+  return {(int)std::ceil(left + inset), (int)std::ceil(top + inset),
+          (int)std::floor(right - inset), (int)std::floor(bottom - inset)};
+}
+
+void SoftwareCanvas::SetTarget(uint8_t *pixels, int width, int height, int stride) {
+  _pixels = pixels;
+  _width = pixels ? width : 0;
+  _height = pixels ? height : 0;
+  _stride = stride;
+  _bounds = {0, 0, _width, _height};
+  _clipStack.clear();
+}
+
+void SoftwareCanvas::PushClip(const PixelRect &rect) {
+  _clipStack.push_back(rect.Intersect(Clip()));
+}
+
+void SoftwareCanvas::PopClip() {
+  if (!_clipStack.empty()) {
+    _clipStack.pop_back();
+  }
+}
+
+template <typename Coverage>
+void SoftwareCanvas::Fill(float left, float top, float right, float bottom, uint32_t color,
+                          float opacity, const Coverage &coverage, const PixelRect &interior,
+                          float interiorCoverage) {
+  auto colorAlpha = ColorAlpha(color, opacity);
+  if (!_pixels || colorAlpha == 0) {
+    return;
+  }
+
+  PixelRect area{(int)std::floor(left), (int)std::floor(top), (int)std::ceil(right),
+                 (int)std::ceil(bottom)};
+  area = area.Intersect(Clip());
+  auto skip = interior.Intersect(area);
+  auto interiorAlpha = (uint32_t)(interiorCoverage * (float)colorAlpha + 0.5f);
+
+  auto fillSpan = [&](int y, int from, int to) {
+    auto pixel = _pixels + (size_t)y * _stride + (size_t)from * 4;
+    for (auto x = from; x < to; x++, pixel += 4) {
+      // Coverage is never negative, so adding a half rounds without calling into libm
+      auto alpha = (uint32_t)(coverage(x, y) * (float)colorAlpha + 0.5f);
+      if (alpha > 0) {
+        BlendPixel(pixel, color, alpha);
+      }
+    }
+  };
+
+  for (auto y = area.top; y < area.bottom; y++) {
+    if (skip.IsEmpty() || y < skip.top || y >= skip.bottom) {
+      fillSpan(y, area.left, area.right);
+      continue;
+    }
+
+    fillSpan(y, area.left, skip.left);
+    if (interiorAlpha > 0) {
+      auto pixel = _pixels + (size_t)y * _stride + (size_t)skip.left * 4;
+      for (auto x = skip.left; x < skip.right; x++, pixel += 4) {
+        BlendPixel(pixel, color, interiorAlpha);
+      }
+    }
+    fillSpan(y, skip.right, area.right);
+  }
+}
+
+void SoftwareCanvas::FillRect(float left, float top, float right, float bottom, uint32_t color,
+                              float opacity) {
+  auto coverage = [&](int x, int y) { return RectCoverage(x, y, left, top, right, bottom); };
+  Fill(left, top, right, bottom, color, opacity, coverage,
+       RoundedRectInterior(left, top, right, bottom, 0), 1);
+}
+
+void SoftwareCanvas::StrokeRect(float left, float top, float right, float bottom,
+                                float strokeWidth, uint32_t color, float opacity) {
+  auto half = strokeWidth / 2;
+  auto outerLeft = left - half, outerTop = top - half;
+  auto outerRight = right + half, outerBottom = bottom + half;
+  auto innerLeft = left + half, innerTop = top + half;
+  auto innerRight = std::max(innerLeft, right - half);
+  auto innerBottom = std::max(innerTop, bottom - half);
+  auto coverage = [&](int x, int y) {
+    return RectCoverage(x, y, outerLeft, outerTop, outerRight, outerBottom) -
+           RectCoverage(x, y, innerLeft, innerTop, innerRight, innerBottom);
+  };
+  Fill(outerLeft, outerTop, outerRight, outerBottom, color, opacity, coverage,
+       RoundedRectInterior(innerLeft, innerTop, innerRight, innerBottom, 0), 0);
+}
+
+void SoftwareCanvas::FillRoundedRect(float left, float top, float right, float bottom,
+                                     float radius, uint32_t color, float opacity) {
+  auto coverage = [&](int x, int y) {
+    return RoundedRectCoverage(x, y, left, top, right, bottom, radius);
+  };
+  Fill(left, top, right, bottom, color, opacity, coverage,
+       RoundedRectInterior(left, top, right, bottom, radius), 1);
+}
+
+void SoftwareCanvas::StrokeRoundedRect(float left, float top, float right, float bottom,
+                                       float radius, float strokeWidth, uint32_t color,
+                                       float opacity) {
+  auto half = strokeWidth / 2;
+  auto outerLeft = left - half, outerTop = top - half;
+  auto outerRight = right + half, outerBottom = bottom + half;
+  auto innerLeft = left + half, innerTop = top + half;
+  auto innerRight = std::max(innerLeft, right - half);
+  auto innerBottom = std::max(innerTop, bottom - half);
+  auto innerRadius = std::max(radius - half, 0.0f);
+  auto coverage = [&](int x, int y) {
+    auto outer =
+        RoundedRectCoverage(x, y, outerLeft, outerTop, outerRight, outerBottom, radius + half);
+    auto inner =
+        RoundedRectCoverage(x, y, innerLeft, innerTop, innerRight, innerBottom, innerRadius);
+    return std::max(outer - inner, 0.0f);
+  };
+  // The stroke leaves the inside of its inner edge uncovered
+  Fill(outerLeft, outerTop, outerRight, outerBottom, color, opacity, coverage,
+       RoundedRectInterior(innerLeft, innerTop, innerRight, innerBottom, innerRadius), 0);
+}
+
+void SoftwareCanvas::FillMask(int x, int y, const uint8_t *mask, int width, int height,
+                              int stride, uint32_t color, float opacity) {
+  auto colorAlpha = ColorAlpha(color, opacity);
+  if (!_pixels || colorAlpha == 0) {
+    return;
+  }
+
+  auto area = PixelRect{x, y, x + width, y + height}.Intersect(Clip());
+  for (auto row = area.top; row < area.bottom; row++) {
+    auto coverage = mask + (size_t)(row - y) * stride + (area.left - x);
+    auto pixel = _pixels + (size_t)row * _stride + (size_t)area.left * 4;
+    for (auto column = area.left; column < area.right; column++, coverage++, pixel += 4) {
+      if (*coverage) {
+        BlendPixel(pixel, color, Div255(*coverage * colorAlpha));
+      }
+    }
+  }
+}
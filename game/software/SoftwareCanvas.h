@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * A rectangle of device pixels, excluding the right and bottom edge.
+ */
+struct PixelRect {
+  int left;
+  int top;
+  int right;
+  int bottom;
+
+  [[nodiscard]] bool IsEmpty() const {
+    return right <= left || bottom <= top;
+  }
+
+  [[nodiscard]] PixelRect Intersect(const PixelRect &other) const;
+};
+
+/**
+ * Draws into caller-owned memory holding 32-bit BGRA pixels with premultiplied alpha. All
+ * coordinates are in device pixels and colors are ARGB with straight alpha, as in the styles.
+ * Shapes are antialiased by computing the covered fraction of each pixel.
+ *
+ * Not thread-safe.
+ */
+class SoftwareCanvas {
+ public:
+  /**
+   * The memory must remain valid until another target is set. Null removes the target, and
+   * drawing without a target does nothing.
+   */
+  void SetTarget(uint8_t *pixels, int width, int height, int stride);
+
+  [[nodiscard]] bool HasTarget() const {
+    return _pixels != nullptr;
+  }
+
+  [[nodiscard]] int Width() const {
+    return _width;
+  }
+
+  [[nodiscard]] int Height() const {
+    return _height;
+  }
+
+  /**
+   * Restricts drawing to the intersection of the rectangle with the current clip rectangle.
+   */
+  void PushClip(const PixelRect &rect);
+
+  void PopClip();
+
+  void FillRect(float left, float top, float right, float bottom, uint32_t color, float opacity);
+
+  /**
+   * Strokes the edges of the rectangle, with the stroke centered on the edges.
+   */
+  void StrokeRect(float left, float top, float right, float bottom, float strokeWidth,
+                  uint32_t color, float opacity);
+
+  void FillRoundedRect(float left, float top, float right, float bottom, float radius,
+                       uint32_t color, float opacity);
+
+  void StrokeRoundedRect(float left, float top, float right, float bottom, float radius,
+                         float strokeWidth, uint32_t color, float opacity);
+
+  /**
+   * Blends the color into the target, using an 8-bit coverage mask as the alpha.
+   */
+  void FillMask(int x, int y, const uint8_t *mask, int width, int height, int stride,
+                uint32_t color, float opacity);
+
+ private:
+  /**
+   * Blends the color into the pixels of the area with the alpha scaled by coverage(x, y). Pixels
+   * within interior are known to have interiorCoverage, and coverage is not called for them.
+   */
+  template <typename Coverage>
+  void Fill(float left, float top, float right, float bottom, uint32_t color, float opacity,
+            const Coverage &coverage, const PixelRect &interior = {}, float interiorCoverage = 0);
+
+  [[nodiscard]] const PixelRect &Clip() const {
+    return _clipStack.empty() ? _bounds : _clipStack.back();
+  }
+
+  uint8_t *_pixels = nullptr;
+  int _width = 0;
+  int _height = 0;
+  int _stride = 0;
+  PixelRect _bounds{};
+  std::vector<PixelRect> _clipStack;
+};
@@ -0,0 +1,156 @@
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+#include "SoftwareDrawingEngine.h"
+
+SoftwareDrawingEngine::SoftwareDrawingEngine()
+    : _glyphCache(_fonts), _textRenderer(_canvas, _glyphCache) {}
+
+SoftwareDrawingEngine::~SoftwareDrawingEngine() = default;
+
+void SoftwareDrawingEngine::BeginDraw() noexcept {}
+
+void SoftwareDrawingEngine::EndDraw() {}
+
+void SoftwareDrawingEngine::PushClipRect(float left, float top, float right, float bottom,
+                                         bool antiAliased) noexcept {
+  // Pixels are clipped by their centers either way, which is what aliased clipping does
+  (void)antiAliased;
+  _canvas.PushClip({(int)std::lround(DeviceX(left)), (int)std::lround(DeviceY(top)),
+                    (int)std::lround(DeviceX(right)), (int)std::lround(DeviceY(bottom))});
+}
+
+void SoftwareDrawingEngine::PopClipRect() noexcept {
+  _canvas.PopClip();
+}
+
+void SoftwareDrawingEngine::SetTransform(const SoftwareMatrix &matrix) noexcept {
+  _transform = matrix;
+}
+
+void SoftwareDrawingEngine::GetTransform(SoftwareMatrix *matrix) noexcept {
+  *matrix = _transform;
+}
+
+SoftwareTextLayout *SoftwareDrawingEngine::CreateTextLayout(const ParagraphStyle &paragraphStyle,
+                                                            const TextStyle &textStyle,
+                                                            const char16_t *text,
+                                                            uint32_t textLength,
+                                                            float maxWidth,
+                                                            float maxHeight) {
+  return new SoftwareTextLayout(_fonts, paragraphStyle, textStyle, {text, textLength}, maxWidth,
+                                maxHeight);
+}
+
+SoftwareTextLayout *SoftwareDrawingEngine::CreateCachedTextLayout(
+    const ParagraphStyle &paragraphStyle,
+    const TextStyle &textStyle,
+    const char16_t *text,
+    uint32_t textLength,
+    float maxWidth,
+    float maxHeight,
+    const TextStyleRun *runs,
+    uint32_t runCount) {
+  auto layout = std::make_unique<SoftwareTextLayout>(_fonts, paragraphStyle, textStyle,
+                                                     std::u16string_view{text, textLength},
+                                                     maxWidth, maxHeight);
+  for (uint32_t i = 0; i < runCount; i++) {
+    layout->SetStyle(runs[i].Start, runs[i].Length, runs[i].Properties, runs[i].Style);
+  }
+  return layout.release();
+}
+
+SoftwareTextLayout *SoftwareDrawingEngine::CreateTextLayoutFromMarkup(
+    const ParagraphStyle &paragraphStyle,
+    const TextStyle &textStyle,
+    std::u16string_view markup,
+    float maxWidth,
+    float maxHeight,
+    const MarkupStyle *palette,
+    uint32_t paletteSize) {
+  // Reused by all calls on the same thread
+  thread_local std::u16string markupText;
+  thread_local std::vector<TextStyleSpan> markupSpans;
+  thread_local std::vector<TextStyle> markupStyles;
+
+  ParseMarkup(markup, palette, paletteSize, markupText, markupSpans);
+
+  markupStyles.clear();
+  for (uint32_t i = 0; i < paletteSize; i++) {
+    markupStyles.push_back(palette[i].Style);
+  }
+
+  auto layout = std::make_unique<SoftwareTextLayout>(_fonts, paragraphStyle, textStyle,
+                                                     markupText, maxWidth, maxHeight);
+  layout->SetStyles(markupSpans.data(), (uint32_t)markupSpans.size(), markupStyles.data(),
+                    paletteSize);
+  return layout.release();
+}
+
+void SoftwareDrawingEngine::ReloadFontFamilies() {
+  // Fonts are never unloaded, so existing layouts and cached glyphs remain valid
+  _fonts.Load(_fontFiles);
+}
+
+int SoftwareDrawingEngine::GetFontFamiliesCount() const {
+  return _fonts.GetFamiliesCount();
+}
+
+std::wstring SoftwareDrawingEngine::GetFontFamilyName(int familyIndex) const {
+  return _fonts.GetFamilyName(familyIndex);
+}
+
+void SoftwareDrawingEngine::RenderTextLayout(float x, float y, SoftwareTextLayout &textLayout,
+                                             float opacity) {
+  _textRenderer.SetDeviceTransform(_transform.m11 * _scaleX, _transform.m22 * _scaleY,
+                                   _transform.dx * _scaleX, _transform.dy * _scaleY);
+  textLayout.Render(_textRenderer, x, y, opacity);
+}
+
+void SoftwareDrawingEngine::RenderBackgroundAndBorder(float x, float y, float width, float height,
+                                                      const BackgroundAndBorderStyle &style) {
+  auto left = DeviceX(x);
+  auto top = DeviceY(y);
+  auto right = DeviceX(x + width);
+  auto bottom = DeviceY(y + height);
+  auto scale = (std::abs(_transform.m11 * _scaleX) + std::abs(_transform.m22 * _scaleY)) / 2;
+  auto borderWidth = style.borderWidth * scale;
+
+  // Rounded corners need to be drawn differently. Elliptical corners are drawn as circular ones
+  // with the smaller radius.
+  if (style.radiusX > 0 || style.radiusY > 0) {
+    auto radius = std::min(style.radiusX * std::abs(_transform.m11 * _scaleX),
+                           style.radiusY * std::abs(_transform.m22 * _scaleY));
+
+    if (!IsTransparent(style.backgroundColor)) {
+      _canvas.FillRoundedRect(left, top, right, bottom, radius, style.backgroundColor, 1);
+    }
+    if (!IsTransparent(style.borderColor)) {
+      _canvas.StrokeRoundedRect(left, top, right, bottom, radius, borderWidth, style.borderColor,
+                                1);
+    }
+  } else {
+    if (!IsTransparent(style.backgroundColor)) {
+      _canvas.FillRect(left, top, right, bottom, style.backgroundColor, 1);
+    }
+    if (!IsTransparent(style.borderColor)) {
+      _canvas.StrokeRect(left, top, right, bottom, borderWidth, style.borderColor, 1);
+    }
+  }
+}
+
+void SoftwareDrawingEngine::SetRenderTarget(uint8_t *pixels, int width, int height, int stride) {
+  _canvas.SetTarget(pixels, width, height, stride);
+}
+
+void SoftwareDrawingEngine::SetCanvasSize(float width, float height) noexcept {
+  _scaleX = (float)_canvas.Width() / width;
+  _scaleY = (float)_canvas.Height() / height;
+}
+
+void SoftwareDrawingEngine::GetCanvasScale(float *width, float *height) noexcept {
+  *width = _scaleX;
+  *height = _scaleY;
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../rendering/drawing/FontFile.h"
+#include "../rendering/drawing/Style.h"
+#include "../text/MarkupParser.h"
+#include "SoftwareCanvas.h"
+#include "SoftwareFonts.h"
+#include "SoftwareGlyphCache.h"
+#include "SoftwareTextLayout.h"
+#include "SoftwareTextRenderer.h"
+
+/**
+ * Same memory layout as D2D1_MATRIX_3X2_F and System.Numerics.Matrix3x2.
+ */
+struct SoftwareMatrix {
+  float m11;
+  float m12;
+  float m21;
+  float m22;
+  float dx;
+  float dy;
+};
+
+/**
+ * Implements the DrawingEngine exports on the CPU for platforms without Direct2D, so that UI text
+ * can be laid out and rendered without a GPU, e.g. for benchmarks and image comparisons. Fonts are
+ * rasterized with FreeType from the added font files, and everything is drawn into memory set
+ * with SetRenderTarget, which holds 32-bit BGRA pixels with premultiplied alpha.
+ *
+ * Layouts may be built and measured on worker threads like with DrawingEngine, see there.
+ *
+ * Differences to DrawingEngine:
+ * - Text is laid out by SoftwareTextLayout, which does no complex script shaping.
+ * - Transforms may only translate and scale, rotation and skew are ignored.
+ * - Clip rectangles are aligned to device pixels.
+ * - The text layout cache is not used, since laying out text is comparatively cheap here.
+ */
+class SoftwareDrawingEngine {
+ public:
+  SoftwareDrawingEngine();
+  ~SoftwareDrawingEngine();
+
+  void BeginDraw() noexcept;
+  void EndDraw();
+
+  void PushClipRect(float left, float top, float right, float bottom, bool antiAliased) noexcept;
+  void PopClipRect() noexcept;
+
+  void SetTransform(const SoftwareMatrix &matrix) noexcept;
+  void GetTransform(SoftwareMatrix *matrix) noexcept;
+
+  SoftwareTextLayout *CreateTextLayout(const ParagraphStyle &paragraphStyle,
+                                       const TextStyle &textStyle,
+                                       const char16_t *text,
+                                       uint32_t textLength,
+                                       float maxWidth,
+                                       float maxHeight);
+
+  /**
+   * Like CreateTextLayout followed by SetStyle for each of the given runs.
+   */
+  SoftwareTextLayout *CreateCachedTextLayout(const ParagraphStyle &paragraphStyle,
+                                             const TextStyle &textStyle,
+                                             const char16_t *text,
+                                             uint32_t textLength,
+                                             float maxWidth,
+                                             float maxHeight,
+                                             const TextStyleRun *runs,
+                                             uint32_t runCount);
+
+  /**
+   * Strips the style markup from the text (see ParseMarkup) and creates a layout with the palette
+   * styles applied to the marked up ranges.
+   */
+  SoftwareTextLayout *CreateTextLayoutFromMarkup(const ParagraphStyle &paragraphStyle,
+                                                 const TextStyle &textStyle,
+                                                 std::u16string_view markup,
+                                                 float maxWidth,
+                                                 float maxHeight,
+                                                 const MarkupStyle *palette,
+                                                 uint32_t paletteSize);
+
+  // Deque, since FreeType reads the data of the files in place
+  const std::deque<FontFile> &GetFontFiles() const {
+    return _fontFiles;
+  }
+
+  void AddFontFile(FontFile fontFile) {
+    _fontFiles.emplace_back(std::move(fontFile));
+  }
+
+  /**
+   * Makes the font files added since the last call available to new layouts.
+   * @throws std::runtime_error If a font file can not be loaded.
+   */
+  void ReloadFontFamilies();
+
+  int GetFontFamiliesCount() const;
+  std::wstring GetFontFamilyName(int familyIndex) const;
+
+  void RenderTextLayout(float x, float y, SoftwareTextLayout &textLayout, float opacity);
+
+  void RenderBackgroundAndBorder(float x, float y, float width, float height,
+                                 const BackgroundAndBorderStyle &style);
+
+  /**
+   * Draws into the given pixels from now on, see SoftwareCanvas::SetTarget.
+   */
+  void SetRenderTarget(uint8_t *pixels, int width, int height, int stride);
+
+  /**
+   * Sets the size of the "virtual canvas" that will be the space in which coordinates
+   * passed to the drawing engine are interpreted. This space is projected onto the
+   * current render target by scaling the coordinates.
+   */
+  void SetCanvasSize(float width, float height) noexcept;
+  void GetCanvasScale(float *width, float *height) noexcept;
+
+  [[nodiscard]] GlyphAtlasStats GetGlyphCacheStats() const {
+    return _glyphCache.Stats();
+  }
+
+ private:
+  [[nodiscard]] float DeviceX(float x) const {
+    return (x * _transform.m11 + _transform.dx) * _scaleX;
+  }
+
+  [[nodiscard]] float DeviceY(float y) const {
+    return (y * _transform.m22 + _transform.dy) * _scaleY;
+  }
+
+  std::deque<FontFile> _fontFiles;
+  SoftwareFontCollection _fonts;
+  SoftwareGlyphCache _glyphCache;
+  SoftwareCanvas _canvas;
+  SoftwareTextRenderer _textRenderer;
+
+  SoftwareMatrix _transform{1, 0, 0, 1, 0, 0};
+  float _scaleX = 1;
+  float _scaleY = 1;
+};
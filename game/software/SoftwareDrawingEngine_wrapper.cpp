@@ -0,0 +1,359 @@
+
+// Exports the same functions as rendering/drawing/DrawingEngine_wrapper.cpp, backed by
+// SoftwareDrawingEngine. Strings are always UTF-16, since wchar_t is 32-bit on these platforms.
+
+#include <exception>
+#include <new>
+
+#include "../interop/StringArena.h"
+#include "../interop/string_interop.h"
+#include "../utils.h"
+#include "SoftwareDrawingEngine.h"
+
+static char16_t *copyError(const std::exception &e) {
+  return copyString(localToWide(e.what()));
+}
+
+/**
+ * The device is ignored, since this engine only renders into memory.
+ */
+NATIVE_API ApiBool DrawingEngine_Create([[maybe_unused]] void *unusedD3dDevice,
+                                        [[maybe_unused]] ApiBool debugDevice,
+                                        SoftwareDrawingEngine **engine,
+                                        char16_t **error) noexcept {
+  *error = nullptr;
+  *engine = nullptr;
+
+  try {
+    *engine = new SoftwareDrawingEngine();
+    return true;
+  } catch (const std::exception &e) {
+    *error = copyError(e);
+    return false;
+  }
+}
+
+NATIVE_API void DrawingEngine_Free(SoftwareDrawingEngine *engine) noexcept {
+  delete engine;
+}
+
+NATIVE_API void DrawingEngine_BeginDraw(SoftwareDrawingEngine *engine) noexcept {
+  engine->BeginDraw();
+}
+
+NATIVE_API ApiBool DrawingEngine_EndDraw(SoftwareDrawingEngine *engine,
+                                         char16_t **error) noexcept {
+  try {
+    engine->EndDraw();
+    *error = nullptr;
+    return true;
+  } catch (const std::exception &e) {
+    *error = copyError(e);
+    return false;
+  }
+}
+
+NATIVE_API void DrawingEngine_PushClipRect(SoftwareDrawingEngine *engine, float left, float top,
+                                           float right, float bottom,
+                                           ApiBool antiAliased) noexcept {
+  engine->PushClipRect(left, top, right, bottom, antiAliased);
+}
+
+NATIVE_API void DrawingEngine_PopClipRect(SoftwareDrawingEngine *engine) noexcept {
+  engine->PopClipRect();
+}
+
+/**
+ * Only accepts null to remove the render target, use DrawingEngine_SetMemoryRenderTarget instead.
+ */
+NATIVE_API ApiBool DrawingEngine_SetRenderTarget(SoftwareDrawingEngine *engine,
+                                                 void *texture,
+                                                 char16_t **error) noexcept {
+  if (texture) {
+    *error = copyString(L"Only memory render targets are supported on this platform.");
+    return false;
+  }
+
+  engine->SetRenderTarget(nullptr, 0, 0, 0);
+  *error = nullptr;
+  return true;
+}
+
+/**
+ * Renders into memory holding 32-bit BGRA pixels with premultiplied alpha, which must remain valid
+ * until another render target is set. Stride is the distance between rows in bytes.
+ */
+NATIVE_API ApiBool DrawingEngine_SetMemoryRenderTarget(SoftwareDrawingEngine *engine,
+                                                       uint8_t *pixels,
+                                                       int width,
+                                                       int height,
+                                                       int stride,
+                                                       char16_t **error) noexcept {
+  if (pixels && (width <= 0 || height <= 0 || stride < width * 4)) {
+    *error = copyString(L"Invalid size of the render target.");
+    return false;
+  }
+
+  engine->SetRenderTarget(pixels, width, height, stride);
+  *error = nullptr;
+  return true;
+}
+
+NATIVE_API void DrawingEngine_SetTransform(SoftwareDrawingEngine *engine,
+                                           SoftwareMatrix *matrix) noexcept {
+  engine->SetTransform(*matrix);
+}
+
+NATIVE_API void DrawingEngine_GetTransform(SoftwareDrawingEngine *engine,
+                                           SoftwareMatrix *matrix) noexcept {
+  engine->GetTransform(matrix);
+}
+
+NATIVE_API void DrawingEngine_SetCanvasSize(SoftwareDrawingEngine *engine,
+                                            float width,
+                                            float height) noexcept {
+  engine->SetCanvasSize(width, height);
+}
+
+NATIVE_API void DrawingEngine_GetCanvasScale(SoftwareDrawingEngine *engine,
+                                             float *width,
+                                             float *height) noexcept {
+  engine->GetCanvasScale(width, height);
+}
+
+NATIVE_API void DrawingEngine_AddFontFile(SoftwareDrawingEngine *engine,
+                                          const char *filename,
+                                          const uint8_t *data,
+                                          uint32_t dataLength) noexcept {
+  std::string filenameCopy(filename);
+  std::vector<uint8_t> dataCopy(data, data + dataLength);
+
+  engine->AddFontFile(FontFile(std::move(filenameCopy), std::move(dataCopy)));
+}
+
+NATIVE_API ApiBool DrawingEngine_ReloadFontFamilies(SoftwareDrawingEngine *engine,
+                                                    char16_t **error) noexcept {
+  *error = nullptr;
+
+  try {
+    engine->ReloadFontFamilies();
+    return true;
+  } catch (const std::exception &e) {
+    *error = copyError(e);
+    return false;
+  }
+}
+
+NATIVE_API int DrawingEngine_GetFontFamiliesCount(SoftwareDrawingEngine *engine) noexcept {
+  return engine->GetFontFamiliesCount();
+}
+
+NATIVE_API char16_t *DrawingEngine_GetFontFamilyName(SoftwareDrawingEngine *engine,
+                                                     int index) noexcept {
+  return copyString(engine->GetFontFamilyName(index));
+}
+
+/**
+ * Like DrawingEngine_GetFontFamilyName, but the name is only valid until the arena is reset.
+ * Returns null and sets error if the name could not be copied.
+ */
+NATIVE_API const char16_t *DrawingEngine_GetFontFamilyNameInArena(SoftwareDrawingEngine *engine,
+                                                                  int index,
+                                                                  StringArena *arena,
+                                                                  int *length,
+                                                                  char16_t **error) noexcept {
+  *error = nullptr;
+  *length = 0;
+
+  // Growing the arena allocates, which must not escape through the noexcept ABI boundary
+  try {
+    auto name = engine->GetFontFamilyName(index);
+    auto result = arena->copy(name);
+    *length = (int)utf16Length(name);
+    return result;
+  } catch (const std::bad_alloc &) {
+    *error = copyString(L"Out of memory while copying the font family name");
+  } catch (const std::exception &e) {
+    *error = copyError(e);
+  }
+  return nullptr;
+}
+
+NATIVE_API ApiBool DrawingEngine_CreateTextLayout(SoftwareDrawingEngine *engine,
+                                                  const ParagraphStyle &paragraphStyle,
+                                                  const TextStyle &textStyle,
+                                                  const char16_t *text,
+                                                  uint32_t textLength,
+                                                  float maxWidth,
+                                                  float maxHeight,
+                                                  SoftwareTextLayout **textLayout,
+                                                  char16_t **error) noexcept {
+  *error = nullptr;
+  *textLayout = nullptr;
+
+  if (!textStyle.FontFace) {
+    *error = copyString(L"FontFace must be set.");
+    return false;
+  }
+
+  try {
+    *textLayout =
+        engine->CreateTextLayout(paragraphStyle, textStyle, text, textLength, maxWidth, maxHeight);
+    return true;
+  } catch (const std::exception &e) {
+    *error = copyError(e);
+    return false;
+  }
+}
+
+/**
+ * Like DrawingEngine_CreateTextLayout followed by TextLayout_SetStyle for every run. Layouts are
+ * not cached by this engine.
+ */
+NATIVE_API ApiBool DrawingEngine_CreateCachedTextLayout(SoftwareDrawingEngine *engine,
+                                                        const ParagraphStyle &paragraphStyle,
+                                                        const TextStyle &textStyle,
+                                                        const char16_t *text,
+                                                        uint32_t textLength,
+                                                        float maxWidth,
+                                                        float maxHeight,
+                                                        const TextStyleRun *runs,
+                                                        uint32_t runCount,
+                                                        SoftwareTextLayout **textLayout,
+                                                        char16_t **error) noexcept {
+  *error = nullptr;
+  *textLayout = nullptr;
+
+  if (!textStyle.FontFace) {
+    *error = copyString(L"FontFace must be set.");
+    return false;
+  }
+  for (uint32_t i = 0; i < runCount; i++) {
+    auto &run = runs[i];
+    if ((run.Properties & TextStyleProperty::FontFace) == TextStyleProperty::FontFace &&
+        !run.Style.FontFace) {
+      *error = copyString(L"FontFace must be set for runs that change the font face.");
+      return false;
+    }
+  }
+
+  try {
+    *textLayout = engine->CreateCachedTextLayout(paragraphStyle, textStyle, text, textLength,
+                                                 maxWidth, maxHeight, runs, runCount);
+    return true;
+  } catch (const std::exception &e) {
+    *error = copyError(e);
+    return false;
+  }
+}
+
+/**
+ * Creates a layout from text with inline style markup, applying the styles of the palette to the
+ * marked up ranges (see ParseMarkup).
+ */
+NATIVE_API ApiBool DrawingEngine_CreateTextLayoutFromMarkup(SoftwareDrawingEngine *engine,
+                                                            const ParagraphStyle &paragraphStyle,
+                                                            const TextStyle &textStyle,
+                                                            const char16_t *markup,
+                                                            uint32_t markupLength,
+                                                            float maxWidth,
+                                                            float maxHeight,
+                                                            const MarkupStyle *palette,
+                                                            uint32_t paletteSize,
+                                                            SoftwareTextLayout **textLayout,
+                                                            char16_t **error) noexcept {
+  *error = nullptr;
+  *textLayout = nullptr;
+
+  if (!textStyle.FontFace) {
+    *error = copyString(L"FontFace must be set.");
+    return false;
+  }
+  for (uint32_t i = 0; i < paletteSize; i++) {
+    if ((palette[i].Properties & TextStyleProperty::FontFace) == TextStyleProperty::FontFace &&
+        !palette[i].Style.FontFace) {
+      *error = copyString(L"FontFace must be set for palette entries that change the font face.");
+      return false;
+    }
+  }
+
+  try {
+    *textLayout = engine->CreateTextLayoutFromMarkup(paragraphStyle, textStyle,
+                                                     {markup, markupLength}, maxWidth, maxHeight,
+                                                     palette, paletteSize);
+    return true;
+  } catch (const std::exception &e) {
+    *error = copyError(e);
+    return false;
+  }
+}
+
+// Same layout as TextLayoutCacheStats
+struct SoftwareTextLayoutCacheStats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  uint32_t entries;
+  uint64_t bytes;
+};
+
+NATIVE_API void DrawingEngine_ConfigureTextLayoutCache(
+    [[maybe_unused]] SoftwareDrawingEngine *engine, [[maybe_unused]] uint32_t maxEntries,
+    [[maybe_unused]] uint64_t maxBytes) noexcept {
+  // There is no layout cache
+}
+
+NATIVE_API void DrawingEngine_GetTextLayoutCacheStats(
+    [[maybe_unused]] SoftwareDrawingEngine *engine, SoftwareTextLayoutCacheStats *stats) noexcept {
+  *stats = {};
+}
+
+NATIVE_API void DrawingEngine_GetStructSizes(int *paragraphStylesSize,
+                                             int *textStylesSize) noexcept {
+  *paragraphStylesSize = sizeof(ParagraphStyle);
+  *textStylesSize = sizeof(TextStyle);
+}
+
+NATIVE_API ApiBool DrawingEngine_RenderTextLayout(SoftwareDrawingEngine *engine,
+                                                  SoftwareTextLayout *layout,
+                                                  float x, float y, float opacity,
+                                                  char16_t **error) noexcept {
+  if (!engine || !layout) {
+    *error = copyString(L"Null-parameter");
+    return false;
+  }
+
+  *error = nullptr;
+  try {
+    engine->RenderTextLayout(x, y, *layout, opacity);
+    return true;
+  } catch (const std::exception &e) {
+    *error = copyError(e);
+    return false;
+  } catch (...) {
+    *error = copyString(L"Unknown Error");
+    return false;
+  }
+}
+
+NATIVE_API ApiBool DrawingEngine_RenderBackgroundAndBorder(SoftwareDrawingEngine *engine, float x,
+                                                           float y, float width, float height,
+                                                           const BackgroundAndBorderStyle &style,
+                                                           char16_t **error) noexcept {
+  if (!engine) {
+    *error = copyString(L"Null-parameter");
+    return false;
+  }
+
+  *error = nullptr;
+  try {
+    engine->RenderBackgroundAndBorder(x, y, width, height, style);
+    return true;
+  } catch (const std::exception &e) {
+    *error = copyError(e);
+    return false;
+  } catch (...) {
+    *error = copyString(L"Unknown Error");
+    return false;
+  }
+}
@@ -0,0 +1,168 @@
+
+#include <algorithm>
+#include <cstdlib>
+#include <cwctype>
+#include <stdexcept>
+
+#include "../interop/string_interop.h"
+#include "SoftwareFonts.h"
+
+#include FT_ADVANCES_H
+#include FT_TRUETYPE_TABLES_H
+
+SoftwareFont::SoftwareFont(FT_Face face, uint32_t id)
+    : _face(face),
+      _id(id),
+      _familyName(localToWide(face->family_name ? face->family_name : "")),
+      _weight((face->style_flags & FT_STYLE_FLAG_BOLD) ? 700 : 400),
+      _italic((face->style_flags & FT_STYLE_FLAG_ITALIC) != 0),
+      _emsPerUnit(1.0f / (float)(face->units_per_EM ? face->units_per_EM : 1000)) {
+  ascent = (float)face->ascender * _emsPerUnit;
+  descent = (float)-face->descender * _emsPerUnit;
+  lineGap = std::max(0.0f, (float)(face->height - face->ascender + face->descender) * _emsPerUnit);
+
+  // FreeType gives the center of the underline, but it is drawn from its top edge
+  underlineThickness = std::max(1, (int)face->underline_thickness) * _emsPerUnit;
+  underlinePosition = (float)-face->underline_position * _emsPerUnit - underlineThickness / 2;
+
+  auto os2 = static_cast<TT_OS2 *>(FT_Get_Sfnt_Table(face, FT_SFNT_OS2));
+  if (os2 && os2->version != 0xFFFF) {
+    if (os2->usWeightClass >= 100 && os2->usWeightClass <= 1000) {
+      _weight = os2->usWeightClass;
+    }
+    strikethroughThickness = std::max(1, (int)os2->yStrikeoutSize) * _emsPerUnit;
+    strikethroughPosition = (float)os2->yStrikeoutPosition * _emsPerUnit;
+  }
+  if (strikethroughThickness <= 0) {
+    strikethroughThickness = underlineThickness;
+    strikethroughPosition = ascent / 3 + strikethroughThickness / 2;
+  }
+}
+
+SoftwareFont::~SoftwareFont() {
+  FT_Done_Face(_face);
+}
+
+uint32_t SoftwareFont::GlyphIndex(char32_t codePoint) {
+  auto it = _glyphIndices.find(codePoint);
+  if (it == _glyphIndices.end()) {
+    it = _glyphIndices.emplace(codePoint, FT_Get_Char_Index(_face, codePoint)).first;
+  }
+  return it->second;
+}
+
+float SoftwareFont::Advance(uint32_t glyphIndex) {
+  auto it = _advances.find(glyphIndex);
+  if (it == _advances.end()) {
+    // Unscaled advances keep the layout independent of the size glyphs are rasterized at
+    FT_Fixed advance = 0;
+    FT_Get_Advance(_face, glyphIndex, FT_LOAD_NO_SCALE, &advance);
+    it = _advances.emplace(glyphIndex, (float)advance * _emsPerUnit).first;
+  }
+  return it->second;
+}
+
+float SoftwareFont::Kerning(uint32_t leftGlyph, uint32_t rightGlyph) const {
+  if (!FT_HAS_KERNING(_face)) {
+    return 0;
+  }
+  FT_Vector kerning{};
+  FT_Get_Kerning(_face, leftGlyph, rightGlyph, FT_KERNING_UNSCALED, &kerning);
+  return (float)kerning.x * _emsPerUnit;
+}
+
+SoftwareFontCollection::SoftwareFontCollection() {
+  if (FT_Init_FreeType(&_library)) {
+    throw std::runtime_error("Failed to initialize FreeType.");
+  }
+}
+
+SoftwareFontCollection::~SoftwareFontCollection() {
+  // The faces have to be destroyed before the library
+  _fonts.clear();
+  FT_Done_FreeType(_library);
+}
+
+// Family names are compared per code unit, which is sufficient for the names of the game's fonts
+template <typename CharA, typename CharB>
+static bool EqualsIgnoreCase(std::basic_string_view<CharA> a, std::basic_string_view<CharB> b) {
+  if (a.length() != b.length()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.length(); i++) {
+    auto charA = (wint_t)a[i];
+    auto charB = (wint_t)b[i];
+    if (charA != charB && std::towlower(charA) != std::towlower(charB)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void SoftwareFontCollection::Load(const std::deque<FontFile> &fontFiles) {
+  for (; _loadedFiles < fontFiles.size(); _loadedFiles++) {
+    auto &fontFile = fontFiles[_loadedFiles];
+    FT_Long faceCount = 1;
+    for (FT_Long faceIndex = 0; faceIndex < faceCount; faceIndex++) {
+      FT_Face face;
+      if (FT_New_Memory_Face(_library, fontFile.data.data(), (FT_Long)fontFile.data.size(),
+                             faceIndex, &face)) {
+        throw std::runtime_error("Failed to load font file " + fontFile.filename);
+      }
+      faceCount = face->num_faces;
+
+      auto font = std::make_unique<SoftwareFont>(face, (uint32_t)_fonts.size());
+      auto &familyName = font->FamilyName();
+      auto known = false;
+      for (auto &name : _familyNames) {
+        known = known || EqualsIgnoreCase<wchar_t, wchar_t>(name, familyName);
+      }
+      if (!known) {
+        _familyNames.push_back(familyName);
+      }
+      _fonts.push_back(std::move(font));
+    }
+  }
+}
+
+std::wstring SoftwareFontCollection::GetFamilyName(int familyIndex) const {
+  if (familyIndex < 0 || familyIndex >= GetFamiliesCount()) {
+    return L"<OUT_OF_RANGE>";
+  }
+  return _familyNames[familyIndex];
+}
+
+SoftwareFont *SoftwareFontCollection::Find(std::u16string_view familyName,
+                                           ::FontWeight weight,
+                                           ::FontStyle style) const {
+  // Same priorities as font matching in CSS: style first, then the closest weight
+  SoftwareFont *best = nullptr;
+  int bestScore = 0;
+  for (auto &font : _fonts) {
+    if (!EqualsIgnoreCase<wchar_t, char16_t>(font->FamilyName(), familyName)) {
+      continue;
+    }
+    auto score = std::abs(font->Weight() - (int)weight);
+    if (font->IsItalic() != (style != ::FontStyle::Normal)) {
+      score += 10000;
+    }
+    if (!best || score < bestScore) {
+      best = font.get();
+      bestScore = score;
+    }
+  }
+
+  if (!best && !_fonts.empty()) {
+    best = _fonts.front().get();
+  }
+  return best;
+}
+
+SoftwareFont *SoftwareFontCollection::FindFallback(char32_t codePoint) const {
+  for (auto &font : _fonts) {
+    if (font->GlyphIndex(codePoint)) {
+      return font.get();
+    }
+  }
+  return nullptr;
+}
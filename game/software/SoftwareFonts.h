@@ -0,0 +1,142 @@
+#pragma once
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "../rendering/drawing/FontFile.h"
+#include "../rendering/drawing/Style.h"
+
+/**
+ * A face loaded from one of the font files. Metrics are given in ems, i.e. they have to be
+ * multiplied with the font size. The lookups may only be used while holding the mutex of the
+ * collection (see SoftwareFontCollection::Mutex).
+ */
+class SoftwareFont {
+ public:
+  SoftwareFont(FT_Face face, uint32_t id);
+  ~SoftwareFont();
+
+  SoftwareFont(const SoftwareFont &) = delete;
+  SoftwareFont &operator=(const SoftwareFont &) = delete;
+
+  [[nodiscard]] uint32_t Id() const {
+    return _id;
+  }
+
+  [[nodiscard]] FT_Face Face() const {
+    return _face;
+  }
+
+  [[nodiscard]] const std::wstring &FamilyName() const {
+    return _familyName;
+  }
+
+  [[nodiscard]] int Weight() const {
+    return _weight;
+  }
+
+  [[nodiscard]] bool IsItalic() const {
+    return _italic;
+  }
+
+  /**
+   * @return 0 if the font has no glyph for the code point.
+   */
+  uint32_t GlyphIndex(char32_t codePoint);
+
+  float Advance(uint32_t glyphIndex);
+
+  float Kerning(uint32_t leftGlyph, uint32_t rightGlyph) const;
+
+  float ascent = 0;
+  float descent = 0;
+  float lineGap = 0;
+  float underlinePosition = 0;  // Distance of the underline's top edge below the baseline
+  float underlineThickness = 0;
+  float strikethroughPosition = 0;  // Distance of the line's top edge above the baseline
+  float strikethroughThickness = 0;
+
+ private:
+  FT_Face _face;
+  const uint32_t _id;
+  std::wstring _familyName;
+  int _weight;
+  bool _italic;
+  float _emsPerUnit;
+  // Both lookups are comparatively slow in FreeType and are done for every character of a layout
+  std::unordered_map<char32_t, uint32_t> _glyphIndices;
+  std::unordered_map<uint32_t, float> _advances;
+};
+
+/**
+ * The faces of all font files added to the drawing engine, loaded with FreeType.
+ *
+ * Fonts are only ever added, so that layouts can keep referring to the fonts they were created
+ * with after the font families have been reloaded.
+ *
+ * Fonts may be looked up from any thread, but must not be loaded while other threads use the
+ * collection. The FreeType faces and the lookup caches of the fonts may only be used while holding
+ * Mutex, since layouts on worker threads and the glyph cache on the render thread share them.
+ */
+class SoftwareFontCollection {
+ public:
+  SoftwareFontCollection();
+  ~SoftwareFontCollection();
+
+  SoftwareFontCollection(const SoftwareFontCollection &) = delete;
+  SoftwareFontCollection &operator=(const SoftwareFontCollection &) = delete;
+
+  /**
+   * Loads the faces of the files that have been added since the last call. The files must not be
+   * moved or destroyed while the collection exists, since FreeType reads them in place.
+   * @throws std::runtime_error If a file can not be loaded.
+   */
+  void Load(const std::deque<FontFile> &fontFiles);
+
+  [[nodiscard]] FT_Library Library() const {
+    return _library;
+  }
+
+  [[nodiscard]] int GetFamiliesCount() const {
+    return (int)_familyNames.size();
+  }
+
+  [[nodiscard]] std::wstring GetFamilyName(int familyIndex) const;
+
+  /**
+   * Returns the face of the family that best matches the weight and style. Family names are
+   * compared case-insensitively. Falls back to the first loaded face if the family does not exist.
+   * @return Null if no fonts have been loaded.
+   */
+  SoftwareFont *Find(std::u16string_view familyName, ::FontWeight weight,
+                     ::FontStyle style) const;
+
+  /**
+   * Returns the first face that has a glyph for the code point, or null. Only while holding Mutex.
+   */
+  SoftwareFont *FindFallback(char32_t codePoint) const;
+
+  [[nodiscard]] SoftwareFont *Get(uint32_t id) const {
+    return _fonts[id].get();
+  }
+
+  [[nodiscard]] std::mutex &Mutex() const {
+    return _mutex;
+  }
+
+ private:
+  mutable std::mutex _mutex;
+  FT_Library _library = nullptr;
+  size_t _loadedFiles = 0;
+  std::vector<std::unique_ptr<SoftwareFont>> _fonts;
+  std::vector<std::wstring> _familyNames;
+};
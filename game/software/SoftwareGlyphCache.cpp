@@ -0,0 +1,142 @@
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "SoftwareGlyphCache.h"
+
+#include FT_GLYPH_H
+#include FT_OUTLINE_H
+
+// 8 pages of 1 MiB each hold a few thousand glyphs at typical UI sizes
+constexpr uint32_t PageSize = 1024;
+constexpr uint32_t MaxPages = 8;
+
+// Same strength and slant that FreeType uses for FT_GlyphSlot_Embolden and FT_GlyphSlot_Oblique
+constexpr FT_Pos BoldStrengthDivisor = 24;
+constexpr FT_Fixed ItalicShear = 0x0366A;
+
+constexpr uint32_t SimulatedBoldFlag = 1;
+constexpr uint32_t SimulatedItalicFlag = 2;
+
+SoftwareGlyphCache::SoftwareGlyphCache(const SoftwareFontCollection &fonts)
+    : _fonts(fonts), _atlas(PageSize, MaxPages) {
+  if (FT_Stroker_New(fonts.Library(), &_stroker)) {
+    throw std::runtime_error("Failed to create the FreeType stroker.");
+  }
+}
+
+SoftwareGlyphCache::~SoftwareGlyphCache() {
+  FT_Stroker_Done(_stroker);
+}
+
+bool SoftwareGlyphCache::Get(SoftwareFont &font, uint32_t glyphIndex, float pixelSize, float x,
+                             bool simulateBold, bool simulateItalic, float outlineWidth,
+                             SoftwareGlyph &glyph) {
+  auto fontFace = font.Id() << 2;
+  if (simulateBold) {
+    fontFace |= SimulatedBoldFlag;
+  }
+  if (simulateItalic) {
+    fontFace |= SimulatedItalicFlag;
+  }
+  auto key = GlyphAtlas::MakeKey(fontFace, glyphIndex, pixelSize, x, outlineWidth);
+  if (key.sizeBucket == 0) {
+    return false;
+  }
+
+  auto entry = _atlas.Find(key);
+  if (!entry) {
+    FT_BitmapGlyph bitmapGlyph;
+    {
+      std::lock_guard<std::mutex> lock(_fonts.Mutex());
+      bitmapGlyph = reinterpret_cast<FT_BitmapGlyph>(
+          Rasterize(font, key, simulateBold, simulateItalic));
+    }
+    if (!bitmapGlyph) {
+      return false;
+    }
+
+    auto &bitmap = bitmapGlyph->bitmap;
+    entry = _atlas.Insert(key, bitmap.width, bitmap.rows, bitmapGlyph->left, -bitmapGlyph->top);
+    if (!entry) {
+      // Masks are copied to the target right away, so every page can be evicted
+      _atlas.BeginFrame();
+      entry = _atlas.Insert(key, bitmap.width, bitmap.rows, bitmapGlyph->left, -bitmapGlyph->top);
+    }
+    if (entry) {
+      if (_pages.size() <= entry->page) {
+        _pages.resize(entry->page + 1);
+      }
+      auto &page = _pages[entry->page];
+      page.resize((size_t)PageSize * PageSize);
+      for (uint32_t row = 0; row < bitmap.rows; row++) {
+        auto source = bitmap.buffer + (ptrdiff_t)row * bitmap.pitch;
+        std::copy(source, source + bitmap.width,
+                  page.data() + (size_t)(entry->y + row) * PageSize + entry->x);
+      }
+    }
+    FT_Done_Glyph(reinterpret_cast<FT_Glyph>(bitmapGlyph));
+    if (!entry) {
+      return false;
+    }
+  }
+
+  glyph.mask = _pages[entry->page].data() + (size_t)entry->y * PageSize + entry->x;
+  glyph.stride = (int)PageSize;
+  glyph.width = entry->width;
+  glyph.height = entry->height;
+  glyph.offsetX = entry->offsetX;
+  glyph.offsetY = entry->offsetY;
+  return true;
+}
+
+FT_Glyph SoftwareGlyphCache::Rasterize(SoftwareFont &font, const GlyphKey &key,
+                                       bool simulateBold, bool simulateItalic) {
+  auto face = font.Face();
+  // Sizes are in 26.6 fixed point, and at 72 DPI points are pixels
+  auto size = (FT_F26Dot6)key.sizeBucket * 64 / GlyphAtlas::SizeSteps;
+  if (FT_Set_Char_Size(face, 0, size, 72, 72) ||
+      FT_Load_Glyph(face, key.glyphIndex, FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP)) {
+    return nullptr;
+  }
+
+  auto slot = face->glyph;
+  if (slot->format == FT_GLYPH_FORMAT_OUTLINE) {
+    auto &outline = slot->outline;
+    if (simulateBold) {
+      auto strength = FT_MulFix(face->units_per_EM, face->size->metrics.y_scale) /
+                      BoldStrengthDivisor;
+      FT_Outline_EmboldenXY(&outline, strength, strength);
+    }
+    if (simulateItalic) {
+      FT_Matrix shear{0x10000, ItalicShear, 0, 0x10000};
+      FT_Outline_Transform(&outline, &shear);
+    }
+    auto offset = (FT_Pos)(GlyphAtlas::SubpixelOffset(key) * 64);
+    FT_Outline_Translate(&outline, offset, 0);
+  }
+
+  FT_Glyph glyph;
+  if (FT_Get_Glyph(slot, &glyph)) {
+    return nullptr;
+  }
+
+  if (key.outlineWidth > 0 && glyph->format == FT_GLYPH_FORMAT_OUTLINE) {
+    // The stroke is centered on the outline, like the strokes Direct2D draws
+    auto radius = (FT_Fixed)key.outlineWidth * 64 / GlyphAtlas::SizeSteps / 2;
+    FT_Stroker_Set(_stroker, radius, FT_STROKER_LINECAP_ROUND, FT_STROKER_LINEJOIN_ROUND, 0);
+    FT_Glyph_Stroke(&glyph, _stroker, 1);
+  }
+
+  if (FT_Glyph_To_Bitmap(&glyph, FT_RENDER_MODE_NORMAL, nullptr, 1) ||
+      reinterpret_cast<FT_BitmapGlyph>(glyph)->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY) {
+    FT_Done_Glyph(glyph);
+    return nullptr;
+  }
+  return glyph;
+}
+
+void SoftwareGlyphCache::Clear() {
+  _atlas.Clear();
+  _pages.clear();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_STROKER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "../text/GlyphAtlas.h"
+#include "SoftwareFonts.h"
+
+/**
+ * The coverage mask of a rasterized glyph. The offset is the position of the mask's top-left
+ * corner relative to the glyph origin on the baseline, in pixels.
+ */
+struct SoftwareGlyph {
+  const uint8_t *mask;
+  int stride;
+  int width;
+  int height;
+  int offsetX;
+  int offsetY;
+};
+
+/**
+ * Rasterizes glyphs with FreeType and keeps their coverage masks in the pages of a GlyphAtlas, so
+ * that text that is drawn every frame is only rasterized once. Glyphs are rasterized without
+ * hinting at one of GlyphAtlas::SubpixelPositions horizontal offsets, which matches the
+ * unhinted, subpixel positioned layout.
+ *
+ * Not thread-safe, but glyphs are rasterized while holding the mutex of the font collection, so
+ * that layouts can be built on other threads in the meantime.
+ */
+class SoftwareGlyphCache {
+ public:
+  explicit SoftwareGlyphCache(const SoftwareFontCollection &fonts);
+  ~SoftwareGlyphCache();
+
+  SoftwareGlyphCache(const SoftwareGlyphCache &) = delete;
+  SoftwareGlyphCache &operator=(const SoftwareGlyphCache &) = delete;
+
+  /**
+   * Returns the mask of a glyph whose origin is at the horizontal device position x. Bold and
+   * italic are simulated if the font does not have them. If outlineWidth is not zero, the mask is
+   * that of a stroke of the given width along the glyph's outline instead of the filled glyph.
+   * The mask is valid until the next call.
+   * @return False if the glyph can not be rasterized.
+   */
+  bool Get(SoftwareFont &font, uint32_t glyphIndex, float pixelSize, float x, bool simulateBold,
+           bool simulateItalic, float outlineWidth, SoftwareGlyph &glyph);
+
+  void Clear();
+
+  [[nodiscard]] GlyphAtlasStats Stats() const {
+    return _atlas.Stats();
+  }
+
+ private:
+  /**
+   * Renders the glyph to a bitmap glyph, which the caller has to free with FT_Done_Glyph.
+   */
+  FT_Glyph Rasterize(SoftwareFont &font, const GlyphKey &key, bool simulateBold,
+                     bool simulateItalic);
+
+  const SoftwareFontCollection &_fonts;
+  GlyphAtlas _atlas;
+  std::vector<std::vector<uint8_t>> _pages;
+  FT_Stroker _stroker = nullptr;
+};
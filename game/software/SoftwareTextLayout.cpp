@@ -0,0 +1,799 @@
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "SoftwareTextLayout.h"
+#include "SoftwareTextRenderer.h"
+
+// Widths are compared with some tolerance, so that text laid out with its own measured width as
+// the maximum width is not wrapped because of rounding errors
+constexpr float WidthTolerance = 0.001f;
+
+// DirectWrite's default incremental tab stop is four times the font size
+constexpr float DefaultTabStopEms = 4;
+
+constexpr char32_t EllipsisCharacter = 0x2026;
+
+// Same offset as the drop shadows drawn by TextRenderer
+constexpr float DropShadowOffset = 1;
+
+static bool HasProperty(TextStyleProperty properties, TextStyleProperty property) {
+  return (properties & property) == property;
+}
+
+static bool IsNewline(char32_t codePoint) {
+  return codePoint == '\n' || codePoint == '\r' || codePoint == 0x0B || codePoint == 0x0C ||
+         codePoint == 0x85 || codePoint == 0x2028 || codePoint == 0x2029;
+}
+
+// Spaces that lines can be broken after, and that hang over the end of the line. No-break spaces
+// are laid out like any other character.
+static bool IsBreakingSpace(char32_t codePoint) {
+  return codePoint == ' ' || codePoint == 0x1680 ||
+         (codePoint >= 0x2000 && codePoint <= 0x200B && codePoint != 0x2007) ||
+         codePoint == 0x205F || codePoint == 0x3000;
+}
+
+static bool IsInvisible(char32_t codePoint) {
+  return codePoint < 0x20 || (codePoint >= 0x200B && codePoint <= 0x200F) || codePoint == 0xFEFF;
+}
+
+// Ideographic scripts are written without spaces, so lines may be broken between any two of their
+// characters
+static bool IsIdeographic(char32_t codePoint) {
+  return (codePoint >= 0x2E80 && codePoint < 0xA000) ||
+         (codePoint >= 0xAC00 && codePoint < 0xD800) ||
+         (codePoint >= 0xF900 && codePoint < 0xFB00) || codePoint >= 0x20000;
+}
+
+static bool IsHyphen(char32_t codePoint) {
+  return codePoint == '-' || codePoint == 0x2010;
+}
+
+static void ApplyProperties(SoftwareTextStyle &target, TextStyleProperty properties,
+                            const TextStyle &style) {
+  if (HasProperty(properties, TextStyleProperty::FontFace)) {
+    target.fontFamily = style.FontFace;
+  }
+  if (HasProperty(properties, TextStyleProperty::FontSize)) {
+    target.fontSize = style.FontSize;
+  }
+  if (HasProperty(properties, TextStyleProperty::Color)) {
+    target.color = style.Color;
+  }
+  if (HasProperty(properties, TextStyleProperty::Underline)) {
+    target.underline = style.Underline;
+  }
+  if (HasProperty(properties, TextStyleProperty::LineThrough)) {
+    target.lineThrough = style.LineThrough;
+  }
+  if (HasProperty(properties, TextStyleProperty::FontStyle)) {
+    target.fontStyle = style.FontStyle;
+  }
+  if (HasProperty(properties, TextStyleProperty::FontWeight)) {
+    target.fontWeight = style.FontWeight;
+  }
+  if (HasProperty(properties, TextStyleProperty::DropShadowColor)) {
+    target.dropShadowColor = style.DropShadowColor;
+  }
+  if (HasProperty(properties, TextStyleProperty::Outline)) {
+    target.outlineColor = style.OutlineColor;
+    target.outlineWidth = style.OutlineWidth;
+  }
+  if (HasProperty(properties, TextStyleProperty::Kerning)) {
+    target.kerning = style.Kerning;
+  }
+}
+
+static bool SameStyle(const SoftwareTextStyle &a, const SoftwareTextStyle &b) {
+  return a.fontFamily == b.fontFamily && a.fontSize == b.fontSize && a.color == b.color &&
+         a.underline == b.underline && a.lineThrough == b.lineThrough &&
+         a.kerning == b.kerning && a.fontStyle == b.fontStyle && a.fontWeight == b.fontWeight &&
+         a.dropShadowColor == b.dropShadowColor && a.outlineColor == b.outlineColor &&
+         a.outlineWidth == b.outlineWidth;
+}
+
+SoftwareTextLayout::SoftwareTextLayout(SoftwareFontCollection &fonts,
+                                       const ParagraphStyle &paragraphStyle,
+                                       const TextStyle &textStyle,
+                                       std::u16string_view text,
+                                       float maxWidth,
+                                       float maxHeight)
+    : _fonts(fonts),
+      _paragraphStyle(paragraphStyle),
+      _text(text),
+      _maxWidth(maxWidth),
+      _maxHeight(maxHeight) {
+  SoftwareTextStyle baseStyle{};
+  ApplyProperties(baseStyle,
+                  TextStyleProperty::FontFace | TextStyleProperty::FontSize |
+                      TextStyleProperty::Color | TextStyleProperty::Underline |
+                      TextStyleProperty::LineThrough | TextStyleProperty::FontStyle |
+                      TextStyleProperty::FontWeight | TextStyleProperty::DropShadowColor |
+                      TextStyleProperty::Outline | TextStyleProperty::Kerning,
+                  textStyle);
+  // The base style is always the first, which line spacing relies on
+  (void)AddStyle(std::move(baseStyle));
+  _styleIndices.assign(_text.length(), 0);
+}
+
+uint16_t SoftwareTextLayout::AddStyle(SoftwareTextStyle style) {
+  for (size_t i = 0; i < _styles.size(); i++) {
+    if (SameStyle(_styles[i], style)) {
+      return (uint16_t)i;
+    }
+  }
+  if (_styles.size() > std::numeric_limits<uint16_t>::max()) {
+    throw std::runtime_error("Too many distinct styles in a text layout.");
+  }
+
+  style.font = _fonts.Find(style.fontFamily, style.fontWeight, style.fontStyle);
+  if (!style.font) {
+    throw std::runtime_error("No fonts have been loaded.");
+  }
+  // Like DirectWrite, bold is only simulated if the font is considerably lighter
+  auto weight = (int)style.fontWeight;
+  style.simulateBold = weight >= (int)FontWeight::SemiBold && weight - style.font->Weight() >= 200;
+  style.simulateItalic = style.fontStyle != FontStyle::Normal && !style.font->IsItalic();
+
+  _styles.push_back(std::move(style));
+  return (uint16_t)(_styles.size() - 1);
+}
+
+void SoftwareTextLayout::SetStyle(uint32_t start,
+                                  uint32_t length,
+                                  TextStyleProperty properties,
+                                  const TextStyle &style) {
+  ApplyStyle(start, length, properties, style);
+}
+
+void SoftwareTextLayout::SetStyles(const TextStyleSpan *spans,
+                                   uint32_t spanCount,
+                                   const TextStyle *styles,
+                                   uint32_t styleCount) {
+  // Validate all spans first, so that a bad span does not leave the layout partially styled
+  for (uint32_t i = 0; i < spanCount; i++) {
+    auto &span = spans[i];
+    if (span.StyleIndex >= styleCount) {
+      throw std::out_of_range("Style index of span " + std::to_string(i) + " is out of range.");
+    }
+    if ((span.Properties & TextStyleProperty::FontFace) == TextStyleProperty::FontFace &&
+        !styles[span.StyleIndex].FontFace) {
+      throw std::invalid_argument("FontFace must be set for spans that change the font face.");
+    }
+  }
+
+  for (uint32_t i = 0; i < spanCount; i++) {
+    auto &span = spans[i];
+    ApplyStyle(span.Start, span.Length, span.Properties, styles[span.StyleIndex]);
+  }
+}
+
+void SoftwareTextLayout::ApplyStyle(uint32_t start, uint32_t length,
+                                    TextStyleProperty properties, const TextStyle &style) {
+  auto end = (uint32_t)std::min<uint64_t>((uint64_t)start + length, _text.length());
+
+  // The text usually has few distinct styles, so each is only derived once per call
+  uint32_t lastFrom = std::numeric_limits<uint32_t>::max();
+  uint16_t lastTo = 0;
+  for (auto i = start; i < end; i++) {
+    auto from = _styleIndices[i];
+    if (from != lastFrom) {
+      auto derived = _styles[from];
+      ApplyProperties(derived, properties, style);
+      lastTo = AddStyle(std::move(derived));
+      lastFrom = from;
+    }
+    _styleIndices[i] = lastTo;
+  }
+
+  _shapingDirty = true;
+  _layoutDirty = true;
+}
+
+void SoftwareTextLayout::SetMaxWidth(float maxWidth) {
+  _maxWidth = maxWidth;
+  _layoutDirty = true;
+}
+
+void SoftwareTextLayout::SetMaxHeight(float maxHeight) {
+  _maxHeight = maxHeight;
+  _layoutDirty = true;
+}
+
+void SoftwareTextLayout::Update() {
+  if (!_shapingDirty && !_layoutDirty) {
+    return;
+  }
+
+  // Shaping, measuring and trimming look up glyphs in the fonts shared with other threads
+  std::lock_guard<std::mutex> lock(_fonts.Mutex());
+  if (_shapingDirty) {
+    Shape();
+    _shapingDirty = false;
+    _layoutDirty = true;
+  }
+
+  BreakLines();
+  Trim();
+  Align();
+
+  _metrics = {};
+  _metrics.left = std::numeric_limits<float>::max();
+  for (auto &line : _lines) {
+    _metrics.left = std::min(_metrics.left, line.x);
+    _metrics.width = std::max(_metrics.width, line.width);
+    _metrics.widthIncludingTrailingWhitespace =
+        std::max(_metrics.widthIncludingTrailingWhitespace, line.widthIncludingTrailingWhitespace);
+    _metrics.height += line.height;
+  }
+  _metrics.top = _lines.front().top;
+  // Same as the width TextLayout gives DirectWrite, which is reduced by a hanging indent
+  _metrics.layoutWidth = AvailableWidth(1);
+  _metrics.layoutHeight = _maxHeight;
+  _metrics.lineCount = (uint32_t)_lines.size();
+
+  _layoutDirty = false;
+}
+
+void SoftwareTextLayout::Shape() {
+  _glyphs.clear();
+
+  char32_t previous = 0;
+  for (uint32_t i = 0; i < _text.length();) {
+    char32_t codePoint = _text[i];
+    uint16_t length = 1;
+    if (codePoint >= 0xD800 && codePoint < 0xDC00 && i + 1 < _text.length() &&
+        _text[i + 1] >= 0xDC00 && _text[i + 1] < 0xE000) {
+      codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (_text[i + 1] - 0xDC00);
+      length = 2;
+    } else if (codePoint == '\r' && i + 1 < _text.length() && _text[i + 1] == '\n') {
+      length = 2;
+    }
+
+    auto &style = _styles[_styleIndices[i]];
+    Glyph glyph{};
+    glyph.font = style.font;
+    glyph.textPosition = i;
+    glyph.length = length;
+    glyph.style = _styleIndices[i];
+    if (IsNewline(codePoint)) {
+      glyph.kind = GlyphKind::Newline;
+    } else if (codePoint == '\t') {
+      glyph.kind = GlyphKind::Tab;
+    } else {
+      glyph.kind = IsBreakingSpace(codePoint) ? GlyphKind::Space : GlyphKind::Normal;
+      if (!IsInvisible(codePoint)) {
+        glyph.index = glyph.font->GlyphIndex(codePoint);
+        if (!glyph.index) {
+          if (auto fallback = _fonts.FindFallback(codePoint)) {
+            glyph.font = fallback;
+            glyph.index = fallback->GlyphIndex(codePoint);
+          }
+        }
+        glyph.advance = glyph.font->Advance(glyph.index) * style.fontSize;
+      }
+    }
+
+    if (!_glyphs.empty()) {
+      auto &prev = _glyphs.back();
+      auto &prevStyle = _styles[prev.style];
+      if (prev.kind == GlyphKind::Normal && glyph.kind == GlyphKind::Normal &&
+          prev.font == glyph.font && prevStyle.fontSize == style.fontSize && prevStyle.kerning &&
+          style.kerning) {
+        prev.advance += glyph.font->Kerning(prev.index, glyph.index) * style.fontSize;
+      }
+      glyph.breakBefore =
+          glyph.kind == GlyphKind::Normal &&
+          (prev.kind == GlyphKind::Space || prev.kind == GlyphKind::Tab || IsHyphen(previous) ||
+           IsIdeographic(previous) || IsIdeographic(codePoint));
+    }
+
+    _glyphs.push_back(glyph);
+    previous = codePoint;
+    i += length;
+  }
+}
+
+float SoftwareTextLayout::AvailableWidth(size_t lineIndex) const {
+  // Like TextLayout, a hanging indent makes the first line wider than the others
+  auto width = _maxWidth;
+  if (_paragraphStyle.HangingIndent && lineIndex > 0) {
+    width -= _paragraphStyle.Indent;
+  }
+  return width;
+}
+
+float SoftwareTextLayout::LineStart(size_t lineIndex) const {
+  return _paragraphStyle.HangingIndent && lineIndex == 0 ? -_paragraphStyle.Indent : 0;
+}
+
+void SoftwareTextLayout::BreakLines() {
+  _lines.clear();
+
+  auto wordWrap = _paragraphStyle.WordWrap;
+  auto wrapping = wordWrap != WordWrap::NoWrap;
+  auto breakWords = wordWrap != WordWrap::WholeWord;
+  auto breakAnywhere = wordWrap == WordWrap::Character;
+
+  auto lineTop = 0.0f;
+  uint32_t first = 0;
+  bool newline;
+  do {
+    auto available = AvailableWidth(_lines.size());
+    auto x = 0.0f;
+    uint32_t breakAt = first;
+    auto end = first;
+    newline = false;
+    for (; end < _glyphs.size(); end++) {
+      auto &glyph = _glyphs[end];
+      if (glyph.kind == GlyphKind::Newline) {
+        glyph.x = x;
+        newline = true;
+        end++;
+        break;
+      }
+
+      if (glyph.kind == GlyphKind::Tab) {
+        auto tabStop = _paragraphStyle.TabStopWidth;
+        if (tabStop <= 0) {
+          tabStop = _styles[glyph.style].fontSize * DefaultTabStopEms;
+        }
+        glyph.advance = tabStop > 0 ? tabStop - std::fmod(x, tabStop) : 0;
+      }
+
+      if (end > first &&
+          (glyph.breakBefore || (breakAnywhere && glyph.kind == GlyphKind::Normal))) {
+        breakAt = end;
+      }
+      // Whitespace never causes a break, it hangs over the end of the line instead
+      if (wrapping && glyph.kind == GlyphKind::Normal && end > first &&
+          x + glyph.advance > available + WidthTolerance) {
+        if (breakAt > first) {
+          end = breakAt;
+          break;
+        }
+        if (breakWords) {
+          break;
+        }
+      }
+
+      glyph.x = x;
+      x += glyph.advance;
+    }
+
+    Line line{};
+    line.firstGlyph = first;
+    line.glyphCount = end - first;
+    line.visibleGlyphCount = line.glyphCount;
+    line.start = first < _glyphs.size() ? _glyphs[first].textPosition : (uint32_t)_text.length();
+    auto nextStart = end < _glyphs.size() ? _glyphs[end].textPosition : (uint32_t)_text.length();
+    line.length = nextStart - line.start;
+
+    auto contentEnd = end;
+    if (newline) {
+      contentEnd--;
+      line.newlineLength = _glyphs[contentEnd].length;
+    }
+    auto trailingStart = contentEnd;
+    while (trailingStart > first && _glyphs[trailingStart - 1].kind != GlyphKind::Normal) {
+      trailingStart--;
+    }
+    if (trailingStart > first) {
+      auto &last = _glyphs[trailingStart - 1];
+      line.width = last.x + last.advance;
+    }
+    if (contentEnd > first) {
+      auto &last = _glyphs[contentEnd - 1];
+      line.widthIncludingTrailingWhitespace = last.x + last.advance;
+    }
+    line.trailingWhitespaceLength =
+        nextStart - (trailingStart < end ? _glyphs[trailingStart].textPosition : nextStart);
+
+    // The line is as high as the largest font on it, and empty lines use the style of the
+    // preceding text
+    auto ascent = 0.0f, descent = 0.0f, lineGap = 0.0f;
+    auto measure = [&](const SoftwareFont &font, float fontSize) {
+      ascent = std::max(ascent, font.ascent * fontSize);
+      descent = std::max(descent, font.descent * fontSize);
+      lineGap = std::max(lineGap, font.lineGap * fontSize);
+    };
+    for (auto i = first; i < end; i++) {
+      measure(*_glyphs[i].font, _styles[_glyphs[i].style].fontSize);
+    }
+    if (first == end) {
+      auto &style = _styles[_text.empty() ? 0 : _styleIndices[std::max(line.start, 1u) - 1]];
+      measure(*style.font, style.fontSize);
+    }
+
+    switch (_paragraphStyle.LineSpacingMode) {
+      default:
+      case LineSpacingMode::Default:
+        line.height = ascent + descent + lineGap;
+        line.baseline = ascent;
+        break;
+      case LineSpacingMode::Uniform: {
+        // Same baseline as TextLayout, which measures it with the default font
+        auto &baseStyle = _styles[0];
+        line.height = _paragraphStyle.LineHeight;
+        line.baseline = baseStyle.font->ascent * baseStyle.fontSize;
+        break;
+      }
+      case LineSpacingMode::Proportional:
+        line.height = (ascent + descent + lineGap) * _paragraphStyle.LineHeight;
+        line.baseline = ascent;
+        break;
+    }
+    line.top = lineTop;
+    lineTop += line.height;
+
+    _lines.push_back(line);
+    first = end;
+  } while (first < _glyphs.size() || newline);
+}
+
+void SoftwareTextLayout::Trim() {
+  _visibleLines = _lines.size();
+  if (_paragraphStyle.TrimMode == TrimMode::None) {
+    return;
+  }
+
+  // Lines that do not fit vertically are hidden, but the first line is always shown
+  for (size_t i = 1; i < _lines.size(); i++) {
+    if (_lines[i].top + _lines[i].height > _maxHeight + WidthTolerance) {
+      _visibleLines = i;
+      break;
+    }
+  }
+
+  // Hidden lines are trimmed as well, so that the metrics do not depend on the height
+  for (size_t i = 0; i < _lines.size(); i++) {
+    auto &line = _lines[i];
+    auto available = AvailableWidth(i);
+    if (line.width > available + WidthTolerance ||
+        (i + 1 == _visibleLines && _visibleLines < _lines.size())) {
+      TrimLine(line, available);
+    }
+  }
+}
+
+void SoftwareTextLayout::TrimLine(Line &line, float availableWidth) {
+  line.isTrimmed = true;
+
+  auto contentCount = line.glyphCount - (line.newlineLength ? 1 : 0);
+  auto &lastGlyph = _glyphs[line.firstGlyph + (contentCount ? contentCount - 1 : 0)];
+  auto styleIndex = contentCount ? lastGlyph.style : _styleIndices[line.start];
+  auto &style = _styles[styleIndex];
+
+  auto &ellipsis = line.ellipsis;
+  ellipsis = {};
+  if (_paragraphStyle.TrimmingSign == TrimmingSign::Ellipsis) {
+    ellipsis.font = style.font;
+    ellipsis.style = styleIndex;
+    ellipsis.index = style.font->GlyphIndex(EllipsisCharacter);
+    if (!ellipsis.index) {
+      if (auto fallback = _fonts.FindFallback(EllipsisCharacter)) {
+        ellipsis.font = fallback;
+        ellipsis.index = fallback->GlyphIndex(EllipsisCharacter);
+      }
+    }
+    ellipsis.advance = ellipsis.font->Advance(ellipsis.index) * style.fontSize;
+    line.hasEllipsis = true;
+  }
+
+  // Keep the glyphs that fit next to the ellipsis
+  auto limit = availableWidth - ellipsis.advance + WidthTolerance;
+  uint32_t count = 0;
+  while (count < contentCount) {
+    auto &glyph = _glyphs[line.firstGlyph + count];
+    if (glyph.kind == GlyphKind::Normal && glyph.x + glyph.advance > limit) {
+      break;
+    }
+    count++;
+  }
+  if (count < contentCount && _paragraphStyle.TrimMode == TrimMode::Word) {
+    auto wordStart = count;
+    while (wordStart > 0 && !_glyphs[line.firstGlyph + wordStart].breakBefore) {
+      wordStart--;
+    }
+    // A single word that is too long is trimmed at a character instead
+    if (wordStart > 0) {
+      count = wordStart;
+    }
+  }
+  while (count > 0 && _glyphs[line.firstGlyph + count - 1].kind != GlyphKind::Normal) {
+    count--;
+  }
+
+  line.visibleGlyphCount = count;
+  if (count > 0) {
+    auto &last = _glyphs[line.firstGlyph + count - 1];
+    ellipsis.x = last.x + last.advance;
+  }
+  line.width = ellipsis.x + ellipsis.advance;
+  line.widthIncludingTrailingWhitespace = line.width;
+}
+
+void SoftwareTextLayout::Align() {
+  auto alignment = _paragraphStyle.TextAlignment;
+  for (size_t i = 0; i < _lines.size(); i++) {
+    auto &line = _lines[i];
+    auto extra = AvailableWidth(i) - line.width;
+    auto offset = 0.0f;
+    switch (alignment) {
+      default:
+      case TextAlign::Left:
+        break;
+      case TextAlign::Right:
+        offset = extra;
+        break;
+      case TextAlign::Center:
+        offset = extra / 2;
+        break;
+      case TextAlign::Justified: {
+        // The last line of each paragraph is not justified
+        if (line.newlineLength || i + 1 == _lines.size() || line.isTrimmed || extra <= 0) {
+          break;
+        }
+        auto contentEnd = line.firstGlyph + line.glyphCount;
+        while (contentEnd > line.firstGlyph && _glyphs[contentEnd - 1].kind != GlyphKind::Normal) {
+          contentEnd--;
+        }
+        uint32_t spaces = 0;
+        for (auto g = line.firstGlyph; g < contentEnd; g++) {
+          spaces += _glyphs[g].kind == GlyphKind::Space;
+        }
+        if (spaces == 0) {
+          break;
+        }
+        auto shift = 0.0f;
+        for (auto g = line.firstGlyph; g < line.firstGlyph + line.glyphCount; g++) {
+          _glyphs[g].x += shift;
+          if (g < contentEnd && _glyphs[g].kind == GlyphKind::Space) {
+            shift += extra / (float)spaces;
+          }
+        }
+        line.width += extra;
+        line.widthIncludingTrailingWhitespace += extra;
+        break;
+      }
+    }
+    line.x = LineStart(i) + offset;
+  }
+
+  auto height = _lines.back().top + _lines.back().height;
+  auto top = 0.0f;
+  if (_paragraphStyle.ParagraphAlignment == ParagraphAlign::Far) {
+    top = _maxHeight - height;
+  } else if (_paragraphStyle.ParagraphAlignment == ParagraphAlign::Center) {
+    top = (_maxHeight - height) / 2;
+  }
+  for (auto &line : _lines) {
+    line.top += top;
+  }
+}
+
+const SoftwareTextMetrics &SoftwareTextLayout::GetMetrics() {
+  Update();
+  return _metrics;
+}
+
+bool SoftwareTextLayout::GetLineMetrics(SoftwareLineMetrics *lineMetrics,
+                                        uint32_t count,
+                                        uint32_t *actualCount) {
+  Update();
+  *actualCount = (uint32_t)_lines.size();
+  auto toCopy = std::min<size_t>(count, _lines.size());
+  for (size_t i = 0; i < toCopy; i++) {
+    auto &line = _lines[i];
+    lineMetrics[i] = {line.length, line.trailingWhitespaceLength, line.newlineLength,
+                      line.height, line.baseline, line.isTrimmed};
+  }
+  return count >= _lines.size();
+}
+
+const SoftwareTextLayout::Line *SoftwareTextLayout::FindLine(uint32_t textPosition) const {
+  for (auto &line : _lines) {
+    if (textPosition < line.start + line.length) {
+      return &line;
+    }
+  }
+  return &_lines.back();
+}
+
+bool SoftwareTextLayout::HitTestPoint(float x, float y, int *position, int *length,
+                                      bool *trailingHit) {
+  Update();
+  x -= _paragraphStyle.Indent;
+
+  size_t lineIndex = 0;
+  while (lineIndex + 1 < _lines.size() &&
+         y >= _lines[lineIndex].top + _lines[lineIndex].height) {
+    lineIndex++;
+  }
+  auto &line = _lines[lineIndex];
+  auto inside = y >= _lines.front().top && y < _lines.back().top + _lines.back().height;
+
+  auto lineX = x - line.x;
+  auto contentEnd = line.firstGlyph + line.glyphCount - (line.newlineLength ? 1 : 0);
+  if (contentEnd == line.firstGlyph) {
+    *position = (int)line.start;
+    *length = 0;
+    *trailingHit = false;
+    return false;
+  }
+
+  if (lineX < 0) {
+    auto &glyph = _glyphs[line.firstGlyph];
+    *position = (int)glyph.textPosition;
+    *length = glyph.length;
+    *trailingHit = false;
+    return false;
+  }
+
+  for (auto i = line.firstGlyph; i < contentEnd; i++) {
+    auto &glyph = _glyphs[i];
+    if (lineX < glyph.x + glyph.advance) {
+      *position = (int)glyph.textPosition;
+      *length = glyph.length;
+      *trailingHit = lineX >= glyph.x + glyph.advance / 2;
+      return inside;
+    }
+  }
+
+  auto &last = _glyphs[contentEnd - 1];
+  *position = (int)last.textPosition;
+  *length = last.length;
+  *trailingHit = true;
+  return false;
+}
+
+void SoftwareTextLayout::HitTestTextPosition(uint32_t textPosition, bool afterPosition,
+                                             float *pointX, float *pointY,
+                                             SoftwareHitTestMetrics *metrics) {
+  Update();
+  auto &line = *FindLine(textPosition);
+  metrics->top = line.top;
+  metrics->height = line.height;
+  *pointY = line.top;
+
+  for (auto i = line.firstGlyph; i < line.firstGlyph + line.glyphCount; i++) {
+    auto &glyph = _glyphs[i];
+    if (textPosition >= glyph.textPosition && textPosition < glyph.textPosition + glyph.length) {
+      metrics->textPosition = glyph.textPosition;
+      metrics->length = glyph.length;
+      metrics->left = line.x + glyph.x + _paragraphStyle.Indent;
+      metrics->width = glyph.advance;
+      *pointX = metrics->left + (afterPosition ? glyph.advance : 0);
+      return;
+    }
+  }
+
+  // Past the end of the text, where both edges are the end of the last line
+  metrics->textPosition = (uint32_t)_text.length();
+  metrics->length = 0;
+  metrics->left = line.x + line.widthIncludingTrailingWhitespace + _paragraphStyle.Indent;
+  metrics->width = 0;
+  *pointX = metrics->left;
+}
+
+bool SoftwareTextLayout::HitTestTextRange(uint32_t start,
+                                          uint32_t length,
+                                          SoftwareHitTestMetrics *metrics,
+                                          uint32_t metricsCount,
+                                          uint32_t *actualMetricsCount) {
+  Update();
+  auto end = (uint32_t)std::min<uint64_t>((uint64_t)start + length, _text.length());
+
+  // One rectangle per line that contains part of the range
+  uint32_t count = 0;
+  for (auto &line : _lines) {
+    auto rangeStart = std::max(start, line.start);
+    auto rangeEnd = std::min(end, line.start + line.length);
+    if (rangeStart >= rangeEnd) {
+      continue;
+    }
+
+    auto left = std::numeric_limits<float>::max();
+    auto right = 0.0f;
+    for (auto i = line.firstGlyph; i < line.firstGlyph + line.glyphCount; i++) {
+      auto &glyph = _glyphs[i];
+      if (glyph.textPosition + glyph.length > rangeStart && glyph.textPosition < rangeEnd) {
+        left = std::min(left, glyph.x);
+        right = std::max(right, glyph.x + glyph.advance);
+      }
+    }
+
+    if (count < metricsCount) {
+      auto &rect = metrics[count];
+      rect.textPosition = rangeStart;
+      rect.length = rangeEnd - rangeStart;
+      rect.left = line.x + left + _paragraphStyle.Indent;
+      rect.top = line.top;
+      rect.width = std::max(0.0f, right - left);
+      rect.height = line.height;
+    }
+    count++;
+  }
+
+  *actualMetricsCount = count;
+  return count <= metricsCount;
+}
+
+void SoftwareTextLayout::Render(SoftwareTextRenderer &renderer, float x, float y,
+                                float opacity) {
+  Update();
+  for (size_t i = 0; i < _visibleLines; i++) {
+    RenderLine(renderer, _lines[i], x + _paragraphStyle.Indent, y, opacity);
+  }
+}
+
+void SoftwareTextLayout::RenderLine(SoftwareTextRenderer &renderer, const Line &line, float x,
+                                    float y, float opacity) {
+  auto originX = x + line.x;
+  auto baseline = y + line.top + line.baseline;
+  auto first = _glyphs.begin() + line.firstGlyph;
+  auto last = first + line.visibleGlyphCount;
+
+  auto forEachGlyph = [&](auto callback) {
+    for (auto it = first; it != last; ++it) {
+      if (it->kind == GlyphKind::Normal && it->index) {
+        callback(*it, _styles[it->style]);
+      }
+    }
+    if (line.hasEllipsis) {
+      callback(line.ellipsis, _styles[line.ellipsis.style]);
+    }
+  };
+
+  // Shadows go below all glyphs of the line, since they are offset into neighboring glyphs
+  forEachGlyph([&](const Glyph &glyph, const SoftwareTextStyle &style) {
+    if (!IsTransparent(style.dropShadowColor)) {
+      renderer.DrawGlyph(*glyph.font, glyph.index, style, originX + glyph.x + DropShadowOffset,
+                         baseline + DropShadowOffset, style.dropShadowColor, 0, opacity);
+    }
+  });
+
+  // Outlines are drawn over the glyphs, like in TextRenderer
+  forEachGlyph([&](const Glyph &glyph, const SoftwareTextStyle &style) {
+    if (!IsTransparent(style.color)) {
+      renderer.DrawGlyph(*glyph.font, glyph.index, style, originX + glyph.x, baseline,
+                         style.color, 0, opacity);
+    }
+    if (style.HasOutline()) {
+      renderer.DrawGlyph(*glyph.font, glyph.index, style, originX + glyph.x, baseline,
+                         style.outlineColor, style.outlineWidth, opacity);
+    }
+  });
+
+  // Underlines and strikethroughs are drawn for each run of glyphs sharing a style, excluding
+  // trailing whitespace
+  auto decorationEnd = last;
+  while (decorationEnd != first && (decorationEnd - 1)->kind != GlyphKind::Normal) {
+    --decorationEnd;
+  }
+  for (auto runStart = first; runStart != decorationEnd;) {
+    auto runEnd = runStart + 1;
+    while (runEnd != decorationEnd && runEnd->style == runStart->style) {
+      ++runEnd;
+    }
+
+    auto &style = _styles[runStart->style];
+    auto left = originX + runStart->x;
+    auto right = originX + (runEnd - 1)->x + (runEnd - 1)->advance;
+    auto &font = *style.font;
+    if (style.underline) {
+      auto top = baseline + font.underlinePosition * style.fontSize;
+      renderer.FillRect(left, top, right, top + font.underlineThickness * style.fontSize,
+                        style.color, opacity);
+    }
+    if (style.lineThrough) {
+      auto top = baseline - font.strikethroughPosition * style.fontSize;
+      renderer.FillRect(left, top, right, top + font.strikethroughThickness * style.fontSize,
+                        style.color, opacity);
+    }
+    runStart = runEnd;
+  }
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../rendering/drawing/Style.h"
+#include "SoftwareFonts.h"
+
+class SoftwareTextRenderer;
+
+/**
+ * A text style with the font resolved from the font collection. Fonts that lack the requested
+ * weight or style are made bold or italic when glyphs are rasterized.
+ */
+struct SoftwareTextStyle {
+  std::u16string fontFamily;
+  float fontSize;
+  uint32_t color;
+  bool underline;
+  bool lineThrough;
+  bool kerning;
+  ::FontStyle fontStyle;
+  ::FontWeight fontWeight;
+  uint32_t dropShadowColor;
+  uint32_t outlineColor;
+  float outlineWidth;
+
+  SoftwareFont *font = nullptr;
+  bool simulateBold = false;
+  bool simulateItalic = false;
+
+  [[nodiscard]] bool HasOutline() const {
+    return outlineWidth > 0 && !IsTransparent(outlineColor);
+  }
+};
+
+/**
+ * Same fields as DWRITE_TEXT_METRICS, without the bidi reordering depth.
+ */
+struct SoftwareTextMetrics {
+  float left;
+  float top;
+  float width;
+  float widthIncludingTrailingWhitespace;
+  float height;
+  float layoutWidth;
+  float layoutHeight;
+  uint32_t lineCount;
+};
+
+/**
+ * Same fields as DWRITE_LINE_METRICS.
+ */
+struct SoftwareLineMetrics {
+  uint32_t length;
+  uint32_t trailingWhitespaceLength;
+  uint32_t newlineLength;
+  float height;
+  float baseline;
+  bool isTrimmed;
+};
+
+/**
+ * The subset of DWRITE_HIT_TEST_METRICS that the exports return.
+ */
+struct SoftwareHitTestMetrics {
+  uint32_t textPosition;
+  uint32_t length;
+  float left;
+  float top;
+  float width;
+  float height;
+};
+
+/**
+ * Lays out UTF-16 text with the fonts of a SoftwareFontCollection, mirroring what TextLayout does
+ * with DirectWrite closely enough for UI layout: glyphs are placed per code point with the fonts'
+ * advances and pair kerning, there is no complex script shaping or bidirectional text. Characters
+ * missing from a font are taken from the first font that has them.
+ *
+ * Lines are broken greedily after whitespace and hyphens (or anywhere, depending on the word
+ * wrap mode), and the layout is only computed again when it is used after a change.
+ *
+ * Not thread-safe. The font collection must outlive the layout.
+ */
+class SoftwareTextLayout {
+ public:
+  /**
+   * @throws std::runtime_error If no fonts have been loaded.
+   */
+  SoftwareTextLayout(SoftwareFontCollection &fonts,
+                     const ParagraphStyle &paragraphStyle,
+                     const TextStyle &textStyle,
+                     std::u16string_view text,
+                     float maxWidth,
+                     float maxHeight);
+
+  void Render(SoftwareTextRenderer &renderer, float x, float y, float opacity);
+
+  void SetStyle(uint32_t start,
+                uint32_t length,
+                TextStyleProperty properties,
+                const TextStyle &style);
+
+  /**
+   * Applies styles to multiple ranges of text at once. Each span refers to an entry of the style
+   * table by its index, which must be less than styleCount.
+   * @throws std::out_of_range If a style index is out of range.
+   * @throws std::invalid_argument If a span changes the font face to null.
+   */
+  void SetStyles(const TextStyleSpan *spans,
+                 uint32_t spanCount,
+                 const TextStyle *styles,
+                 uint32_t styleCount);
+
+  const SoftwareTextMetrics &GetMetrics();
+
+  /**
+   * @return false if the given buffer is not large enough to hold the line metrics,
+   * actualCount will be initialized to the correct size.
+   */
+  bool GetLineMetrics(SoftwareLineMetrics *lineMetrics, uint32_t count, uint32_t *actualCount);
+
+  void SetMaxWidth(float maxWidth);
+
+  void SetMaxHeight(float maxHeight);
+
+  bool HitTestPoint(float x, float y, int *position, int *length, bool *trailingHit);
+
+  /**
+   * Returns the area of the character at the text position, and in pointX and pointY the caret
+   * position at its leading edge, or at its trailing edge if afterPosition is set. As with
+   * DirectWrite, the metrics cover the whole character regardless of afterPosition.
+   */
+  void HitTestTextPosition(uint32_t textPosition, bool afterPosition, float *pointX,
+                           float *pointY, SoftwareHitTestMetrics *metrics);
+
+  bool HitTestTextRange(uint32_t start,
+                        uint32_t length,
+                        SoftwareHitTestMetrics *metrics,
+                        uint32_t metricsCount,
+                        uint32_t *actualMetricsCount);
+
+ private:
+  enum class GlyphKind : uint8_t { Normal, Space, Tab, Newline };
+
+  struct Glyph {
+    SoftwareFont *font;
+    uint32_t index;
+    uint32_t textPosition;
+    uint16_t length;  // UTF-16 code units of the character
+    uint16_t style;
+    GlyphKind kind;
+    bool breakBefore;  // Whether lines may be broken before this glyph
+    float x;           // Relative to the start of the line
+    float advance;
+  };
+
+  struct Line {
+    uint32_t start;
+    uint32_t length;
+    uint32_t trailingWhitespaceLength;
+    uint32_t newlineLength;
+    uint32_t firstGlyph;
+    uint32_t glyphCount;
+    uint32_t visibleGlyphCount;  // Glyphs that are drawn, which excludes trimmed glyphs
+    float x;
+    float top;
+    float height;
+    float baseline;
+    float width;
+    float widthIncludingTrailingWhitespace;
+    bool isTrimmed;
+    bool hasEllipsis;
+    Glyph ellipsis;
+  };
+
+  [[nodiscard]] uint16_t AddStyle(SoftwareTextStyle style);
+
+  void ApplyStyle(uint32_t start, uint32_t length, TextStyleProperty properties,
+                  const TextStyle &style);
+
+  void Update();
+  void Shape();
+  void BreakLines();
+  void Align();
+  void Trim();
+  void TrimLine(Line &line, float availableWidth);
+
+  float AvailableWidth(size_t lineIndex) const;
+  float LineStart(size_t lineIndex) const;
+
+  const Line *FindLine(uint32_t textPosition) const;
+
+  void RenderLine(SoftwareTextRenderer &renderer, const Line &line, float x, float y,
+                  float opacity);
+
+  SoftwareFontCollection &_fonts;
+  ParagraphStyle _paragraphStyle;
+  std::u16string _text;
+  float _maxWidth;
+  float _maxHeight;
+
+  // Styles used by the text, and the index of the style of each code unit
+  std::vector<SoftwareTextStyle> _styles;
+  std::vector<uint16_t> _styleIndices;
+
+  bool _shapingDirty = true;
+  bool _layoutDirty = true;
+  std::vector<Glyph> _glyphs;
+  std::vector<Line> _lines;
+  size_t _visibleLines = 0;
+  SoftwareTextMetrics _metrics{};
+};
@@ -0,0 +1,203 @@
+
+// Exports the same functions as rendering/drawing/TextLayout_wrapper.cpp, backed by
+// SoftwareTextLayout.
+
+#include <algorithm>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "../interop/string_interop.h"
+#include "../utils.h"
+#include "SoftwareTextLayout.h"
+
+NATIVE_API ApiBool TextLayout_SetStyle(SoftwareTextLayout *layout,
+                                       uint32_t start,
+                                       uint32_t length,
+                                       TextStyleProperty properties,
+                                       const TextStyle &style,
+                                       char16_t **error) noexcept {
+  *error = nullptr;
+
+  if ((properties & TextStyleProperty::FontFace) == TextStyleProperty::FontFace &&
+      !style.FontFace) {
+    *error = copyString(L"FontFace must be set.");
+    return false;
+  }
+
+  try {
+    layout->SetStyle(start, length, properties, style);
+    return true;
+  } catch (const std::exception &e) {
+    *error = copyString(localToWide(e.what()));
+    return false;
+  }
+}
+
+/**
+ * Applies multiple styles in one call. Spans refer to entries of the style table by index.
+ */
+NATIVE_API ApiBool TextLayout_SetStyles(SoftwareTextLayout *layout,
+                                        const TextStyleSpan *spans,
+                                        uint32_t spanCount,
+                                        const TextStyle *styles,
+                                        uint32_t styleCount,
+                                        char16_t **error) noexcept {
+  *error = nullptr;
+
+  // Invalid spans are rejected by SetStyles before any style is applied
+  try {
+    layout->SetStyles(spans, spanCount, styles, styleCount);
+    return true;
+  } catch (const std::exception &e) {
+    *error = copyString(localToWide(e.what()));
+    return false;
+  }
+}
+
+NATIVE_API void TextLayout_Free(SoftwareTextLayout *layout) noexcept {
+  delete layout;
+}
+
+struct Metrics {
+  float left;
+  float top;
+  float width;
+  float widthIncludingTrailingWhitespace;
+  float height;
+  float layoutWidth;
+  float layoutHeight;
+  int maxBidiReorderingDepth;
+  int lineCount;
+};
+
+NATIVE_API void TextLayout_GetMetrics(SoftwareTextLayout *layout, Metrics *metricsOut) noexcept {
+  auto &metrics = layout->GetMetrics();
+
+  metricsOut->left = metrics.left;
+  metricsOut->top = metrics.top;
+  metricsOut->width = metrics.width;
+  metricsOut->widthIncludingTrailingWhitespace = metrics.widthIncludingTrailingWhitespace;
+  metricsOut->height = metrics.height;
+  metricsOut->layoutWidth = metrics.layoutWidth;
+  metricsOut->layoutHeight = metrics.layoutHeight;
+  metricsOut->maxBidiReorderingDepth = 1;
+  metricsOut->lineCount = (int)metrics.lineCount;
+}
+
+struct LineMetrics {
+  int length;
+  int trailingWhitespaceLength;
+  int newlineLength;
+  float height;
+  float baseline;
+  bool isTrimmed;
+};
+
+NATIVE_API ApiBool TextLayout_GetLineMetrics(SoftwareTextLayout *layout,
+                                             LineMetrics *lineMetricsOut,
+                                             uint32_t lineMetricsSize,
+                                             uint32_t *actualLineCount) noexcept {
+  // This is a way to get the actual line count
+  if (lineMetricsSize == 0) {
+    layout->GetLineMetrics(nullptr, 0, actualLineCount);
+    return false;
+  }
+
+  std::vector<SoftwareLineMetrics> lineMetrics(lineMetricsSize);
+  auto result = layout->GetLineMetrics(lineMetrics.data(), lineMetricsSize, actualLineCount);
+
+  auto linesToConvert = std::min<uint32_t>(lineMetricsSize, *actualLineCount);
+  for (auto i = 0u; i < linesToConvert; i++) {
+    auto &in = lineMetrics[i];
+    auto &out = lineMetricsOut[i];
+
+    out.length = (int)in.length;
+    out.trailingWhitespaceLength = (int)in.trailingWhitespaceLength;
+    out.newlineLength = (int)in.newlineLength;
+    out.height = in.height;
+    out.baseline = in.baseline;
+    out.isTrimmed = in.isTrimmed;
+  }
+
+  return result;
+}
+
+NATIVE_API ApiBool TextLayout_HitTestPoint(SoftwareTextLayout *layout, float x, float y,
+                                           int *start, int *length, ApiBool *trailingHit) noexcept {
+  bool trailingHitBool = false;
+  auto hit = layout->HitTestPoint(x, y, start, length, &trailingHitBool);
+  *trailingHit = trailingHitBool;
+  return hit;
+}
+
+struct HitTestRect {
+  float x;
+  float y;
+  float width;
+  float height;
+};
+
+static void ConvertHitTestRects(const SoftwareHitTestMetrics *hitMetrics,
+                                HitTestRect *rectsOut,
+                                uint32_t count) {
+  for (auto i = 0u; i < count; i++) {
+    auto &in = hitMetrics[i];
+    auto &out = rectsOut[i];
+
+    out.x = in.left;
+    out.y = in.top;
+    out.width = in.width;
+    out.height = in.height;
+  }
+}
+
+NATIVE_API void TextLayout_HitTestTextPosition(SoftwareTextLayout *layout,
+                                               int textPosition,
+                                               ApiBool afterPosition,
+                                               HitTestRect *rect) noexcept {
+  float x = 0;
+  float y = 0;
+  SoftwareHitTestMetrics metrics{};
+  layout->HitTestTextPosition(textPosition, afterPosition, &x, &y, &metrics);
+  ConvertHitTestRects(&metrics, rect, 1);
+}
+
+NATIVE_API ApiBool TextLayout_HitTestTextRange(SoftwareTextLayout *layout,
+                                               int textPosition,
+                                               int length,
+                                               HitTestRect *rectsOut,
+                                               uint32_t rectsCount,
+                                               uint32_t *actualRectsCount) noexcept {
+  // This is a way to get the actual line count
+  if (rectsCount == 0) {
+    layout->HitTestTextRange(textPosition, length, nullptr, 0, actualRectsCount);
+    return false;
+  }
+
+  std::vector<SoftwareHitTestMetrics> hitMetrics(rectsCount);
+  auto result = layout->HitTestTextRange(textPosition, length, hitMetrics.data(), rectsCount,
+                                         actualRectsCount);
+
+  auto rectsToConvert = std::min<uint32_t>(rectsCount, *actualRectsCount);
+  ConvertHitTestRects(hitMetrics.data(), rectsOut, rectsToConvert);
+
+  return result;
+}
+
+NATIVE_API ApiBool TextLayout_SetMaxWidth(SoftwareTextLayout *layout, float maxWidth) noexcept {
+  layout->SetMaxWidth(maxWidth);
+  return true;
+}
+
+NATIVE_API ApiBool TextLayout_SetMaxHeight(SoftwareTextLayout *layout, float maxHeight) noexcept {
+  layout->SetMaxHeight(maxHeight);
+  return true;
+}
+
+/**
+ * Layouts are always drawn directly by this engine.
+ */
+NATIVE_API void TextLayout_SetBitmapCaching([[maybe_unused]] SoftwareTextLayout *layout,
+                                           [[maybe_unused]] ApiBool enabled) noexcept {
+}
@@ -0,0 +1,30 @@
+
+#include <cmath>
+
+#include "SoftwareTextLayout.h"
+#include "SoftwareTextRenderer.h"
+
+void SoftwareTextRenderer::DrawGlyph(SoftwareFont &font, uint32_t glyphIndex,
+                                     const SoftwareTextStyle &style, float x, float y,
+                                     uint32_t color, float outlineWidth, float opacity) {
+  // Glyphs are positioned horizontally with subpixel precision, but baselines are snapped to
+  // pixels, since glyphs are only rasterized at horizontal offsets
+  auto deviceX = x * _scaleX + _offsetX;
+  auto deviceY = std::round(y * _scaleY + _offsetY);
+
+  SoftwareGlyph glyph{};
+  if (!_glyphCache.Get(font, glyphIndex, style.fontSize * _scaleY, deviceX, style.simulateBold,
+                       style.simulateItalic, outlineWidth * _scaleY, glyph) ||
+      glyph.width == 0 || glyph.height == 0) {
+    return;
+  }
+
+  _canvas.FillMask((int)std::floor(deviceX) + glyph.offsetX, (int)deviceY + glyph.offsetY,
+                   glyph.mask, glyph.width, glyph.height, glyph.stride, color, opacity);
+}
+
+void SoftwareTextRenderer::FillRect(float left, float top, float right, float bottom,
+                                    uint32_t color, float opacity) {
+  _canvas.FillRect(left * _scaleX + _offsetX, top * _scaleY + _offsetY,
+                   right * _scaleX + _offsetX, bottom * _scaleY + _offsetY, color, opacity);
+}
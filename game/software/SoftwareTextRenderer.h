@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+#include "SoftwareCanvas.h"
+#include "SoftwareGlyphCache.h"
+
+struct SoftwareTextStyle;
+
+/**
+ * Draws the glyphs and decorations of text layouts onto a canvas. Coordinates are given in DIPs
+ * and mapped to device pixels by a scale and an offset, so text can be moved and scaled, but not
+ * rotated or skewed.
+ */
+class SoftwareTextRenderer {
+ public:
+  SoftwareTextRenderer(SoftwareCanvas &canvas, SoftwareGlyphCache &glyphCache)
+      : _canvas(canvas), _glyphCache(glyphCache) {}
+
+  void SetDeviceTransform(float scaleX, float scaleY, float offsetX, float offsetY) {
+    _scaleX = scaleX;
+    _scaleY = scaleY;
+    _offsetX = offsetX;
+    _offsetY = offsetY;
+  }
+
+  /**
+   * Draws a glyph with its origin on the baseline at x, y. If outlineWidth is not zero, only the
+   * outline of the glyph is drawn, with the given stroke width.
+   */
+  void DrawGlyph(SoftwareFont &font, uint32_t glyphIndex, const SoftwareTextStyle &style, float x,
+                 float y, uint32_t color, float outlineWidth, float opacity);
+
+  void FillRect(float left, float top, float right, float bottom, uint32_t color, float opacity);
+
+ private:
+  SoftwareCanvas &_canvas;
+  SoftwareGlyphCache &_glyphCache;
+  float _scaleX = 1;
+  float _scaleY = 1;
+  float _offsetX = 0;
+  float _offsetY = 0;
+};
@@ -0,0 +1,174 @@
+
+#include <algorithm>
+#include <cmath>
+
+#include "GlyphAtlas.h"
+
+// Shelf heights are rounded up to a multiple of this, so that glyphs of similar heights share
+// shelves
+constexpr uint32_t ShelfHeightStep = 4;
+
+// A glyph is only put on an existing shelf that is at most this much taller than the glyph, unless
+// no new shelf can be started
+constexpr uint32_t MaxShelfWasteDivisor = 2;
+
+static uint16_t Quantize(float value, uint32_t steps) {
+  auto quantized = std::lround(value * (float)steps);
+  return (uint16_t)std::clamp<long>(quantized, 0, UINT16_MAX);
+}
+
+GlyphAtlas::GlyphAtlas(uint32_t pageSize, uint32_t maxPages)
+    : _pageSize(std::clamp<uint32_t>(pageSize, 1, 65536)),
+      _maxPages(std::clamp<uint32_t>(maxPages, 1, 65536)) {}
+
+GlyphKey GlyphAtlas::MakeKey(uint32_t fontFace, uint32_t glyphIndex, float fontSize, float x,
+                             float outlineWidth) {
+  GlyphKey key{};
+  key.fontFace = fontFace;
+  key.glyphIndex = glyphIndex;
+  key.sizeBucket = Quantize(fontSize, SizeSteps);
+  key.outlineWidth = Quantize(outlineWidth, SizeSteps);
+  auto fraction = x - std::floor(x);
+  key.subpixelOffset = (uint8_t)((uint32_t)(fraction * SubpixelPositions) % SubpixelPositions);
+  return key;
+}
+
+const GlyphAtlasEntry *GlyphAtlas::Find(const GlyphKey &key) {
+  auto it = _glyphs.find(key);
+  if (it == _glyphs.end()) {
+    _misses++;
+    return nullptr;
+  }
+  _hits++;
+  Touch(it->second.page);
+  return &it->second;
+}
+
+const GlyphAtlasEntry *GlyphAtlas::Insert(const GlyphKey &key, uint32_t width, uint32_t height,
+                                          int32_t offsetX, int32_t offsetY) {
+  if (auto it = _glyphs.find(key); it != _glyphs.end()) {
+    Touch(it->second.page);
+    return &it->second;
+  }
+
+  auto paddedWidth = width + Padding;
+  auto paddedHeight = height + Padding;
+  if (paddedWidth > _pageSize || paddedHeight > _pageSize) {
+    return nullptr;
+  }
+
+  uint32_t x, y;
+  auto page = FindPage(paddedWidth, paddedHeight, x, y);
+  if (page < 0) {
+    return nullptr;
+  }
+
+  GlyphAtlasEntry entry{};
+  entry.page = (uint16_t)page;
+  entry.x = (uint16_t)x;
+  entry.y = (uint16_t)y;
+  entry.width = (uint16_t)width;
+  entry.height = (uint16_t)height;
+  entry.offsetX = (int16_t)std::clamp<int32_t>(offsetX, INT16_MIN, INT16_MAX);
+  entry.offsetY = (int16_t)std::clamp<int32_t>(offsetY, INT16_MIN, INT16_MAX);
+
+  _pages[page].glyphs.push_back(key);
+  Touch(page);
+  return &_glyphs.emplace(key, entry).first->second;
+}
+
+void GlyphAtlas::Clear() {
+  _pages.clear();
+  _glyphs.clear();
+  _lastPage = 0;
+}
+
+GlyphAtlasStats GlyphAtlas::Stats() const {
+  GlyphAtlasStats stats{};
+  stats.hits = _hits;
+  stats.misses = _misses;
+  stats.pageEvictions = _pageEvictions;
+  stats.glyphs = (uint32_t)_glyphs.size();
+  stats.pages = (uint32_t)_pages.size();
+  return stats;
+}
+
+bool GlyphAtlas::Allocate(Page &page, uint32_t width, uint32_t height, uint32_t &x,
+                          uint32_t &y) const {
+  // Best fit: the lowest shelf that the glyph fits on
+  Shelf *best = nullptr;
+  for (auto &shelf : page.shelves) {
+    if (shelf.height >= height && shelf.used + width <= _pageSize &&
+        (!best || shelf.height < best->height)) {
+      best = &shelf;
+    }
+  }
+
+  auto shelfHeight = std::min((height + ShelfHeightStep - 1) / ShelfHeightStep * ShelfHeightStep,
+                              _pageSize);
+  auto canAddShelf = page.used + height <= _pageSize;
+  if (canAddShelf && (!best || best->height - height > height / MaxShelfWasteDivisor)) {
+    // The last shelf may be lower than the step to fit into the remaining space
+    page.shelves.push_back({page.used, std::min(shelfHeight, _pageSize - page.used), 0});
+    page.used += page.shelves.back().height;
+    best = &page.shelves.back();
+  }
+
+  if (!best) {
+    return false;
+  }
+  x = best->used;
+  y = best->y;
+  best->used += width;
+  return true;
+}
+
+int GlyphAtlas::FindPage(uint32_t width, uint32_t height, uint32_t &x, uint32_t &y) {
+  // Start with the page that was allocated from last, since earlier pages are likely full
+  for (uint32_t i = 0; i < _pages.size(); i++) {
+    auto index = (_lastPage + i) % (uint32_t)_pages.size();
+    if (Allocate(_pages[index], width, height, x, y)) {
+      _lastPage = index;
+      return (int)index;
+    }
+  }
+
+  if (_pages.size() < _maxPages) {
+    auto &page = _pages.emplace_back();
+    Allocate(page, width, height, x, y);
+    _lastPage = (uint32_t)_pages.size() - 1;
+    return (int)_lastPage;
+  }
+
+  // Evict the least recently used page that has not been used in the current frame
+  int victim = -1;
+  for (uint32_t i = 0; i < _pages.size(); i++) {
+    auto &page = _pages[i];
+    if (page.lastFrame != _frame && (victim < 0 || page.lastUse < _pages[victim].lastUse)) {
+      victim = (int)i;
+    }
+  }
+  if (victim < 0) {
+    return -1;
+  }
+  EvictPage(victim);
+  Allocate(_pages[victim], width, height, x, y);
+  _lastPage = victim;
+  return victim;
+}
+
+void GlyphAtlas::EvictPage(uint32_t index) {
+  auto &page = _pages[index];
+  for (auto &key : page.glyphs) {
+    _glyphs.erase(key);
+  }
+  page.glyphs.clear();
+  page.shelves.clear();
+  page.used = 0;
+  _pageEvictions++;
+}
+
+void GlyphAtlas::Touch(uint32_t page) {
+  _pages[page].lastUse = ++_clock;
+  _pages[page].lastFrame = _frame;
+}
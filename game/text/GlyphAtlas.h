@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Identifies a rasterized glyph. Sizes are quantized by GlyphAtlas::MakeKey, so that glyphs drawn
+ * at almost the same size or position share an entry.
+ */
+struct GlyphKey {
+  uint32_t fontFace;  // Chosen by the caller, e.g. an index into its font table
+  uint32_t glyphIndex;
+  uint16_t sizeBucket;     // Font size in 1/SizeSteps pixels
+  uint16_t outlineWidth;   // Outline width in 1/SizeSteps pixels, 0 for glyphs without outline
+  uint8_t subpixelOffset;  // Horizontal offset in 1/SubpixelPositions pixels
+
+  bool operator==(const GlyphKey &other) const noexcept {
+    return fontFace == other.fontFace && glyphIndex == other.glyphIndex &&
+           sizeBucket == other.sizeBucket && outlineWidth == other.outlineWidth &&
+           subpixelOffset == other.subpixelOffset;
+  }
+};
+
+namespace std {
+template <>
+struct hash<GlyphKey> {
+  size_t operator()(const GlyphKey &key) const noexcept {
+    auto a = (uint64_t)key.fontFace << 32 | key.glyphIndex;
+    auto b = (uint64_t)key.sizeBucket << 24 | (uint64_t)key.outlineWidth << 8 | key.subpixelOffset;
+    auto hash = (a ^ (b * 0xC2B2AE3D27D4EB4Full)) * 0x9E3779B97F4A7C15ull;
+    return (size_t)(hash ^ (hash >> 32));
+  }
+};
+}  // namespace std
+
+/**
+ * Where a glyph's bitmap is stored in the atlas. The offset is the position of the bitmap's
+ * top-left corner relative to the glyph origin on the baseline, in pixels.
+ */
+struct GlyphAtlasEntry {
+  uint16_t page;
+  uint16_t x;
+  uint16_t y;
+  uint16_t width;
+  uint16_t height;
+  int16_t offsetX;
+  int16_t offsetY;
+};
+
+struct GlyphAtlasStats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t pageEvictions;
+  uint32_t glyphs;  // Number of glyphs currently in the atlas
+  uint32_t pages;   // Number of pages currently in use
+};
+
+/**
+ * Assigns rasterized glyphs to rectangles in a set of square atlas pages, so that text can be
+ * drawn from a few textures with one batch per page. It does not own any pixels: the caller
+ * rasterizes a glyph into the rectangle returned by Insert and uploads it to the page's texture.
+ *
+ * Each page is packed with shelves, i.e. rows of glyphs that share a height, which suits glyphs
+ * because most glyphs of a font have similar heights. Rectangles are never freed individually.
+ * When no page has room left, the least recently used page is cleared as a whole and all glyphs
+ * on it have to be rasterized again when they are needed next.
+ *
+ * Pages that were used since the last call to BeginFrame are not evicted, so that entries that
+ * were handed out for the current batch stay valid. If every page is in use, Insert fails and the
+ * caller has to draw what it has batched so far and call BeginFrame before trying again.
+ *
+ * Not thread-safe.
+ */
+class GlyphAtlas {
+ public:
+  static constexpr uint32_t SizeSteps = 4;
+  static constexpr uint32_t SubpixelPositions = 4;
+
+  /**
+   * Space that is kept free to the right of and below every glyph, so that sampling with
+   * bilinear filtering does not bleed into neighboring glyphs.
+   */
+  static constexpr uint32_t Padding = 1;
+
+  /**
+   * @param pageSize Width and height of each page in pixels, at most 65536.
+   * @param maxPages Number of pages that may be used before pages are evicted, at most 65536.
+   */
+  GlyphAtlas(uint32_t pageSize, uint32_t maxPages);
+
+  /**
+   * Builds the key for a glyph drawn with the given size and outline width at the given
+   * horizontal position, all in pixels.
+   */
+  static GlyphKey MakeKey(uint32_t fontFace, uint32_t glyphIndex, float fontSize, float x,
+                          float outlineWidth = 0);
+
+  /**
+   * @return The horizontal offset in pixels that the glyph of the key should be rasterized with.
+   */
+  static float SubpixelOffset(const GlyphKey &key) {
+    return (float)key.subpixelOffset / SubpixelPositions;
+  }
+
+  /**
+   * Returns the entry of a glyph and marks its page as used, or null if the glyph has to be
+   * rasterized and inserted. The pointer is invalidated by the next call to Insert.
+   */
+  const GlyphAtlasEntry *Find(const GlyphKey &key);
+
+  /**
+   * Reserves a rectangle for a glyph that is not in the atlas yet. The rectangle may contain
+   * pixels of an evicted glyph, which have to be overwritten.
+   * @return Null if the glyph is larger than a page, or if all pages have been used since the
+   *         last call to BeginFrame. The pointer is invalidated by the next call to Insert.
+   */
+  const GlyphAtlasEntry *Insert(const GlyphKey &key, uint32_t width, uint32_t height,
+                                int32_t offsetX, int32_t offsetY);
+
+  /**
+   * Allows the pages used so far to be evicted again.
+   */
+  void BeginFrame() {
+    _frame++;
+  }
+
+  /**
+   * Removes all glyphs and pages. The statistics are kept.
+   */
+  void Clear();
+
+  [[nodiscard]] uint32_t PageSize() const {
+    return _pageSize;
+  }
+
+  [[nodiscard]] uint32_t MaxPages() const {
+    return _maxPages;
+  }
+
+  [[nodiscard]] GlyphAtlasStats Stats() const;
+
+ private:
+  struct Shelf {
+    uint32_t y;
+    uint32_t height;
+    uint32_t used;  // Width taken by the glyphs on the shelf
+  };
+
+  struct Page {
+    std::vector<Shelf> shelves;
+    uint32_t used = 0;  // Height taken by the shelves
+    uint64_t lastUse = 0;
+    uint64_t lastFrame = 0;
+    std::vector<GlyphKey> glyphs;
+  };
+
+  /**
+   * Finds room for a rectangle on the page, adding a new shelf if needed.
+   * @return False if the page is full.
+   */
+  bool Allocate(Page &page, uint32_t width, uint32_t height, uint32_t &x, uint32_t &y) const;
+
+  /**
+   * Returns the page to take the rectangle from, evicting one if all pages are full, or -1.
+   */
+  int FindPage(uint32_t width, uint32_t height, uint32_t &x, uint32_t &y);
+
+  void EvictPage(uint32_t index);
+
+  void Touch(uint32_t page);
+
+  const uint32_t _pageSize;
+  const uint32_t _maxPages;
+  std::vector<Page> _pages;
+  std::unordered_map<GlyphKey, GlyphAtlasEntry> _glyphs;
+  uint32_t _lastPage = 0;
+  uint64_t _clock = 0;
+  uint64_t _frame = 1;
+  uint64_t _hits = 0;
+  uint64_t _misses = 0;
+  uint64_t _pageEvictions = 0;
+};
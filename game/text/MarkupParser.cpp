@@ -0,0 +1,68 @@
+
+#include "MarkupParser.h"
+
+template <typename Char>
+void ParseMarkup(std::basic_string_view<Char> markup,
+                 const MarkupStyle *palette,
+                 uint32_t paletteSize,
+                 std::basic_string<Char> &text,
+                 std::vector<TextStyleSpan> &spans) {
+  text.clear();
+  text.reserve(markup.length());
+  spans.clear();
+
+  uint32_t styleIndex = 0;
+  uint32_t spanStart = 0;
+
+  auto closeSpan = [&]() {
+    auto end = (uint32_t)text.length();
+    if (styleIndex != 0 && end > spanStart &&
+        palette[styleIndex].Properties != static_cast<TextStyleProperty>(0)) {
+      spans.push_back({spanStart, end - spanStart, palette[styleIndex].Properties, styleIndex});
+    }
+  };
+
+  size_t pos = 0;
+  while (pos < markup.length()) {
+    // Copy the text up to the next possible style switch in one go
+    auto next = markup.find((Char)'@', pos);
+    if (next == std::basic_string_view<Char>::npos) {
+      next = markup.length();
+    }
+    text.append(markup.data() + pos, next - pos);
+    pos = next;
+    if (pos >= markup.length()) {
+      break;
+    }
+
+    if (pos + 1 < markup.length() && markup[pos + 1] >= '0' && markup[pos + 1] <= '9') {
+      auto newIndex = (uint32_t)(markup[pos + 1] - '0');
+      if (newIndex >= paletteSize) {
+        newIndex = 0;
+      }
+      if (newIndex != styleIndex) {
+        closeSpan();
+        styleIndex = newIndex;
+        spanStart = (uint32_t)text.length();
+      }
+      pos += 2;
+    } else {
+      text.push_back((Char)'@');
+      pos++;
+    }
+  }
+
+  closeSpan();
+}
+
+template void ParseMarkup(std::wstring_view markup,
+                          const MarkupStyle *palette,
+                          uint32_t paletteSize,
+                          std::wstring &text,
+                          std::vector<TextStyleSpan> &spans);
+
+template void ParseMarkup(std::u16string_view markup,
+                          const MarkupStyle *palette,
+                          uint32_t paletteSize,
+                          std::u16string &text,
+                          std::vector<TextStyleSpan> &spans);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../rendering/drawing/Style.h"
+
+/**
+ * An entry of the style palette that markup refers to. Only the given properties of the style are
+ * applied to the marked up text.
+ */
+struct MarkupStyle {
+  TextStyleProperty Properties;
+  TextStyle Style;
+};
+
+/**
+ * Parses the inline style markup used by the game's text: "@" followed by a digit switches to
+ * the palette entry with that index for the following text, where entry 0 is the base style of
+ * the layout. Digits outside of the palette switch back to the base style. An "@" that is not
+ * followed by a digit is kept as text.
+ *
+ * The text without markup is written to text, and a span for every stretch of text using a
+ * palette entry other than 0 to spans, with the palette index as the style index.
+ *
+ * Implemented for wchar_t and char16_t.
+ */
+template <typename Char>
+void ParseMarkup(std::basic_string_view<Char> markup,
+                 const MarkupStyle *palette,
+                 uint32_t paletteSize,
+                 std::basic_string<Char> &text,
+                 std::vector<TextStyleSpan> &spans);
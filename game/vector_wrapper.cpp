@@ -1,5 +1,6 @@
 
 #include "utils.h"
+#include "interop/BufferPool.h"
 
 #include <cstdlib>
 #include <cstdint>
@@ -16,3 +17,35 @@ NATIVE_API uint32_t vector_get_size(std::vector<uint8_t> *vector) {
 NATIVE_API void *vector_get_data(std::vector<uint8_t> *vector) {
   return vector->data();
 }
+
+NATIVE_API PooledBuffer *buffer_acquire(size_t size) {
+  return BufferPool::Acquire(size);
+}
+
+NATIVE_API void buffer_resize(PooledBuffer *buffer, size_t size) {
+  BufferPool::Resize(buffer, size);
+}
+
+NATIVE_API void buffer_release(PooledBuffer *buffer) {
+  BufferPool::Release(buffer);
+}
+
+NATIVE_API size_t buffer_get_size(PooledBuffer *buffer) {
+  return buffer->size;
+}
+
+NATIVE_API size_t buffer_get_capacity(PooledBuffer *buffer) {
+  return buffer->capacity;
+}
+
+NATIVE_API void *buffer_get_data(PooledBuffer *buffer) {
+  return buffer->data;
+}
+
+NATIVE_API void buffer_pool_get_stats(BufferPoolStats *stats) {
+  *stats = BufferPool::GetStats();
+}
+
+NATIVE_API void buffer_pool_trim() {
+  BufferPool::Trim();
+}
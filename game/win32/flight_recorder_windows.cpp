@@ -0,0 +1,45 @@
+#include "windows_headers.h"
+#include <string>
+
+#include "../logging/FlightRecorder.h"
+
+static std::wstring crashDumpPath;
+static LPTOP_LEVEL_EXCEPTION_FILTER previousFilter = nullptr;
+
+static void WriteToHandle(void *context, const char *data, size_t length) {
+  DWORD written;
+  WriteFile(static_cast<HANDLE>(context), data, (DWORD)length, &written, nullptr);
+}
+
+static bool DumpToPath(const wchar_t *path) {
+  auto file = CreateFileW(path, GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                          FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  FlightRecorder::Dump(WriteToHandle, file);
+  CloseHandle(file);
+  return true;
+}
+
+static LONG WINAPI CrashFilter(EXCEPTION_POINTERS *exceptionInfo) {
+  DumpToPath(crashDumpPath.c_str());
+  if (previousFilter) {
+    return previousFilter(exceptionInfo);
+  }
+  return EXCEPTION_CONTINUE_SEARCH;
+}
+
+bool FlightRecorder::DumpToFile(std::wstring_view path) {
+  return DumpToPath(std::wstring(path).c_str());
+}
+
+bool FlightRecorder::InstallCrashHandler(std::wstring_view path) {
+  // The filter must not allocate, so the path is copied up front
+  auto installed = !crashDumpPath.empty();
+  crashDumpPath = path;
+  if (!installed) {
+    previousFilter = SetUnhandledExceptionFilter(CrashFilter);
+  }
+  return true;
+}
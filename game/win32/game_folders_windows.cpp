@@ -13,10 +13,10 @@ static winrt::com_ptr<IKnownFolderManager> GetFolderManager() noexcept {
   try {
     return winrt::create_instance<IKnownFolderManager>(CLSID_KnownFolderManager);
   } catch (winrt::hresult_error &e) {
-    Logger::Error(std::wstring(L"Failed to create IKnownFolderManager: ") + e.message());
+    Logger::Error(L"Failed to create IKnownFolderManager: {}", e.message());
     return nullptr;
   } catch (std::exception &e) {
-    Logger::Error(std::wstring(L"Failed to create IKnownFolderManager: ") + localToWide(e.what()));
+    Logger::Error(L"Failed to create IKnownFolderManager: {}", e.what());
     return nullptr;
   }
 }
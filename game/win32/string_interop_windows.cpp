@@ -0,0 +1,26 @@
+#include "windows_headers.h"
+#include <string>
+
+#include "../interop/string_interop.h"
+
+void *allocInteropMemory(size_t size) {
+  return CoTaskMemAlloc(size);
+}
+
+std::wstring localToWide(std::string_view view) {
+  std::wstring result;
+
+  auto wideLength = MultiByteToWideChar(CP_ACP, 0, view.data(), view.length(), nullptr, 0);
+  if (wideLength == 0) {
+    return result;
+  }
+
+  result.resize(wideLength);
+
+  if (!MultiByteToWideChar(CP_ACP, 0, view.data(), view.length(), &result[0], result.length())) {
+    result.resize(0);
+    return result;
+  }
+
+  return result;
+}
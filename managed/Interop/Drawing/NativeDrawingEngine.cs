@@ -8,6 +8,11 @@ namespace OpenTemple.Interop.Drawing;
 
 /// <summary>
 /// A text rendering engine.
+///
+/// Text layouts may be created, styled, measured and hit-tested on any thread, as long as each
+/// layout is only used by one thread at a time. All other methods, including rendering, must be
+/// called from the render thread, and fonts must not be added or reloaded while other threads
+/// create layouts.
 /// </summary>
 public partial class NativeDrawingEngine : IDisposable
 {
@@ -95,17 +100,34 @@ public partial class NativeDrawingEngine : IDisposable
     {
         get
         {
+            // All names are copied into one arena instead of allocating each one separately
+            using var arena = new NativeStringArena();
             var count = DrawingEngine_GetFontFamiliesCount(_native);
             var result = new List<string>(count);
             for (var i = 0; i < count; i++)
             {
-                result.Add(DrawingEngine_GetFontFamilyName(_native, i));
+                result.Add(GetFontFamilyName(i, arena));
             }
 
             return result;
         }
     }
 
+    /// <summary>
+    /// Gets the name of a font family without allocating native memory for each call.
+    /// </summary>
+    public unsafe string GetFontFamilyName(int index, NativeStringArena arena)
+    {
+        var name = DrawingEngine_GetFontFamilyNameInArena(_native, index, arena.Handle, out var length,
+            out var error);
+        if (name == null)
+        {
+            throw new InvalidOperationException("Failed to get font family name: " + error);
+        }
+
+        return NativeStringArena.ToManaged(name, length);
+    }
+
     public unsafe void AddFontFile(string filename, ReadOnlySpan<byte> data)
     {
         if (data.IsEmpty)
@@ -135,6 +157,19 @@ public partial class NativeDrawingEngine : IDisposable
         }
     }
 
+    /// <summary>
+    /// Renders into memory holding 32-bit BGRA pixels with premultiplied alpha, which must stay
+    /// valid (and pinned) until another render target is set. Only supported by the software
+    /// engine used on platforms other than Windows.
+    /// </summary>
+    public void SetMemoryRenderTarget(nint pixels, int width, int height, int stride)
+    {
+        if (!DrawingEngine_SetMemoryRenderTarget(_native, pixels, width, height, stride, out var error))
+        {
+            throw new InvalidOperationException("Failed to set render target: " + error);
+        }
+    }
+
     public unsafe NativeTextLayout CreateTextLayout(ref NativeParagraphStyle paragraphStyle,
         ref NativeTextStyle textStyle,
         ReadOnlySpan<char> text,
@@ -169,6 +204,107 @@ public partial class NativeDrawingEngine : IDisposable
         }
     }
 
+    /// <summary>
+    /// Creates a text layout and applies the given style runs to it, or returns a layout that
+    /// was created with the same parameters before. Cached layouts are shared, but changing one
+    /// does not affect the others.
+    /// </summary>
+    public unsafe NativeTextLayout CreateCachedTextLayout(ref NativeParagraphStyle paragraphStyle,
+        ref NativeTextStyle textStyle,
+        ReadOnlySpan<char> text,
+        float maxWidth,
+        float maxHeight,
+        NativeTextStyleRun[] runs)
+    {
+        if (text.IsEmpty)
+        {
+            text = EmptyText;
+        }
+
+        runs ??= Array.Empty<NativeTextStyleRun>();
+
+        fixed (char* textPtr = text)
+        {
+            if (!DrawingEngine_CreateCachedTextLayout(
+                    _native,
+                    ref paragraphStyle,
+                    ref textStyle,
+                    textPtr,
+                    text.Length,
+                    maxWidth,
+                    maxHeight,
+                    runs,
+                    runs.Length,
+                    out var textLayoutNative,
+                    out var error
+                ))
+            {
+                throw new InvalidOperationException("Failed to create TextLayout: " + error);
+            }
+
+            return new NativeTextLayout(textLayoutNative);
+        }
+    }
+
+    /// <summary>
+    /// Creates a text layout from text with inline style markup in a single call. "@" followed by
+    /// a digit switches to that entry of the palette, where entry 0 is the base text style.
+    /// </summary>
+    public unsafe NativeTextLayout CreateTextLayoutFromMarkup(ref NativeParagraphStyle paragraphStyle,
+        ref NativeTextStyle textStyle,
+        ReadOnlySpan<char> markup,
+        float maxWidth,
+        float maxHeight,
+        NativeMarkupStyle[] palette)
+    {
+        if (markup.IsEmpty)
+        {
+            markup = EmptyText;
+        }
+
+        palette ??= Array.Empty<NativeMarkupStyle>();
+
+        fixed (char* markupPtr = markup)
+        {
+            if (!DrawingEngine_CreateTextLayoutFromMarkup(
+                    _native,
+                    ref paragraphStyle,
+                    ref textStyle,
+                    markupPtr,
+                    markup.Length,
+                    maxWidth,
+                    maxHeight,
+                    palette,
+                    palette.Length,
+                    out var textLayoutNative,
+                    out var error
+                ))
+            {
+                throw new InvalidOperationException("Failed to create TextLayout: " + error);
+            }
+
+            return new NativeTextLayout(textLayoutNative);
+        }
+    }
+
+    /// <summary>
+    /// Changes the limits of the text layout cache, which empties it. A maximum of 0 entries
+    /// disables the cache.
+    /// </summary>
+    public void ConfigureTextLayoutCache(int maxEntries, long maxBytes)
+    {
+        DrawingEngine_ConfigureTextLayoutCache(_native, (uint) maxEntries, (ulong) maxBytes);
+    }
+
+    public NativeTextLayoutCacheStats TextLayoutCacheStats
+    {
+        get
+        {
+            DrawingEngine_GetTextLayoutCacheStats(_native, out var stats);
+            return stats;
+        }
+    }
+
     public void RenderTextLayout(NativeTextLayout layout, float x, float y, float opacity)
     {
         if (!DrawingEngine_RenderTextLayout(_native, layout.NativePointer, x, y, opacity, out var error))
@@ -251,6 +387,17 @@ public partial class NativeDrawingEngine : IDisposable
         out string error
     );
 
+    [LibraryImport(OpenTempleLib.Path)]
+    [return:MarshalAs(UnmanagedType.Bool)]
+    private static partial bool DrawingEngine_SetMemoryRenderTarget(nint drawingEngine,
+        nint pixels,
+        int width,
+        int height,
+        int stride,
+        [MarshalAs(UnmanagedType.LPWStr)]
+        out string error
+    );
+
     [DllImport(OpenTempleLib.Path)]
     private static extern void DrawingEngine_SetTransform(nint drawingEngine, ref Matrix3x2 matrix);
 
@@ -285,8 +432,14 @@ public partial class NativeDrawingEngine : IDisposable
     private static partial int DrawingEngine_GetFontFamiliesCount(nint drawingEngine);
 
     [LibraryImport(OpenTempleLib.Path)]
-    [return: MarshalAs(UnmanagedType.LPWStr)]
-    private static partial string DrawingEngine_GetFontFamilyName(nint drawingEngine, int index);
+    private static unsafe partial char* DrawingEngine_GetFontFamilyNameInArena(
+        nint drawingEngine,
+        int index,
+        nint arena,
+        out int length,
+        [MarshalAs(UnmanagedType.LPWStr)]
+        out string error
+    );
 
     [DllImport(OpenTempleLib.Path)]
     [return:MarshalAs(UnmanagedType.Bool)]
@@ -305,6 +458,55 @@ public partial class NativeDrawingEngine : IDisposable
         out string error
     );
 
+    [DllImport(OpenTempleLib.Path)]
+    [return:MarshalAs(UnmanagedType.Bool)]
+    private static extern unsafe bool DrawingEngine_CreateCachedTextLayout(
+        nint drawingEngine,
+        [In]
+        ref NativeParagraphStyle paragraphStyle,
+        [In]
+        ref NativeTextStyle textStyle,
+        char* text,
+        int textLength,
+        float maxWidth,
+        float maxHeight,
+        [In]
+        NativeTextStyleRun[] runs,
+        int runCount,
+        out nint textLayout,
+        [MarshalAs(UnmanagedType.LPWStr)]
+        out string error
+    );
+
+    [DllImport(OpenTempleLib.Path)]
+    [return:MarshalAs(UnmanagedType.Bool)]
+    private static extern unsafe bool DrawingEngine_CreateTextLayoutFromMarkup(
+        nint drawingEngine,
+        [In]
+        ref NativeParagraphStyle paragraphStyle,
+        [In]
+        ref NativeTextStyle textStyle,
+        char* markup,
+        int markupLength,
+        float maxWidth,
+        float maxHeight,
+        [In]
+        NativeMarkupStyle[] palette,
+        int paletteSize,
+        out nint textLayout,
+        [MarshalAs(UnmanagedType.LPWStr)]
+        out string error
+    );
+
+    [LibraryImport(OpenTempleLib.Path)]
+    private static partial void DrawingEngine_ConfigureTextLayoutCache(nint drawingEngine,
+        uint maxEntries, ulong maxBytes);
+
+    [LibraryImport(OpenTempleLib.Path)]
+    [SuppressGCTransition]
+    private static partial void DrawingEngine_GetTextLayoutCacheStats(nint drawingEngine,
+        out NativeTextLayoutCacheStats stats);
+
     [LibraryImport(OpenTempleLib.Path)]
     [return:MarshalAs(UnmanagedType.Bool)]
     private static partial bool DrawingEngine_RenderTextLayout(
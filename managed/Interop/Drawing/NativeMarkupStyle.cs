@@ -0,0 +1,14 @@
+using System.Runtime.InteropServices;
+
+namespace OpenTemple.Interop.Drawing;
+
+/// <summary>
+/// An entry of the style palette that inline markup ("@1" selects entry 1) refers to.
+/// Only the given properties of the style are applied.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct NativeMarkupStyle
+{
+    public NativeTextStyleProperty Properties;
+    public NativeTextStyle Style;
+}
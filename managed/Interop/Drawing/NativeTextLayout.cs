@@ -20,6 +20,22 @@ public partial class NativeTextLayout : IDisposable
         }
     }
 
+    /// <summary>
+    /// Applies multiple styles in one call. Each span refers to an entry of the style table, which
+    /// should contain every distinct style only once.
+    /// </summary>
+    public unsafe void SetStyles(ReadOnlySpan<NativeTextStyleSpan> spans, NativeTextStyle[] styles)
+    {
+        fixed (NativeTextStyleSpan* spansPtr = spans)
+        {
+            if (!TextLayout_SetStyles(NativePointer, spansPtr, (uint) spans.Length, styles,
+                    (uint) styles.Length, out var error))
+            {
+                throw new InvalidOperationException("Couldn't set text styles: " + error);
+            }
+        }
+    }
+
     public void GetMetrics(out NativeMetrics metrics)
     {
         TextLayout_GetMetrics(NativePointer, out metrics);
@@ -86,6 +102,16 @@ public partial class NativeTextLayout : IDisposable
         }
     }
 
+    /// <summary>
+    /// Draw this layout from a bitmap that is only rasterized again after the layout has changed.
+    /// Meant for text that rarely changes, since rasterizing is more expensive than drawing the
+    /// text once.
+    /// </summary>
+    public void SetBitmapCaching(bool enabled)
+    {
+        TextLayout_SetBitmapCaching(NativePointer, enabled);
+    }
+
     private void ReleaseUnmanagedResources()
     {
         if (NativePointer != nint.Zero)
@@ -123,6 +149,16 @@ public partial class NativeTextLayout : IDisposable
         [MarshalAs(UnmanagedType.LPWStr)] out string error
     );
 
+    [DllImport(OpenTempleLib.Path)]
+    [return:MarshalAs(UnmanagedType.Bool)]
+    private static extern unsafe bool TextLayout_SetStyles(nint textLayout,
+        NativeTextStyleSpan* spans,
+        uint spanCount,
+        [In] NativeTextStyle[] styles,
+        uint styleCount,
+        [MarshalAs(UnmanagedType.LPWStr)] out string error
+    );
+
     [LibraryImport(OpenTempleLib.Path)]
     [SuppressGCTransition]
     private static partial void TextLayout_GetMetrics(nint textLayout, out NativeMetrics metrics);
@@ -177,5 +213,12 @@ public partial class NativeTextLayout : IDisposable
         float maxHeight
     );
 
+    [LibraryImport(OpenTempleLib.Path)]
+    [SuppressGCTransition]
+    private static partial void TextLayout_SetBitmapCaching(
+        nint textLayout,
+        [MarshalAs(UnmanagedType.Bool)] bool enabled
+    );
+
     #endregion
 }
\ No newline at end of file
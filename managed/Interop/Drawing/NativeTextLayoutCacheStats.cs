@@ -0,0 +1,18 @@
+using System.Runtime.InteropServices;
+
+namespace OpenTemple.Interop.Drawing;
+
+[StructLayout(LayoutKind.Sequential)]
+public struct NativeTextLayoutCacheStats
+{
+    public ulong Hits;
+    public ulong Misses;
+    public ulong Evictions;
+    public uint Entries;
+    /// <summary>
+    /// Estimated memory used by the cached layouts.
+    /// </summary>
+    public ulong Bytes;
+
+    public double HitRate => Hits + Misses == 0 ? 0 : (double) Hits / (Hits + Misses);
+}
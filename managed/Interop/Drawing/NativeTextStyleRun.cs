@@ -0,0 +1,15 @@
+using System.Runtime.InteropServices;
+
+namespace OpenTemple.Interop.Drawing;
+
+/// <summary>
+/// Applies the given properties of a text style to a range of text in a layout.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct NativeTextStyleRun
+{
+    public uint Start;
+    public uint Length;
+    public NativeTextStyleProperty Properties;
+    public NativeTextStyle Style;
+}
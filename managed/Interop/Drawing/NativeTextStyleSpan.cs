@@ -0,0 +1,15 @@
+using System.Runtime.InteropServices;
+
+namespace OpenTemple.Interop.Drawing;
+
+/// <summary>
+/// Applies the given properties of an entry in a style table to a range of text in a layout.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct NativeTextStyleSpan
+{
+    public uint Start;
+    public uint Length;
+    public NativeTextStyleProperty Properties;
+    public uint StyleIndex;
+}
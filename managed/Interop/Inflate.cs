@@ -42,6 +42,24 @@ public static class Inflate
         }
     }
 
+    /// <summary>
+    /// Decompresses into a pooled native buffer, which the caller has to dispose.
+    /// </summary>
+    public static NativeBuffer Uncompress(ReadOnlySpan<byte> source, int uncompressedSize)
+    {
+        var buffer = new NativeBuffer(uncompressedSize);
+        try
+        {
+            Uncompress(source, buffer.AsSpan());
+            return buffer;
+        }
+        catch
+        {
+            buffer.Dispose();
+            throw;
+        }
+    }
+
     [DllImport(OpenTempleLib.Path)]
     private static extern unsafe int Inflate_Uncompress(byte* dest, nuint* destLen, [In] byte* src, nuint* srcLen);
 }
@@ -0,0 +1,104 @@
+using System;
+using System.Runtime.InteropServices;
+
+namespace OpenTemple.Interop;
+
+/// <summary>
+/// A JPEG encoded map tile and its position in the tile grid (column and row).
+/// </summary>
+public readonly record struct MapOverviewTile(ReadOnlyMemory<byte> Data, int X, int Y);
+
+/// <summary>
+/// Composes a scaled-down overview of a map from all its background tiles.
+/// </summary>
+public static class MapOverview
+{
+    /// <summary>
+    /// Decodes all tiles at scaleNum/scaleDenom of their original size (using the reduced DCT
+    /// scaling of libjpeg-turbo) directly into the given pixel buffer. Tiles are decoded in parallel.
+    /// </summary>
+    /// <param name="threadCount">Number of decoding threads to use. 0 uses all hardware threads.</param>
+    /// <returns>The number of tiles that were composed successfully.</returns>
+    public static unsafe int Compose(ReadOnlySpan<MapOverviewTile> tiles,
+        int tileWidth,
+        int tileHeight,
+        int scaleNum,
+        int scaleDenom,
+        Span<byte> pixelData,
+        int width,
+        int stride,
+        int height,
+        JpegPixelFormat pixelFormat,
+        int threadCount = 0)
+    {
+        if ((long) stride * height > pixelData.Length)
+        {
+            throw new ArgumentException("Pixel buffer is too small for the given dimensions.");
+        }
+
+        var nativeTiles = new NativeTile[tiles.Length];
+        var pins = new System.Buffers.MemoryHandle[tiles.Length];
+        try
+        {
+            for (var i = 0; i < tiles.Length; i++)
+            {
+                pins[i] = tiles[i].Data.Pin();
+                nativeTiles[i] = new NativeTile
+                {
+                    Data = (byte*) pins[i].Pointer,
+                    DataSize = (uint) tiles[i].Data.Length,
+                    X = tiles[i].X,
+                    Y = tiles[i].Y
+                };
+            }
+
+            int result;
+            fixed (NativeTile* tilesPtr = nativeTiles)
+            fixed (byte* pixelDataPtr = pixelData)
+            {
+                result = Map_ComposeOverview(tilesPtr, nativeTiles.Length, tileWidth, tileHeight,
+                    scaleNum, scaleDenom, pixelDataPtr, width, stride, height, pixelFormat, 0, threadCount);
+            }
+
+            if (result < 0)
+            {
+                throw new ArgumentException($"Unsupported scaling factor: {scaleNum}/{scaleDenom}");
+            }
+
+            return result;
+        }
+        finally
+        {
+            foreach (var pin in pins)
+            {
+                pin.Dispose();
+            }
+        }
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    private unsafe struct NativeTile
+    {
+        public byte* Data;
+        public uint DataSize;
+        public int X;
+        public int Y;
+    }
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern unsafe int Map_ComposeOverview(
+        NativeTile* tiles,
+        int tileCount,
+        int tileWidth,
+        int tileHeight,
+        int scaleNum,
+        int scaleDenom,
+        byte* outputData,
+        int outputWidth,
+        int outputStride,
+        int outputHeight,
+        JpegPixelFormat pixelFormat,
+        int flags,
+        int threadCount
+    );
+}
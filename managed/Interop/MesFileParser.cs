@@ -0,0 +1,101 @@
+using System;
+using System.Runtime.InteropServices;
+
+namespace OpenTemple.Interop;
+
+[StructLayout(LayoutKind.Sequential)]
+public readonly record struct MesFileEntry(int Id, int Offset, int Length);
+
+/// <summary>
+/// The contents of a message file: all texts in one string, and an index sorted by ID.
+/// </summary>
+public sealed class ParsedMesFile
+{
+    public ParsedMesFile(string text, MesFileEntry[] entries)
+    {
+        Text = text;
+        Entries = entries;
+    }
+
+    public string Text { get; }
+
+    public MesFileEntry[] Entries { get; }
+
+    public ReadOnlySpan<char> GetText(in MesFileEntry entry) => Text.AsSpan(entry.Offset, entry.Length);
+
+    /// <summary>
+    /// Binary search in the sorted index.
+    /// </summary>
+    public bool TryGetText(int id, out ReadOnlySpan<char> text)
+    {
+        int low = 0, high = Entries.Length - 1;
+        while (low <= high)
+        {
+            var mid = low + (high - low) / 2;
+            var entryId = Entries[mid].Id;
+            if (entryId == id)
+            {
+                text = GetText(Entries[mid]);
+                return true;
+            }
+
+            if (entryId < id)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid - 1;
+            }
+        }
+
+        text = default;
+        return false;
+    }
+}
+
+/// <summary>
+/// Parses legacy message files ({id}{text} entries encoded as Windows-1252) in native code.
+/// </summary>
+public static class MesFileParser
+{
+    public static unsafe ParsedMesFile Parse(ReadOnlySpan<byte> data)
+    {
+        nint file;
+        fixed (byte* dataPtr = data)
+        {
+            file = MesFile_Parse(dataPtr, data.Length, out var error);
+            if (file == nint.Zero)
+            {
+                throw new InvalidOperationException("Failed to parse message file: " + error);
+            }
+        }
+
+        try
+        {
+            MesFile_GetText(file, out var text, out var textLength);
+            MesFile_GetEntries(file, out var entries, out var entryCount);
+            return new ParsedMesFile(
+                new string(text, 0, textLength),
+                new ReadOnlySpan<MesFileEntry>(entries, entryCount).ToArray()
+            );
+        }
+        finally
+        {
+            MesFile_Free(file);
+        }
+    }
+
+    [DllImport(OpenTempleLib.Path, CharSet = CharSet.Unicode)]
+    private static extern unsafe nint MesFile_Parse(byte* data, int length, out string error);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern unsafe void MesFile_GetText(nint file, out char* text, out int textLength);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern unsafe void MesFile_GetEntries(nint file, out MesFileEntry* entries,
+        out int entryCount);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern void MesFile_Free(nint file);
+}
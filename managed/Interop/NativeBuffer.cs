@@ -0,0 +1,116 @@
+using System;
+using System.Runtime.InteropServices;
+
+namespace OpenTemple.Interop;
+
+[StructLayout(LayoutKind.Sequential)]
+public struct NativeBufferPoolStats
+{
+    public ulong Acquired;
+    public ulong Reused;
+    public ulong Released;
+    public ulong BytesInUse;
+    public ulong PeakBytesInUse;
+    public ulong BytesPooled;
+}
+
+/// <summary>
+/// A 64-byte aligned block of native memory taken from a process-wide pool. Disposing the buffer
+/// gives it back to the pool, so that decoders can reuse it for the next chunk of output instead
+/// of allocating new memory. Spans of the buffer must not be used after it was disposed or resized.
+/// </summary>
+public sealed class NativeBuffer : IDisposable
+{
+    private nint _handle;
+
+    public NativeBuffer(int size)
+    {
+        if (size < 0)
+        {
+            throw new ArgumentOutOfRangeException(nameof(size));
+        }
+
+        _handle = buffer_acquire((nuint) size);
+    }
+
+    public int Length => (int) buffer_get_size(Handle);
+
+    public int Capacity => (int) buffer_get_capacity(Handle);
+
+    private nint Handle => _handle != nint.Zero
+        ? _handle
+        : throw new ObjectDisposedException(nameof(NativeBuffer));
+
+    public unsafe Span<byte> AsSpan() => new((void*) buffer_get_data(Handle), Length);
+
+    /// <summary>
+    /// Changes the length of the buffer while keeping its contents.
+    /// </summary>
+    public void Resize(int size)
+    {
+        if (size < 0)
+        {
+            throw new ArgumentOutOfRangeException(nameof(size));
+        }
+
+        buffer_resize(Handle, (nuint) size);
+    }
+
+    public static NativeBufferPoolStats GetPoolStats()
+    {
+        buffer_pool_get_stats(out var stats);
+        return stats;
+    }
+
+    /// <summary>
+    /// Frees the memory of all buffers that are waiting in the pool.
+    /// </summary>
+    public static void TrimPool()
+    {
+        buffer_pool_trim();
+    }
+
+    private void ReleaseUnmanagedResources()
+    {
+        if (_handle != nint.Zero)
+        {
+            buffer_release(_handle);
+            _handle = nint.Zero;
+        }
+    }
+
+    public void Dispose()
+    {
+        ReleaseUnmanagedResources();
+        GC.SuppressFinalize(this);
+    }
+
+    ~NativeBuffer()
+    {
+        ReleaseUnmanagedResources();
+    }
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern nint buffer_acquire(nuint size);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern void buffer_resize(nint buffer, nuint size);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern void buffer_release(nint buffer);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern nuint buffer_get_size(nint buffer);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern nuint buffer_get_capacity(nint buffer);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern nint buffer_get_data(nint buffer);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern void buffer_pool_get_stats(out NativeBufferPoolStats stats);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern void buffer_pool_trim();
+}
@@ -0,0 +1,49 @@
+using System;
+using System.Runtime.InteropServices;
+
+namespace OpenTemple.Interop;
+
+/// <summary>
+/// Native code keeps its most recent log messages and trace markers per thread, independent of
+/// the log sink and with little overhead. These can be written to a file after a native crash.
+/// </summary>
+public static class NativeFlightRecorder
+{
+    /// <summary>
+    /// Records a trace marker for the calling thread.
+    /// </summary>
+    public static unsafe void Mark(ReadOnlySpan<char> name)
+    {
+        fixed (char* namePtr = name)
+        {
+            FlightRecorder_Mark(namePtr, name.Length);
+        }
+    }
+
+    /// <summary>
+    /// Writes the recorded events of all threads to the given file.
+    /// </summary>
+    public static bool DumpToFile(string path)
+    {
+        return FlightRecorder_DumpToFile(path);
+    }
+
+    /// <summary>
+    /// Writes the recorded events to the given file if the process crashes.
+    /// </summary>
+    public static bool InstallCrashHandler(string path)
+    {
+        return FlightRecorder_InstallCrashHandler(path);
+    }
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern unsafe void FlightRecorder_Mark(char* name, int nameLength);
+
+    [DllImport(OpenTempleLib.Path, CharSet = CharSet.Unicode)]
+    [return: MarshalAs(UnmanagedType.Bool)]
+    private static extern bool FlightRecorder_DumpToFile(string path);
+
+    [DllImport(OpenTempleLib.Path, CharSet = CharSet.Unicode)]
+    [return: MarshalAs(UnmanagedType.Bool)]
+    private static extern bool FlightRecorder_InstallCrashHandler(string path);
+}
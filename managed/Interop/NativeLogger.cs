@@ -15,6 +15,7 @@ public delegate void NativeLogCallback(NativeLogLevel level, ReadOnlySpan<char>
 
 /// <summary>
 /// Controls how native code can log messages.
+/// Native messages are queued and delivered to the sink from a background thread.
 /// </summary>
 public static class NativeLogger
 {
@@ -40,6 +41,50 @@ public static class NativeLogger
         get => _sink;
     }
 
+    /// <summary>
+    /// Returns whether native code logs messages of the given level.
+    /// </summary>
+    public static bool IsLevelEnabled(NativeLogLevel level)
+    {
+        return (Logger_GetEnabledLevels() & (1u << (int) level)) != 0;
+    }
+
+    /// <summary>
+    /// Enables or disables a native log level. Native code skips formatting messages for
+    /// disabled levels entirely, so this is the cheapest way to silence debug logging.
+    /// </summary>
+    public static void SetLevelEnabled(NativeLogLevel level, bool enabled)
+    {
+        Logger_SetLevelEnabled(level, enabled);
+    }
+
+    /// <summary>
+    /// Delivers all native messages that are still queued to the sink before returning.
+    /// Call this before shutting down or when handling a crash.
+    /// </summary>
+    public static void Flush()
+    {
+        Logger_Flush();
+    }
+
+    /// <summary>
+    /// Starts writing native messages that use the binary log format to the given file instead of
+    /// formatting them. Use the log decoder tool to turn the file into text.
+    /// </summary>
+    /// <returns>False if the file could not be created.</returns>
+    public static bool StartBinaryCapture(string path)
+    {
+        return Logger_StartBinaryCapture(path);
+    }
+
+    /// <summary>
+    /// Writes all pending binary log records and closes the capture file.
+    /// </summary>
+    public static void StopBinaryCapture()
+    {
+        Logger_StopBinaryCapture();
+    }
+
     [UnmanagedCallersOnly]
     private static unsafe void SinkCallback(NativeLogLevel level, char* text, int textLength)
     {
@@ -56,4 +101,23 @@ public static class NativeLogger
 
     [DllImport(OpenTempleLib.Path)]
     private static extern void Logger_ClearSink();
-}
\ No newline at end of file
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern void Logger_Flush();
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern uint Logger_GetEnabledLevels();
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern void Logger_SetLevelEnabled(
+        NativeLogLevel level,
+        [MarshalAs(UnmanagedType.Bool)] bool enabled
+    );
+
+    [DllImport(OpenTempleLib.Path, CharSet = CharSet.Unicode)]
+    [return: MarshalAs(UnmanagedType.Bool)]
+    private static extern bool Logger_StartBinaryCapture(string path);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern void Logger_StopBinaryCapture();
+}
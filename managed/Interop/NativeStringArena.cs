@@ -0,0 +1,68 @@
+using System;
+using System.Runtime.InteropServices;
+
+namespace OpenTemple.Interop;
+
+/// <summary>
+/// Native memory that strings returned from native code are copied into, instead of allocating
+/// and freeing each string separately. All strings returned into the arena are invalidated at once
+/// by <see cref="Reset"/>, i.e. once per frame, or when the arena is disposed.
+/// Not thread-safe.
+/// </summary>
+public sealed class NativeStringArena : IDisposable
+{
+    internal nint Handle { get; private set; } = StringArena_Create();
+
+    /// <summary>
+    /// Number of bytes used by strings since the last reset.
+    /// </summary>
+    public long BytesUsed => (long) StringArena_GetBytesUsed(Handle);
+
+    /// <summary>
+    /// Invalidates all strings that were returned into this arena.
+    /// </summary>
+    public void Reset()
+    {
+        StringArena_Reset(Handle);
+    }
+
+    /// <summary>
+    /// Copies a string that native code returned into the arena to the managed heap.
+    /// </summary>
+    internal static unsafe string ToManaged(char* text, int length)
+    {
+        return text == null ? null : new string(text, 0, length);
+    }
+
+    private void ReleaseUnmanagedResources()
+    {
+        if (Handle != nint.Zero)
+        {
+            StringArena_Free(Handle);
+            Handle = nint.Zero;
+        }
+    }
+
+    public void Dispose()
+    {
+        ReleaseUnmanagedResources();
+        GC.SuppressFinalize(this);
+    }
+
+    ~NativeStringArena()
+    {
+        ReleaseUnmanagedResources();
+    }
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern nint StringArena_Create();
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern void StringArena_Reset(nint arena);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern nuint StringArena_GetBytesUsed(nint arena);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern void StringArena_Free(nint arena);
+}
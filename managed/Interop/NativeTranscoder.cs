@@ -0,0 +1,124 @@
+using System;
+using System.Runtime.InteropServices;
+
+namespace OpenTemple.Interop;
+
+public enum NativeTextEncoding
+{
+    Utf8 = 0,
+    Utf16 = 1,
+    Windows1252 = 2
+}
+
+/// <summary>
+/// Vectorized text conversion between UTF-8, UTF-16 and Windows-1252 (the encoding of the game's
+/// legacy text data). Invalid input is replaced with U+FFFD, and characters that Windows-1252
+/// can not represent with '?'.
+/// </summary>
+public static class NativeTranscoder
+{
+    /// <summary>
+    /// Decodes 8-bit text into a string.
+    /// </summary>
+    public static unsafe string Decode(ReadOnlySpan<byte> text, NativeTextEncoding encoding)
+    {
+        var buffer = new char[GetMaxLength(encoding, NativeTextEncoding.Utf16, text.Length)];
+        fixed (byte* textPtr = text)
+        fixed (char* bufferPtr = buffer)
+        {
+            var length = Transcode_Convert(encoding, NativeTextEncoding.Utf16, textPtr, text.Length,
+                bufferPtr, buffer.Length);
+            return new string(bufferPtr, 0, length);
+        }
+    }
+
+    /// <summary>
+    /// Encodes a string as 8-bit text.
+    /// </summary>
+    public static unsafe byte[] Encode(ReadOnlySpan<char> text, NativeTextEncoding encoding)
+    {
+        var buffer = new byte[GetMaxLength(NativeTextEncoding.Utf16, encoding, text.Length)];
+        fixed (char* textPtr = text)
+        fixed (byte* bufferPtr = buffer)
+        {
+            var length = Transcode_Convert(NativeTextEncoding.Utf16, encoding, textPtr, text.Length,
+                bufferPtr, buffer.Length);
+            return buffer.AsSpan(0, length).ToArray();
+        }
+    }
+
+    /// <summary>
+    /// Decodes a whole table of 8-bit strings in one native call.
+    /// </summary>
+    /// <param name="data">The strings, back-to-back.</param>
+    /// <param name="offsets">Start offset of every string in data, followed by the end offset of
+    /// the last string. Must be ascending and within data.</param>
+    public static unsafe string[] DecodeTable(ReadOnlySpan<byte> data, ReadOnlySpan<int> offsets,
+        NativeTextEncoding encoding)
+    {
+        var count = offsets.Length - 1;
+        if (count <= 0)
+        {
+            return Array.Empty<string>();
+        }
+
+        // The native side can not check the end of data, so the offsets are checked here
+        if (offsets[0] < 0 || offsets[count] > data.Length)
+        {
+            throw new ArgumentOutOfRangeException(nameof(offsets), "String offsets must lie within data");
+        }
+
+        for (var i = 0; i < count; i++)
+        {
+            if (offsets[i + 1] < offsets[i])
+            {
+                throw new ArgumentException("String offsets must be in ascending order", nameof(offsets));
+            }
+        }
+
+        var totalLength = offsets[count] - offsets[0];
+        var buffer = new char[GetMaxLength(encoding, NativeTextEncoding.Utf16, totalLength)];
+        var outputOffsets = new int[count + 1];
+        fixed (byte* dataPtr = data)
+        fixed (int* offsetsPtr = offsets)
+        fixed (char* bufferPtr = buffer)
+        fixed (int* outputOffsetsPtr = outputOffsets)
+        {
+            if (Transcode_ConvertBatch(encoding, NativeTextEncoding.Utf16, dataPtr, offsetsPtr, count,
+                    bufferPtr, buffer.Length, outputOffsetsPtr) < 0)
+            {
+                throw new InvalidOperationException("Failed to decode string table");
+            }
+
+            var result = new string[count];
+            for (var i = 0; i < count; i++)
+            {
+                result[i] = new string(bufferPtr, outputOffsets[i], outputOffsets[i + 1] - outputOffsets[i]);
+            }
+
+            return result;
+        }
+    }
+
+    private static int GetMaxLength(NativeTextEncoding from, NativeTextEncoding to, int length)
+    {
+        var maxLength = Transcode_GetMaxLength(from, to, length);
+        if (maxLength < 0)
+        {
+            throw new ArgumentException($"Text of length {length} is too long to be transcoded");
+        }
+        return maxLength;
+    }
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern int Transcode_GetMaxLength(NativeTextEncoding from, NativeTextEncoding to,
+        int length);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern unsafe int Transcode_Convert(NativeTextEncoding from, NativeTextEncoding to,
+        void* input, int length, void* output, int outputCapacity);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern unsafe int Transcode_ConvertBatch(NativeTextEncoding from, NativeTextEncoding to,
+        void* input, int* inputOffsets, int count, void* output, int outputCapacity, int* outputOffsets);
+}
@@ -4,22 +4,188 @@ using SoLoud;
 
 namespace OpenTemple.Interop;
 
+/// <summary>
+/// Snapshot of the playback position and buffer level of a <see cref="SoLoudDynamicSource"/>.
+/// Timestamps are in nanoseconds of <see cref="SoLoudDynamicSource.ClockNanos"/>.
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct SoLoudDynamicSourceStats
+{
+    public ulong SamplesConsumed;
+    public uint QueuedSamples;
+    public uint HighWaterMark;
+    public uint UnderrunCount;
+    public long LastUnderrunTime;
+    public ulong DroppedSamples;
+}
+
+/// <summary>
+/// Controls what happens when samples are pushed into a <see cref="SoLoudDynamicSource"/> that is full.
+/// </summary>
+public enum SoLoudOverflowPolicy
+{
+    /// <summary>
+    /// The pushing thread waits until enough samples have been played. The push returns false
+    /// if the source is flushed, seeked or disposed while it waits.
+    /// </summary>
+    Block = 0,
+
+    /// <summary>
+    /// The oldest queued samples are dropped to make room. Pushes never wait.
+    /// </summary>
+    DropOldest,
+
+    /// <summary>
+    /// The push is rejected entirely and returns false.
+    /// </summary>
+    Reject
+}
+
 public unsafe class SoLoudDynamicSource : SoloudObject, IDisposable
 {
+    /// <summary>
+    /// The maximum number of channels supported by the native source (7.1).
+    /// </summary>
+    public const int MaxChannels = 8;
+
+    public int ChannelCount { get; }
+
+    public int SampleRate { get; }
+
     public SoLoudDynamicSource(int channelCount, int sampleRate)
     {
         objhandle = SoLoudDynamicSource_Create(channelCount, sampleRate);
+        if (objhandle == IntPtr.Zero)
+        {
+            throw new ArgumentOutOfRangeException(nameof(channelCount),
+                $"Channel count must be between 1 and {MaxChannels}");
+        }
+        ChannelCount = channelCount;
+        SampleRate = sampleRate;
+    }
+
+    /// <param name="capacity">The maximum amount of audio that can be queued.</param>
+    /// <param name="overflowPolicy">What happens when samples are pushed while the queue is full.</param>
+    public SoLoudDynamicSource(int channelCount, int sampleRate, TimeSpan capacity,
+        SoLoudOverflowPolicy overflowPolicy)
+    {
+        if (capacity <= TimeSpan.Zero)
+        {
+            throw new ArgumentOutOfRangeException(nameof(capacity), "Capacity must be positive");
+        }
+
+        objhandle = SoLoudDynamicSource_CreateWithCapacity(channelCount, sampleRate,
+            (int) Math.Ceiling(capacity.TotalMilliseconds), overflowPolicy);
+        if (objhandle == IntPtr.Zero)
+        {
+            throw new ArgumentOutOfRangeException(nameof(channelCount),
+                $"Channel count must be between 1 and {MaxChannels}");
+        }
+        ChannelCount = channelCount;
+        SampleRate = sampleRate;
     }
 
-    public void PushSamples(ReadOnlySpan<float> channel1, ReadOnlySpan<float> channel2)
+    public SoLoudOverflowPolicy OverflowPolicy
     {
+        set => SoLoudDynamicSource_SetOverflowPolicy(objhandle, value);
+    }
+
+    /// <summary>
+    /// Number of samples per channel (at the input sample rate) that can be pushed without
+    /// triggering the overflow policy.
+    /// </summary>
+    public int WritableSamples => (int) SoLoudDynamicSource_GetWritableSamples(objhandle);
+
+    /// <summary>
+    /// Number of samples per channel that have been played so far. Does not lock and can be
+    /// called from any thread.
+    /// </summary>
+    public ulong SamplesConsumed => SoLoudDynamicSource_GetSamplesConsumed(objhandle);
+
+    /// <summary>
+    /// The playback position derived from <see cref="SamplesConsumed"/>.
+    /// </summary>
+    public TimeSpan PlaybackPosition => TimeSpan.FromSeconds((double) SamplesConsumed / SampleRate);
+
+    public SoLoudDynamicSourceStats GetStats()
+    {
+        SoLoudDynamicSource_GetStats(objhandle, out var stats);
+        return stats;
+    }
+
+    /// <summary>
+    /// Returns the timestamps of the most recent underruns, newest first.
+    /// </summary>
+    public long[] GetUnderrunTimes()
+    {
+        var times = stackalloc long[16];
+        var count = SoLoudDynamicSource_GetUnderrunTimes(objhandle, times, 16);
+        return new Span<long>(times, count).ToArray();
+    }
+
+    /// <summary>
+    /// Current time of the monotonic clock used for the timestamps in <see cref="SoLoudDynamicSourceStats"/>.
+    /// </summary>
+    public static long ClockNanos => SoLoudDynamicSource_GetClock();
+
+    /// <summary>
+    /// Drops all queued samples without touching the playback clock. Must be called from the
+    /// thread that pushes samples.
+    /// </summary>
+    public void Flush()
+    {
+        SoLoudDynamicSource_Flush(objhandle);
+    }
+
+    /// <summary>
+    /// Drops all queued samples and moves the playback clock to the given position.
+    /// Samples pushed afterwards are assumed to start at that position.
+    /// Must be called from the thread that pushes samples.
+    /// </summary>
+    public void Seek(TimeSpan position)
+    {
+        SoLoudDynamicSource_Seek(objhandle, position.TotalSeconds);
+    }
+
+    /// <summary>
+    /// Pushes interleaved samples (one sample per channel per frame). The samples are deinterleaved natively.
+    /// </summary>
+    public bool PushInterleavedSamples(ReadOnlySpan<float> samples)
+    {
+        if (samples.Length % ChannelCount != 0)
+        {
+            throw new ArgumentException($"Sample count must be a multiple of the channel count {ChannelCount}");
+        }
+
+        if (samples.IsEmpty)
+        {
+            return true;
+        }
+
+        var planes = stackalloc float*[1];
+        fixed (float* samplesData = samples)
+        {
+            planes[0] = samplesData;
+            return SoLoudDynamicSource_PushSamples(objhandle, planes, samples.Length / ChannelCount, true);
+        }
+    }
+
+    /// <summary>
+    /// Pushes the samples of a mono source, or of a stereo source with one plane per channel.
+    /// </summary>
+    public bool PushSamples(ReadOnlySpan<float> channel1, ReadOnlySpan<float> channel2)
+    {
+        if (channel1.IsEmpty && !channel2.IsEmpty)
+        {
+            throw new ArgumentException("If channel1 is not provided, channel2 must not be provided either");
+        }
+
+        var planeCount = channel2.IsEmpty ? 1 : 2;
+        CheckPlaneCount(planeCount);
+
         if (channel1.IsEmpty)
         {
-            if (!channel2.IsEmpty)
-            {
-                throw new ArgumentException("If channel1 is not provided, channel2 must not be provided either");
-            }
-            return; // No samples
+            return true; // No samples
         }
 
         if (!channel2.IsEmpty && channel1.Length != channel2.Length)
@@ -29,34 +195,190 @@ public unsafe class SoLoudDynamicSource : SoloudObject, IDisposable
 
         var planes = stackalloc float*[2];
         fixed (float* channel1Data = channel1)
+        fixed (float* channel2Data = channel2)
         {
             planes[0] = channel1Data;
-            if (channel2.IsEmpty)
+            planes[1] = channel2Data;
+            return SoLoudDynamicSource_PushSamples(objhandle, planes, channel1.Length, false);
+        }
+    }
+
+    /// <summary>
+    /// Pushes one plane of samples per channel, for sources with any number of channels.
+    /// All planes must have the same number of samples.
+    /// </summary>
+    public bool PushSamples(params ReadOnlyMemory<float>[] channels)
+    {
+        CheckPlaneCount(channels.Length);
+
+        var sampleCount = channels[0].Length;
+        foreach (var channel in channels)
+        {
+            if (channel.Length != sampleCount)
+            {
+                throw new ArgumentException("All channels must have the same number of samples.");
+            }
+        }
+
+        if (sampleCount == 0)
+        {
+            return true;
+        }
+
+        var planes = stackalloc float*[channels.Length];
+        var pins = new System.Buffers.MemoryHandle[channels.Length];
+        try
+        {
+            for (var i = 0; i < channels.Length; i++)
             {
-                planes[1] = null;
-                SoLoudDynamicSource_PushSamples(objhandle, planes, channel1.Length, false);
+                pins[i] = channels[i].Pin();
+                planes[i] = (float*) pins[i].Pointer;
             }
-            else
+
+            return SoLoudDynamicSource_PushSamples(objhandle, planes, sampleCount, false);
+        }
+        finally
+        {
+            foreach (var pin in pins)
             {
-                fixed (float* channel2Data = channel2)
-                {
-                    planes[1] = channel2Data;
-                    SoLoudDynamicSource_PushSamples(objhandle, planes, channel1.Length, false);
-                }
+                pin.Dispose();
             }
         }
     }
 
+    // The native source reads one plane per channel, so any other number of planes would make it
+    // read past the given ones
+    private void CheckPlaneCount(int planeCount)
+    {
+        if (planeCount != ChannelCount)
+        {
+            throw new ArgumentException(
+                $"Expected one plane per channel ({ChannelCount}), but got {planeCount}");
+        }
+    }
+
+    /// <summary>
+    /// Pushes interleaved signed 16-bit samples, which are converted to float natively.
+    /// </summary>
+    public bool PushInterleavedSamples(ReadOnlySpan<short> samples)
+    {
+        if (samples.Length % ChannelCount != 0)
+        {
+            throw new ArgumentException($"Sample count must be a multiple of the channel count {ChannelCount}");
+        }
+
+        if (samples.IsEmpty)
+        {
+            return true;
+        }
+
+        var planes = stackalloc short*[1];
+        fixed (short* samplesData = samples)
+        {
+            planes[0] = samplesData;
+            return SoLoudDynamicSource_PushSamplesS16(objhandle, planes, samples.Length / ChannelCount, true);
+        }
+    }
+
+    /// <summary>
+    /// Pushes interleaved signed 32-bit samples, which are converted to float natively.
+    /// </summary>
+    public bool PushInterleavedSamples(ReadOnlySpan<int> samples)
+    {
+        if (samples.Length % ChannelCount != 0)
+        {
+            throw new ArgumentException($"Sample count must be a multiple of the channel count {ChannelCount}");
+        }
+
+        if (samples.IsEmpty)
+        {
+            return true;
+        }
+
+        var planes = stackalloc int*[1];
+        fixed (int* samplesData = samples)
+        {
+            planes[0] = samplesData;
+            return SoLoudDynamicSource_PushSamplesS32(objhandle, planes, samples.Length / ChannelCount, true);
+        }
+    }
+
+    /// <summary>
+    /// Sets the sample rate of the samples that will be pushed. If it differs from the sample rate
+    /// this source was created with, the samples are resampled natively.
+    /// Must be called from the same thread that pushes samples.
+    /// </summary>
+    public void SetInputSampleRate(int sampleRate)
+    {
+        if (!SoLoudDynamicSource_SetInputSampleRate(objhandle, sampleRate))
+        {
+            throw new ArgumentException($"Unsupported input sample rate: {sampleRate}");
+        }
+    }
+
     [DllImport(OpenTempleLib.Path)]
     private static extern IntPtr SoLoudDynamicSource_Create(int channelCount, int sampleRate);
 
     [DllImport(OpenTempleLib.Path)]
-    private static extern void SoLoudDynamicSource_PushSamples(IntPtr source,
+    [return: MarshalAs(UnmanagedType.Bool)]
+    private static extern bool SoLoudDynamicSource_PushSamples(IntPtr source,
         float** planes,
         int sampleCount,
         [MarshalAs(UnmanagedType.Bool)]
         bool interleaved);
 
+    [DllImport(OpenTempleLib.Path)]
+    [return: MarshalAs(UnmanagedType.Bool)]
+    private static extern bool SoLoudDynamicSource_PushSamplesS16(IntPtr source,
+        short** planes,
+        int sampleCount,
+        [MarshalAs(UnmanagedType.Bool)]
+        bool interleaved);
+
+    [DllImport(OpenTempleLib.Path)]
+    [return: MarshalAs(UnmanagedType.Bool)]
+    private static extern bool SoLoudDynamicSource_PushSamplesS32(IntPtr source,
+        int** planes,
+        int sampleCount,
+        [MarshalAs(UnmanagedType.Bool)]
+        bool interleaved);
+
+    [DllImport(OpenTempleLib.Path)]
+    [return: MarshalAs(UnmanagedType.Bool)]
+    private static extern bool SoLoudDynamicSource_SetInputSampleRate(IntPtr source, int sampleRate);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern IntPtr SoLoudDynamicSource_CreateWithCapacity(int channelCount, int sampleRate,
+        int capacityMs, SoLoudOverflowPolicy overflowPolicy);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern void SoLoudDynamicSource_Flush(IntPtr source);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern void SoLoudDynamicSource_Seek(IntPtr source, double seconds);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern void SoLoudDynamicSource_SetOverflowPolicy(IntPtr source, SoLoudOverflowPolicy policy);
+
+    [DllImport(OpenTempleLib.Path)]
+    [SuppressGCTransition]
+    private static extern uint SoLoudDynamicSource_GetWritableSamples(IntPtr source);
+
+    [DllImport(OpenTempleLib.Path)]
+    [SuppressGCTransition]
+    private static extern ulong SoLoudDynamicSource_GetSamplesConsumed(IntPtr source);
+
+    [DllImport(OpenTempleLib.Path)]
+    [SuppressGCTransition]
+    private static extern void SoLoudDynamicSource_GetStats(IntPtr source, out SoLoudDynamicSourceStats stats);
+
+    [DllImport(OpenTempleLib.Path)]
+    private static extern int SoLoudDynamicSource_GetUnderrunTimes(IntPtr source, long* times, int count);
+
+    [DllImport(OpenTempleLib.Path)]
+    [SuppressGCTransition]
+    private static extern long SoLoudDynamicSource_GetClock();
+
     [DllImport(OpenTempleLib.Path)]
     private static extern void SoLoudDynamicSource_Free(IntPtr source);
 
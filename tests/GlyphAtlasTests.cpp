@@ -0,0 +1,190 @@
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "../game/text/GlyphAtlas.h"
+#include "TestHarness.h"
+
+static GlyphKey Glyph(uint32_t glyphIndex) {
+  return GlyphAtlas::MakeKey(0, glyphIndex, 12, 0);
+}
+
+static bool Overlaps(const GlyphAtlasEntry &a, const GlyphAtlasEntry &b) {
+  // Includes the padding to the right and below, which must not be shared either
+  auto pad = GlyphAtlas::Padding;
+  return a.page == b.page && a.x < b.x + b.width + pad && b.x < a.x + a.width + pad &&
+         a.y < b.y + b.height + pad && b.y < a.y + a.height + pad;
+}
+
+TEST(GlyphAtlas_PacksGlyphsOnShelves) {
+  GlyphAtlas atlas(64, 1);
+
+  // 15x15 glyphs take 16x16 with padding, so four fit on a shelf
+  for (uint32_t i = 0; i < 5; i++) {
+    auto entry = atlas.Insert(Glyph(i), 15, 15, 1, -15);
+    REQUIRE(entry);
+    CHECK(entry->page == 0);
+    CHECK(entry->x == (i % 4) * 16);
+    CHECK(entry->y == (i / 4) * 16);
+    CHECK(entry->width == 15);
+    CHECK(entry->height == 15);
+    CHECK(entry->offsetX == 1);
+    CHECK(entry->offsetY == -15);
+  }
+  CHECK(atlas.Stats().glyphs == 5);
+  CHECK(atlas.Stats().pages == 1);
+}
+
+TEST(GlyphAtlas_PutsShortGlyphsOnTheirOwnShelf) {
+  GlyphAtlas atlas(64, 1);
+  auto tall = *atlas.Insert(Glyph(0), 10, 31, 0, 0);
+  auto small = *atlas.Insert(Glyph(1), 10, 7, 0, 0);
+  auto medium = *atlas.Insert(Glyph(2), 10, 27, 0, 0);
+
+  // The small glyph would waste most of the tall shelf, the medium one fits well enough
+  CHECK(small.y != tall.y);
+  CHECK(medium.y == tall.y);
+  CHECK(medium.x == tall.x + 11);
+}
+
+TEST(GlyphAtlas_FindReturnsInsertedEntry) {
+  GlyphAtlas atlas(64, 1);
+  CHECK(!atlas.Find(Glyph(1)));
+  auto inserted = *atlas.Insert(Glyph(1), 8, 10, 0, -10);
+
+  auto found = atlas.Find(Glyph(1));
+  REQUIRE(found);
+  CHECK(found->x == inserted.x && found->y == inserted.y);
+  CHECK(!atlas.Find(Glyph(2)));
+
+  // Inserting a glyph again returns the existing entry
+  auto again = atlas.Insert(Glyph(1), 8, 10, 0, -10);
+  CHECK(again && again->x == inserted.x && again->y == inserted.y);
+  CHECK(atlas.Stats().glyphs == 1);
+
+  auto stats = atlas.Stats();
+  CHECK(stats.hits == 1);
+  CHECK(stats.misses == 2);
+}
+
+TEST(GlyphAtlas_RejectsGlyphsLargerThanAPage) {
+  GlyphAtlas atlas(64, 2);
+  CHECK(!atlas.Insert(Glyph(1), 64, 8, 0, 0));
+  CHECK(!atlas.Insert(Glyph(2), 8, 64, 0, 0));
+  CHECK(atlas.Insert(Glyph(3), 63, 63, 0, 0));
+  CHECK(atlas.Stats().glyphs == 1);
+}
+
+TEST(GlyphAtlas_EvictsLeastRecentlyUsedPage) {
+  // Every glyph fills a whole page
+  GlyphAtlas atlas(16, 2);
+  REQUIRE(atlas.Insert(Glyph(1), 15, 15, 0, 0));
+  REQUIRE(atlas.Insert(Glyph(2), 15, 15, 0, 0));
+  auto secondPage = atlas.Find(Glyph(2))->page;
+
+  atlas.BeginFrame();
+  CHECK(atlas.Find(Glyph(1)));
+  atlas.BeginFrame();
+
+  auto entry = atlas.Insert(Glyph(3), 15, 15, 0, 0);
+  REQUIRE(entry);
+  CHECK(entry->page == secondPage);
+  CHECK(atlas.Find(Glyph(1)));
+  CHECK(!atlas.Find(Glyph(2)));
+  CHECK(atlas.Find(Glyph(3)));
+
+  auto stats = atlas.Stats();
+  CHECK(stats.pageEvictions == 1);
+  CHECK(stats.glyphs == 2);
+  CHECK(stats.pages == 2);
+}
+
+TEST(GlyphAtlas_KeepsPagesUsedInTheCurrentFrame) {
+  GlyphAtlas atlas(16, 2);
+  REQUIRE(atlas.Insert(Glyph(1), 15, 15, 0, 0));
+  REQUIRE(atlas.Insert(Glyph(2), 15, 15, 0, 0));
+
+  // Both pages have entries that may still be batched
+  CHECK(!atlas.Insert(Glyph(3), 15, 15, 0, 0));
+  CHECK(atlas.Find(Glyph(1)) && atlas.Find(Glyph(2)));
+  CHECK(atlas.Stats().pageEvictions == 0);
+
+  atlas.BeginFrame();
+  CHECK(atlas.Find(Glyph(2)));
+  auto entry = atlas.Insert(Glyph(3), 15, 15, 0, 0);
+  REQUIRE(entry);
+  CHECK(!atlas.Find(Glyph(1)));
+  CHECK(atlas.Find(Glyph(2)));
+}
+
+TEST(GlyphAtlas_ClearKeepsStats) {
+  GlyphAtlas atlas(64, 2);
+  atlas.Insert(Glyph(1), 8, 8, 0, 0);
+  atlas.Find(Glyph(1));
+  atlas.Clear();
+
+  CHECK(!atlas.Find(Glyph(1)));
+  auto stats = atlas.Stats();
+  CHECK(stats.glyphs == 0);
+  CHECK(stats.pages == 0);
+  CHECK(stats.hits == 1);
+  CHECK(stats.misses == 1);
+
+  auto entry = atlas.Insert(Glyph(1), 8, 8, 0, 0);
+  CHECK(entry && entry->page == 0 && entry->x == 0 && entry->y == 0);
+}
+
+TEST(GlyphAtlas_QuantizesKeys) {
+  CHECK(GlyphAtlas::MakeKey(1, 2, 12.0f, 0) == GlyphAtlas::MakeKey(1, 2, 12.1f, 0));
+  CHECK(!(GlyphAtlas::MakeKey(1, 2, 12.0f, 0) == GlyphAtlas::MakeKey(1, 2, 12.25f, 0)));
+  CHECK(!(GlyphAtlas::MakeKey(1, 2, 12, 0) == GlyphAtlas::MakeKey(1, 3, 12, 0)));
+  CHECK(!(GlyphAtlas::MakeKey(1, 2, 12, 0) == GlyphAtlas::MakeKey(2, 2, 12, 0)));
+  CHECK(!(GlyphAtlas::MakeKey(1, 2, 12, 0) == GlyphAtlas::MakeKey(1, 2, 12, 0, 1)));
+
+  // Only the fractional part of the position matters
+  CHECK(GlyphAtlas::MakeKey(1, 2, 12, 5.3f) == GlyphAtlas::MakeKey(1, 2, 12, 107.3f));
+  CHECK(GlyphAtlas::MakeKey(1, 2, 12, 5.3f).subpixelOffset == 1);
+  CHECK(GlyphAtlas::MakeKey(1, 2, 12, -0.3f).subpixelOffset == 2);
+  CHECK(GlyphAtlas::SubpixelOffset(GlyphAtlas::MakeKey(1, 2, 12, 0.5f)) == 0.5f);
+}
+
+TEST(GlyphAtlas_RandomGlyphsNeverOverlap) {
+  constexpr uint32_t PageSize = 128;
+  GlyphAtlas atlas(PageSize, 3);
+  std::mt19937 random(42);
+  std::uniform_int_distribution<uint32_t> glyphs(0, 2000);
+  std::uniform_int_distribution<uint32_t> sizes(1, 40);
+
+  std::unordered_map<GlyphKey, GlyphAtlasEntry> inserted;
+  for (int frame = 0; frame < 50; frame++) {
+    atlas.BeginFrame();
+    for (int i = 0; i < 40; i++) {
+      auto key = Glyph(glyphs(random));
+      if (atlas.Find(key)) {
+        continue;
+      }
+      auto entry = atlas.Insert(key, sizes(random), sizes(random), 0, 0);
+      if (entry) {
+        inserted[key] = *entry;
+      }
+    }
+
+    // Every glyph still in the atlas has kept its rectangle, and no two rectangles overlap
+    std::vector<GlyphAtlasEntry> live;
+    for (auto &[key, expected] : inserted) {
+      if (auto entry = atlas.Find(key)) {
+        CHECK(entry->page == expected.page && entry->x == expected.x && entry->y == expected.y);
+        CHECK(entry->x + entry->width + GlyphAtlas::Padding <= PageSize);
+        CHECK(entry->y + entry->height + GlyphAtlas::Padding <= PageSize);
+        live.push_back(*entry);
+      }
+    }
+    REQUIRE(live.size() == atlas.Stats().glyphs);
+    for (size_t a = 0; a < live.size(); a++) {
+      for (size_t b = a + 1; b < live.size(); b++) {
+        REQUIRE(!Overlaps(live[a], live[b]));
+      }
+    }
+  }
+  CHECK(atlas.Stats().pageEvictions > 0);
+}
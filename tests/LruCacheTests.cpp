@@ -0,0 +1,219 @@
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../game/LruCache.h"
+#include "TestHarness.h"
+
+// Puts every key into the same bucket, so that all entries share one probe sequence
+struct CollidingHash {
+  size_t operator()(int) const noexcept {
+    return 42;
+  }
+};
+
+// Keys with the same value modulo 4 collide, which gives several interleaved probe sequences
+struct ModuloHash {
+  size_t operator()(int key) const noexcept {
+    return (size_t)(key % 4);
+  }
+};
+
+TEST(LruCache_FindsInsertedEntries) {
+  LruCache<int, std::string> cache(4);
+  cache.insert(1, "one");
+  cache.insert(2, "two");
+
+  std::string value;
+  CHECK(cache.tryGet(1, value) && value == "one");
+  CHECK(cache.tryGet(2, value) && value == "two");
+  CHECK(!cache.tryGet(3, value));
+  CHECK(cache.size() == 2);
+  CHECK(cache.stats().hits == 2);
+  CHECK(cache.stats().misses == 1);
+}
+
+TEST(LruCache_ReplacesExistingValue) {
+  LruCache<int, std::string> cache(4);
+  cache.insert(1, "one");
+  cache.insert(1, "uno");
+
+  auto value = cache.find(1);
+  REQUIRE(value);
+  CHECK(*value == "uno");
+  CHECK(cache.size() == 1);
+}
+
+TEST(LruCache_EvictsLeastRecentlyUsed) {
+  LruCache<int, int> cache(3);
+  cache.insert(1, 10);
+  cache.insert(2, 20);
+  cache.insert(3, 30);
+  // Using 1 makes 2 the least recently used entry
+  CHECK(cache.find(1));
+  cache.insert(4, 40);
+
+  CHECK(cache.size() == 3);
+  CHECK(cache.find(1));
+  CHECK(!cache.find(2));
+  CHECK(cache.find(3));
+  CHECK(cache.find(4));
+  CHECK(cache.stats().evictions == 1);
+}
+
+TEST(LruCache_ReinsertingRefreshesRecency) {
+  LruCache<int, int> cache(2);
+  cache.insert(1, 10);
+  cache.insert(2, 20);
+  cache.insert(1, 11);
+  cache.insert(3, 30);
+
+  CHECK(cache.find(1));
+  CHECK(!cache.find(2));
+}
+
+TEST(LruCache_EvictsUntilWeightFits) {
+  LruCache<int, int> cache(10, 10);
+  cache.insert(1, 1, 4);
+  cache.insert(2, 2, 4);
+  CHECK(cache.weight() == 8);
+
+  // Needs 1 and 2 to go
+  cache.insert(3, 3, 9);
+  CHECK(cache.weight() == 9);
+  CHECK(cache.size() == 1);
+  CHECK(!cache.find(1));
+  CHECK(!cache.find(2));
+  CHECK(cache.find(3));
+}
+
+TEST(LruCache_KeepsOversizedEntry) {
+  LruCache<int, int> cache(10, 10);
+  cache.insert(1, 1, 5);
+  cache.insert(2, 2, 50);
+
+  CHECK(cache.size() == 1);
+  CHECK(cache.find(2));
+  CHECK(cache.weight() == 50);
+}
+
+TEST(LruCache_ReplacingUpdatesWeight) {
+  LruCache<int, int> cache(10, 10);
+  cache.insert(1, 1, 3);
+  cache.insert(2, 2, 3);
+  cache.insert(1, 1, 8);
+
+  // 1 grew past the limit, so the older 2 had to go
+  CHECK(cache.weight() == 8);
+  CHECK(cache.find(1));
+  CHECK(!cache.find(2));
+}
+
+TEST(LruCache_RemoveKeepsCollidingEntriesReachable) {
+  LruCache<int, int, CollidingHash> cache(8);
+  for (int i = 0; i < 8; i++) {
+    cache.insert(i, i * 10);
+  }
+
+  // Removing from the start, the middle and the end of the probe sequence shifts the following
+  // slots back into the gap
+  CHECK(cache.remove(0));
+  CHECK(cache.remove(4));
+  CHECK(cache.remove(7));
+  CHECK(!cache.remove(7));
+
+  for (int i = 0; i < 8; i++) {
+    auto value = cache.find(i);
+    if (i == 0 || i == 4 || i == 7) {
+      CHECK(!value);
+    } else {
+      CHECK(value && *value == i * 10);
+    }
+  }
+  CHECK(cache.size() == 5);
+}
+
+TEST(LruCache_RemoveWithInterleavedProbeSequences) {
+  // 16 slots for 8 entries, with four home positions that overlap once the sequences grow
+  LruCache<int, int, ModuloHash> cache(8);
+  std::unordered_map<int, int> expected;
+  for (int i = 0; i < 8; i++) {
+    cache.insert(i, i);
+    expected[i] = i;
+  }
+
+  // Churn through removals and inserts and compare against a reference map. A wrong backward
+  // shift would make entries unreachable or leave stale slots behind.
+  for (int round = 0; round < 200; round++) {
+    auto victim = (round * 5) % 16;
+    CHECK(cache.remove(victim) == (expected.erase(victim) == 1));
+    auto added = (round * 7 + 3) % 16;
+    if (expected.size() < 8 || expected.count(added)) {
+      cache.insert(added, round);
+      expected[added] = round;
+    }
+
+    for (int key = 0; key < 16; key++) {
+      auto value = cache.find(key);
+      auto it = expected.find(key);
+      CHECK((value != nullptr) == (it != expected.end()));
+      if (value && it != expected.end()) {
+        CHECK(*value == it->second);
+      }
+    }
+  }
+}
+
+TEST(LruCache_EvictionWithCollisions) {
+  LruCache<int, int, CollidingHash> cache(4);
+  for (int i = 0; i < 100; i++) {
+    cache.insert(i, i);
+  }
+
+  CHECK(cache.size() == 4);
+  for (int i = 96; i < 100; i++) {
+    CHECK(cache.find(i));
+  }
+  CHECK(!cache.find(95));
+  CHECK(cache.stats().evictions == 96);
+}
+
+TEST(LruCache_PrecomputedHashes) {
+  LruCache<std::string, int> cache(4);
+  std::string key = "font";
+  auto hash = std::hash<std::string>()(key);
+  cache.insertHashed(key, hash, 7);
+
+  CHECK(cache.find(key) && *cache.find(key) == 7);
+  CHECK(cache.findHashed(key, hash) && *cache.findHashed(key, hash) == 7);
+  CHECK(cache.removeHashed(key, hash));
+  CHECK(cache.size() == 0);
+}
+
+TEST(LruCache_ClearKeepsStats) {
+  LruCache<int, int> cache(2);
+  cache.insert(1, 1);
+  cache.insert(2, 2);
+  cache.insert(3, 3);
+  cache.find(3);
+  cache.clear();
+
+  CHECK(cache.size() == 0);
+  CHECK(cache.weight() == 0);
+  CHECK(!cache.find(3));
+  CHECK(cache.stats().evictions == 1);
+  CHECK(cache.stats().hits == 1);
+
+  // All entries are free again
+  cache.insert(4, 4);
+  cache.insert(5, 5);
+  CHECK(cache.size() == 2);
+  CHECK(cache.stats().evictions == 1);
+}
+
+TEST(LruCache_ZeroCapacity) {
+  LruCache<int, int> cache(0);
+  CHECK(!cache.insert(1, 1));
+  CHECK(!cache.find(1));
+  CHECK(cache.size() == 0);
+}
@@ -0,0 +1,82 @@
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#include "../game/MesParser.h"
+#include "../game/utils.h"
+#include "TestHarness.h"
+
+NATIVE_API MesFile *MesFile_Parse(const uint8_t *data, int length, char16_t **error) noexcept;
+NATIVE_API void MesFile_Free(MesFile *file);
+
+static bool Parse(std::string_view content, MesFile &file, std::string &error) {
+  return ParseMesFile(reinterpret_cast<const uint8_t *>(content.data()), content.length(), file,
+                      error);
+}
+
+static std::u16string Text(const MesFile &file, size_t index) {
+  auto &entry = file.entries[index];
+  return file.text.substr(entry.offset, entry.length);
+}
+
+TEST(MesParser_ParsesEntriesSortedById) {
+  MesFile file;
+  std::string error;
+  REQUIRE(Parse("// Greetings\n{20}{World}\n{10}{Hello}\n{-1}{Multiple\nlines}\n", file, error));
+  REQUIRE(file.entries.size() == 3);
+  CHECK(file.entries[0].id == -1);
+  CHECK(Text(file, 0) == u"Multiple\nlines");
+  CHECK(file.entries[1].id == 10);
+  CHECK(Text(file, 1) == u"Hello");
+  CHECK(file.entries[2].id == 20);
+  CHECK(Text(file, 2) == u"World");
+}
+
+TEST(MesParser_LastDuplicateWins) {
+  MesFile file;
+  std::string error;
+  REQUIRE(Parse("{1}{first}{2}{other}{1}{second}{1}{third}", file, error));
+  REQUIRE(file.entries.size() == 2);
+  CHECK(file.entries[0].id == 1);
+  CHECK(Text(file, 0) == u"third");
+  CHECK(Text(file, 1) == u"other");
+}
+
+TEST(MesParser_DecodesWindows1252) {
+  MesFile file;
+  std::string error;
+  // Euro sign, e with acute accent, curly quotes and Y with diaeresis
+  REQUIRE(Parse("{1}{\x80 caf\xE9 \x93quoted\x94 \x9F}", file, error));
+  REQUIRE(file.entries.size() == 1);
+  CHECK(Text(file, 0) == u"€ café “quoted” Ÿ");
+}
+
+TEST(MesParser_RejectsUnterminatedBraces) {
+  MesFile file;
+  std::string error;
+  CHECK(!Parse("{1}{ok}\n{2", file, error));
+  CHECK(error == "Unterminated message ID in line 2");
+
+  CHECK(!Parse("{1}{ok}\n\n{2}{never closed", file, error));
+  CHECK(error == "Unterminated text of message 2");
+
+  CHECK(!Parse("{1}", file, error));
+  CHECK(error == "Missing text for message 1");
+
+  CHECK(!Parse("{x}{text}", file, error));
+  CHECK(error == "Invalid message ID in line 1");
+}
+
+TEST(MesParser_ExportRejectsNegativeLength) {
+  char16_t *error = nullptr;
+  CHECK(MesFile_Parse(reinterpret_cast<const uint8_t *>("{1}{a}"), -1, &error) == nullptr);
+  REQUIRE(error != nullptr);
+  CHECK(std::u16string(error) == u"Negative message file length");
+  free(error);
+
+  auto file = MesFile_Parse(reinterpret_cast<const uint8_t *>("{1}{a}"), 6, &error);
+  REQUIRE(file != nullptr);
+  CHECK(error == nullptr);
+  CHECK(file->entries.size() == 1);
+  MesFile_Free(file);
+}
@@ -0,0 +1,117 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../game/SampleRingBuffer.h"
+#include "TestHarness.h"
+
+// Writes consecutive values starting at first to every channel
+static size_t WriteSequence(SampleRingBuffer &buffer, float first, size_t count) {
+  std::vector<float> samples(count);
+  for (size_t i = 0; i < count; i++) {
+    samples[i] = first + (float)i;
+  }
+  std::vector<const float *> planes(buffer.channels(), samples.data());
+  return buffer.writePlanar(planes.data(), count);
+}
+
+static std::vector<float> ReadAll(SampleRingBuffer &buffer, size_t count) {
+  std::vector<float> left(count), right(count);
+  float *planes[] = {left.data(), right.data()};
+  left.resize(buffer.readPlanar(planes, count));
+  return left;
+}
+
+TEST(SampleRingBuffer_WrapsAroundTheEnd) {
+  SampleRingBuffer buffer(2, 8);
+  CHECK(WriteSequence(buffer, 0, 6) == 6);
+  CHECK(ReadAll(buffer, 5).size() == 5);
+
+  // Starts at offset 6 and wraps after two samples
+  CHECK(WriteSequence(buffer, 6, 10) == 7);
+  CHECK(buffer.size() == 8);
+  CHECK(buffer.writeAvailable() == 0);
+
+  auto samples = ReadAll(buffer, 16);
+  REQUIRE(samples.size() == 8);
+  for (size_t i = 0; i < samples.size(); i++) {
+    CHECK(samples[i] == 5.0f + (float)i);
+  }
+}
+
+TEST(SampleRingBuffer_KeepsUsableCapacity) {
+  // The planes are rounded up to 128 samples, but only 100 may be queued
+  SampleRingBuffer buffer(2, 100);
+  CHECK(WriteSequence(buffer, 0, 150) == 100);
+  CHECK(buffer.writeAvailable() == 0);
+}
+
+TEST(SampleRingBuffer_DiscardedSpaceIsWritableWithoutReads) {
+  SampleRingBuffer buffer(2, 16);
+  CHECK(WriteSequence(buffer, 0, 16) == 16);
+
+  CHECK(buffer.discard(10) == 10);
+  CHECK(buffer.size() == 6);
+  CHECK(buffer.writeAvailable() == 10);
+  CHECK(WriteSequence(buffer, 16, 10) == 10);
+
+  // Only the oldest samples were dropped
+  auto samples = ReadAll(buffer, 16);
+  REQUIRE(samples.size() == 16);
+  CHECK(samples.front() == 10);
+  CHECK(samples.back() == 25);
+
+  // Nothing to drop
+  CHECK(buffer.discard(1) == 0);
+}
+
+TEST(SampleRingBuffer_ReadsNeverReturnOverwrittenSamples) {
+  // The producer drops the oldest samples whenever the buffer is full, like DropOldest, so the
+  // consumer regularly copies samples that are dropped and overwritten under it
+  constexpr size_t Total = 2000000;
+  SampleRingBuffer buffer(2, 64);
+  std::atomic<bool> done{false};
+
+  std::thread producer([&] {
+    size_t next = 0;
+    while (next < Total) {
+      auto count = std::min<size_t>(Total - next, 48);
+      if (buffer.writeAvailable() < count) {
+        buffer.discard(count - buffer.writeAvailable());
+      }
+      next += WriteSequence(buffer, (float)next, count);
+    }
+    done = true;
+  });
+
+  // Floats represent every value up to Total exactly
+  float last = -1;
+  bool ordered = true;
+  std::vector<float> left(64), right(64);
+  float *planes[] = {left.data(), right.data()};
+  while (!done || buffer.size() > 0) {
+    auto count = buffer.readPlanar(planes, 64);
+    for (size_t i = 0; i < count; i++) {
+      // Samples of one read are contiguous, later reads continue after earlier ones
+      ordered &= left[i] == right[i] && left[i] > last && (i == 0 || left[i] == left[i - 1] + 1);
+      last = left[i];
+    }
+  }
+  producer.join();
+  CHECK(ordered);
+  CHECK(last == (float)(Total - 1));
+}
+
+TEST(SampleRingBuffer_ClearFreesCapacityWithoutReads) {
+  SampleRingBuffer buffer(2, 16);
+  CHECK(WriteSequence(buffer, 0, 16) == 16);
+
+  buffer.clear();
+  CHECK(buffer.size() == 0);
+  CHECK(buffer.writeAvailable() == 16);
+  CHECK(WriteSequence(buffer, 100, 16) == 16);
+
+  auto samples = ReadAll(buffer, 16);
+  REQUIRE(samples.size() == 16);
+  CHECK(samples.front() == 100);
+}
@@ -0,0 +1,150 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../game/SoLoudDynamicSource.h"
+#include "TestHarness.h"
+
+// At 1000 Hz, a capacity of 100 ms holds exactly 100 samples
+constexpr int SampleRate = 1000;
+constexpr int CapacityMs = 100;
+constexpr size_t Capacity = 100;
+
+static std::vector<float> Sequence(float first, size_t count) {
+  std::vector<float> samples(count);
+  for (size_t i = 0; i < count; i++) {
+    samples[i] = first + (float)i;
+  }
+  return samples;
+}
+
+static bool Push(SoLoudDynamicSource &source, std::vector<float> samples) {
+  float *planes[] = {samples.data()};
+  return source.pushSamples(planes, (int)samples.size(), false);
+}
+
+// Plays the part of the audio thread
+static std::vector<float> Play(SoLoud::AudioSourceInstance &instance, size_t count) {
+  std::vector<float> samples(count);
+  samples.resize(instance.getAudio(samples.data(), (unsigned int)count, (unsigned int)count));
+  return samples;
+}
+
+static std::unique_ptr<SoLoud::AudioSourceInstance> CreateInstance(SoLoudDynamicSource &source) {
+  std::unique_ptr<SoLoud::AudioSourceInstance> instance(source.createInstance());
+  instance->mChannels = source.mChannels;
+  return instance;
+}
+
+TEST(SoLoudDynamicSource_DropOldestNeverWaits) {
+  SoLoudDynamicSource source(1, SampleRate, CapacityMs, OverflowPolicy::DropOldest);
+
+  // Nothing consumes the samples, as if the voice were paused
+  auto pushed = std::async(std::launch::async, [&] { return Push(source, Sequence(0, 300)); });
+  REQUIRE(pushed.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  CHECK(pushed.get());
+
+  SoLoudDynamicSourceStats stats{};
+  source.getStats(&stats);
+  CHECK(stats.queuedSamples == Capacity);
+  CHECK(stats.droppedSamples == 200);
+
+  // The newest samples are kept
+  auto instance = CreateInstance(source);
+  auto samples = Play(*instance, 300);
+  REQUIRE(samples.size() == Capacity);
+  CHECK(samples.front() == 200);
+  CHECK(samples.back() == 299);
+}
+
+TEST(SoLoudDynamicSource_BlockWaitsForTheAudioThread) {
+  SoLoudDynamicSource source(1, SampleRate, CapacityMs, OverflowPolicy::Block);
+  auto instance = CreateInstance(source);
+  REQUIRE(Push(source, Sequence(0, Capacity)));
+
+  auto pushed = std::async(std::launch::async, [&] { return Push(source, Sequence(100, 50)); });
+  CHECK(pushed.wait_for(std::chrono::milliseconds(50)) == std::future_status::timeout);
+
+  CHECK(Play(*instance, 60).size() == 60);
+  REQUIRE(pushed.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  CHECK(pushed.get());
+  auto samples = Play(*instance, 100);
+  REQUIRE(samples.size() == 90);
+  CHECK(samples.front() == 60);
+  CHECK(samples.back() == 149);
+}
+
+TEST(SoLoudDynamicSource_FreeCancelsBlockedPush) {
+  auto source = std::make_unique<SoLoudDynamicSource>(1, SampleRate, CapacityMs,
+                                                      OverflowPolicy::Block);
+  REQUIRE(Push(*source, Sequence(0, Capacity)));
+
+  std::atomic<bool> started{false};
+  auto pushed = std::async(std::launch::async, [&, raw = source.get()] {
+    started = true;
+    return Push(*raw, Sequence(100, 50));
+  });
+  while (!started) {
+    std::this_thread::yield();
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  // Waits for the push to give up before the queue is freed
+  source.reset();
+  REQUIRE(pushed.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  CHECK(!pushed.get());
+}
+
+TEST(SoLoudDynamicSource_FlushFreesCapacityWithoutReads) {
+  for (auto policy : {OverflowPolicy::Block, OverflowPolicy::Reject}) {
+    SoLoudDynamicSource source(1, SampleRate, CapacityMs, policy);
+    REQUIRE(Push(source, Sequence(0, Capacity)));
+    CHECK(source.writableSamples() == 0);
+
+    // Nothing consumes the samples, so only the flush itself can make room
+    source.flush();
+    CHECK(source.writableSamples() == Capacity);
+    auto pushed = std::async(std::launch::async,
+                             [&] { return Push(source, Sequence(1000, Capacity)); });
+    REQUIRE(pushed.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    CHECK(pushed.get());
+
+    auto instance = CreateInstance(source);
+    auto samples = Play(*instance, 200);
+    REQUIRE(samples.size() == Capacity);
+    CHECK(samples.front() == 1000);
+  }
+}
+
+TEST(SoLoudDynamicSource_SeekFreesCapacityWithoutReads) {
+  SoLoudDynamicSource source(1, SampleRate, CapacityMs, OverflowPolicy::Reject);
+  REQUIRE(Push(source, Sequence(0, Capacity)));
+  CHECK(!Push(source, Sequence(100, 1)));
+
+  source.seek(2.0);
+  CHECK(source.samplesConsumed() == 2 * SampleRate);
+  CHECK(Push(source, Sequence(2000, Capacity)));
+}
+
+TEST(SoLoudDynamicSource_SeekCancelsBlockedPush) {
+  SoLoudDynamicSource source(1, SampleRate, CapacityMs, OverflowPolicy::Block);
+  auto instance = CreateInstance(source);
+  REQUIRE(Push(source, Sequence(0, Capacity)));
+
+  auto pushed = std::async(std::launch::async, [&] { return Push(source, Sequence(100, 50)); });
+  CHECK(pushed.wait_for(std::chrono::milliseconds(20)) == std::future_status::timeout);
+
+  // SoLoud seeks on the audio thread, while the decoder thread is still pushing the old position
+  float scratch[16];
+  CHECK(instance->seek(1.0, scratch, 16) == SoLoud::SO_NO_ERROR);
+  REQUIRE(pushed.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  CHECK(!pushed.get());
+
+  // None of the samples of the old position are left
+  CHECK(source.writableSamples() == Capacity);
+  CHECK(Push(source, Sequence(1000, Capacity)));
+  CHECK(Play(*instance, 1).front() == 1000);
+}
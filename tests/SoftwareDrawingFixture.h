@@ -0,0 +1,53 @@
+#pragma once
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../game/software/SoftwareDrawingEngine.h"
+
+/**
+ * Shared by the software drawing engine's tests and benchmarks: an engine with the test font
+ * loaded, and the styles they start from. TEST_DATA_DIR is defined by the build.
+ */
+namespace SoftwareDrawingFixture {
+
+inline std::vector<uint8_t> ReadFile(const std::string &path) {
+  std::ifstream stream(path, std::ios::binary);
+  if (!stream) {
+    throw std::runtime_error("Failed to open " + path);
+  }
+  return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+}
+
+inline std::unique_ptr<SoftwareDrawingEngine> CreateEngine() {
+  auto engine = std::make_unique<SoftwareDrawingEngine>();
+  auto path = std::string(TEST_DATA_DIR) + "/fonts/Lato-Regular.ttf";
+  engine->AddFontFile(FontFile(path, ReadFile(path)));
+  engine->ReloadFontFamilies();
+  return engine;
+}
+
+inline ParagraphStyle DefaultParagraph() {
+  ParagraphStyle style{};
+  style.TabStopWidth = 48;
+  style.LineHeight = 1;
+  return style;
+}
+
+inline TextStyle DefaultText() {
+  TextStyle style{};
+  style.FontFace = u"Lato";
+  style.FontSize = 16;
+  style.Color = 0xFFFFFFFF;
+  style.Kerning = true;
+  style.FontStretch = FontStretch::Normal;
+  style.FontStyle = FontStyle::Normal;
+  style.FontWeight = FontWeight::Regular;
+  return style;
+}
+
+}  // namespace SoftwareDrawingFixture
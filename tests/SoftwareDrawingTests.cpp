@@ -0,0 +1,353 @@
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "SoftwareDrawingFixture.h"
+#include "TestHarness.h"
+
+using namespace SoftwareDrawingFixture;
+
+/*
+ * Image regression tests render into memory and compare the result with the reference images in
+ * data/images. Run native_tests with OPENTEMPLE_UPDATE_IMAGES=1 to write the references after an
+ * intended change, and check the new images before committing them. When a comparison fails, the
+ * rendered image is written to the working directory next to the reference's name.
+ *
+ * Images are rendered on an opaque background and stored as binary PPM files.
+ */
+
+// FreeType versions differ slightly in their antialiasing, so small differences are accepted
+static constexpr int ChannelTolerance = 24;
+static constexpr size_t MaxDifferingPixelsPerMille = 5;
+
+static constexpr uint32_t Background = 0xFF202830;
+
+struct Image {
+  int width;
+  int height;
+  std::vector<uint8_t> pixels;  // BGRA, premultiplied
+
+  Image(int width, int height, uint32_t color) : width(width), height(height) {
+    pixels.resize((size_t)width * height * 4);
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+      pixels[i] = (uint8_t)color;
+      pixels[i + 1] = (uint8_t)(color >> 8);
+      pixels[i + 2] = (uint8_t)(color >> 16);
+      pixels[i + 3] = (uint8_t)(color >> 24);
+    }
+  }
+};
+
+static bool WritePpm(const std::string &path, const Image &image) {
+  auto file = fopen(path.c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+  fprintf(file, "P6\n%d %d\n255\n", image.width, image.height);
+  for (size_t i = 0; i < image.pixels.size(); i += 4) {
+    uint8_t rgb[3] = {image.pixels[i + 2], image.pixels[i + 1], image.pixels[i]};
+    fwrite(rgb, 1, 3, file);
+  }
+  fclose(file);
+  return true;
+}
+
+// Only reads what WritePpm writes
+static bool ReadPpm(const std::string &path, int width, int height, std::vector<uint8_t> &rgb) {
+  auto file = fopen(path.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+  int fileWidth, fileHeight, maxValue;
+  auto ok = fscanf(file, "P6 %d %d %d", &fileWidth, &fileHeight, &maxValue) == 3 &&
+            fgetc(file) == '\n' && fileWidth == width && fileHeight == height && maxValue == 255;
+  if (ok) {
+    rgb.resize((size_t)width * height * 3);
+    ok = fread(rgb.data(), 1, rgb.size(), file) == rgb.size();
+  }
+  fclose(file);
+  return ok;
+}
+
+static void CheckImage(const char *file, int line, const char *name, const Image &image) {
+  auto referencePath = std::string(TEST_DATA_DIR) + "/images/" + name + ".ppm";
+  if (getenv("OPENTEMPLE_UPDATE_IMAGES")) {
+    if (!WritePpm(referencePath, image)) {
+      TestHarness::Fail(file, line, ("failed to write " + referencePath).c_str());
+    }
+    return;
+  }
+
+  std::vector<uint8_t> reference;
+  if (!ReadPpm(referencePath, image.width, image.height, reference)) {
+    auto message = "missing or mismatched reference image " + referencePath;
+    TestHarness::Fail(file, line, message.c_str());
+    return;
+  }
+
+  size_t differing = 0;
+  for (size_t i = 0, count = (size_t)image.width * image.height; i < count; i++) {
+    auto pixel = &image.pixels[i * 4];
+    auto expected = &reference[i * 3];
+    if (std::abs(pixel[2] - expected[0]) > ChannelTolerance ||
+        std::abs(pixel[1] - expected[1]) > ChannelTolerance ||
+        std::abs(pixel[0] - expected[2]) > ChannelTolerance) {
+      differing++;
+    }
+  }
+
+  if (differing * 1000 > (size_t)image.width * image.height * MaxDifferingPixelsPerMille) {
+    auto actualPath = std::string(name) + ".actual.ppm";
+    WritePpm(actualPath, image);
+    auto message = std::string(name) + " differs from the reference in " +
+                   std::to_string(differing) + " pixels, see " + actualPath;
+    TestHarness::Fail(file, line, message.c_str());
+  }
+}
+
+#define CHECK_IMAGE(name, image) CheckImage(__FILE__, __LINE__, name, image)
+
+static void Render(SoftwareDrawingEngine &engine, Image &image, SoftwareTextLayout &layout,
+                   float x, float y) {
+  engine.SetRenderTarget(image.pixels.data(), image.width, image.height, image.width * 4);
+  engine.SetCanvasSize((float)image.width, (float)image.height);
+  engine.BeginDraw();
+  engine.RenderTextLayout(x, y, layout, 1);
+  engine.EndDraw();
+}
+
+static std::unique_ptr<SoftwareTextLayout> CreateLayout(SoftwareDrawingEngine &engine,
+                                                        const ParagraphStyle &paragraph,
+                                                        const TextStyle &text,
+                                                        std::u16string_view str, float maxWidth,
+                                                        float maxHeight) {
+  return std::unique_ptr<SoftwareTextLayout>(engine.CreateTextLayout(
+      paragraph, text, str.data(), (uint32_t)str.length(), maxWidth, maxHeight));
+}
+
+static const char16_t Paragraph[] =
+    u"The quick brown fox jumps over the lazy dog, while the tired dog keeps on sleeping.";
+
+TEST(SoftwareDrawing_WrapsLinesWithinMaxWidth) {
+  auto engine = CreateEngine();
+  auto layout = CreateLayout(*engine, DefaultParagraph(), DefaultText(), Paragraph, 150, 1000);
+
+  auto &metrics = layout->GetMetrics();
+  CHECK(metrics.lineCount > 2);
+  CHECK(metrics.width <= 150);
+
+  std::vector<SoftwareLineMetrics> lines(metrics.lineCount);
+  uint32_t lineCount;
+  REQUIRE(layout->GetLineMetrics(lines.data(), (uint32_t)lines.size(), &lineCount));
+  uint32_t length = 0;
+  for (auto &line : lines) {
+    CHECK(line.height > 0);
+    length += line.length;
+  }
+  CHECK(length == std::char_traits<char16_t>::length(Paragraph));
+
+  // Widening the layout takes fewer lines
+  layout->SetMaxWidth(1000);
+  CHECK(layout->GetMetrics().lineCount == 1);
+}
+
+TEST(SoftwareDrawing_HitTestTextPositionReportsCaretEdge) {
+  auto engine = CreateEngine();
+  auto layout = CreateLayout(*engine, DefaultParagraph(), DefaultText(), u"Hello", 1000, 1000);
+
+  float leadingX, leadingY, trailingX, trailingY;
+  SoftwareHitTestMetrics leading{}, trailing{};
+  layout->HitTestTextPosition(1, false, &leadingX, &leadingY, &leading);
+  layout->HitTestTextPosition(1, true, &trailingX, &trailingY, &trailing);
+
+  // The character's area is the same, only the caret moves to its trailing edge
+  CHECK(leading.textPosition == 1 && trailing.textPosition == 1);
+  CHECK(leading.left == trailing.left && leading.width == trailing.width);
+  CHECK(leading.width > 0);
+  CHECK(leadingX == leading.left);
+  CHECK(trailingX == leading.left + leading.width);
+  CHECK(leadingY == trailingY);
+
+  // The trailing edge of a character is the leading edge of the next one
+  float nextX, nextY;
+  SoftwareHitTestMetrics next{};
+  layout->HitTestTextPosition(2, false, &nextX, &nextY, &next);
+  CHECK(nextX == trailingX);
+}
+
+TEST(SoftwareDrawing_HitTestPointFindsCharacter) {
+  auto engine = CreateEngine();
+  auto layout = CreateLayout(*engine, DefaultParagraph(), DefaultText(), u"Hello", 1000, 1000);
+
+  float x, y;
+  SoftwareHitTestMetrics metrics{};
+  layout->HitTestTextPosition(3, false, &x, &y, &metrics);
+
+  int position, length;
+  bool trailingHit;
+  CHECK(layout->HitTestPoint(metrics.left + metrics.width * 0.25f,
+                             metrics.top + metrics.height / 2, &position, &length, &trailingHit));
+  CHECK(position == 3 && length == 1 && !trailingHit);
+  layout->HitTestPoint(metrics.left + metrics.width * 0.75f, metrics.top + metrics.height / 2,
+                       &position, &length, &trailingHit);
+  CHECK(position == 3 && trailingHit);
+}
+
+TEST(SoftwareDrawing_SetStylesRejectsInvalidSpans) {
+  auto engine = CreateEngine();
+  auto layout = CreateLayout(*engine, DefaultParagraph(), DefaultText(), u"Hello World", 1000,
+                             1000);
+  auto width = layout->GetMetrics().width;
+
+  auto large = DefaultText();
+  large.FontSize = 32;
+  auto noFace = large;
+  noFace.FontFace = nullptr;
+  TextStyle styles[] = {large, noFace};
+
+  // The valid first span must not be applied either
+  TextStyleSpan outOfRange[] = {{0, 5, TextStyleProperty::FontSize, 0},
+                                {6, 5, TextStyleProperty::FontSize, 2}};
+  bool threw = false;
+  try {
+    layout->SetStyles(outOfRange, 2, styles, 2);
+  } catch (const std::out_of_range &) {
+    threw = true;
+  }
+  CHECK(threw);
+  CHECK(layout->GetMetrics().width == width);
+
+  TextStyleSpan nullFace[] = {{0, 5, TextStyleProperty::FontSize, 0},
+                              {6, 5, TextStyleProperty::FontFace, 1}};
+  threw = false;
+  try {
+    layout->SetStyles(nullFace, 2, styles, 2);
+  } catch (const std::invalid_argument &) {
+    threw = true;
+  }
+  CHECK(threw);
+  CHECK(layout->GetMetrics().width == width);
+
+  // Spans that only change other properties may use a style without a font face
+  TextStyleSpan sizeOnly[] = {{6, 5, TextStyleProperty::FontSize, 1}};
+  layout->SetStyles(sizeOnly, 1, styles, 2);
+  CHECK(layout->GetMetrics().width > width);
+}
+
+TEST(SoftwareDrawing_RendersPremultipliedPixels) {
+  auto engine = CreateEngine();
+  auto text = DefaultText();
+  text.Color = 0x80FF8000;
+  auto layout = CreateLayout(*engine, DefaultParagraph(), text, u"Alpha", 1000, 1000);
+
+  Image image(64, 24, 0);
+  Render(*engine, image, *layout, 2, 2);
+
+  size_t covered = 0;
+  for (size_t i = 0; i < image.pixels.size(); i += 4) {
+    auto alpha = image.pixels[i + 3];
+    CHECK(image.pixels[i] <= alpha && image.pixels[i + 1] <= alpha && image.pixels[i + 2] <= alpha);
+    CHECK(alpha <= 0x80);
+    covered += alpha > 0;
+  }
+  CHECK(covered > 0);
+}
+
+TEST(SoftwareDrawing_RendersPlainText) {
+  auto engine = CreateEngine();
+  auto layout = CreateLayout(*engine, DefaultParagraph(), DefaultText(),
+                             u"Hello, World! 0123456789", 1000, 1000);
+
+  Image image(220, 28, Background);
+  Render(*engine, image, *layout, 4, 4);
+  CHECK_IMAGE("plain_text", image);
+}
+
+TEST(SoftwareDrawing_RendersWrappedCenteredMarkup) {
+  auto engine = CreateEngine();
+  auto paragraph = DefaultParagraph();
+  paragraph.TextAlignment = TextAlign::Center;
+  auto text = DefaultText();
+  text.FontSize = 14;
+
+  MarkupStyle palette[3]{};
+  palette[1].Properties = TextStyleProperty::Color;
+  palette[1].Style = text;
+  palette[1].Style.Color = 0xFFFF6040;
+  palette[2].Properties = TextStyleProperty::Color | TextStyleProperty::FontSize;
+  palette[2].Style = text;
+  palette[2].Style.Color = 0xFF60C0FF;
+  palette[2].Style.FontSize = 18;
+
+  std::u16string_view markup = u"The @1quick brown fox@0 jumps over the @2lazy dog@0.";
+  auto layout = std::unique_ptr<SoftwareTextLayout>(engine->CreateTextLayoutFromMarkup(
+      paragraph, text, markup, 160, 1000, palette, 3));
+
+  Image image(168, 72, Background);
+  Render(*engine, image, *layout, 4, 4);
+  CHECK_IMAGE("wrapped_centered_markup", image);
+}
+
+TEST(SoftwareDrawing_RendersDecorations) {
+  auto engine = CreateEngine();
+  auto text = DefaultText();
+  text.FontSize = 20;
+  auto layout = CreateLayout(*engine, DefaultParagraph(), text, u"Under Strike Outline Bold",
+                             1000, 1000);
+
+  auto style = text;
+  style.Underline = true;
+  style.LineThrough = true;
+  style.OutlineColor = 0xFF000000;
+  style.OutlineWidth = 1;
+  style.DropShadowColor = 0xC0000000;
+  style.FontWeight = FontWeight::Bold;
+  style.FontStyle = FontStyle::Italic;
+  layout->SetStyle(0, 5, TextStyleProperty::Underline, style);
+  layout->SetStyle(6, 6, TextStyleProperty::LineThrough, style);
+  layout->SetStyle(13, 7, TextStyleProperty::Outline | TextStyleProperty::DropShadowColor, style);
+  layout->SetStyle(21, 4, TextStyleProperty::FontWeight | TextStyleProperty::FontStyle, style);
+
+  Image image(280, 36, Background);
+  Render(*engine, image, *layout, 4, 4);
+  CHECK_IMAGE("decorations", image);
+}
+
+TEST(SoftwareDrawing_RendersTrimmedText) {
+  auto engine = CreateEngine();
+  auto paragraph = DefaultParagraph();
+  paragraph.WordWrap = WordWrap::NoWrap;
+  paragraph.TrimMode = TrimMode::Character;
+  paragraph.TrimmingSign = TrimmingSign::Ellipsis;
+  auto layout = CreateLayout(*engine, paragraph, DefaultText(), Paragraph, 140, 1000);
+
+  Image image(148, 28, Background);
+  Render(*engine, image, *layout, 4, 4);
+  CHECK_IMAGE("trimmed_text", image);
+}
+
+TEST(SoftwareDrawing_RendersBackgroundAndBorder) {
+  auto engine = CreateEngine();
+  Image image(120, 60, Background);
+  engine->SetRenderTarget(image.pixels.data(), image.width, image.height, image.width * 4);
+  engine->SetCanvasSize((float)image.width, (float)image.height);
+
+  BackgroundAndBorderStyle square;
+  square.backgroundColor = 0xFF406080;
+  square.borderColor = 0xFFFFFFFF;
+  square.borderWidth = 1;
+  BackgroundAndBorderStyle rounded;
+  rounded.radiusX = rounded.radiusY = 8;
+  rounded.backgroundColor = 0x80FF8040;
+  rounded.borderColor = 0xFFFFC000;
+  rounded.borderWidth = 2;
+
+  engine->BeginDraw();
+  engine->RenderBackgroundAndBorder(4, 4, 50, 30, square);
+  engine->RenderBackgroundAndBorder(40.5f, 20.5f, 70, 32, rounded);
+  engine->EndDraw();
+  CHECK_IMAGE("background_and_border", image);
+}
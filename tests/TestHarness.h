@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+/**
+ * A minimal test runner, so that the native tests do not need a third-party framework.
+ *
+ * TEST(Group_Name) defines a test case. CHECK(condition) records a failure and lets the test
+ * continue, REQUIRE(condition) returns from the test on failure. The runner executes every test
+ * whose name starts with the prefix given on the command line (or all of them) and exits with a
+ * non-zero code if any check failed.
+ */
+namespace TestHarness {
+
+struct TestCase {
+  const char *name;
+  void (*run)();
+};
+
+std::vector<TestCase> &Registry();
+
+void Fail(const char *file, int line, const char *expression);
+
+struct Registrar {
+  Registrar(const char *name, void (*run)()) {
+    Registry().push_back({name, run});
+  }
+};
+
+}  // namespace TestHarness
+
+#define TEST(name)                                                      \
+  static void name();                                                   \
+  static const TestHarness::Registrar name##Registrar_(#name, &name);  \
+  static void name()
+
+#define CHECK(condition)                                        \
+  do {                                                          \
+    if (!(condition)) {                                         \
+      TestHarness::Fail(__FILE__, __LINE__, #condition);        \
+    }                                                           \
+  } while (0)
+
+#define REQUIRE(condition)                                      \
+  do {                                                          \
+    if (!(condition)) {                                         \
+      TestHarness::Fail(__FILE__, __LINE__, #condition);        \
+      return;                                                   \
+    }                                                           \
+  } while (0)
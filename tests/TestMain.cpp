@@ -0,0 +1,48 @@
+#include <cstring>
+
+#include "TestHarness.h"
+
+namespace TestHarness {
+
+static int failures = 0;
+
+std::vector<TestCase> &Registry() {
+  static std::vector<TestCase> tests;
+  return tests;
+}
+
+void Fail(const char *file, int line, const char *expression) {
+  fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+  failures++;
+}
+
+}  // namespace TestHarness
+
+int main(int argc, char **argv) {
+  using namespace TestHarness;
+
+  auto prefix = argc > 1 ? argv[1] : "";
+  int run = 0;
+  int failed = 0;
+  for (auto &test : Registry()) {
+    if (strncmp(test.name, prefix, strlen(prefix)) != 0) {
+      continue;
+    }
+    auto failuresBefore = failures;
+    test.run();
+    run++;
+    if (failures != failuresBefore) {
+      fprintf(stderr, "FAILED %s\n", test.name);
+      failed++;
+    } else {
+      printf("passed %s\n", test.name);
+    }
+  }
+
+  printf("%d of %d tests passed\n", run - failed, run);
+  if (run == 0) {
+    fprintf(stderr, "No tests match '%s'\n", prefix);
+    return 1;
+  }
+  return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,191 @@
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "../game/LruCache.h"
+#include "../game/rendering/drawing/FontNameTable.h"
+#include "../game/rendering/drawing/TextFormatKey.h"
+#include "TestHarness.h"
+
+// Font names are UTF-16 on every platform, but only wchar_t literals on Windows
+static StyleString Name(const char *ascii) {
+  return StyleString(ascii, ascii + strlen(ascii));
+}
+
+static ParagraphStyle DefaultParagraph() {
+  ParagraphStyle style{};
+  style.TabStopWidth = 40;
+  style.LineHeight = 1;
+  return style;
+}
+
+static TextStyle DefaultText(const StyleChar *fontFace) {
+  TextStyle style{};
+  style.FontFace = fontFace;
+  style.FontSize = 12;
+  style.FontWeight = FontWeight::Regular;
+  style.FontStretch = FontStretch::Normal;
+  return style;
+}
+
+TEST(TextFormatKey_InternAssignsStableIds) {
+  FontNameTable table;
+  auto arial = Name("Arial");
+  auto times = Name("Times New Roman");
+
+  auto arialId = table.intern(arial);
+  auto timesId = table.intern(times);
+  CHECK(arialId != timesId);
+  CHECK(table.intern(arial) == arialId);
+  CHECK(table.intern(Name("Arial")) == arialId);
+  CHECK(table.size() == 2);
+
+  CHECK(table.name(arialId) == arial);
+  CHECK(table.name(timesId) == times);
+}
+
+TEST(TextFormatKey_InternIsCaseSensitive) {
+  FontNameTable table;
+  CHECK(table.intern(Name("Arial")) != table.intern(Name("arial")));
+  CHECK(table.size() == 2);
+}
+
+TEST(TextFormatKey_InternedNamesStayValid) {
+  FontNameTable table;
+  auto firstId = table.intern(Name("Font 0"));
+  auto first = table.name(firstId).c_str();
+
+  // Growing the table must not move the strings that keys and layouts point to
+  for (int i = 1; i < 1000; i++) {
+    table.intern(Name(("Font " + std::to_string(i)).c_str()));
+  }
+  CHECK(table.name(firstId).c_str() == first);
+  CHECK(table.name(firstId) == Name("Font 0"));
+}
+
+TEST(TextFormatKey_ConcurrentInternAgrees) {
+  FontNameTable table;
+  std::vector<std::vector<FontNameId>> ids(4);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < ids.size(); t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < 200; i++) {
+        ids[t].push_back(table.intern(Name(("Font " + std::to_string(i)).c_str())));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  CHECK(table.size() == 200);
+  for (size_t t = 1; t < ids.size(); t++) {
+    CHECK(ids[t] == ids[0]);
+  }
+}
+
+TEST(TextFormatKey_EqualStylesGiveEqualKeys) {
+  FontNameTable table;
+  // Different pointers to the same name must still produce the same key
+  auto name1 = Name("Arial");
+  auto name2 = Name("Arial");
+  auto paragraph = DefaultParagraph();
+
+  TextFormatKey a(table, paragraph, DefaultText(name1.c_str()));
+  TextFormatKey b(table, paragraph, DefaultText(name2.c_str()));
+  CHECK(a == b);
+  CHECK(a.Hash == b.Hash);
+  CHECK(std::hash<TextFormatKey>()(a) == std::hash<TextFormatKey>()(b));
+}
+
+TEST(TextFormatKey_IgnoresPropertiesOutsideTheFormat) {
+  FontNameTable table;
+  auto name = Name("Arial");
+  auto paragraph = DefaultParagraph();
+  auto text = DefaultText(name.c_str());
+  TextFormatKey base(table, paragraph, text);
+
+  // Colors, decorations and indentation are applied to the layout, not the format
+  text.Color = 0xFFFF0000;
+  text.Underline = true;
+  text.OutlineWidth = 2;
+  paragraph.Indent = 10;
+  paragraph.HangingIndent = true;
+  CHECK(TextFormatKey(table, paragraph, text) == base);
+}
+
+TEST(TextFormatKey_EveryFormatPropertyMatters) {
+  FontNameTable table;
+  auto arial = Name("Arial");
+  auto times = Name("Times");
+  auto paragraph = DefaultParagraph();
+  auto text = DefaultText(arial.c_str());
+  TextFormatKey base(table, paragraph, text);
+
+  std::vector<TextFormatKey> variants;
+  auto addText = [&](auto change) {
+    auto changed = text;
+    change(changed);
+    variants.emplace_back(table, paragraph, changed);
+  };
+  auto addParagraph = [&](auto change) {
+    auto changed = paragraph;
+    change(changed);
+    variants.emplace_back(table, changed, text);
+  };
+  addText([&](TextStyle &s) { s.FontFace = times.c_str(); });
+  addText([](TextStyle &s) { s.FontSize = 13; });
+  addText([](TextStyle &s) { s.FontWeight = FontWeight::Bold; });
+  addText([](TextStyle &s) { s.FontStyle = FontStyle::Italic; });
+  addText([](TextStyle &s) { s.FontStretch = FontStretch::Condensed; });
+  addParagraph([](ParagraphStyle &s) { s.TabStopWidth = 20; });
+  addParagraph([](ParagraphStyle &s) { s.TextAlignment = TextAlign::Center; });
+  addParagraph([](ParagraphStyle &s) { s.ParagraphAlignment = ParagraphAlign::Far; });
+  addParagraph([](ParagraphStyle &s) { s.WordWrap = WordWrap::NoWrap; });
+  addParagraph([](ParagraphStyle &s) { s.TrimMode = TrimMode::Word; });
+  addParagraph([](ParagraphStyle &s) { s.TrimmingSign = TrimmingSign::Ellipsis; });
+  addParagraph([](ParagraphStyle &s) { s.LineSpacingMode = LineSpacingMode::Uniform; });
+  addParagraph([](ParagraphStyle &s) { s.LineHeight = 2; });
+
+  std::unordered_set<uint64_t> hashes{base.Hash};
+  for (auto &variant : variants) {
+    CHECK(!(variant == base));
+    hashes.insert(variant.Hash);
+  }
+  // Not required for correctness, but a collision here would point at a weak hash
+  CHECK(hashes.size() == variants.size() + 1);
+}
+
+TEST(TextFormatKey_SignedZeroHashesEqual) {
+  FontNameTable table;
+  auto name = Name("Arial");
+  auto paragraph = DefaultParagraph();
+  auto text = DefaultText(name.c_str());
+  paragraph.LineHeight = 0.0f;
+  TextFormatKey positive(table, paragraph, text);
+  paragraph.LineHeight = -0.0f;
+  TextFormatKey negative(table, paragraph, text);
+
+  CHECK(positive == negative);
+  CHECK(positive.Hash == negative.Hash);
+}
+
+TEST(TextFormatKey_WorksAsCacheKey) {
+  FontNameTable table;
+  auto name = Name("Arial");
+  auto paragraph = DefaultParagraph();
+  auto text = DefaultText(name.c_str());
+  LruCache<TextFormatKey, int> cache(16);
+
+  for (int size = 10; size < 20; size++) {
+    text.FontSize = (float)size;
+    TextFormatKey key(table, paragraph, text);
+    cache.insertHashed(key, key.Hash, size);
+  }
+  text.FontSize = 15;
+  TextFormatKey key(table, paragraph, text);
+  auto value = cache.findHashed(key, key.Hash);
+  CHECK(value && *value == 15);
+}
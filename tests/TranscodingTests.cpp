@@ -0,0 +1,69 @@
+#include <climits>
+#include <cstdint>
+#include <string>
+
+#include "../game/interop/Transcoding.h"
+#include "../game/utils.h"
+#include "TestHarness.h"
+
+NATIVE_API int Transcode_GetMaxLength(TextEncoding from, TextEncoding to, int length);
+NATIVE_API int Transcode_Convert(TextEncoding from, TextEncoding to, const void *input,
+                                 int length, void *output, int outputCapacity);
+NATIVE_API int Transcode_ConvertBatch(TextEncoding from, TextEncoding to, const void *input,
+                                      const int *inputOffsets, int count, void *output,
+                                      int outputCapacity, int *outputOffsets);
+
+TEST(Transcoding_ConvertsWindows1252) {
+  // Euro sign, e with acute accent and a plain letter
+  const uint8_t input[] = {0x80, 0xE9, 'a'};
+  char16_t utf16[3];
+  REQUIRE(Transcode_Convert(TextEncoding::Windows1252, TextEncoding::Utf16, input, 3, utf16, 3) ==
+          3);
+  CHECK(std::u16string(utf16, 3) == u"€éa");
+
+  char utf8[9];
+  auto length = Transcode_Convert(TextEncoding::Utf16, TextEncoding::Utf8, utf16, 3, utf8, 9);
+  CHECK(std::string(utf8, length) == "\xE2\x82\xAC\xC3\xA9" "a");
+}
+
+TEST(Transcoding_RejectsNegativeLengths) {
+  char16_t output[4];
+  CHECK(Transcode_GetMaxLength(TextEncoding::Utf8, TextEncoding::Utf16, -1) == -1);
+  CHECK(Transcode_Convert(TextEncoding::Utf8, TextEncoding::Utf16, "", -1, output, 4) == -1);
+  CHECK(Transcode_Convert(TextEncoding::Utf8, TextEncoding::Utf16, "", INT_MIN, output, 4) == -1);
+}
+
+TEST(Transcoding_ChecksCapacityWithoutOverflow) {
+  // Three UTF-8 bytes per input unit no longer fit into an int
+  auto length = INT_MAX / 3 + 1;
+  CHECK(Transcode_GetMaxLength(TextEncoding::Utf16, TextEncoding::Utf8, INT_MAX / 3) ==
+        INT_MAX / 3 * 3);
+  CHECK(Transcode_GetMaxLength(TextEncoding::Utf16, TextEncoding::Utf8, length) == -1);
+  CHECK(Transcode_GetMaxLength(TextEncoding::Utf8, TextEncoding::Utf16, INT_MAX) == INT_MAX);
+
+  // Rejected before the input is read, so it does not need to be that long
+  char16_t input[1] = {u'a'};
+  char output[16];
+  CHECK(Transcode_Convert(TextEncoding::Utf16, TextEncoding::Utf8, input, length, output, 16) ==
+        -1);
+  CHECK(Transcode_Convert(TextEncoding::Utf16, TextEncoding::Utf8, input, length, output,
+                          INT_MAX) == -1);
+  CHECK(Transcode_Convert(TextEncoding::Utf16, TextEncoding::Utf8, input, 1, output, -3) == -1);
+
+  int offsets[] = {0, length};
+  int outputOffsets[2];
+  CHECK(Transcode_ConvertBatch(TextEncoding::Utf16, TextEncoding::Utf8, input, offsets, 1, output,
+                               INT_MAX, outputOffsets) == -1);
+}
+
+TEST(Transcoding_ConvertsBatches) {
+  const char input[] = "abc" "\xC3\xA9" "d";
+  int offsets[] = {0, 3, 3, 6};
+  char16_t output[6];
+  int outputOffsets[4];
+  REQUIRE(Transcode_ConvertBatch(TextEncoding::Utf8, TextEncoding::Utf16, input, offsets, 3,
+                                 output, 6, outputOffsets) == 5);
+  CHECK(std::u16string(output, 5) == u"abcéd");
+  CHECK(outputOffsets[0] == 0 && outputOffsets[1] == 3 && outputOffsets[2] == 3 &&
+        outputOffsets[3] == 5);
+}
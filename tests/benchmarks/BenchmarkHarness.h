@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * A minimal benchmark runner to go with the native tests.
+ *
+ * BENCHMARK(Group_Name) defines a benchmark that is given a State and has to perform
+ * state.iterations operations. The runner prints the time per operation. With --quick, every
+ * benchmark runs only a few iterations, which is how CTest runs them to keep them compiling and
+ * working. Arguments that are not options select benchmarks by name prefix.
+ */
+namespace BenchmarkHarness {
+
+struct State {
+  size_t iterations;
+};
+
+struct Benchmark {
+  const char *name;
+  void (*run)(State &state);
+};
+
+std::vector<Benchmark> &Registry();
+
+struct Registrar {
+  Registrar(const char *name, void (*run)(State &)) {
+    Registry().push_back({name, run});
+  }
+};
+
+extern volatile uint64_t OptimizerSink;
+
+/**
+ * Keeps the compiler from optimizing away the computation of a result.
+ */
+template <typename T>
+void DoNotOptimize(T result) {
+  OptimizerSink = (uint64_t)result;
+}
+
+}  // namespace BenchmarkHarness
+
+#define BENCHMARK(name)                                                        \
+  static void name(BenchmarkHarness::State &state);                           \
+  static const BenchmarkHarness::Registrar name##Registrar_(#name, &name);    \
+  static void name(BenchmarkHarness::State &state)
@@ -0,0 +1,66 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "BenchmarkHarness.h"
+
+namespace BenchmarkHarness {
+
+volatile uint64_t OptimizerSink = 0;
+
+std::vector<Benchmark> &Registry() {
+  static std::vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+}  // namespace BenchmarkHarness
+
+// Iterations are doubled until a run takes at least this long
+static constexpr auto MinRunTime = std::chrono::milliseconds(200);
+static constexpr size_t QuickIterations = 16;
+
+int main(int argc, char **argv) {
+  using namespace BenchmarkHarness;
+  using Clock = std::chrono::steady_clock;
+
+  bool quick = false;
+  std::vector<std::string> prefixes;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--quick") == 0) {
+      quick = true;
+    } else {
+      prefixes.emplace_back(argv[i]);
+    }
+  }
+
+  for (auto &benchmark : Registry()) {
+    std::string name = benchmark.name;
+    if (!prefixes.empty()) {
+      bool selected = false;
+      for (auto &prefix : prefixes) {
+        selected |= name.compare(0, prefix.length(), prefix) == 0;
+      }
+      if (!selected) {
+        continue;
+      }
+    }
+
+    State state{quick ? QuickIterations : 1};
+    double seconds;
+    for (;;) {
+      auto start = Clock::now();
+      benchmark.run(state);
+      seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      if (quick || seconds >= std::chrono::duration<double>(MinRunTime).count()) {
+        break;
+      }
+      state.iterations *= 2;
+    }
+
+    printf("%-48s %12zu iterations %12.1f ns/op\n", benchmark.name, state.iterations,
+           seconds * 1e9 / (double)state.iterations);
+  }
+  return 0;
+}
@@ -0,0 +1,66 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "../../game/text/GlyphAtlas.h"
+#include "BenchmarkHarness.h"
+
+struct GlyphRequest {
+  GlyphKey key;
+  uint32_t width;
+  uint32_t height;
+};
+
+// Text-like glyph usage: a few hundred glyphs at a handful of sizes and subpixel positions, with
+// common glyphs drawn far more often than rare ones
+static std::vector<GlyphRequest> MakeRequests(size_t count, uint32_t glyphCount) {
+  std::mt19937 random(1234);
+  std::geometric_distribution<uint32_t> glyphs(8.0 / glyphCount);
+  std::uniform_int_distribution<int> sizes(0, 3);
+  std::uniform_real_distribution<float> positions(0, 1000);
+  std::vector<GlyphRequest> requests(count);
+  for (auto &request : requests) {
+    auto glyph = glyphs(random) % glyphCount;
+    auto fontSize = 10.0f + 4.0f * (float)sizes(random);
+    request.key = GlyphAtlas::MakeKey(0, glyph, fontSize, positions(random));
+    request.width = (uint32_t)fontSize * (glyph % 3 + 2) / 4;
+    request.height = (uint32_t)fontSize;
+  }
+  return requests;
+}
+
+static uint64_t Draw(GlyphAtlas &atlas, const std::vector<GlyphRequest> &requests,
+                     size_t iterations) {
+  // Starts a new frame every 256 glyphs, like a UI drawing a few text blocks per frame
+  uint64_t sum = 0;
+  for (size_t i = 0; i < iterations; i++) {
+    if (i % 256 == 0) {
+      atlas.BeginFrame();
+    }
+    auto &request = requests[i % requests.size()];
+    auto entry = atlas.Find(request.key);
+    if (!entry) {
+      entry = atlas.Insert(request.key, request.width, request.height, 0, 0);
+    }
+    if (entry) {
+      sum += entry->x + entry->y;
+    }
+  }
+  return sum;
+}
+
+BENCHMARK(GlyphAtlas_FindHit) {
+  GlyphAtlas atlas(1024, 4);
+  auto requests = MakeRequests(4096, 128);
+  Draw(atlas, requests, requests.size());
+
+  BenchmarkHarness::DoNotOptimize(Draw(atlas, requests, state.iterations));
+}
+
+BENCHMARK(GlyphAtlas_InsertWithEvictions) {
+  // Too small for the working set, so pages are evicted constantly
+  GlyphAtlas atlas(128, 4);
+  auto requests = MakeRequests(4096, 2048);
+
+  BenchmarkHarness::DoNotOptimize(Draw(atlas, requests, state.iterations));
+}
@@ -0,0 +1,146 @@
+#include <cstdint>
+#include <list>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../../game/LruCache.h"
+#include "BenchmarkHarness.h"
+
+static constexpr size_t CacheSize = 1024;
+
+// Mostly hits with a long tail of misses, like the text format and layout caches see
+static std::vector<uint32_t> MakeKeys(size_t count, uint32_t keyRange) {
+  std::mt19937 random(1234);
+  std::geometric_distribution<uint32_t> distribution(4.0 / keyRange);
+  std::vector<uint32_t> keys(count);
+  for (auto &key : keys) {
+    key = distribution(random) % keyRange;
+  }
+  return keys;
+}
+
+BENCHMARK(LruCache_FindHit) {
+  LruCache<uint32_t, uint64_t> cache(CacheSize);
+  for (uint32_t i = 0; i < CacheSize; i++) {
+    cache.insert(i, i);
+  }
+  auto keys = MakeKeys(4096, CacheSize);
+
+  uint64_t sum = 0;
+  for (size_t i = 0; i < state.iterations; i++) {
+    sum += *cache.find(keys[i % keys.size()]);
+  }
+  BenchmarkHarness::DoNotOptimize(sum);
+}
+
+BENCHMARK(LruCache_FindOrInsertWithEvictions) {
+  LruCache<uint32_t, uint64_t> cache(CacheSize);
+  auto keys = MakeKeys(4096, CacheSize * 4);
+
+  uint64_t sum = 0;
+  for (size_t i = 0; i < state.iterations; i++) {
+    auto key = keys[i % keys.size()];
+    auto value = cache.find(key);
+    if (!value) {
+      value = cache.insert(key, key);
+    }
+    sum += *value;
+  }
+  BenchmarkHarness::DoNotOptimize(sum);
+}
+
+BENCHMARK(LruCache_InsertRemove) {
+  LruCache<uint32_t, uint64_t> cache(CacheSize);
+  for (uint32_t i = 0; i < CacheSize / 2; i++) {
+    cache.insert(i, i);
+  }
+
+  // Keeps the table half full, so every removal shifts a probe sequence back
+  for (size_t i = 0; i < state.iterations; i++) {
+    auto key = (uint32_t)i;
+    cache.insert(key + CacheSize / 2, key);
+    cache.remove(key);
+  }
+  BenchmarkHarness::DoNotOptimize(cache.size());
+}
+
+/**
+ * Baseline with the structure of lru11::Cache, which LruCache replaced: an unordered_map from
+ * keys to the nodes of a std::list that is kept in recency order. Hits splice their node to the
+ * front, and once the cache has grown elasticity entries past maxSize, it is pruned back to
+ * maxSize from the back of the list. Uses the same default elasticity as lru11::Cache.
+ */
+template <typename Key, typename Value>
+class ListLruCache {
+ public:
+  explicit ListLruCache(size_t maxSize, size_t elasticity = 10)
+      : _maxSize(maxSize), _elasticity(elasticity) {}
+
+  Value *find(const Key &key) {
+    auto it = _map.find(key);
+    if (it == _map.end()) {
+      return nullptr;
+    }
+    _list.splice(_list.begin(), _list, it->second);
+    return &it->second->second;
+  }
+
+  Value *insert(const Key &key, Value value) {
+    auto it = _map.find(key);
+    if (it != _map.end()) {
+      it->second->second = std::move(value);
+      _list.splice(_list.begin(), _list, it->second);
+      return &it->second->second;
+    }
+
+    _list.emplace_front(key, std::move(value));
+    _map[key] = _list.begin();
+    if (_map.size() >= _maxSize + _elasticity) {
+      while (_map.size() > _maxSize) {
+        _map.erase(_list.back().first);
+        _list.pop_back();
+      }
+    }
+    return &_list.front().second;
+  }
+
+ private:
+  using List = std::list<std::pair<Key, Value>>;
+  List _list;
+  std::unordered_map<Key, typename List::iterator> _map;
+  size_t _maxSize;
+  size_t _elasticity;
+};
+
+// The same work as LruCache_FindHit and LruCache_FindOrInsertWithEvictions, for comparison
+BENCHMARK(LruCache_ListBaselineFindHit) {
+  ListLruCache<uint32_t, uint64_t> cache(CacheSize);
+  for (uint32_t i = 0; i < CacheSize; i++) {
+    cache.insert(i, i);
+  }
+  auto keys = MakeKeys(4096, CacheSize);
+
+  uint64_t sum = 0;
+  for (size_t i = 0; i < state.iterations; i++) {
+    sum += *cache.find(keys[i % keys.size()]);
+  }
+  BenchmarkHarness::DoNotOptimize(sum);
+}
+
+BENCHMARK(LruCache_ListBaselineFindOrInsertWithEvictions) {
+  ListLruCache<uint32_t, uint64_t> cache(CacheSize);
+  auto keys = MakeKeys(4096, CacheSize * 4);
+
+  uint64_t sum = 0;
+  for (size_t i = 0; i < state.iterations; i++) {
+    auto key = keys[i % keys.size()];
+    auto value = cache.find(key);
+    if (!value) {
+      value = cache.insert(key, key);
+    }
+    sum += *value;
+  }
+  BenchmarkHarness::DoNotOptimize(sum);
+}
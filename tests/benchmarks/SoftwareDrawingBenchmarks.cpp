@@ -0,0 +1,115 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../SoftwareDrawingFixture.h"
+#include "BenchmarkHarness.h"
+
+using namespace SoftwareDrawingFixture;
+
+static const std::u16string_view Paragraph =
+    u"The quick brown fox jumps over the lazy dog, while the tired dog keeps on sleeping. "
+    u"Meanwhile, the fox has long since disappeared into the forest behind the old mill.";
+
+// Button and label captions of a typical game screen
+static const std::u16string_view Labels[] = {
+    u"New Game", u"Load Game", u"Options", u"Quit", u"Strength", u"Dexterity", u"Constitution",
+    u"Intelligence", u"Wisdom", u"Charisma", u"Hit Points: 42/57", u"Armor Class: 17",
+    u"Experience: 12500 / 15000", u"Gold: 1,204", u"Inventory", u"Spells", u"Skills", u"Feats",
+};
+
+BENCHMARK(SoftwareDrawing_LayoutParagraph) {
+  auto engine = CreateEngine();
+  auto paragraph = DefaultParagraph();
+  auto text = DefaultText();
+
+  uint64_t lines = 0;
+  for (size_t i = 0; i < state.iterations; i++) {
+    std::unique_ptr<SoftwareTextLayout> layout(engine->CreateTextLayout(
+        paragraph, text, Paragraph.data(), (uint32_t)Paragraph.length(), 300, 1000));
+    lines += layout->GetMetrics().lineCount;
+  }
+  BenchmarkHarness::DoNotOptimize(lines);
+}
+
+// Resizing a window lays out the same text at a new width, without shaping it again
+BENCHMARK(SoftwareDrawing_RelayoutParagraph) {
+  auto engine = CreateEngine();
+  std::unique_ptr<SoftwareTextLayout> layout(
+      engine->CreateTextLayout(DefaultParagraph(), DefaultText(), Paragraph.data(),
+                               (uint32_t)Paragraph.length(), 300, 1000));
+
+  uint64_t lines = 0;
+  for (size_t i = 0; i < state.iterations; i++) {
+    layout->SetMaxWidth(200.0f + (float)(i % 8) * 25);
+    lines += layout->GetMetrics().lineCount;
+  }
+  BenchmarkHarness::DoNotOptimize(lines);
+}
+
+BENCHMARK(SoftwareDrawing_LayoutMarkup) {
+  auto engine = CreateEngine();
+  auto text = DefaultText();
+  MarkupStyle palette[2]{};
+  palette[1].Properties = TextStyleProperty::Color | TextStyleProperty::FontWeight;
+  palette[1].Style = text;
+  palette[1].Style.Color = 0xFFFF6040;
+  palette[1].Style.FontWeight = FontWeight::Bold;
+  std::u16string_view markup =
+      u"You hit the @1goblin@0 for @112@0 points of damage. The @1goblin@0 is @1dying@0.";
+
+  uint64_t lines = 0;
+  for (size_t i = 0; i < state.iterations; i++) {
+    std::unique_ptr<SoftwareTextLayout> layout(engine->CreateTextLayoutFromMarkup(
+        DefaultParagraph(), text, markup, 300, 1000, palette, 2));
+    lines += layout->GetMetrics().lineCount;
+  }
+  BenchmarkHarness::DoNotOptimize(lines);
+}
+
+BENCHMARK(SoftwareDrawing_RenderParagraph) {
+  auto engine = CreateEngine();
+  std::vector<uint8_t> pixels(512 * 256 * 4);
+  engine->SetRenderTarget(pixels.data(), 512, 256, 512 * 4);
+  engine->SetCanvasSize(512, 256);
+  std::unique_ptr<SoftwareTextLayout> layout(
+      engine->CreateTextLayout(DefaultParagraph(), DefaultText(), Paragraph.data(),
+                               (uint32_t)Paragraph.length(), 500, 250));
+
+  for (size_t i = 0; i < state.iterations; i++) {
+    engine->BeginDraw();
+    engine->RenderTextLayout(4, 4, *layout, 1);
+    engine->EndDraw();
+  }
+  BenchmarkHarness::DoNotOptimize(pixels[512 * 10 * 4 + 40]);
+}
+
+// One frame of a UI screen: every label is laid out and drawn on a button background
+BENCHMARK(SoftwareDrawing_UiFrame) {
+  auto engine = CreateEngine();
+  std::vector<uint8_t> pixels(1024 * 768 * 4);
+  engine->SetRenderTarget(pixels.data(), 1024, 768, 1024 * 4);
+  engine->SetCanvasSize(1024, 768);
+  auto paragraph = DefaultParagraph();
+  paragraph.TextAlignment = TextAlign::Center;
+  auto text = DefaultText();
+  BackgroundAndBorderStyle button;
+  button.radiusX = button.radiusY = 4;
+  button.backgroundColor = 0xFF304050;
+  button.borderColor = 0xFF8090A0;
+  button.borderWidth = 1;
+
+  for (size_t i = 0; i < state.iterations; i++) {
+    engine->BeginDraw();
+    float y = 4;
+    for (auto label : Labels) {
+      std::unique_ptr<SoftwareTextLayout> layout(engine->CreateTextLayout(
+          paragraph, text, label.data(), (uint32_t)label.length(), 200, 32));
+      engine->RenderBackgroundAndBorder(4, y, 200, 32, button);
+      engine->RenderTextLayout(4, y + 6, *layout, 1);
+      y += 40;
+    }
+    engine->EndDraw();
+  }
+  BenchmarkHarness::DoNotOptimize(pixels[1024 * 10 * 4 + 40]);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+/**
+ * The parts of SoLoud's API that SoLoudDynamicSource uses, so that it can be tested without the
+ * SoLoud submodule. Tests play the part of the audio thread by calling getAudio directly.
+ */
+namespace SoLoud {
+
+typedef unsigned int result;
+typedef double time;
+
+enum SOLOUD_ERRORS { SO_NO_ERROR = 0, INVALID_PARAMETER = 1 };
+
+static constexpr unsigned int MAX_CHANNELS = 8;
+
+class AudioSourceInstance {
+ public:
+  virtual ~AudioSourceInstance() = default;
+  virtual unsigned int getAudio(float *aBuffer, unsigned int aSamplesToRead,
+                                unsigned int aBufferSize) = 0;
+  virtual bool hasEnded() = 0;
+  virtual result seek([[maybe_unused]] time aSeconds, [[maybe_unused]] float *mScratch,
+                      [[maybe_unused]] unsigned int mScratchSize) {
+    return SO_NO_ERROR;
+  }
+
+  unsigned int mChannels = 1;
+  time mStreamPosition = 0;
+};
+
+class AudioSource {
+ public:
+  enum FLAGS { SHOULD_LOOP = 1, SINGLE_INSTANCE = 2, INAUDIBLE_TICK = 32 };
+
+  virtual ~AudioSource() = default;
+  virtual AudioSourceInstance *createInstance() = 0;
+  void stop() {}
+
+  unsigned int mFlags = 0;
+  float mBaseSamplerate = 44100;
+  unsigned int mChannels = 1;
+};
+
+}  // namespace SoLoud
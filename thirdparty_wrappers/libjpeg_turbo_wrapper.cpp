@@ -1,8 +1,13 @@
 
 #include <turbojpeg.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstdlib>
+#include <exception>
+#include <thread>
+#include <vector>
 #include "../game/utils.h"
 
 enum class JpegPixelFormat : int { RGB = 0, BGR, RGBX, BGRX, XBGR, XRGB };
@@ -67,3 +72,127 @@ NATIVE_API ApiBool Jpeg_Decode(tjhandle decoder, uint8_t *imageData,
 }
 
 NATIVE_API void Jpeg_Destroy(tjhandle handle) { tjDestroy(handle); }
+
+/**
+ * A single JPEG tile that should be placed into the overview image.
+ * x and y are grid coordinates (column and row), not pixels.
+ */
+struct OverviewTile {
+  const uint8_t *data;
+  uint32_t dataSize;
+  int x;
+  int y;
+};
+
+// Finds the libjpeg-turbo scaling factor that matches num/denom exactly
+static bool FindScalingFactor(int num, int denom, tjscalingfactor *factorOut) {
+  int count = 0;
+  auto factors = tjGetScalingFactors(&count);
+  if (!factors) {
+    return false;
+  }
+  for (auto i = 0; i < count; i++) {
+    if (factors[i].num * denom == num * factors[i].denom) {
+      *factorOut = factors[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Decodes a list of JPEG tiles at a reduced DCT scale and places them into a single
+ * composite image. Each tile is decoded directly into its cell of the output buffer, which is
+ * (tileWidth * scale) x (tileHeight * scale) pixels in size. Tiles are decoded in parallel
+ * using up to threadCount threads (0 = number of hardware threads).
+ *
+ * Each cell may be given at most one tile. Tiles that fail to decode, are larger than a cell or do
+ * not fit into the output buffer are skipped. Returns the number of tiles that were composed
+ * successfully, or -1 if the scaling factor is not supported by libjpeg-turbo or the output
+ * buffer is invalid.
+ */
+NATIVE_API int Map_ComposeOverview(const OverviewTile *tiles, int tileCount,
+                                   int tileWidth, int tileHeight,
+                                   int scaleNum, int scaleDenom,
+                                   uint8_t *outputData, int outputWidth, int outputStride,
+                                   int outputHeight, JpegPixelFormat pixelFormat,
+                                   int flags, int threadCount) {
+  tjscalingfactor scale{};
+  if (!FindScalingFactor(scaleNum, scaleDenom, &scale)) {
+    return -1;
+  }
+
+  auto pf = ConvertPixelFormat(pixelFormat);
+  auto bytesPerPixel = tjPixelSize[pf];
+  auto cellWidth = TJSCALED(tileWidth, scale);
+  auto cellHeight = TJSCALED(tileHeight, scale);
+  if (!outputData || outputWidth < 0 || outputHeight < 0 ||
+      (int64_t)outputStride < (int64_t)outputWidth * bytesPerPixel) {
+    return -1;
+  }
+
+  if (threadCount <= 0) {
+    threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+  }
+  threadCount = std::min(threadCount, tileCount);
+
+  std::atomic<int> nextTile{0};
+  std::atomic<int> composedTiles{0};
+
+  // Every worker pulls tiles until none are left. Tiles are confined to their cells, which are
+  // disjoint regions of the output buffer, so no further synchronization is needed.
+  auto worker = [&]() {
+    auto decoder = tjInitDecompress();
+    if (!decoder) {
+      return;
+    }
+
+    for (auto i = nextTile++; i < tileCount; i = nextTile++) {
+      auto &tile = tiles[i];
+
+      int width, height, subsamp, colorspace;
+      if (tjDecompressHeader3(decoder, tile.data, tile.dataSize, &width, &height, &subsamp,
+                              &colorspace) != 0) {
+        continue;
+      }
+
+      auto scaledWidth = TJSCALED(width, scale);
+      auto scaledHeight = TJSCALED(height, scale);
+      // A larger tile would overwrite neighbouring cells, which other threads decode into
+      if (scaledWidth > cellWidth || scaledHeight > cellHeight) {
+        continue;
+      }
+
+      auto left = (int64_t)tile.x * cellWidth;
+      auto top = (int64_t)tile.y * cellHeight;
+      if (tile.x < 0 || tile.y < 0 || left + scaledWidth > outputWidth ||
+          top + scaledHeight > outputHeight) {
+        continue;
+      }
+
+      auto dest = outputData + (size_t)top * outputStride + (size_t)left * bytesPerPixel;
+      if (tjDecompress2(decoder, tile.data, tile.dataSize, dest, scaledWidth, outputStride,
+                        scaledHeight, pf, flags) == 0) {
+        composedTiles++;
+      }
+    }
+
+    tjDestroy(decoder);
+  };
+
+  std::vector<std::thread> threads;
+  try {
+    threads.reserve(threadCount > 0 ? threadCount - 1 : 0);
+    for (auto i = 1; i < threadCount; i++) {
+      threads.emplace_back(worker);
+    }
+  } catch (const std::exception &) {
+    // Fewer threads only take longer, the remaining tiles are decoded by the calling thread
+  }
+  worker();  // The calling thread participates as well
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  return composedTiles;
+}
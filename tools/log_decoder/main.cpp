@@ -0,0 +1,286 @@
+/*
+ * Turns binary log captures written by BinaryLog back into text.
+ *
+ * Usage: OpenTemple.LogDecoder <capture file> [output file]
+ * Writes UTF-8 text to the output file, or to stdout if none is given. Timestamps are in UTC.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BinaryLogFormat.h"
+
+using namespace BinaryLogFormat;
+
+static const char *LevelNames[] = {"Error", "Warn", "Info", "Debug"};
+
+struct Descriptor {
+  uint8_t level;
+  uint32_t line;
+  std::string file;
+  std::string format;  // Converted to UTF-8
+};
+
+/**
+ * Bounds-checked reading from a memory buffer. Reading past the end sets the failed flag and
+ * returns zeroes.
+ */
+class Reader {
+ public:
+  Reader(const uint8_t *data, size_t size) : _data(data), _size(size) {}
+
+  template <typename T>
+  T read() {
+    T value{};
+    if (_pos + sizeof(T) > _size) {
+      _failed = true;
+      _pos = _size;
+      return value;
+    }
+    memcpy(&value, _data + _pos, sizeof(T));
+    _pos += sizeof(T);
+    return value;
+  }
+
+  std::string readNarrow() {
+    auto length = read<uint16_t>();
+    if (_pos + length > _size) {
+      _failed = true;
+      _pos = _size;
+      return {};
+    }
+    std::string result(reinterpret_cast<const char *>(_data + _pos), length);
+    _pos += length;
+    return result;
+  }
+
+  std::u16string readWide() {
+    auto length = read<uint16_t>();
+    std::u16string result;
+    result.reserve(length);
+    for (int i = 0; i < length && !_failed; i++) {
+      result.push_back(read<char16_t>());
+    }
+    return result;
+  }
+
+  [[nodiscard]] bool atEnd() const {
+    return _pos >= _size;
+  }
+
+  [[nodiscard]] bool failed() const {
+    return _failed;
+  }
+
+ private:
+  const uint8_t *_data;
+  size_t _size;
+  size_t _pos = 0;
+  bool _failed = false;
+};
+
+static void AppendUtf8(std::string &out, uint32_t codePoint) {
+  if (codePoint < 0x80) {
+    out.push_back((char)codePoint);
+  } else if (codePoint < 0x800) {
+    out.push_back((char)(0xC0 | (codePoint >> 6)));
+    out.push_back((char)(0x80 | (codePoint & 0x3F)));
+  } else if (codePoint < 0x10000) {
+    out.push_back((char)(0xE0 | (codePoint >> 12)));
+    out.push_back((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+    out.push_back((char)(0x80 | (codePoint & 0x3F)));
+  } else {
+    out.push_back((char)(0xF0 | (codePoint >> 18)));
+    out.push_back((char)(0x80 | ((codePoint >> 12) & 0x3F)));
+    out.push_back((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+    out.push_back((char)(0x80 | (codePoint & 0x3F)));
+  }
+}
+
+static std::string ToUtf8(const std::u16string &text) {
+  std::string result;
+  result.reserve(text.size());
+  for (size_t i = 0; i < text.size(); i++) {
+    uint32_t unit = text[i];
+    if (unit >= 0xD800 && unit < 0xDC00 && i + 1 < text.size() && text[i + 1] >= 0xDC00 &&
+        text[i + 1] < 0xE000) {
+      unit = 0x10000 + ((unit - 0xD800) << 10) + (text[i + 1] - 0xDC00);
+      i++;
+    } else if (unit >= 0xD800 && unit < 0xE000) {
+      unit = 0xFFFD;
+    }
+    AppendUtf8(result, unit);
+  }
+  return result;
+}
+
+/**
+ * Decodes the next argument of a record payload.
+ * @return False if the payload is exhausted or malformed.
+ */
+static bool DecodeArg(Reader &payload, std::string &out) {
+  if (payload.atEnd()) {
+    return false;
+  }
+  char buffer[64];
+  switch ((ArgType)payload.read<uint8_t>()) {
+    case ArgType::WideString:
+      out += ToUtf8(payload.readWide());
+      break;
+    case ArgType::NarrowString:
+      out += payload.readNarrow();
+      break;
+    case ArgType::Bool:
+      out += payload.read<uint8_t>() ? "true" : "false";
+      break;
+    case ArgType::Signed:
+      out += std::to_string(payload.read<int64_t>());
+      break;
+    case ArgType::Unsigned:
+      out += std::to_string(payload.read<uint64_t>());
+      break;
+    case ArgType::Float:
+      snprintf(buffer, sizeof(buffer), "%g", payload.read<double>());
+      out += buffer;
+      break;
+    case ArgType::Pointer:
+      snprintf(buffer, sizeof(buffer), "0x%llx", (unsigned long long)payload.read<uint64_t>());
+      out += buffer;
+      break;
+    default:
+      return false;
+  }
+  return !payload.failed();
+}
+
+// Replaces the "{}" placeholders the same way Logger::Format does
+static std::string FormatRecord(const std::string &format, Reader &payload) {
+  std::string result;
+  size_t pos = 0;
+  while (true) {
+    auto placeholder = format.find("{}", pos);
+    if (placeholder == std::string::npos) {
+      break;
+    }
+    std::string arg;
+    if (!DecodeArg(payload, arg)) {
+      break;
+    }
+    result.append(format, pos, placeholder - pos);
+    result += arg;
+    pos = placeholder + 2;
+  }
+  result.append(format, pos);
+  return result;
+}
+
+static std::string FormatTimestamp(uint64_t nanos) {
+  auto seconds = (time_t)(nanos / 1000000000);
+  auto millis = (int)((nanos / 1000000) % 1000);
+  char buffer[64];
+  auto length = strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", gmtime(&seconds));
+  snprintf(buffer + length, sizeof(buffer) - length, ".%03d", millis);
+  return buffer;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2 || argc > 3) {
+    fprintf(stderr, "Usage: %s <capture file> [output file]\n", argv[0]);
+    return 1;
+  }
+
+  std::ifstream input(argv[1], std::ios::binary);
+  if (!input) {
+    fprintf(stderr, "Failed to open %s\n", argv[1]);
+    return 1;
+  }
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(input)),
+                            std::istreambuf_iterator<char>());
+
+  auto output = stdout;
+  if (argc == 3) {
+    output = fopen(argv[2], "wb");
+    if (!output) {
+      fprintf(stderr, "Failed to create %s\n", argv[2]);
+      return 1;
+    }
+  }
+
+  Reader reader(data.data(), data.size());
+  char magic[sizeof(Magic)];
+  for (auto &ch : magic) {
+    ch = reader.read<char>();
+  }
+  if (reader.failed() || memcmp(magic, Magic, sizeof(Magic)) != 0) {
+    fprintf(stderr, "%s is not a binary log capture\n", argv[1]);
+    return 1;
+  }
+  auto version = reader.read<uint32_t>();
+  if (version != Version) {
+    fprintf(stderr, "Unsupported binary log version %u\n", version);
+    return 1;
+  }
+
+  std::unordered_map<uint32_t, Descriptor> descriptors;
+  while (!reader.atEnd() && !reader.failed()) {
+    switch ((ChunkType)reader.read<uint8_t>()) {
+      case ChunkType::Descriptor: {
+        auto id = reader.read<uint32_t>();
+        Descriptor descriptor;
+        descriptor.level = reader.read<uint8_t>();
+        descriptor.line = reader.read<uint32_t>();
+        descriptor.file = reader.readNarrow();
+        descriptor.format = ToUtf8(reader.readWide());
+        descriptors[id] = std::move(descriptor);
+        break;
+      }
+      case ChunkType::Record: {
+        auto id = reader.read<uint32_t>();
+        auto timestamp = reader.read<uint64_t>();
+        auto payloadSize = reader.read<uint16_t>();
+        std::vector<uint8_t> payloadData(payloadSize);
+        for (auto &byte : payloadData) {
+          byte = reader.read<uint8_t>();
+        }
+        if (reader.failed()) {
+          break;
+        }
+
+        auto it = descriptors.find(id);
+        if (it == descriptors.end()) {
+          fprintf(output, "%s [?] <unknown descriptor %u>\n", FormatTimestamp(timestamp).c_str(),
+                  id);
+          break;
+        }
+        auto &descriptor = it->second;
+        Reader payload(payloadData.data(), payloadData.size());
+        auto message = FormatRecord(descriptor.format, payload);
+        auto levelName = descriptor.level < 4 ? LevelNames[descriptor.level] : "?";
+        fprintf(output, "%s [%s] %s (%s:%u)\n", FormatTimestamp(timestamp).c_str(), levelName,
+                message.c_str(), descriptor.file.c_str(), descriptor.line);
+        break;
+      }
+      case ChunkType::Dropped:
+        fprintf(output, "<%llu records were dropped>\n",
+                (unsigned long long)reader.read<uint64_t>());
+        break;
+      default:
+        fprintf(stderr, "Corrupt chunk in %s\n", argv[1]);
+        return 1;
+    }
+  }
+
+  if (reader.failed()) {
+    fprintf(stderr, "%s ends with an incomplete chunk\n", argv[1]);
+  }
+  if (output != stdout) {
+    fclose(output);
+  }
+  return 0;
+}